@@ -38,8 +38,22 @@
 #include <nuttx/fs/fs.h>
 #include <nuttx/mutex.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/wqueue.h>
 #include <nuttx/crypto/crypto.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+#  ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC_HPWORK
+#    define CRYPTO_WORK HPWORK
+#  else
+#    define CRYPTO_WORK LPWORK
+#  endif
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -53,6 +67,49 @@ int crypto_drivers_num = 0;
 
 static mutex_t g_crypto_lock = NXMUTEX_INITIALIZER;
 
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+/* Requests handed to crypto_dispatch() wait here for the worker */
+
+static spinlock_t g_crypto_qlock = SP_UNLOCKED;
+static FAR struct cryptop *g_crypto_qhead;
+static FAR struct cryptop *g_crypto_qtail;
+static struct work_s g_crypto_work;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+/* Run everything queued so far.  crypto_invoke() does not return before
+ * the driver has processed the request, so each request is completed as
+ * soon as it returns.
+ */
+
+static void crypto_worker(FAR void *arg)
+{
+  FAR struct cryptop *crp;
+  FAR struct cryptop *next;
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&g_crypto_qlock);
+  crp = g_crypto_qhead;
+  g_crypto_qhead = NULL;
+  g_crypto_qtail = NULL;
+  spin_unlock_irqrestore(&g_crypto_qlock, flags);
+
+  while (crp != NULL)
+    {
+      next = crp->crp_next;
+      crp->crp_next = NULL;
+
+      crypto_invoke(crp);
+      crypto_done(crp);
+      crp = next;
+    }
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -624,6 +681,71 @@ migrate:
   return 0;
 }
 
+/* Queue a crypto request for the crypto worker, or run it right away if
+ * the caller asked for CRYPTO_F_NOQUEUE.  Either way crp_callback is
+ * invoked once the request has completed.
+ */
+
+int crypto_dispatch(FAR struct cryptop *crp)
+{
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  irqstate_t flags;
+  bool kick;
+#endif
+
+  if (crp == NULL)
+    {
+      return -EINVAL;
+    }
+
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  if ((crp->crp_flags & CRYPTO_F_NOQUEUE) == 0)
+    {
+      crp->crp_next = NULL;
+
+      flags = spin_lock_irqsave(&g_crypto_qlock);
+      kick = g_crypto_qhead == NULL;
+      if (kick)
+        {
+          g_crypto_qhead = crp;
+        }
+      else
+        {
+          g_crypto_qtail->crp_next = crp;
+        }
+
+      g_crypto_qtail = crp;
+      spin_unlock_irqrestore(&g_crypto_qlock, flags);
+
+      /* The worker takes the whole queue at once, so it only has to be
+       * scheduled when the queue goes from empty to non-empty.
+       */
+
+      if (kick)
+        {
+          work_queue(CRYPTO_WORK, &g_crypto_work, crypto_worker, NULL, 0);
+        }
+
+      return 0;
+    }
+#endif
+
+  crypto_invoke(crp);
+  crypto_done(crp);
+  return 0;
+}
+
+/* Mark a crypto request as completed and notify its owner. */
+
+void crypto_done(FAR struct cryptop *crp)
+{
+  crp->crp_flags |= CRYPTO_F_DONE;
+  if (crp->crp_callback != NULL)
+    {
+      crp->crp_callback(crp);
+    }
+}
+
 /* Release a set of crypto descriptors. */
 
 void crypto_freereq(FAR struct cryptop *crp)
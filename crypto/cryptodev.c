@@ -43,6 +43,8 @@
 #include <errno.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
+#include <nuttx/semaphore.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/crypto/crypto.h>
 #include <nuttx/drivers/drivers.h>
@@ -91,10 +93,32 @@ struct csession
   int error;
 };
 
+struct cryptodev_areq
+{
+  TAILQ_ENTRY(cryptodev_areq) next;
+  FAR struct fcrypt *fcr;
+  FAR struct csession *cse;
+  uint32_t reqid;
+  int status;
+  FAR void *opaque;
+};
+
 struct fcrypt
 {
   TAILQ_HEAD(csessionlist, csession) csessions;
   int sesn;
+
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  /* Completed asynchronous requests waiting for CIOCCRYPTRET */
+
+  TAILQ_HEAD(cryptodev_arlist, cryptodev_areq) results;
+  mutex_t lock;
+  sem_t drain;                /* Posted when npending drops to zero */
+  FAR struct pollfd *fds;
+  uint32_t reqid;             /* Last request id handed out */
+  int npending;               /* Requests still owned by the worker */
+  int ndrain;                 /* Threads waiting on drain */
+#endif
 };
 
 /****************************************************************************
@@ -170,8 +194,17 @@ FAR struct csession *csecreate(FAR struct fcrypt *, uint64_t,
                                uint32_t, bool, bool);
 int csefree(FAR struct csession *);
 
+static int cryptodev_check(FAR struct csession *,
+                           FAR const struct crypt_op *);
 int cryptodev_op(FAR struct csession *,
-                 FAR struct crypt_op *);
+                 FAR struct crypt_op *,
+                 FAR struct cryptodev_areq *);
+static int cryptodev_mop(FAR struct fcrypt *, FAR struct crypt_mop *);
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+static void cryptodev_unpend(FAR struct fcrypt *);
+static int cryptodev_ret(FAR struct fcrypt *, FAR struct cryptret *);
+static void cryptodev_drain(FAR struct fcrypt *);
+#endif
 int cryptodev_key(FAR struct crypt_kop *);
 int cryptodev_dokey(FAR struct crypt_kop *kop, FAR struct crparam *kvp);
 
@@ -344,6 +377,11 @@ bail:
             return -EINVAL;
           }
 
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+        /* Queued requests still reference the session keys */
+
+        cryptodev_drain(fcr);
+#endif
         csedelete(fcr, cse);
         error = csefree(cse);
         break;
@@ -355,8 +393,16 @@ bail:
             return -EINVAL;
           }
 
-        error = cryptodev_op(cse, cop);
+        error = cryptodev_op(cse, cop, NULL);
+        break;
+      case CIOCCRYPTM:
+        error = cryptodev_mop(fcr, (FAR struct crypt_mop *)arg);
+        break;
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+      case CIOCCRYPTRET:
+        error = cryptodev_ret(fcr, (FAR struct cryptret *)arg);
         break;
+#endif
       case CIOCKEY:
         error = cryptodev_key((FAR struct crypt_kop *)arg);
         break;
@@ -370,8 +416,39 @@ bail:
   return error;
 }
 
+/* Reject an operation that does not match its session before anything
+ * is allocated or queued for it.
+ */
+
+static int cryptodev_check(FAR struct csession *cse,
+                           FAR const struct crypt_op *cop)
+{
+  if (!cse->txform && !cse->thash)
+    {
+      return -EINVAL;
+    }
+
+  if (cse->txform && cop->len == 0)
+    {
+      return -EINVAL;
+    }
+
+  if ((cop->iv || cop->dst) && !cse->txform)
+    {
+      return -EINVAL;
+    }
+
+  if (cop->mac && !cse->thash)
+    {
+      return -EINVAL;
+    }
+
+  return OK;
+}
+
 int cryptodev_op(FAR struct csession *cse,
-                 FAR struct crypt_op *cop)
+                 FAR struct crypt_op *cop,
+                 FAR struct cryptodev_areq *areq)
 {
   FAR struct cryptop *crp = NULL;
   FAR struct cryptodesc *crde = NULL;
@@ -379,12 +456,10 @@ int cryptodev_op(FAR struct csession *cse,
   int error = OK;
   uint32_t hid;
 
-  if (cse->txform)
+  error = cryptodev_check(cse, cop);
+  if (error < 0)
     {
-      if (cop->len == 0)
-        {
-          return -EINVAL;
-        }
+      return error;
     }
 
   /* number of requests, not logical and */
@@ -490,6 +565,22 @@ int cryptodev_op(FAR struct csession *cse,
       crp->crp_mac = cop->mac;
     }
 
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  /* hand asynchronous requests to the crypto worker, cryptodev_cb()
+   * releases them.  The callback needs the request rather than the
+   * session, so the session is kept in the request.
+   */
+
+  if (areq != NULL)
+    {
+      areq->cse = cse;
+      crp->crp_flags = CRYPTO_F_IOV;
+      crp->crp_opaque = areq;
+      crp->crp_callback = cryptodev_cb;
+      return crypto_dispatch(crp);
+    }
+#endif
+
   /* try the fast path first */
 
   crp->crp_flags = CRYPTO_F_IOV | CRYPTO_F_NOQUEUE;
@@ -550,6 +641,193 @@ bail:
   return error;
 }
 
+/* Run a batch of operations.  Every operation gets its own status, so
+ * the ioctl itself only fails if the batch descriptor is bad.
+ */
+
+static int cryptodev_mop(FAR struct fcrypt *fcr, FAR struct crypt_mop *mop)
+{
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  FAR struct cryptodev_areq *areq;
+#endif
+  FAR struct csession *cse = NULL;
+  FAR struct crypt_n_op *nop;
+  uint32_t i;
+
+  if (mop->count > 0 && mop->reqs == NULL)
+    {
+      return -EINVAL;
+    }
+
+#ifndef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  if (mop->flags & CRYPT_MOP_F_ASYNC)
+    {
+      return -ENOSYS;
+    }
+#endif
+
+  for (i = 0; i < mop->count; i++)
+    {
+      nop = &mop->reqs[i];
+      nop->reqid = 0;
+
+      /* records of one stream normally share a session */
+
+      if (cse == NULL || cse->ses != nop->op.ses)
+        {
+          cse = csefind(fcr, nop->op.ses);
+          if (cse == NULL)
+            {
+              nop->status = -EINVAL;
+              continue;
+            }
+        }
+
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+      if (mop->flags & CRYPT_MOP_F_ASYNC)
+        {
+          nop->status = cryptodev_check(cse, &nop->op);
+          if (nop->status != 0)
+            {
+              continue;
+            }
+
+          areq = kmm_zalloc(sizeof(struct cryptodev_areq));
+          if (areq == NULL)
+            {
+              nop->status = -ENOMEM;
+              continue;
+            }
+
+          areq->fcr = fcr;
+          areq->opaque = nop->opaque;
+
+          nxmutex_lock(&fcr->lock);
+          if (++fcr->reqid == 0)
+            {
+              fcr->reqid = 1;
+            }
+
+          areq->reqid = fcr->reqid;
+          fcr->npending++;
+          nxmutex_unlock(&fcr->lock);
+
+          /* the request may complete and be collected before
+           * cryptodev_op() returns, so publish the id first.
+           */
+
+          nop->reqid = areq->reqid;
+          nop->status = cryptodev_op(cse, &nop->op, areq);
+          if (nop->status != 0)
+            {
+              nop->reqid = 0;
+              nxmutex_lock(&fcr->lock);
+              cryptodev_unpend(fcr);
+              nxmutex_unlock(&fcr->lock);
+              kmm_free(areq);
+            }
+
+          continue;
+        }
+#endif
+
+      nop->status = cryptodev_op(cse, &nop->op, NULL);
+    }
+
+  return 0;
+}
+
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+/* Drop one pending request and wake up the threads waiting for the last
+ * one.  Called with fcr->lock held.
+ */
+
+static void cryptodev_unpend(FAR struct fcrypt *fcr)
+{
+  if (--fcr->npending == 0)
+    {
+      while (fcr->ndrain > 0)
+        {
+          fcr->ndrain--;
+          nxsem_post(&fcr->drain);
+        }
+    }
+}
+
+/* Completion callback of asynchronous requests, runs on the worker.  The
+ * status is taken the same way as cryptodev_op() does for synchronous
+ * requests.
+ */
+
+int cryptodev_cb(FAR struct cryptop *crp)
+{
+  FAR struct cryptodev_areq *areq = crp->crp_opaque;
+  FAR struct fcrypt *fcr = areq->fcr;
+
+  if (areq->cse->error)
+    {
+      areq->status = areq->cse->error;
+    }
+  else
+    {
+      areq->status = crp->crp_etype;
+    }
+
+  crypto_freereq(crp);
+
+  nxmutex_lock(&fcr->lock);
+  TAILQ_INSERT_TAIL(&fcr->results, areq, next);
+  cryptodev_unpend(fcr);
+  poll_notify(&fcr->fds, 1, POLLIN);
+  nxmutex_unlock(&fcr->lock);
+  return 0;
+}
+
+/* Collect up to cret->count completed asynchronous requests */
+
+static int cryptodev_ret(FAR struct fcrypt *fcr, FAR struct cryptret *cret)
+{
+  FAR struct cryptodev_areq *areq;
+  uint32_t n = 0;
+
+  if (cret->count > 0 && cret->results == NULL)
+    {
+      return -EINVAL;
+    }
+
+  nxmutex_lock(&fcr->lock);
+  while (n < cret->count && (areq = TAILQ_FIRST(&fcr->results)) != NULL)
+    {
+      TAILQ_REMOVE(&fcr->results, areq, next);
+      cret->results[n].reqid = areq->reqid;
+      cret->results[n].status = areq->status;
+      cret->results[n].opaque = areq->opaque;
+      kmm_free(areq);
+      n++;
+    }
+
+  nxmutex_unlock(&fcr->lock);
+  cret->count = n;
+  return 0;
+}
+
+/* Wait until the worker has finished with every queued request */
+
+static void cryptodev_drain(FAR struct fcrypt *fcr)
+{
+  nxmutex_lock(&fcr->lock);
+  while (fcr->npending > 0)
+    {
+      fcr->ndrain++;
+      nxmutex_unlock(&fcr->lock);
+      nxsem_wait_uninterruptible(&fcr->drain);
+      nxmutex_lock(&fcr->lock);
+    }
+
+  nxmutex_unlock(&fcr->lock);
+}
+#endif
+
 int cryptodev_key(FAR struct crypt_kop *kop)
 {
   FAR struct cryptkop *krp = NULL;
@@ -680,7 +958,38 @@ fail:
 static int cryptof_poll(FAR struct file *filep,
                         struct pollfd *fds, bool setup)
 {
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  FAR struct fcrypt *fcr = filep->f_priv;
+  int ret = 0;
+
+  nxmutex_lock(&fcr->lock);
+  if (setup)
+    {
+      if (fcr->fds != NULL)
+        {
+          ret = -EBUSY;
+        }
+      else
+        {
+          fcr->fds = fds;
+          fds->priv = &fcr->fds;
+          if (!TAILQ_EMPTY(&fcr->results))
+            {
+              poll_notify(&fcr->fds, 1, POLLIN);
+            }
+        }
+    }
+  else if (fds->priv != NULL)
+    {
+      *(FAR struct pollfd **)fds->priv = NULL;
+      fds->priv = NULL;
+    }
+
+  nxmutex_unlock(&fcr->lock);
+  return ret;
+#else
   return 0;
+#endif
 }
 
 /* ARGSUSED */
@@ -689,6 +998,19 @@ static int cryptof_close(FAR struct file *filep)
 {
   FAR struct fcrypt *fcr = filep->f_priv;
   FAR struct csession *cse;
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+  FAR struct cryptodev_areq *areq;
+
+  cryptodev_drain(fcr);
+  while ((areq = TAILQ_FIRST(&fcr->results)))
+    {
+      TAILQ_REMOVE(&fcr->results, areq, next);
+      kmm_free(areq);
+    }
+
+  nxsem_destroy(&fcr->drain);
+  nxmutex_destroy(&fcr->lock);
+#endif
 
   while ((cse = TAILQ_FIRST(&fcr->csessions)))
     {
@@ -738,13 +1060,27 @@ static int cryptoioctl(FAR struct file *filep, int cmd, unsigned long arg)
   switch (cmd)
     {
       case CRIOGET:
-        fcr = kmm_malloc(sizeof(struct fcrypt));
+        fcr = kmm_zalloc(sizeof(struct fcrypt));
+        if (fcr == NULL)
+          {
+            return -ENOMEM;
+          }
+
         TAILQ_INIT(&fcr->csessions);
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+        TAILQ_INIT(&fcr->results);
+        nxmutex_init(&fcr->lock);
+        nxsem_init(&fcr->drain, 0, 0);
+#endif
 
         fd = file_allocate(&g_cryptoinode, 0,
                            0, fcr, 0, true);
         if (fd < 0)
           {
+#ifdef CONFIG_CRYPTO_CRYPTODEV_ASYNC
+            nxsem_destroy(&fcr->drain);
+            nxmutex_destroy(&fcr->lock);
+#endif
             kmm_free(fcr);
             return fd;
           }
@@ -33,6 +33,7 @@
 
 #include <nuttx/mutex.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/drivers/drivers.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -40,22 +41,56 @@
 
 #define MAX_OPENCNT       (255)                  /* Limit of uint8_t */
 
+#ifndef CONFIG_BCH_CACHE_NSECTORS
+#  define CONFIG_BCH_CACHE_NSECTORS 1
+#endif
+
+#ifndef CONFIG_BCH_CACHE_READAHEAD
+#  define CONFIG_BCH_CACHE_READAHEAD 0
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* One entry of the sector cache */
+
+struct bchlib_sector_s
+{
+  size_t sector;           /* The sector in the buffer, -1: Entry is free */
+  uint32_t stamp;          /* LRU time stamp of the last access */
+  bool dirty;              /* true: Data has been written to the buffer */
+  bool prefetched;         /* true: Read ahead and not yet accessed */
+  FAR uint8_t *buffer;     /* One sector buffer */
+};
+
 struct bchlib_s
 {
   FAR struct inode *inode; /* I-node of the block driver */
   uint32_t sectsize;       /* The size of one sector on the device */
   size_t nsectors;         /* Number of sectors supported by the device */
-  size_t sector;           /* The current sector in the buffer */
   mutex_t lock;            /* For atomic accesses to this structure */
   uint8_t refs;            /* Number of references */
-  bool dirty;              /* true: Data has been written to the buffer */
   bool readonly;           /* true: Only read operations are supported */
   bool unlinked;           /* true: The driver has been unlinked */
-  FAR uint8_t *buffer;     /* One sector buffer */
+  uint32_t clock;          /* LRU clock, advanced on each cache access */
+  FAR uint8_t *buffer;     /* Sector buffers of all cache entries */
+
+  /* The most recently accessed cache entry */
+
+  FAR struct bchlib_sector_s *current;
+
+#if CONFIG_BCH_CACHE_READAHEAD > 1
+  size_t nextmiss;         /* Expected miss of a sequential access */
+#endif
+#if CONFIG_BCH_CACHE_READAHEAD > 0
+  FAR uint8_t *rabuffer;   /* Read-ahead and write-back staging buffer */
+#endif
+
+  /* Cache statistics and entries */
+
+  struct bchlib_stats_s stats;
+  struct bchlib_sector_s cache[CONFIG_BCH_CACHE_NSECTORS];
 
 #if defined(CONFIG_BCH_ENCRYPTION)
   uint8_t key[CONFIG_BCH_ENCRYPTION_KEY_SIZE];  /* Encryption key */
@@ -83,6 +118,10 @@ EXTERN const struct file_operations g_bch_fops;
 
 EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch, bool discard);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
+EXTERN void bchlib_cacheread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                             size_t sector, size_t nsectors);
+EXTERN void bchlib_cacheinvalidate(FAR struct bchlib_s *bch, size_t sector,
+                                   size_t nsectors);
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -424,7 +424,38 @@ static int bch_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
         {
           /* Flush any dirty pages remaining in the cache */
 
+          ret = nxmutex_lock(&bch->lock);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
           ret = bchlib_flushsector(bch, false);
+          nxmutex_unlock(&bch->lock);
+        }
+        break;
+
+      /* This is a request to return the sector cache statistics */
+
+      case BIOC_CACHESTATS:
+        {
+          FAR struct bchlib_stats_s *stats =
+            (FAR struct bchlib_stats_s *)((uintptr_t)arg);
+
+          if (stats == NULL)
+            {
+              ret = -EINVAL;
+              break;
+            }
+
+          ret = nxmutex_lock(&bch->lock);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          memcpy(stats, &bch->stats, sizeof(struct bchlib_stats_s));
+          nxmutex_unlock(&bch->lock);
         }
         break;
 
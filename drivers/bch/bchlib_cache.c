@@ -25,7 +25,9 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/param.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -59,10 +61,11 @@ static void bch_xor(uint32_t *R, uint32_t *A, uint32_t *B)
  ****************************************************************************/
 
 #if defined(CONFIG_BCH_ENCRYPTION)
-static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
+static int bch_cypher(FAR struct bchlib_s *bch, FAR uint8_t *data,
+                      size_t sector, int encrypt)
 {
   int blocks = bch->sectsize / 16;
-  FAR uint32_t *buffer = (FAR uint32_t *)bch->buffer;
+  FAR uint32_t *buffer = (FAR uint32_t *)data;
   int i;
 
   for (i = 0; i < blocks; i++, buffer += 16 / sizeof(uint32_t) )
@@ -70,7 +73,7 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
       uint32_t T[4];
       uint32_t X[4] =
       {
-        bch->sector, 0, 0, i
+        sector, 0, 0, i
       };
 
       aes_cypher(X, X, 16, NULL, bch->key, CONFIG_BCH_ENCRYPTION_KEY_SIZE,
@@ -89,74 +92,358 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
 #endif
 
 /****************************************************************************
- * Public Functions
+ * Name: bchlib_findsector
+ *
+ * Description:
+ *   Return the cache entry holding 'sector' or NULL if it is not cached
+ *
  ****************************************************************************/
 
+static FAR struct bchlib_sector_s *
+bchlib_findsector(FAR struct bchlib_s *bch, size_t sector)
+{
+  int i;
+
+  if (bch->current != NULL && bch->current->sector == sector)
+    {
+      return bch->current;
+    }
+
+  for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+    {
+      if (bch->cache[i].sector == sector)
+        {
+          return &bch->cache[i];
+        }
+    }
+
+  return NULL;
+}
+
 /****************************************************************************
- * Name: bchlib_flushsector
+ * Name: bchlib_touchsector
  *
  * Description:
- *   Flush the current contents of the sector buffer (if dirty)
+ *   Make 'entry' the most recently used entry of the cache
  *
- * Assumptions:
- *   Caller must assume mutual exclusion
+ ****************************************************************************/
+
+static void bchlib_touchsector(FAR struct bchlib_s *bch,
+                               FAR struct bchlib_sector_s *entry)
+{
+  entry->stamp = ++bch->clock;
+  bch->current = entry;
+}
+
+/****************************************************************************
+ * Name: bchlib_writeback
+ *
+ * Description:
+ *   Write one dirty cache entry back to the media
  *
  ****************************************************************************/
 
-int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
+static int bchlib_writeback(FAR struct bchlib_s *bch,
+                            FAR struct bchlib_sector_s *entry)
 {
-  FAR struct inode *inode;
-  ssize_t ret = OK;
+  FAR struct inode *inode = bch->inode;
+  ssize_t ret;
 
-  /* Check if the sector has been modified and is out of synch with the
-   * media.
-   */
+#if defined(CONFIG_BCH_ENCRYPTION)
+  /* Encrypt data as necessary */
+
+  bch_cypher(bch, entry->buffer, entry->sector, CYPHER_ENCRYPT);
+#endif
+
+  /* Write the sector to the media */
+
+  ret = inode->u.i_bops->write(inode, entry->buffer, entry->sector, 1);
+
+#if defined(CONFIG_BCH_ENCRYPTION)
+  /* Computation overhead to save memory for extra sector buffer */
+
+  bch_cypher(bch, entry->buffer, entry->sector, CYPHER_DECRYPT);
+#endif
+
+  if (ret < 0)
+    {
+      ferr("Write failed: %zd\n", ret);
+      return (int)ret;
+    }
+
+  /* The sector is now in sync with the media */
+
+  entry->dirty = false;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_writerun
+ *
+ * Description:
+ *   Write the dirty entry 'first' together with the dirty entries of the
+ *   sectors immediately following it back to the media with one request.
+ *
+ ****************************************************************************/
+
+#if CONFIG_BCH_CACHE_READAHEAD > 0
+static int bchlib_writerun(FAR struct bchlib_s *bch,
+                           FAR struct bchlib_sector_s *first)
+{
+  FAR struct inode *inode = bch->inode;
+  FAR struct bchlib_sector_s *entry = first;
+  FAR uint8_t *dest;
+  size_t nsectors = 0;
+  size_t i;
+  ssize_t ret;
+
+  /* Gather the run into the staging buffer */
 
-  if (bch->dirty)
+  do
     {
-      inode = bch->inode;
+      dest = bch->rabuffer + nsectors * bch->sectsize;
+      memcpy(dest, entry->buffer, bch->sectsize);
 
 #if defined(CONFIG_BCH_ENCRYPTION)
-      /* Encrypt data as necessary */
+      bch_cypher(bch, dest, entry->sector, CYPHER_ENCRYPT);
+#endif
+
+      if (++nsectors >= CONFIG_BCH_CACHE_READAHEAD)
+        {
+          break;
+        }
+
+      entry = bchlib_findsector(bch, first->sector + nsectors);
+    }
+  while (entry != NULL && entry->dirty);
+
+  ret = inode->u.i_bops->write(inode, bch->rabuffer, first->sector,
+                               nsectors);
+  if (ret < 0)
+    {
+      ferr("Write failed: %zd\n", ret);
+      return (int)ret;
+    }
 
-      bch_cypher(bch, CYPHER_ENCRYPT);
+  /* The run is now in sync with the media */
+
+  for (i = 1; i < nsectors; i++)
+    {
+      bchlib_findsector(bch, first->sector + i)->dirty = false;
+    }
+
+  first->dirty = false;
+  bch->stats.writebacks += nsectors;
+  bch->stats.writes++;
+  return OK;
+}
 #endif
 
-      /* Write the sector to the media */
+/****************************************************************************
+ * Name: bchlib_allocsector
+ *
+ * Description:
+ *   Return a free cache entry, evicting the least recently used entry if
+ *   there is none.  A dirty victim is written back first.
+ *
+ ****************************************************************************/
+
+static int bchlib_allocsector(FAR struct bchlib_s *bch,
+                              FAR struct bchlib_sector_s **entry)
+{
+  FAR struct bchlib_sector_s *victim = &bch->cache[0];
+  int ret;
+  int i;
+
+  for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+    {
+      if (bch->cache[i].sector == (size_t)-1)
+        {
+          victim = &bch->cache[i];
+          break;
+        }
+
+      if ((int32_t)(bch->cache[i].stamp - victim->stamp) < 0)
+        {
+          victim = &bch->cache[i];
+        }
+    }
 
-      ret = inode->u.i_bops->write(inode, bch->buffer, bch->sector, 1);
+  if (victim->dirty)
+    {
+      ret = bchlib_writeback(bch, victim);
       if (ret < 0)
         {
-          ferr("Write failed: %zd\n", ret);
-          return (int)ret;
+          return ret;
         }
 
+      bch->stats.evictions++;
+    }
+
+  if (bch->current == victim)
+    {
+      bch->current = NULL;
+    }
+
+  victim->sector     = (size_t)-1;
+  victim->prefetched = false;
+  *entry             = victim;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_readahead
+ *
+ * Description:
+ *   Read 'sector' and the sectors following it into the cache with one
+ *   request.  Sectors that are already cached are left untouched since the
+ *   cached copy may be newer than the media.
+ *
+ ****************************************************************************/
+
+#if CONFIG_BCH_CACHE_READAHEAD > 1
+static int bchlib_readahead(FAR struct bchlib_s *bch, size_t sector)
+{
+  FAR struct inode *inode = bch->inode;
+  FAR struct bchlib_sector_s *entry;
+  size_t nsectors;
+  size_t i;
+  ssize_t ret;
+
+  nsectors = MIN(CONFIG_BCH_CACHE_READAHEAD, CONFIG_BCH_CACHE_NSECTORS);
+  nsectors = MIN(nsectors, bch->nsectors - sector);
+
+  ret = inode->u.i_bops->read(inode, bch->rabuffer, sector, nsectors);
+  if (ret < 0)
+    {
+      ferr("Read failed: %zd\n", ret);
+      return (int)ret;
+    }
+
 #if defined(CONFIG_BCH_ENCRYPTION)
-      /* Computation overhead to save memory for extra sector buffer
-       * TODO: Add configuration switch for extra sector buffer
-       */
+  for (i = 0; i < nsectors; i++)
+    {
+      bch_cypher(bch, bch->rabuffer + i * bch->sectsize, sector + i,
+                 CYPHER_DECRYPT);
+    }
+#endif
 
-      bch_cypher(bch, CYPHER_DECRYPT);
+  /* Dirty entries of the range may be evicted while filling the cache, so
+   * the staging buffer must hold their newer contents.
+   */
+
+  bchlib_cacheread(bch, bch->rabuffer, sector, nsectors);
+
+  /* Fill the cache backwards so that the requested sector ends up as the
+   * most recently used entry.
+   */
+
+  for (i = nsectors; i-- > 0; )
+    {
+      if (i > 0 && bchlib_findsector(bch, sector + i) != NULL)
+        {
+          continue;
+        }
+
+      ret = bchlib_allocsector(bch, &entry);
+      if (ret < 0)
+        {
+          return (int)ret;
+        }
+
+      memcpy(entry->buffer, bch->rabuffer + i * bch->sectsize,
+             bch->sectsize);
+      entry->sector     = sector + i;
+      entry->dirty      = false;
+      entry->prefetched = i > 0;
+      bchlib_touchsector(bch, entry);
+
+      if (i > 0)
+        {
+          bch->stats.readahead++;
+        }
+    }
+
+  bch->nextmiss = sector + nsectors;
+  return OK;
+}
 #endif
 
-      /* The sector is now in sync with the media */
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bchlib_flushsector
+ *
+ * Description:
+ *   Write all dirty sectors of the cache back to the media in ascending
+ *   sector order.  Runs of consecutive sectors are coalesced into a single
+ *   request when a staging buffer is configured.  If 'discard' is true, the
+ *   cache is emptied as well.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
+{
+  FAR struct bchlib_sector_s *first;
+  int ret;
+  int i;
+
+  for (; ; )
+    {
+      /* Find the dirty sector with the lowest sector number */
+
+      first = NULL;
+      for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+        {
+          if (bch->cache[i].dirty &&
+              (first == NULL || bch->cache[i].sector < first->sector))
+            {
+              first = &bch->cache[i];
+            }
+        }
+
+      if (first == NULL)
+        {
+          break;
+        }
+
+#if CONFIG_BCH_CACHE_READAHEAD > 0
+      ret = bchlib_writerun(bch, first);
+#else
+      ret = bchlib_writeback(bch, first);
+      if (ret >= 0)
+        {
+          bch->stats.writebacks++;
+          bch->stats.writes++;
+        }
+#endif
 
-      bch->dirty = false;
+      if (ret < 0)
+        {
+          ferr("Flush failed: %d\n", ret);
+          return ret;
+        }
     }
 
   if (discard)
     {
-      bch->sector = (size_t)-1;
+      bchlib_cacheinvalidate(bch, 0, bch->nsectors);
     }
 
-  return (int)ret;
+  return OK;
 }
 
 /****************************************************************************
  * Name: bchlib_readsector
  *
  * Description:
- *   Read the current sector contents into buffer
+ *   Make the sector contents available in the cache.  On success,
+ *   bch->current refers to the cache entry holding the sector.
  *
  * Assumptions:
  *   Caller must assume mutual exclusion
@@ -165,32 +452,126 @@ int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
 
 int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 {
+  FAR struct bchlib_sector_s *entry;
   FAR struct inode *inode;
-  ssize_t ret = OK;
+  ssize_t ret;
 
-  if (bch->sector != sector)
+  entry = bchlib_findsector(bch, sector);
+  if (entry != NULL)
     {
-      inode = bch->inode;
-
-      ret = bchlib_flushsector(bch, true);
-      if (ret < 0)
+      if (entry->prefetched)
         {
-          ferr("Flush failed: %zd\n", ret);
-          return (int)ret;
+          entry->prefetched = false;
+          bch->stats.rahits++;
         }
 
-      ret = inode->u.i_bops->read(inode, bch->buffer, sector, 1);
-      if (ret < 0)
-        {
-          ferr("Read failed: %zd\n", ret);
-          return (int)ret;
-        }
+      bch->stats.hits++;
+      bchlib_touchsector(bch, entry);
+      return OK;
+    }
+
+  bch->stats.misses++;
+
+#if CONFIG_BCH_CACHE_READAHEAD > 1
+  /* A miss right behind the previous one indicates sequential access */
+
+  if (sector == bch->nextmiss)
+    {
+      return bchlib_readahead(bch, sector);
+    }
+
+  bch->nextmiss = sector + 1;
+#endif
+
+  ret = bchlib_allocsector(bch, &entry);
+  if (ret < 0)
+    {
+      return (int)ret;
+    }
+
+  inode = bch->inode;
+  ret = inode->u.i_bops->read(inode, entry->buffer, sector, 1);
+  if (ret < 0)
+    {
+      ferr("Read failed: %zd\n", ret);
+      return (int)ret;
+    }
 
-      bch->sector = sector;
 #if defined(CONFIG_BCH_ENCRYPTION)
-      bch_cypher(bch, CYPHER_DECRYPT);
+  bch_cypher(bch, entry->buffer, sector, CYPHER_DECRYPT);
 #endif
+
+  entry->sector = sector;
+  entry->dirty  = false;
+  bchlib_touchsector(bch, entry);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_cacheread
+ *
+ * Description:
+ *   Overlay the dirty cached sectors in the range 'sector' through
+ *   'sector' + 'nsectors' - 1 onto 'buffer', which holds the same range as
+ *   just read directly from the media.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_cacheread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                      size_t sector, size_t nsectors)
+{
+  FAR struct bchlib_sector_s *entry;
+  int i;
+
+  for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+    {
+      entry = &bch->cache[i];
+      if (entry->dirty && entry->sector >= sector &&
+          entry->sector - sector < nsectors)
+        {
+          memcpy(buffer + (entry->sector - sector) * bch->sectsize,
+                 entry->buffer, bch->sectsize);
+        }
     }
+}
 
-  return (int)ret;
+/****************************************************************************
+ * Name: bchlib_cacheinvalidate
+ *
+ * Description:
+ *   Drop the cached sectors in the range 'sector' through
+ *   'sector' + 'nsectors' - 1 without writing them back.  Used once the
+ *   range has been overwritten directly on the media, and to discard the
+ *   whole cache.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_cacheinvalidate(FAR struct bchlib_s *bch, size_t sector,
+                            size_t nsectors)
+{
+  FAR struct bchlib_sector_s *entry;
+  int i;
+
+  for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+    {
+      entry = &bch->cache[i];
+      if (entry->sector != (size_t)-1 && entry->sector >= sector &&
+          entry->sector - sector < nsectors)
+        {
+          if (bch->current == entry)
+            {
+              bch->current = NULL;
+            }
+
+          entry->sector     = (size_t)-1;
+          entry->dirty      = false;
+          entry->prefetched = false;
+        }
+    }
 }
@@ -118,7 +118,7 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, size_t offset,
           nbytes = len;
         }
 
-      memcpy(buffer, &bch->buffer[sectoffset], nbytes);
+      memcpy(buffer, &bch->current->buffer[sectoffset], nbytes);
 
       /* Adjust pointers and counts */
 
@@ -154,6 +154,10 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, size_t offset,
           return ret;
         }
 
+      /* The cache may hold newer data than the media */
+
+      bchlib_cacheread(bch, (FAR uint8_t *)buffer, sector, nsectors);
+
       /* Adjust pointers and counts */
 
       sector    += nsectors;
@@ -183,7 +187,7 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, size_t offset,
 
       /* Copy the head end of the sector to the user buffer */
 
-      memcpy(buffer, bch->buffer, len);
+      memcpy(buffer, bch->current->buffer, len);
 
       /* Adjust counts */
 
@@ -58,6 +58,7 @@ int bchlib_setup(const char *blkdev, bool readonly, FAR void **handle)
   FAR struct bchlib_s *bch;
   struct geometry geo;
   int ret;
+  int i;
 
   DEBUGASSERT(blkdev);
 
@@ -108,15 +109,15 @@ int bchlib_setup(const char *blkdev, bool readonly, FAR void **handle)
   nxmutex_init(&bch->lock);
   bch->nsectors = geo.geo_nsectors;
   bch->sectsize = geo.geo_sectorsize;
-  bch->sector   = (size_t)-1;
   bch->readonly = readonly;
 
-  /* Allocate the sector I/O buffer */
+  /* Allocate the sector buffers of the cache */
 
 #if CONFIG_BCH_BUFFER_ALIGNMENT != 0
-  bch->buffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, bch->sectsize);
+  bch->buffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT,
+                             bch->sectsize * CONFIG_BCH_CACHE_NSECTORS);
 #else
-  bch->buffer = kmm_malloc(bch->sectsize);
+  bch->buffer = kmm_malloc(bch->sectsize * CONFIG_BCH_CACHE_NSECTORS);
 #endif
   if (!bch->buffer)
     {
@@ -125,9 +126,43 @@ int bchlib_setup(const char *blkdev, bool readonly, FAR void **handle)
       goto errout_with_bch;
     }
 
+  for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+    {
+      bch->cache[i].sector = (size_t)-1;
+      bch->cache[i].buffer = bch->buffer + i * bch->sectsize;
+    }
+
+  bch->stats.nsectors = CONFIG_BCH_CACHE_NSECTORS;
+
+#if CONFIG_BCH_CACHE_READAHEAD > 1
+  bch->nextmiss = (size_t)-1;
+#endif
+
+#if CONFIG_BCH_CACHE_READAHEAD > 0
+  /* Allocate the read-ahead and write-back staging buffer */
+
+#  if CONFIG_BCH_BUFFER_ALIGNMENT != 0
+  bch->rabuffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT,
+                               bch->sectsize * CONFIG_BCH_CACHE_READAHEAD);
+#  else
+  bch->rabuffer = kmm_malloc(bch->sectsize * CONFIG_BCH_CACHE_READAHEAD);
+#  endif
+  if (!bch->rabuffer)
+    {
+      ferr("ERROR: Failed to allocate staging buffer\n");
+      ret = -ENOMEM;
+      goto errout_with_buffer;
+    }
+#endif
+
   *handle = bch;
   return OK;
 
+#if CONFIG_BCH_CACHE_READAHEAD > 0
+errout_with_buffer:
+  kmm_free(bch->buffer);
+#endif
+
 errout_with_bch:
   kmm_free(bch);
   return ret;
@@ -102,8 +102,8 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset,
           nbytes = len;
         }
 
-      memcpy(&bch->buffer[sectoffset], buffer, nbytes);
-      bch->dirty = true;
+      memcpy(&bch->current->buffer[sectoffset], buffer, nbytes);
+      bch->current->dirty = true;
 
       /* Adjust pointers and counts */
 
@@ -131,16 +131,6 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset,
           nsectors = bch->nsectors - sector;
         }
 
-      /* Flush the dirty sector to keep the sector sequence */
-
-      ret = bchlib_flushsector(bch, sector <= bch->sector &&
-                               bch->sector < (sector + nsectors));
-      if (ret < 0)
-        {
-          ferr("ERROR: Flush failed: %d\n", ret);
-          return ret;
-        }
-
       /* Write the contiguous sectors */
 
       ret = bch->inode->u.i_bops->write(bch->inode, (FAR uint8_t *)buffer,
@@ -151,6 +141,13 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset,
           return ret;
         }
 
+      /* Cached copies of these sectors are superseded by this write.  They
+       * are only dropped once it has succeeded, so dirty sectors are not
+       * lost if it fails.
+       */
+
+      bchlib_cacheinvalidate(bch, sector, nsectors);
+
       /* Adjust pointers and counts */
 
       sector       += nsectors;
@@ -180,8 +177,8 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset,
 
       /* Copy the head end of the sector from the user buffer */
 
-      memcpy(bch->buffer, buffer, len);
-      bch->dirty = true;
+      memcpy(bch->current->buffer, buffer, len);
+      bch->current->dirty = true;
 
       /* Adjust counts */
 
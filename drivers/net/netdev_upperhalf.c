@@ -34,9 +34,11 @@
 #include <nuttx/kthread.h>
 #include <nuttx/mm/iob.h>
 #include <nuttx/net/can.h>
+#include <nuttx/net/ip.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev_lowerhalf.h>
 #include <nuttx/net/pkt.h>
+#include <nuttx/net/tcp.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/spinlock.h>
 
@@ -54,6 +56,18 @@
 #  define NETDEV_WORK LPWORK
 #endif
 
+#ifdef CONFIG_NETDEV_WORK_QUEUE
+#  define netdev_upper_work_queue(upper, worker) \
+     work_queue_wq((upper)->wqueue, &(upper)->work, worker, upper, 0)
+#  define netdev_upper_work_cancel(upper) \
+     work_cancel_wq((upper)->wqueue, &(upper)->work)
+#else
+#  define netdev_upper_work_queue(upper, worker) \
+     work_queue(NETDEV_WORK, &(upper)->work, worker, upper, 0)
+#  define netdev_upper_work_cancel(upper) \
+     work_cancel(NETDEV_WORK, &(upper)->work)
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -71,8 +85,19 @@ struct netdev_upperhalf_s
   sem_t sem;
   sem_t sem_exit;
 #else
+#  ifdef CONFIG_NETDEV_WORK_QUEUE
+  FAR struct kwork_wqueue_s *wqueue;
+#  endif
   struct work_s work;
 #endif
+
+#ifdef CONFIG_NETDEV_GRO
+  /* TCP packet being coalesced, see netdev_upper_gro() */
+
+  FAR netpkt_t *gro_pkt;
+  uint16_t      gro_segs;     /* Number of segments in gro_pkt */
+  uint16_t      gro_mss;      /* Payload length of its first segment */
+#endif
 };
 
 /****************************************************************************
@@ -227,6 +252,235 @@ static inline bool netdev_upper_can_tx(FAR struct netdev_upperhalf_s *upper)
   return netdev_lower_quota_load(upper->lower, NETPKT_TX) > 0;
 }
 
+/****************************************************************************
+ * Name: netdev_upper_xmit
+ *
+ * Description:
+ *   Hand the packet in d_iob to the lower half for transmission.
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX driver state structure
+ *
+ * Returned Value:
+ *   Negated errno value - Error number that occurs.
+ *   OK                  - Driver can send more, continue the poll.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+static int netdev_upper_xmit(FAR struct net_driver_s *dev)
+{
+  FAR struct netdev_upperhalf_s *upper = dev->d_private;
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  FAR netpkt_t                  *pkt;
+  int                            ret;
+
+  pkt = netpkt_get(dev, NETPKT_TX);
+
+  netdev_lock(dev);
+  ret = lower->ops->transmit(lower, pkt);
+  netdev_unlock(dev);
+
+  if (ret != OK)
+    {
+      /* Stop polling on any error
+       * REVISIT: maybe store the pkt in upper half and retry later?
+       */
+
+      NETDEV_TXERRORS(dev);
+      netpkt_put(dev, pkt, NETPKT_TX);
+      return ret;
+    }
+
+  return NETDEV_TX_CONTINUE;
+}
+
+#if defined(CONFIG_NETDEV_GSO) || defined(CONFIG_NETDEV_GRO)
+
+/****************************************************************************
+ * Name: netdev_upper_pseudo_chksum
+ *
+ * Description:
+ *   Sum the pseudo-header of the TCP packet in iob, the IP header of which
+ *   is iplen bytes long.
+ *
+ ****************************************************************************/
+
+static uint16_t netdev_upper_pseudo_chksum(FAR struct iob_s *iob,
+                                           unsigned int iplen)
+{
+  FAR uint8_t *ip = IOB_DATA(iob);
+  uint16_t sum = iob->io_pktlen - iplen + IP_PROTO_TCP;
+
+#ifdef CONFIG_NET_IPv4
+  if ((ip[0] & 0xf0) == IPv4_VERSION)
+    {
+      return chksum(sum,
+                    (FAR uint8_t *)((FAR struct ipv4_hdr_s *)ip)->srcipaddr,
+                    2 * sizeof(in_addr_t));
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  sum = chksum(sum,
+               (FAR uint8_t *)((FAR struct ipv6_hdr_s *)ip)->srcipaddr,
+               2 * sizeof(net_ipv6addr_t));
+#endif
+
+  return sum;
+}
+
+#endif /* CONFIG_NETDEV_GSO || CONFIG_NETDEV_GRO */
+
+#ifdef CONFIG_NETDEV_GSO
+
+/****************************************************************************
+ * Name: netdev_upper_gso_xmit
+ *
+ * Description:
+ *   Cut the TCP super-segment in d_iob in segments of io_gsosize bytes of
+ *   payload and transmit them one by one, for the devices that cannot do
+ *   it (no NETDEV_F_TSO).  Like netpkt_get(), the segments of a
+ *   super-segment may temporarily exceed the TX quota.
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX driver state structure
+ *
+ * Returned Value:
+ *   Negated errno value - Error number that occurs.
+ *   OK                  - Driver can send more, continue the poll.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+static int netdev_upper_gso_xmit(FAR struct net_driver_s *dev)
+{
+  FAR struct iob_s     *super    = dev->d_iob;
+  unsigned int          llhdrlen = NET_LL_HDRLEN(dev);
+  unsigned int          iplen    = super->io_csumstart - llhdrlen;
+  FAR struct tcp_hdr_s *tcp;
+  FAR struct iob_s     *seg;
+  unsigned int          hdrlen;
+  unsigned int          paylen;
+  unsigned int          offset;
+  unsigned int          len;
+  unsigned int          nseg;
+  uint16_t              sum;
+  int                   ret = NETDEV_TX_CONTINUE;
+
+  tcp    = (FAR struct tcp_hdr_s *)(IOB_DATA(super) + iplen);
+  hdrlen = iplen + ((tcp->tcpoffset >> 4) << 2);
+  paylen = super->io_pktlen - hdrlen;
+
+  DEBUGASSERT(super->io_len >= hdrlen && super->io_gsosize > 0);
+
+  /* The segments take the place of the super-segment in d_iob */
+
+  netdev_iob_clear(dev);
+
+  for (offset = 0, nseg = 0; offset < paylen && ret == NETDEV_TX_CONTINUE;
+       offset += len, nseg++)
+    {
+      len = MIN(paylen - offset, super->io_gsosize);
+
+      seg = iob_tryalloc(false);
+      if (seg == NULL)
+        {
+          ret = -ENOMEM;
+          break;
+        }
+
+      /* Copy the link layer header in the guard area, then the IP and TCP
+       * headers and the payload of the segment.
+       */
+
+      iob_reserve(seg, CONFIG_NET_LL_GUARDSIZE);
+      memcpy(IOB_DATA(seg) - llhdrlen, IOB_DATA(super) - llhdrlen,
+             llhdrlen);
+
+      if (iob_trycopyin(seg, IOB_DATA(super), hdrlen, 0, false) < 0 ||
+          iob_clone_partial(super, len, hdrlen + offset, seg, hdrlen,
+                            false, false) < 0)
+        {
+          iob_free_chain(seg);
+          ret = -ENOMEM;
+          break;
+        }
+
+      /* Fix the IP header for the length of the segment */
+
+#ifdef CONFIG_NET_IPv4
+      if ((super->io_pktflags & NETPKT_F_GSO_TCPV4) != 0)
+        {
+          FAR struct ipv4_hdr_s *ipv4 =
+            (FAR struct ipv4_hdr_s *)IOB_DATA(seg);
+          uint16_t ipid = ((uint16_t)ipv4->ipid[0] << 8) + ipv4->ipid[1];
+
+          ipid           += nseg;
+          ipv4->len[0]    = seg->io_pktlen >> 8;
+          ipv4->len[1]    = seg->io_pktlen & 0xff;
+          ipv4->ipid[0]   = ipid >> 8;
+          ipv4->ipid[1]   = ipid & 0xff;
+          ipv4->ipchksum  = 0;
+          ipv4->ipchksum  = ~ipv4_chksum(ipv4);
+        }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+      if ((super->io_pktflags & NETPKT_F_GSO_TCPV6) != 0)
+        {
+          FAR struct ipv6_hdr_s *ipv6 =
+            (FAR struct ipv6_hdr_s *)IOB_DATA(seg);
+
+          ipv6->len[0] = (seg->io_pktlen - IPv6_HDRLEN) >> 8;
+          ipv6->len[1] = (seg->io_pktlen - IPv6_HDRLEN) & 0xff;
+        }
+#endif
+
+      /* Then the TCP header:  only the last segment keeps FIN and PSH */
+
+      tcp = (FAR struct tcp_hdr_s *)(IOB_DATA(seg) + iplen);
+      net_incr32(tcp->seqno, offset);
+
+      if (offset + len < paylen)
+        {
+          tcp->flags &= ~(TCP_FIN | TCP_PSH);
+        }
+
+      /* Leave the checksum to the device if it can, else compute it */
+
+      sum = netdev_upper_pseudo_chksum(seg, iplen);
+
+      if ((dev->d_features & NETDEV_F_TXCSUM) != 0)
+        {
+          tcp->tcpchksum    = HTONS(sum);
+          seg->io_pktflags  = NETPKT_F_CSUM_PARTIAL;
+          seg->io_csumstart = super->io_csumstart;
+          seg->io_csumoff   = super->io_csumoff;
+        }
+      else
+        {
+          tcp->tcpchksum = 0;
+          sum            = chksum_iob(sum, seg, iplen);
+          tcp->tcpchksum = ~((sum == 0) ? 0xffff : HTONS(sum));
+        }
+
+      dev->d_iob = seg;
+      dev->d_len = seg->io_pktlen + llhdrlen;
+
+      ret = netdev_upper_xmit(dev);
+    }
+
+  iob_free_chain(super);
+  return ret;
+}
+
+#endif /* CONFIG_NETDEV_GSO */
+
 /****************************************************************************
  * Name: netdev_upper_txpoll
  *
@@ -254,11 +508,6 @@ static inline bool netdev_upper_can_tx(FAR struct netdev_upperhalf_s *upper)
 
 static int netdev_upper_txpoll(FAR struct net_driver_s *dev)
 {
-  FAR struct netdev_upperhalf_s *upper = dev->d_private;
-  FAR struct netdev_lowerhalf_s *lower = upper->lower;
-  FAR netpkt_t                  *pkt;
-  int                            ret;
-
   DEBUGASSERT(dev->d_len > 0);
 
   NETDEV_TXPACKETS(dev);
@@ -269,21 +518,17 @@ static int netdev_upper_txpoll(FAR struct net_driver_s *dev)
   pkt_input(dev);
 #endif
 
-  pkt = netpkt_get(dev, NETPKT_TX);
-  ret = lower->ops->transmit(lower, pkt);
+#ifdef CONFIG_NETDEV_GSO
+  /* Cut the TCP super-segments the device cannot cut itself */
 
-  if (ret != OK)
+  if ((dev->d_iob->io_pktflags & NETPKT_F_GSO) != 0 &&
+      (dev->d_features & NETDEV_F_TSO) == 0)
     {
-      /* Stop polling on any error
-       * REVISIT: maybe store the pkt in upper half and retry later?
-       */
-
-      NETDEV_TXERRORS(dev);
-      netpkt_put(dev, pkt, NETPKT_TX);
-      return ret;
+      return netdev_upper_gso_xmit(dev);
     }
+#endif
 
-  return NETDEV_TX_CONTINUE;
+  return netdev_upper_xmit(dev);
 }
 
 /****************************************************************************
@@ -296,7 +541,7 @@ static int netdev_upper_txpoll(FAR struct net_driver_s *dev)
  *   upper - Reference to the upper half driver structure
  *
  * Assumptions:
- *   Called with the network locked.
+ *   Called from the work of the device, without any lock.
  *
  ****************************************************************************/
 
@@ -309,8 +554,11 @@ static void netdev_upper_txavail_work(FAR struct netdev_upperhalf_s *upper)
   if (IFF_IS_UP(dev->d_flags))
     {
       DEBUGASSERT(dev->d_buf == NULL); /* Make sure: IOB only. */
+
+      net_lock();
       while (netdev_upper_can_tx(upper) &&
              devif_poll(dev, netdev_upper_txpoll) == NETDEV_TX_CONTINUE);
+      net_unlock();
     }
 }
 
@@ -396,6 +644,376 @@ static void eth_input(FAR struct net_driver_s *dev)
 }
 #endif
 
+/****************************************************************************
+ * Name: netdev_upper_input
+ *
+ * Description:
+ *   Pass a received packet into the network stack.
+ *
+ * Input Parameters:
+ *   upper - Reference to the upper half driver structure
+ *   pkt   - The received packet
+ *
+ ****************************************************************************/
+
+static void netdev_upper_input(FAR struct netdev_upperhalf_s *upper,
+                               FAR netpkt_t *pkt)
+{
+  FAR struct net_driver_s *dev = &upper->lower->netdev;
+
+  net_lock();
+  netpkt_put(dev, pkt, NETPKT_RX);
+
+#ifdef CONFIG_NET_PKT
+  /* When packet sockets are enabled, feed the frame into the tap */
+
+  pkt_input(dev);
+#endif
+
+  switch (dev->d_lltype)
+    {
+#ifdef CONFIG_NET_LOOPBACK
+    case NET_LL_LOOPBACK:
+#endif
+#ifdef CONFIG_NET_ETHERNET
+    case NET_LL_ETHERNET:
+#endif
+#ifdef CONFIG_DRIVERS_IEEE80211
+    case NET_LL_IEEE80211:
+#endif
+#if defined(CONFIG_NET_LOOPBACK) || defined(CONFIG_NET_ETHERNET) || \
+    defined(CONFIG_DRIVERS_IEEE80211)
+      eth_input(dev);
+      break;
+#endif
+#ifdef CONFIG_NET_CAN
+    case NET_LL_CAN:
+      ninfo("CAN frame");
+      can_input(dev);
+      break;
+#endif
+    default:
+      nerr("Unknown link type %d\n", dev->d_lltype);
+      break;
+    }
+
+  net_unlock();
+}
+
+#ifdef CONFIG_NETDEV_GRO
+
+/****************************************************************************
+ * Name: netdev_upper_gro_tcp
+ *
+ * Description:
+ *   Tell whether the received packet is a TCP segment that may be
+ *   coalesced:  an unfragmented IP packet without options or extension
+ *   headers, with a valid checksum, carrying data and no other flag than
+ *   ACK and PSH.
+ *
+ * Input Parameters:
+ *   pkt   - The received packet
+ *   iplen - Returns the length of the IP header
+ *
+ * Returned Value:
+ *   The TCP header of the packet, or NULL if it cannot be coalesced.
+ *
+ ****************************************************************************/
+
+static FAR struct tcp_hdr_s *netdev_upper_gro_tcp(FAR netpkt_t *pkt,
+                                                  FAR unsigned int *iplen)
+{
+  FAR uint8_t          *ip  = IOB_DATA(pkt);
+  FAR struct eth_hdr_s *eth = (FAR struct eth_hdr_s *)(ip - ETH_HDRLEN);
+  FAR struct tcp_hdr_s *tcp;
+  unsigned int          hdrlen;
+  unsigned int          len;
+
+#ifdef CONFIG_NET_IPv4
+  if (eth->type == HTONS(ETHTYPE_IP))
+    {
+      FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)ip;
+
+      if (pkt->io_len < IPv4_HDRLEN + TCP_HDRLEN ||
+          ipv4->vhl != (IPv4_VERSION | (IPv4_HDRLEN >> 2)) ||
+          ipv4->proto != IP_PROTO_TCP ||
+          (ipv4->ipoffset[0] & 0x3f) != 0 || ipv4->ipoffset[1] != 0 ||
+          ipv4_chksum(ipv4) != 0xffff)
+        {
+          return NULL;
+        }
+
+      *iplen = IPv4_HDRLEN;
+      len    = ((uint16_t)ipv4->len[0] << 8) + ipv4->len[1];
+    }
+  else
+#endif
+#ifdef CONFIG_NET_IPv6
+  if (eth->type == HTONS(ETHTYPE_IP6))
+    {
+      FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)ip;
+
+      if (pkt->io_len < IPv6_HDRLEN + TCP_HDRLEN ||
+          ipv6->proto != IP_PROTO_TCP)
+        {
+          return NULL;
+        }
+
+      *iplen = IPv6_HDRLEN;
+      len    = IPv6_HDRLEN + ((uint16_t)ipv6->len[0] << 8) + ipv6->len[1];
+    }
+  else
+#endif
+    {
+      return NULL;
+    }
+
+  tcp    = (FAR struct tcp_hdr_s *)(ip + *iplen);
+  hdrlen = *iplen + ((tcp->tcpoffset >> 4) << 2);
+
+  if (hdrlen < *iplen + TCP_HDRLEN || pkt->io_len < hdrlen ||
+      len != pkt->io_pktlen || len <= hdrlen ||
+      (tcp->flags & ~TCP_PSH) != TCP_ACK)
+    {
+      return NULL;
+    }
+
+  /* The checksum of the coalesced packet will not be checked again */
+
+  if ((pkt->io_pktflags & NETPKT_F_CSUM_VALID) == 0)
+    {
+      if (chksum_iob(netdev_upper_pseudo_chksum(pkt, *iplen),
+                     pkt, *iplen) != 0xffff)
+        {
+          return NULL;
+        }
+
+      pkt->io_pktflags = NETPKT_F_CSUM_VALID;
+    }
+
+  return tcp;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_get32
+ *
+ * Description:
+ *   Read a 32-bit value in network order, such as a TCP sequence number.
+ *
+ ****************************************************************************/
+
+static inline uint32_t netdev_upper_get32(FAR const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | p[3];
+}
+
+/****************************************************************************
+ * Name: netdev_upper_gro_follows
+ *
+ * Description:
+ *   Tell whether the received TCP segment may be appended to the held
+ *   packet:  same link layer and IP addresses, same ports, the next
+ *   sequence number, the same acknowledgment, window and options, and no
+ *   more than the MSS of payload.
+ *
+ ****************************************************************************/
+
+static bool netdev_upper_gro_follows(FAR struct netdev_upperhalf_s *upper,
+                                     FAR netpkt_t *pkt, unsigned int iplen)
+{
+  FAR netpkt_t         *held = upper->gro_pkt;
+  FAR struct tcp_hdr_s *htcp;
+  FAR struct tcp_hdr_s *tcp;
+  unsigned int          hdrlen;
+  unsigned int          paylen;
+
+  htcp   = (FAR struct tcp_hdr_s *)(IOB_DATA(held) + iplen);
+  tcp    = (FAR struct tcp_hdr_s *)(IOB_DATA(pkt) + iplen);
+  hdrlen = iplen + ((tcp->tcpoffset >> 4) << 2);
+  paylen = pkt->io_pktlen - hdrlen;
+
+  if ((IOB_DATA(held)[0] & 0xf0) != (IOB_DATA(pkt)[0] & 0xf0) ||
+      htcp->tcpoffset != tcp->tcpoffset || paylen > upper->gro_mss ||
+      held->io_pktlen + paylen > UINT16_MAX - ETH_HDRLEN)
+    {
+      return false;
+    }
+
+  if (memcmp(IOB_DATA(held) - ETH_HDRLEN, IOB_DATA(pkt) - ETH_HDRLEN,
+             2 * ETHER_ADDR_LEN) != 0)
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NET_IPv4
+  if (iplen == IPv4_HDRLEN &&
+      memcmp(((FAR struct ipv4_hdr_s *)IOB_DATA(held))->srcipaddr,
+             ((FAR struct ipv4_hdr_s *)IOB_DATA(pkt))->srcipaddr,
+             2 * sizeof(in_addr_t)) != 0)
+    {
+      return false;
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (iplen == IPv6_HDRLEN &&
+      memcmp(((FAR struct ipv6_hdr_s *)IOB_DATA(held))->srcipaddr,
+             ((FAR struct ipv6_hdr_s *)IOB_DATA(pkt))->srcipaddr,
+             2 * sizeof(net_ipv6addr_t)) != 0)
+    {
+      return false;
+    }
+#endif
+
+  return htcp->srcport == tcp->srcport &&
+         htcp->destport == tcp->destport &&
+         memcmp(htcp->ackno, tcp->ackno, 4) == 0 &&
+         memcmp(htcp->wnd, tcp->wnd, 2) == 0 &&
+         memcmp(htcp->optdata, tcp->optdata,
+                hdrlen - iplen - TCP_HDRLEN) == 0 &&
+         netdev_upper_get32(tcp->seqno) ==
+         netdev_upper_get32(htcp->seqno) + held->io_pktlen - hdrlen;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_gro_flush
+ *
+ * Description:
+ *   Pass the packet being coalesced, if any, into the network stack.
+ *
+ * Input Parameters:
+ *   upper - Reference to the upper half driver structure
+ *
+ ****************************************************************************/
+
+static void netdev_upper_gro_flush(FAR struct netdev_upperhalf_s *upper)
+{
+  FAR netpkt_t *pkt = upper->gro_pkt;
+
+  if (pkt != NULL)
+    {
+      upper->gro_pkt = NULL;
+      netdev_upper_input(upper, pkt);
+    }
+}
+
+/****************************************************************************
+ * Name: netdev_upper_gro
+ *
+ * Description:
+ *   Coalesce a received TCP segment with the previous one if it follows it
+ *   in the same connection.  The coalesced packet is held until a segment
+ *   that does not follow, a PSH flag, a short segment or
+ *   CONFIG_NETDEV_GRO_MAXSEGS segments, or the end of the receive poll.
+ *
+ * Input Parameters:
+ *   upper - Reference to the upper half driver structure
+ *   pkt   - The received packet
+ *
+ * Returned Value:
+ *   The packet to pass into the network stack now, or NULL if there is
+ *   none.
+ *
+ ****************************************************************************/
+
+static FAR netpkt_t *netdev_upper_gro(FAR struct netdev_upperhalf_s *upper,
+                                      FAR netpkt_t *pkt)
+{
+  FAR struct net_driver_s *dev  = &upper->lower->netdev;
+  FAR netpkt_t            *held = upper->gro_pkt;
+  FAR struct tcp_hdr_s    *htcp;
+  FAR struct tcp_hdr_s    *tcp;
+  unsigned int             hdrlen;
+  unsigned int             paylen;
+  unsigned int             iplen;
+  bool                     flush;
+
+  if (dev->d_lltype != NET_LL_ETHERNET ||
+      (dev->d_features & NETDEV_F_GRO) == 0 ||
+      (tcp = netdev_upper_gro_tcp(pkt, &iplen)) == NULL)
+    {
+      netdev_upper_gro_flush(upper);
+      return pkt;
+    }
+
+  hdrlen = iplen + ((tcp->tcpoffset >> 4) << 2);
+  paylen = pkt->io_pktlen - hdrlen;
+
+  /* Does the segment follow the held one, with the same headers? */
+
+  if (held != NULL && !netdev_upper_gro_follows(upper, pkt, iplen))
+    {
+      netdev_upper_gro_flush(upper);
+      held = NULL;
+    }
+
+  flush = (tcp->flags & TCP_PSH) != 0;
+
+  if (held == NULL)
+    {
+      /* Start a new packet with this segment */
+
+      if (flush)
+        {
+          return pkt;
+        }
+
+      upper->gro_pkt  = pkt;
+      upper->gro_segs = 1;
+      upper->gro_mss  = paylen;
+      return NULL;
+    }
+
+  /* Append the payload of the segment to the held packet.  The quota of
+   * the segment is returned now:  the held packet takes it only once.
+   */
+
+  htcp = (FAR struct tcp_hdr_s *)(IOB_DATA(held) + iplen);
+  htcp->flags |= tcp->flags & TCP_PSH;
+
+  if (paylen < upper->gro_mss ||
+      ++upper->gro_segs >= CONFIG_NETDEV_GRO_MAXSEGS)
+    {
+      flush = true;
+    }
+
+  iob_concat(held, iob_trimhead(pkt, hdrlen));
+  quota_fetch_inc(upper->lower, NETPKT_RX);
+
+#ifdef CONFIG_NET_IPv4
+  if (iplen == IPv4_HDRLEN)
+    {
+      FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)IOB_DATA(held);
+
+      ipv4->len[0]   = held->io_pktlen >> 8;
+      ipv4->len[1]   = held->io_pktlen & 0xff;
+      ipv4->ipchksum = 0;
+      ipv4->ipchksum = ~ipv4_chksum(ipv4);
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (iplen == IPv6_HDRLEN)
+    {
+      FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)IOB_DATA(held);
+
+      ipv6->len[0] = (held->io_pktlen - IPv6_HDRLEN) >> 8;
+      ipv6->len[1] = (held->io_pktlen - IPv6_HDRLEN) & 0xff;
+    }
+#endif
+
+  if (flush)
+    {
+      upper->gro_pkt = NULL;
+      return held;
+    }
+
+  return NULL;
+}
+
+#endif /* CONFIG_NETDEV_GRO */
+
 /****************************************************************************
  * Function: netdev_upper_rxpoll_work
  *
@@ -407,7 +1025,10 @@ static void eth_input(FAR struct net_driver_s *dev)
  *   upper - Reference to the upper half driver structure
  *
  * Assumptions:
- *   Called with the network locked.
+ *   Called from the work of the device, without any lock.  The device is
+ *   only locked while the lower half is called and the network only while
+ *   a received packet is being processed by the stack, so that the lower
+ *   half is drained without holding the network lock.
  *
  ****************************************************************************/
 
@@ -419,8 +1040,17 @@ static void netdev_upper_rxpoll_work(FAR struct netdev_upperhalf_s *upper)
 
   /* Loop while receive() successfully retrieves valid Ethernet frames. */
 
-  while ((pkt = lower->ops->receive(lower)) != NULL)
+  for (; ; )
     {
+      netdev_lock(dev);
+      pkt = lower->ops->receive(lower);
+      netdev_unlock(dev);
+
+      if (pkt == NULL)
+        {
+          break;
+        }
+
       NETDEV_RXPACKETS(dev);
 
       if (!IFF_IS_UP(dev->d_flags))
@@ -432,41 +1062,22 @@ static void netdev_upper_rxpoll_work(FAR struct netdev_upperhalf_s *upper)
           continue;
         }
 
-      netpkt_put(dev, pkt, NETPKT_RX);
+#ifdef CONFIG_NETDEV_GRO
+      pkt = netdev_upper_gro(upper, pkt);
+      if (pkt == NULL)
+        {
+          continue;
+        }
+#endif
 
-#ifdef CONFIG_NET_PKT
-      /* When packet sockets are enabled, feed the frame into the tap */
+      netdev_upper_input(upper, pkt);
+    }
 
-      pkt_input(dev);
-#endif
+#ifdef CONFIG_NETDEV_GRO
+  /* Do not hold a packet past the end of the poll */
 
-      switch (dev->d_lltype)
-        {
-#ifdef CONFIG_NET_LOOPBACK
-        case NET_LL_LOOPBACK:
-#endif
-#ifdef CONFIG_NET_ETHERNET
-        case NET_LL_ETHERNET:
-#endif
-#ifdef CONFIG_DRIVERS_IEEE80211
-        case NET_LL_IEEE80211:
-#endif
-#if defined(CONFIG_NET_LOOPBACK) || defined(CONFIG_NET_ETHERNET) || \
-    defined(CONFIG_DRIVERS_IEEE80211)
-          eth_input(dev);
-          break;
+  netdev_upper_gro_flush(upper);
 #endif
-#ifdef CONFIG_NET_CAN
-        case NET_LL_CAN:
-          ninfo("CAN frame");
-          can_input(dev);
-          break;
-#endif
-        default:
-          nerr("Unknown link type %d\n", dev->d_lltype);
-          break;
-        }
-    }
 }
 
 /****************************************************************************
@@ -484,12 +1095,15 @@ static void netdev_upper_work(FAR void *arg)
 {
   FAR struct netdev_upperhalf_s *upper = arg;
 
-  /* RX may release quota and driver buffer, so do RX first. */
+  /* No lock is held here.  The network lock is only taken around the stack
+   * processing, so that the work of other devices may proceed while this
+   * one talks to its hardware.
+   *
+   * RX may release quota and driver buffer, so do RX first.
+   */
 
-  net_lock();
   netdev_upper_rxpoll_work(upper);
   netdev_upper_txavail_work(upper);
-  net_unlock();
 }
 
 /****************************************************************************
@@ -543,7 +1157,7 @@ static inline void netdev_upper_queue_work(FAR struct net_driver_s *dev)
     {
       /* Schedule to serialize the poll on the worker thread. */
 
-      work_queue(NETDEV_WORK, &upper->work, netdev_upper_work, upper, 0);
+      netdev_upper_work_queue(upper, netdev_upper_work);
     }
 #endif
 }
@@ -842,11 +1456,32 @@ static int netdev_upper_ifup(FAR struct net_driver_s *dev)
           return upper->tid;
         }
     }
+#elif defined(CONFIG_NETDEV_WORK_QUEUE)
+  /* Try to create the dedicated work queue. */
+
+  if (upper->wqueue == NULL)
+    {
+      char name[32];
+
+      snprintf(name, sizeof(name), NETDEV_THREAD_NAME_FMT, dev->d_ifname);
+      upper->wqueue = work_queue_create(name,
+                                        CONFIG_NETDEV_WORK_THREAD_PRIORITY,
+                                        CONFIG_DEFAULT_TASK_STACKSIZE, 1);
+      if (upper->wqueue == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
 #endif
 
   if (upper->lower->ops->ifup)
     {
-      return upper->lower->ops->ifup(upper->lower);
+      int ret;
+
+      netdev_lock(dev);
+      ret = upper->lower->ops->ifup(upper->lower);
+      netdev_unlock(dev);
+      return ret;
     }
 
   return -ENOSYS;
@@ -857,12 +1492,19 @@ static int netdev_upper_ifdown(FAR struct net_driver_s *dev)
   FAR struct netdev_upperhalf_s *upper = dev->d_private;
 
 #ifndef CONFIG_NETDEV_WORK_THREAD
-  work_cancel(NETDEV_WORK, &upper->work);
+  netdev_upper_work_cancel(upper);
 #endif
 
   if (upper->lower->ops->ifdown)
     {
-      return upper->lower->ops->ifdown(upper->lower);
+      int ret;
+
+      /* Wait for the work in progress to leave the lower half */
+
+      netdev_lock(dev);
+      ret = upper->lower->ops->ifdown(upper->lower);
+      netdev_unlock(dev);
+      return ret;
     }
 
   return -ENOSYS;
@@ -876,7 +1518,12 @@ static int netdev_upper_addmac(FAR struct net_driver_s *dev,
 
   if (upper->lower->ops->addmac)
     {
-      return upper->lower->ops->addmac(upper->lower, mac);
+      int ret;
+
+      netdev_lock(dev);
+      ret = upper->lower->ops->addmac(upper->lower, mac);
+      netdev_unlock(dev);
+      return ret;
     }
 
   return -ENOSYS;
@@ -891,7 +1538,12 @@ static int netdev_upper_rmmac(FAR struct net_driver_s *dev,
 
   if (upper->lower->ops->rmmac)
     {
-      return upper->lower->ops->rmmac(upper->lower, mac);
+      int ret;
+
+      netdev_lock(dev);
+      ret = upper->lower->ops->rmmac(upper->lower, mac);
+      netdev_unlock(dev);
+      return ret;
     }
 
   return -ENOSYS;
@@ -904,24 +1556,24 @@ static int netdev_upper_ioctl(FAR struct net_driver_s *dev, int cmd,
 {
   FAR struct netdev_upperhalf_s *upper = dev->d_private;
   FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  int ret = -ENOTTY;
+
+  netdev_lock(dev);
 
 #ifdef CONFIG_NETDEV_WIRELESS_HANDLER
   if (lower->iw_ops)
     {
-      int ret = netdev_upper_wireless_ioctl(lower, cmd, arg);
-      if (ret != -ENOTTY)
-        {
-          return ret;
-        }
+      ret = netdev_upper_wireless_ioctl(lower, cmd, arg);
     }
 #endif
 
-  if (lower->ops->ioctl)
+  if (ret == -ENOTTY && lower->ops->ioctl)
     {
-      return lower->ops->ioctl(lower, cmd, arg);
+      ret = lower->ops->ioctl(lower, cmd, arg);
     }
 
-  return -ENOTTY;
+  netdev_unlock(dev);
+  return ret;
 }
 #endif
 
@@ -978,6 +1630,24 @@ int netdev_lower_register(FAR struct netdev_lowerhalf_s *dev,
 #endif
   dev->netdev.d_private = upper;
 
+#ifdef CONFIG_NETDEV_OFFLOAD
+  /* Software segmentation and coalescing are opt-in per lower half, drop
+   * them if they are not built in.  TSO needs the device to compute the
+   * checksums too.
+   */
+
+#  ifndef CONFIG_NETDEV_GSO
+  dev->netdev.d_features &= ~NETDEV_F_GSO;
+#  endif
+#  ifndef CONFIG_NETDEV_GRO
+  dev->netdev.d_features &= ~NETDEV_F_GRO;
+#  endif
+  if ((dev->netdev.d_features & NETDEV_F_TXCSUM) == 0)
+    {
+      dev->netdev.d_features &= ~NETDEV_F_TSO;
+    }
+#endif
+
   ret = netdev_register(&dev->netdev, lltype);
   if (ret < 0)
     {
@@ -1036,6 +1706,11 @@ int netdev_lower_unregister(FAR struct netdev_lowerhalf_s *dev)
 
   nxsem_destroy(&upper->sem);
   nxsem_destroy(&upper->sem_exit);
+#elif defined(CONFIG_NETDEV_WORK_QUEUE)
+  if (upper->wqueue != NULL)
+    {
+      work_queue_free(upper->wqueue);
+    }
 #endif
 
   kmm_free(upper);
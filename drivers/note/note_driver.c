@@ -38,6 +38,7 @@
 #include <nuttx/note/note_driver.h>
 #include <nuttx/note/noteram_driver.h>
 #include <nuttx/note/notelog_driver.h>
+#include <nuttx/note/notestream_driver.h>
 #include <nuttx/spinlock.h>
 #include <nuttx/sched_note.h>
 
@@ -45,7 +46,8 @@
 
 #if defined(CONFIG_DRIVERS_NOTERAM) +  defined(CONFIG_DRIVERS_NOTELOG) + \
     defined(CONFIG_DRIVERS_NOTESNAP) + defined(CONFIG_DRIVERS_NOTERTT) + \
-    defined(CONFIG_SEGGER_SYSVIEW) > CONFIG_DRIVERS_NOTE_MAX
+    defined(CONFIG_SEGGER_SYSVIEW) + defined(CONFIG_DRIVERS_NOTESTREAM) > \
+    CONFIG_DRIVERS_NOTE_MAX
 #  error "Maximum channel number exceeds. "
 #endif
 
@@ -174,6 +176,9 @@ FAR static struct note_driver_s *
 #endif
 #ifdef CONFIG_DRIVERS_NOTELOG
   &g_notelog_driver,
+#endif
+#ifdef CONFIG_DRIVERS_NOTESTREAM
+  (FAR struct note_driver_s *)&g_notestream_driver,
 #endif
   NULL
 };
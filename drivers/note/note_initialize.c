@@ -28,6 +28,7 @@
 #include <nuttx/note/noteram_driver.h>
 #include <nuttx/note/notectl_driver.h>
 #include <nuttx/note/notesnap_driver.h>
+#include <nuttx/note/notestream_driver.h>
 #include <nuttx/segger/note_rtt.h>
 #include <nuttx/segger/sysview.h>
 
@@ -99,5 +100,14 @@ int note_initialize(void)
     }
 #endif
 
+#ifdef CONFIG_DRIVERS_NOTESTREAM
+  ret = notestream_register();
+  if (ret < 0)
+    {
+      serr("notestream_register failed %d\n", ret);
+      return ret;
+    }
+#endif
+
   return ret;
 }
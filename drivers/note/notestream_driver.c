@@ -0,0 +1,799 @@
+/****************************************************************************
+ * drivers/note/notestream_driver.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/mutex.h>
+#include <nuttx/sched.h>
+#include <nuttx/signal.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/sched_note.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/note/note_driver.h>
+#include <nuttx/note/notestream_driver.h>
+
+#include "sched/sched.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define NCPUS CONFIG_SMP_NCPUS
+
+/* The longest record:  four bytes, two varints and the largest payload a
+ * note can carry.
+ */
+
+#define NOTESTREAM_RECORD_MAX  UINT8_MAX
+
+/* The longest record header:  four bytes, a 32-bit and a 64-bit varint */
+
+#define NOTESTREAM_HEADER_MAX  (4 + 5 + 10)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The buffer of one CPU.  Only that CPU adds records, with its interrupts
+ * disabled, and only the reader removes them.  Each side owns one index,
+ * so neither needs a lock:  it stores its index with release semantics and
+ * loads the other one with acquire semantics.  In the buffer, the time of
+ * a record is relative to the previous record of the same buffer.
+ */
+
+struct notestream_ring_s
+{
+  atomic_uint head;              /* Next byte to write, owned by the CPU */
+  atomic_uint tail;              /* Next byte to read, owned by the reader */
+  volatile uint32_t lost;        /* Records dropped on overflow */
+  uint64_t last;                 /* Time of the last record written */
+  uint8_t buffer[CONFIG_DRIVERS_NOTESTREAM_BUFSIZE];
+};
+
+/* The state of the reader side of one buffer */
+
+struct notestream_reader_s
+{
+  uint64_t last;                 /* Time of the last record taken */
+  uint32_t lost;                 /* Dropped records already reported */
+};
+
+struct notestream_driver_s
+{
+  struct note_driver_s driver;
+  mutex_t lock;                  /* Serializes the readers */
+  struct notestream_reader_s reader[NCPUS];
+  struct notestream_ring_s ring[NCPUS];
+};
+
+/* The state of one open file:  the name records of the tasks that existed
+ * when it was opened, returned before any other record, and the time base
+ * of the records returned through it.
+ */
+
+struct notestream_file_s
+{
+  FAR uint8_t *names;
+  size_t nameslen;
+  size_t namespos;
+  uint64_t last;                 /* Time of the last record returned */
+};
+
+/* A record being decoded */
+
+struct notestream_record_s
+{
+  uint8_t length;
+  uint8_t type;
+  uint8_t priority;
+  uint8_t cpu;
+  uint32_t pid;
+  int64_t delta;
+  FAR const uint8_t *payload;
+  size_t payloadlen;
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int notestream_open(FAR struct file *filep);
+static int notestream_close(FAR struct file *filep);
+static ssize_t notestream_read(FAR struct file *filep,
+                               FAR char *buffer, size_t buflen);
+static void notestream_add(FAR struct note_driver_s *drv,
+                           FAR const void *note, size_t len);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct file_operations g_notestream_fops =
+{
+  notestream_open,  /* open */
+  notestream_close, /* close */
+  notestream_read,  /* read */
+};
+
+static const struct note_driver_ops_s g_notestream_ops =
+{
+  notestream_add
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+struct notestream_driver_s g_notestream_driver =
+{
+  {&g_notestream_ops},
+  NXMUTEX_INITIALIZER,
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: notestream_getle
+ *
+ * Description:
+ *   Get a value flattened in little endian order by the note driver.
+ *
+ ****************************************************************************/
+
+static uint64_t notestream_getle(FAR const uint8_t *src, size_t len)
+{
+  uint64_t value = 0;
+
+  while (len-- > 0)
+    {
+      value = (value << 8) | src[len];
+    }
+
+  return value;
+}
+
+/****************************************************************************
+ * Name: notestream_putvarint/notestream_getvarint
+ ****************************************************************************/
+
+static FAR uint8_t *notestream_putvarint(FAR uint8_t *dst, uint64_t value)
+{
+  while (value >= 0x80)
+    {
+      *dst++ = (uint8_t)value | 0x80;
+      value >>= 7;
+    }
+
+  *dst++ = (uint8_t)value;
+  return dst;
+}
+
+static FAR const uint8_t *notestream_getvarint(FAR const uint8_t *src,
+                                               FAR const uint8_t *end,
+                                               FAR uint64_t *value)
+{
+  unsigned int shift = 0;
+
+  *value = 0;
+  while (src < end && shift < 64)
+    {
+      *value |= (uint64_t)(*src & 0x7f) << shift;
+      if ((*src++ & 0x80) == 0)
+        {
+          return src;
+        }
+
+      shift += 7;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: notestream_encode
+ *
+ * Description:
+ *   Encode a record.
+ *
+ * Returned Value:
+ *   The length of the record or zero if it does not fit in a record.
+ *
+ ****************************************************************************/
+
+static size_t notestream_encode(FAR uint8_t *dst,
+                                FAR const struct notestream_record_s *rec)
+{
+  FAR uint8_t *p = dst + 1;
+
+  if (rec->payloadlen > NOTESTREAM_RECORD_MAX - NOTESTREAM_HEADER_MAX)
+    {
+      return 0;
+    }
+
+  *p++ = rec->type;
+  *p++ = rec->priority;
+  *p++ = rec->cpu;
+  p    = notestream_putvarint(p, rec->pid);
+  p    = notestream_putvarint(p, NOTESTREAM_ZIGZAG(rec->delta));
+
+  memcpy(p, rec->payload, rec->payloadlen);
+  p   += rec->payloadlen;
+
+  dst[0] = p - dst;
+  return dst[0];
+}
+
+/****************************************************************************
+ * Name: notestream_decode
+ *
+ * Description:
+ *   Decode a record.  If the record was truncated to its header, the
+ *   payload fields are not valid.
+ *
+ ****************************************************************************/
+
+static int notestream_decode(FAR const uint8_t *src, size_t len,
+                             FAR struct notestream_record_s *rec)
+{
+  FAR const uint8_t *end = src + len;
+  uint64_t value;
+
+  rec->length   = src[0];
+  rec->type     = src[1];
+  rec->priority = src[2];
+  rec->cpu      = src[3];
+
+  src = notestream_getvarint(src + 4, end, &value);
+  if (src == NULL)
+    {
+      return -EINVAL;
+    }
+
+  rec->pid = value;
+
+  src = notestream_getvarint(src, end, &value);
+  if (src == NULL)
+    {
+      return -EINVAL;
+    }
+
+  rec->delta      = NOTESTREAM_UNZIGZAG(value);
+  rec->payload    = src;
+  rec->payloadlen = rec->length - (src - (end - len));
+  return OK;
+}
+
+/****************************************************************************
+ * Name: notestream_ring_length
+ ****************************************************************************/
+
+static unsigned int notestream_ring_length(unsigned int head,
+                                           unsigned int tail)
+{
+  if (tail > head)
+    {
+      head += CONFIG_DRIVERS_NOTESTREAM_BUFSIZE;
+    }
+
+  return head - tail;
+}
+
+/****************************************************************************
+ * Name: notestream_ring_copyin/notestream_ring_copyout
+ *
+ * Description:
+ *   Copy data to or from a ring buffer at 'ndx', handling wraparound.
+ *
+ ****************************************************************************/
+
+static unsigned int
+notestream_ring_copyin(FAR struct notestream_ring_s *ring, unsigned int ndx,
+                       FAR const uint8_t *src, size_t len)
+{
+  size_t part = CONFIG_DRIVERS_NOTESTREAM_BUFSIZE - ndx;
+
+  if (part > len)
+    {
+      part = len;
+    }
+
+  memcpy(&ring->buffer[ndx], src, part);
+  memcpy(ring->buffer, src + part, len - part);
+
+  ndx += len;
+  if (ndx >= CONFIG_DRIVERS_NOTESTREAM_BUFSIZE)
+    {
+      ndx -= CONFIG_DRIVERS_NOTESTREAM_BUFSIZE;
+    }
+
+  return ndx;
+}
+
+static void notestream_ring_copyout(FAR struct notestream_ring_s *ring,
+                                    unsigned int ndx, FAR uint8_t *dst,
+                                    size_t len)
+{
+  size_t part = CONFIG_DRIVERS_NOTESTREAM_BUFSIZE - ndx;
+
+  if (part > len)
+    {
+      part = len;
+    }
+
+  memcpy(dst, &ring->buffer[ndx], part);
+  memcpy(dst + part, ring->buffer, len - part);
+}
+
+/****************************************************************************
+ * Name: notestream_peek
+ *
+ * Description:
+ *   Return the time of the oldest record of a ring buffer.
+ *
+ * Returned Value:
+ *   True if the ring buffer holds a record.
+ *
+ ****************************************************************************/
+
+static bool notestream_peek(FAR struct notestream_driver_s *drv, int cpu,
+                            FAR uint64_t *time)
+{
+  FAR struct notestream_ring_s *ring = &drv->ring[cpu];
+  struct notestream_record_s rec;
+  uint8_t header[NOTESTREAM_HEADER_MAX];
+  unsigned int tail;
+  unsigned int length;
+
+  tail   = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  length = notestream_ring_length(atomic_load_explicit(&ring->head,
+                                                       memory_order_acquire),
+                                  tail);
+  if (length == 0)
+    {
+      return false;
+    }
+
+  length = MIN(length, ring->buffer[tail]);
+  notestream_ring_copyout(ring, tail, header, MIN(length, sizeof(header)));
+  if (notestream_decode(header, MIN(length, sizeof(header)), &rec) < 0)
+    {
+      return false;
+    }
+
+  *time = drv->reader[cpu].last + rec.delta;
+  return true;
+}
+
+/****************************************************************************
+ * Name: notestream_take
+ *
+ * Description:
+ *   Move the oldest record of a ring buffer to the user buffer, with its
+ *   time made relative to the previous record returned through the file.
+ *   The first record of a file carries the absolute time.
+ *
+ * Returned Value:
+ *   The length of the record returned, zero if it does not fit in the
+ *   user buffer.
+ *
+ ****************************************************************************/
+
+static size_t notestream_take(FAR struct notestream_driver_s *drv,
+                              FAR struct notestream_file_s *file, int cpu,
+                              uint64_t time, FAR uint8_t *buffer,
+                              size_t buflen)
+{
+  FAR struct notestream_ring_s *ring = &drv->ring[cpu];
+  uint8_t record[NOTESTREAM_RECORD_MAX];
+  uint8_t output[NOTESTREAM_RECORD_MAX];
+  struct notestream_record_s rec;
+  unsigned int tail;
+  size_t length;
+
+  tail   = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  length = ring->buffer[tail];
+
+  notestream_ring_copyout(ring, tail, record, length);
+  notestream_decode(record, length, &rec);
+
+  rec.delta = time - file->last;
+  length    = notestream_encode(output, &rec);
+  if (length > buflen)
+    {
+      return 0;
+    }
+
+  memcpy(buffer, output, length);
+
+  drv->reader[cpu].last = time;
+  file->last = time;
+
+  tail += rec.length;
+  if (tail >= CONFIG_DRIVERS_NOTESTREAM_BUFSIZE)
+    {
+      tail -= CONFIG_DRIVERS_NOTESTREAM_BUFSIZE;
+    }
+
+  /* Release the space only after the record was copied */
+
+  atomic_store_explicit(&ring->tail, tail, memory_order_release);
+  return length;
+}
+
+/****************************************************************************
+ * Name: notestream_lost
+ *
+ * Description:
+ *   Report the records of a CPU that were dropped since the last report.
+ *
+ * Returned Value:
+ *   The length of the record returned, zero if there is nothing to report
+ *   or if it does not fit in the user buffer.
+ *
+ ****************************************************************************/
+
+static size_t notestream_lost(FAR struct notestream_driver_s *drv, int cpu,
+                              FAR uint8_t *buffer, size_t buflen)
+{
+  uint32_t lost = drv->ring[cpu].lost;
+  struct notestream_record_s rec;
+  uint8_t record[NOTESTREAM_HEADER_MAX + 5];
+  uint8_t count[5];
+  size_t length;
+
+  if (lost == drv->reader[cpu].lost)
+    {
+      return 0;
+    }
+
+  memset(&rec, 0, sizeof(rec));
+  rec.type       = NOTESTREAM_LOST;
+  rec.cpu        = cpu;
+  rec.payload    = count;
+  rec.payloadlen = notestream_putvarint(count, lost - drv->reader[cpu].lost)
+                   - count;
+
+  length = notestream_encode(record, &rec);
+  if (length > buflen)
+    {
+      return 0;
+    }
+
+  memcpy(buffer, record, length);
+  drv->reader[cpu].lost = lost;
+  return length;
+}
+
+/****************************************************************************
+ * Name: notestream_name
+ *
+ * Description:
+ *   nxsched_foreach() callback that counts the tasks or encodes their name
+ *   records.
+ *
+ ****************************************************************************/
+
+#if CONFIG_TASK_NAME_SIZE > 0
+static void notestream_name(FAR struct tcb_s *tcb, FAR void *arg)
+{
+  FAR struct notestream_file_s *file = arg;
+  struct notestream_record_s rec;
+
+  if (file->names == NULL)
+    {
+      file->nameslen += NOTESTREAM_HEADER_MAX + CONFIG_TASK_NAME_SIZE;
+      return;
+    }
+
+  if (file->namespos + NOTESTREAM_HEADER_MAX + CONFIG_TASK_NAME_SIZE >
+      file->nameslen)
+    {
+      return;
+    }
+
+  memset(&rec, 0, sizeof(rec));
+  rec.type       = NOTESTREAM_NAME;
+  rec.priority   = tcb->sched_priority;
+#ifdef CONFIG_SMP
+  rec.cpu        = tcb->cpu;
+#endif
+  rec.pid        = tcb->pid;
+  rec.payload    = (FAR const uint8_t *)tcb->name;
+  rec.payloadlen = strnlen(tcb->name, CONFIG_TASK_NAME_SIZE);
+
+  file->namespos += notestream_encode(file->names + file->namespos, &rec);
+}
+#endif
+
+/****************************************************************************
+ * Name: notestream_open
+ ****************************************************************************/
+
+static int notestream_open(FAR struct file *filep)
+{
+  FAR struct notestream_file_s *file;
+
+  file = kmm_zalloc(sizeof(*file));
+  if (file == NULL)
+    {
+      return -ENOMEM;
+    }
+
+#if CONFIG_TASK_NAME_SIZE > 0
+  /* Intern the names of the tasks that already exist, the names of the
+   * tasks started from now on are in their NOTE_START record.  Tasks
+   * started between the two passes are left out of the second one.
+   */
+
+  nxsched_foreach(notestream_name, file);
+
+  file->names = kmm_malloc(file->nameslen);
+  if (file->names == NULL)
+    {
+      kmm_free(file);
+      return -ENOMEM;
+    }
+
+  nxsched_foreach(notestream_name, file);
+
+  file->nameslen = file->namespos;
+  file->namespos = 0;
+#endif
+
+  filep->f_priv = file;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: notestream_close
+ ****************************************************************************/
+
+static int notestream_close(FAR struct file *filep)
+{
+  FAR struct notestream_file_s *file = filep->f_priv;
+
+  kmm_free(file->names);
+  kmm_free(file);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: notestream_read
+ *
+ * Description:
+ *   Return as many whole records as fit in the user buffer, merging the
+ *   buffers of all CPUs in time order.  Reading does not stop the trace,
+ *   so a host tool can drain the stream continuously.  Without O_NONBLOCK,
+ *   the read waits until there is at least one record to return.
+ *
+ ****************************************************************************/
+
+static ssize_t notestream_read(FAR struct file *filep, FAR char *buffer,
+                               size_t buflen)
+{
+  FAR struct notestream_driver_s *drv = filep->f_inode->i_private;
+  FAR struct notestream_file_s *file = filep->f_priv;
+  FAR uint8_t *dst = (FAR uint8_t *)buffer;
+  uint64_t oldest = 0;
+  uint64_t time;
+  size_t length;
+  size_t ret = 0;
+  int cpu;
+  int i;
+
+  /* Return the interned task names first */
+
+  if (file->namespos < file->nameslen)
+    {
+      while (file->namespos < file->nameslen &&
+             file->names[file->namespos] <= buflen - ret)
+        {
+          length = file->names[file->namespos];
+          memcpy(dst + ret, file->names + file->namespos, length);
+          file->namespos += length;
+          ret += length;
+        }
+
+      return ret > 0 ? ret : -EFBIG;
+    }
+
+  nxmutex_lock(&drv->lock);
+
+  for (; ; )
+    {
+      for (i = 0; i < NCPUS; i++)
+        {
+          ret += notestream_lost(drv, i, dst + ret, buflen - ret);
+        }
+
+      for (; ; )
+        {
+          /* Find the oldest record of all buffers */
+
+          cpu = -1;
+          for (i = 0; i < NCPUS; i++)
+            {
+              if (notestream_peek(drv, i, &time) &&
+                  (cpu < 0 || (int64_t)(time - oldest) < 0))
+                {
+                  cpu    = i;
+                  oldest = time;
+                }
+            }
+
+          if (cpu < 0)
+            {
+              break;
+            }
+
+          length = notestream_take(drv, file, cpu, oldest, dst + ret,
+                                   buflen - ret);
+          if (length == 0)
+            {
+              break;
+            }
+
+          ret += length;
+        }
+
+      /* Stop if something was returned or if the oldest record does not
+       * fit in the user buffer.
+       */
+
+      if (ret > 0 || cpu >= 0 || (filep->f_oflags & O_NONBLOCK) != 0)
+        {
+          break;
+        }
+
+      /* Nothing to return yet, poll again later */
+
+      nxmutex_unlock(&drv->lock);
+      if (nxsig_usleep(CONFIG_DRIVERS_NOTESTREAM_POLLDELAY * 1000) < 0)
+        {
+          return -EINTR;
+        }
+
+      nxmutex_lock(&drv->lock);
+    }
+
+  nxmutex_unlock(&drv->lock);
+
+  if (ret == 0)
+    {
+      return cpu < 0 ? -EAGAIN : -EFBIG;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: notestream_add
+ *
+ * Description:
+ *   Add a note to the buffer of the calling CPU.
+ *
+ *   This takes no lock:  the buffer of a CPU is only written by that CPU
+ *   and interrupts are only disabled locally while the record is written.
+ *   If the buffer is full, the note is dropped and counted.
+ *
+ ****************************************************************************/
+
+static void notestream_add(FAR struct note_driver_s *driver,
+                           FAR const void *note, size_t notelen)
+{
+  FAR struct notestream_driver_s *drv =
+    (FAR struct notestream_driver_s *)driver;
+  FAR const struct note_common_s *cmn = note;
+  FAR struct notestream_ring_s *ring;
+  uint8_t record[NOTESTREAM_RECORD_MAX];
+  struct notestream_record_s rec;
+  unsigned int length;
+  unsigned int head;
+  unsigned int tail;
+  irqstate_t flags;
+  uint64_t time;
+
+  DEBUGASSERT(notelen >= sizeof(struct note_common_s));
+
+  time = notestream_getle(cmn->nc_systime_sec,
+                          sizeof(cmn->nc_systime_sec)) * NSEC_PER_SEC +
+         notestream_getle(cmn->nc_systime_nsec,
+                          sizeof(cmn->nc_systime_nsec));
+
+  rec.type       = cmn->nc_type;
+  rec.priority   = cmn->nc_priority;
+#ifdef CONFIG_SMP
+  rec.cpu        = cmn->nc_cpu;
+#else
+  rec.cpu        = 0;
+#endif
+  rec.pid        = notestream_getle(cmn->nc_pid, sizeof(cmn->nc_pid));
+  rec.payload    = (FAR const uint8_t *)(cmn + 1);
+  rec.payloadlen = notelen - sizeof(struct note_common_s);
+
+  flags = up_irq_save();
+
+  ring      = &drv->ring[this_cpu()];
+  rec.delta = time - ring->last;
+  length    = notestream_encode(record, &rec);
+
+  head      = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  tail      = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+  if (length == 0 ||
+      length >= CONFIG_DRIVERS_NOTESTREAM_BUFSIZE -
+                notestream_ring_length(head, tail))
+    {
+      ring->lost++;
+    }
+  else
+    {
+      head = notestream_ring_copyin(ring, head, record, length);
+
+      /* Publish the record only after it was written */
+
+      atomic_store_explicit(&ring->head, head, memory_order_release);
+      ring->last = time;
+    }
+
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: notestream_register
+ *
+ * Description:
+ *   Register the note stream driver at /dev/note/stream.
+ *
+ * Input Parameters:
+ *   None.
+ *
+ * Returned Value:
+ *   Zero on success. A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+int notestream_register(void)
+{
+  return register_driver("/dev/note/stream", &g_notestream_fops, 0444,
+                         &g_notestream_driver);
+}
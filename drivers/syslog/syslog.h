@@ -27,6 +27,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/types.h>
 #include <stdbool.h>
 
 /****************************************************************************
@@ -224,6 +225,79 @@ int syslog_add_intbuffer(int ch);
 int syslog_flush_intbuffer(bool force);
 #endif
 
+/****************************************************************************
+ * Name: syslog_write_channels
+ *
+ * Description:
+ *   Write to the SYSLOG channels from the calling context, bypassing the
+ *   per-CPU buffer.
+ *
+ * Input Parameters:
+ *   buffer - The buffer containing the data to be output
+ *   buflen - The number of bytes in the buffer
+ *
+ * Returned Value:
+ *   On success, the number of characters written is returned.  A negated
+ *   errno value is returned on any failure.
+ *
+ ****************************************************************************/
+
+ssize_t syslog_write_channels(FAR const char *buffer, size_t buflen);
+
+/****************************************************************************
+ * Name: syslog_add_percpu
+ *
+ * Description:
+ *   Add a message to the buffer of the calling CPU.  This never blocks and
+ *   takes no lock that is shared with another CPU, so it may be called from
+ *   any context.  If the buffer is full, the message is dropped and counted.
+ *   The flusher thread reports the count in the output.
+ *
+ * Input Parameters:
+ *   buffer - The buffer containing the data to be output
+ *   buflen - The number of bytes in the buffer
+ *
+ * Returned Value:
+ *   buflen if the message was buffered or dropped.  A negated errno value
+ *   if the caller must write the message itself:  -EAGAIN before the
+ *   flusher thread runs or after a crash, -E2BIG if the message is larger
+ *   than the buffer.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+ssize_t syslog_add_percpu(FAR const char *buffer, size_t buflen);
+#endif
+
+/****************************************************************************
+ * Name: syslog_flush_percpu
+ *
+ * Description:
+ *   Called from syslog_flush().  Write the buffered messages out at once.
+ *   Buffering goes on afterwards unless the panic is fatal.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+void syslog_flush_percpu(void);
+#endif
+
+/****************************************************************************
+ * Name: syslog_percpu_initialize
+ *
+ * Description:
+ *   Start the flusher thread of the per-CPU buffer.  Until it runs, messages
+ *   are written to the SYSLOG channels by the caller.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+int syslog_percpu_initialize(void);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
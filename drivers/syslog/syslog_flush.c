@@ -66,6 +66,12 @@ int syslog_flush(void)
 {
   int i;
 
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+  /* Write out the per-CPU buffers */
+
+  syslog_flush_percpu();
+#endif
+
 #ifdef CONFIG_SYSLOG_INTBUFFER
   /* Flush any characters that may have been added to the interrupt
    * buffer.
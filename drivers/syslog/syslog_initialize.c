@@ -95,6 +95,10 @@ int syslog_initialize(void)
   syslog_rpmsg_server_init();
 #endif
 
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+  ret = syslog_percpu_initialize();
+#endif
+
   return ret;
 }
 
@@ -0,0 +1,619 @@
+/****************************************************************************
+ * drivers/syslog/syslog_percpu.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/kthread.h>
+#include <nuttx/panic_notifier.h>
+#include <nuttx/signal.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/syslog/syslog.h>
+
+#include "syslog.h"
+
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+#  define NCPUS CONFIG_SMP_NCPUS
+#else
+#  define NCPUS 1
+#endif
+
+#define SYSLOG_PERCPU_LOSTLEN 48
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Each message is stored as this header followed by the message text.  The
+ * sequence number orders the messages of all CPUs.
+ */
+
+struct syslog_percpu_hdr_s
+{
+  uint32_t ph_seqno;
+  uint16_t ph_len;
+};
+
+/* The buffer of one CPU.  Only that CPU adds messages, with its interrupts
+ * disabled, and only the owner of ps_owner removes them.  Each side owns
+ * one index, so the producer needs no lock.  Each side stores its index
+ * with release semantics and loads the other one with acquire semantics,
+ * so the message bytes are never read before they are written, nor
+ * overwritten before they are read.
+ */
+
+struct syslog_percpu_ring_s
+{
+  atomic_uint pr_head;            /* Next byte to write, owned by the CPU */
+  atomic_uint pr_tail;            /* Next byte to read, owned by flusher */
+  volatile uint32_t pr_lost;      /* Messages dropped on overflow */
+  uint32_t pr_reported;           /* Dropped messages already reported */
+  uint8_t pr_buffer[CONFIG_SYSLOG_PERCPU_BUFSIZE];
+};
+
+struct syslog_percpu_s
+{
+  atomic_uint ps_seqno;           /* Next message sequence number */
+  atomic_int ps_owner;            /* CPU removing messages, or -1 */
+  volatile bool ps_running;       /* The flusher thread is running */
+  volatile bool ps_crashed;       /* A fatal panic was notified */
+  sem_t ps_sem;                   /* Wakes up the flusher thread */
+  struct notifier_block ps_nb;    /* Panic notifier */
+  size_t ps_batchlen;             /* Bytes in ps_batch */
+  char ps_batch[CONFIG_SYSLOG_PERCPU_BUFSIZE];
+  struct syslog_percpu_ring_s ps_ring[NCPUS];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct syslog_percpu_s g_syslog_percpu =
+{
+  .ps_owner = -1,
+  .ps_sem   = SEM_INITIALIZER(0),
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static unsigned int syslog_percpu_used(unsigned int head, unsigned int tail)
+{
+  if (head < tail)
+    {
+      head += CONFIG_SYSLOG_PERCPU_BUFSIZE;
+    }
+
+  return head - tail;
+}
+
+static unsigned int
+syslog_percpu_copyin(FAR struct syslog_percpu_ring_s *ring,
+                     unsigned int ndx, FAR const void *src, size_t len)
+{
+  size_t part = CONFIG_SYSLOG_PERCPU_BUFSIZE - ndx;
+
+  if (part > len)
+    {
+      part = len;
+    }
+
+  memcpy(&ring->pr_buffer[ndx], src, part);
+  memcpy(ring->pr_buffer, (FAR const uint8_t *)src + part, len - part);
+
+  ndx += len;
+  if (ndx >= CONFIG_SYSLOG_PERCPU_BUFSIZE)
+    {
+      ndx -= CONFIG_SYSLOG_PERCPU_BUFSIZE;
+    }
+
+  return ndx;
+}
+
+static unsigned int
+syslog_percpu_copyout(FAR struct syslog_percpu_ring_s *ring,
+                      unsigned int ndx, FAR void *dst, size_t len)
+{
+  size_t part = CONFIG_SYSLOG_PERCPU_BUFSIZE - ndx;
+
+  if (part > len)
+    {
+      part = len;
+    }
+
+  memcpy(dst, &ring->pr_buffer[ndx], part);
+  memcpy((FAR uint8_t *)dst + part, ring->pr_buffer, len - part);
+
+  ndx += len;
+  if (ndx >= CONFIG_SYSLOG_PERCPU_BUFSIZE)
+    {
+      ndx -= CONFIG_SYSLOG_PERCPU_BUFSIZE;
+    }
+
+  return ndx;
+}
+
+/****************************************************************************
+ * Name: syslog_percpu_claim
+ *
+ * Description:
+ *   Become the only remover of messages.  The flusher thread claims the
+ *   buffers for one message at a time, with its interrupts disabled, and
+ *   gives up if they are claimed.  syslog_flush() waits for the flusher,
+ *   or takes over if it interrupted the flusher on the same CPU.
+ *
+ * Input Parameters:
+ *   cpu  - The index of the calling CPU.
+ *   sync - True if called from syslog_flush().
+ *
+ * Returned Value:
+ *   True if the buffers were claimed.
+ *
+ ****************************************************************************/
+
+static bool syslog_percpu_claim(int cpu, bool sync)
+{
+  FAR struct syslog_percpu_s *priv = &g_syslog_percpu;
+  int owner;
+
+  do
+    {
+      owner = -1;
+      if (atomic_compare_exchange_strong(&priv->ps_owner, &owner, cpu))
+        {
+          return true;
+        }
+    }
+  while (sync && owner != cpu);
+
+  return sync;
+}
+
+/****************************************************************************
+ * Name: syslog_percpu_next
+ *
+ * Description:
+ *   Move the oldest buffered message to the SYSLOG channels and report the
+ *   messages that were dropped.  The caller has claimed the buffers.  The
+ *   flusher thread collects the text in ps_batch, to write it later in one
+ *   piece without the claim.
+ *
+ * Input Parameters:
+ *   sync - True if called from syslog_flush().  Then the messages are
+ *          written straight out of the ring buffers, ps_batch may be in
+ *          use by the interrupted flusher thread.
+ *
+ * Returned Value:
+ *   One if a message was moved, zero if no message is left, -ENOSPC if
+ *   ps_batch must be written out first.
+ *
+ ****************************************************************************/
+
+static int syslog_percpu_next(bool sync)
+{
+  FAR struct syslog_percpu_s *priv = &g_syslog_percpu;
+  FAR struct syslog_percpu_ring_s *ring;
+  struct syslog_percpu_hdr_s oldest;
+  struct syslog_percpu_hdr_s hdr;
+  char lost[SYSLOG_PERCPU_LOSTLEN];
+  unsigned int tail;
+  uint32_t nlost;
+  size_t part;
+  int select = -1;
+  int cpu;
+  int len;
+
+  memset(&oldest, 0, sizeof(oldest));
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      ring = &priv->ps_ring[cpu];
+      tail = atomic_load_explicit(&ring->pr_tail, memory_order_relaxed);
+      if (atomic_load_explicit(&ring->pr_head,
+                               memory_order_acquire) == tail)
+        {
+          /* Messages are only dropped when the buffer is full, so report
+           * them after the messages that filled it.
+           */
+
+          nlost = ring->pr_lost;
+          if (nlost == ring->pr_reported)
+            {
+              continue;
+            }
+
+          len = snprintf(lost, sizeof(lost),
+                         "[syslog: %" PRIu32 " lost on CPU%d]\n",
+                         nlost - ring->pr_reported, cpu);
+          if (sync)
+            {
+              syslog_write_channels(lost, len);
+            }
+          else if (priv->ps_batchlen + len <= sizeof(priv->ps_batch))
+            {
+              memcpy(&priv->ps_batch[priv->ps_batchlen], lost, len);
+              priv->ps_batchlen += len;
+            }
+          else
+            {
+              return -ENOSPC;
+            }
+
+          ring->pr_reported = nlost;
+          continue;
+        }
+
+      syslog_percpu_copyout(ring, tail, &hdr, sizeof(hdr));
+      if (select < 0 || (int32_t)(hdr.ph_seqno - oldest.ph_seqno) < 0)
+        {
+          oldest = hdr;
+          select = cpu;
+        }
+    }
+
+  if (select < 0)
+    {
+      return 0;
+    }
+
+  ring = &priv->ps_ring[select];
+  tail = atomic_load_explicit(&ring->pr_tail, memory_order_relaxed) +
+         sizeof(oldest);
+  if (tail >= CONFIG_SYSLOG_PERCPU_BUFSIZE)
+    {
+      tail -= CONFIG_SYSLOG_PERCPU_BUFSIZE;
+    }
+
+  if (sync)
+    {
+      part = CONFIG_SYSLOG_PERCPU_BUFSIZE - tail;
+      if (part > oldest.ph_len)
+        {
+          part = oldest.ph_len;
+        }
+
+      syslog_write_channels((FAR const char *)&ring->pr_buffer[tail], part);
+      if (part < oldest.ph_len)
+        {
+          syslog_write_channels((FAR const char *)ring->pr_buffer,
+                                oldest.ph_len - part);
+        }
+
+      tail += oldest.ph_len;
+      if (tail >= CONFIG_SYSLOG_PERCPU_BUFSIZE)
+        {
+          tail -= CONFIG_SYSLOG_PERCPU_BUFSIZE;
+        }
+    }
+  else
+    {
+      if (priv->ps_batchlen + oldest.ph_len > sizeof(priv->ps_batch))
+        {
+          return -ENOSPC;
+        }
+
+      tail = syslog_percpu_copyout(ring, tail,
+                                   &priv->ps_batch[priv->ps_batchlen],
+                                   oldest.ph_len);
+      priv->ps_batchlen += oldest.ph_len;
+    }
+
+  /* Release the space only after the message was copied */
+
+  atomic_store_explicit(&ring->pr_tail, tail, memory_order_release);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: syslog_percpu_drain
+ *
+ * Description:
+ *   Move all buffered messages to the SYSLOG channels, in the order in
+ *   which they were added, and report the messages that were dropped.
+ *
+ * Input Parameters:
+ *   sync - True if called from syslog_flush().  Then the messages are
+ *          written one by one, straight out of the ring buffers.
+ *
+ ****************************************************************************/
+
+static void syslog_percpu_drain(bool sync)
+{
+  FAR struct syslog_percpu_s *priv = &g_syslog_percpu;
+  irqstate_t flags;
+  int ret;
+
+  if (sync)
+    {
+      flags = up_irq_save();
+      syslog_percpu_claim(up_cpu_index(), true);
+
+      /* After a crash the flusher thread will not run again.  Messages it
+       * already took out of the rings are older than those still in them,
+       * so write them out first.  One that was being written when the
+       * crash happened may be written twice, rather than not at all.
+       */
+
+      if (priv->ps_crashed && priv->ps_batchlen > 0)
+        {
+          syslog_write_channels(priv->ps_batch, priv->ps_batchlen);
+          priv->ps_batchlen = 0;
+        }
+
+      while (syslog_percpu_next(true) > 0)
+        {
+        }
+
+      atomic_store(&priv->ps_owner, -1);
+      up_irq_restore(flags);
+      return;
+    }
+
+  for (; ; )
+    {
+      flags = up_irq_save();
+      if (!syslog_percpu_claim(up_cpu_index(), false))
+        {
+          /* syslog_flush() is draining the buffers */
+
+          up_irq_restore(flags);
+          break;
+        }
+
+      ret = syslog_percpu_next(false);
+
+      atomic_store(&priv->ps_owner, -1);
+      up_irq_restore(flags);
+
+      if (ret == 0)
+        {
+          break;
+        }
+      else if (ret < 0)
+        {
+          syslog_write_channels(priv->ps_batch, priv->ps_batchlen);
+          priv->ps_batchlen = 0;
+        }
+    }
+
+  if (priv->ps_batchlen > 0)
+    {
+      syslog_write_channels(priv->ps_batch, priv->ps_batchlen);
+      priv->ps_batchlen = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_percpu_notifier
+ *
+ * Description:
+ *   On a fatal panic, write the buffered messages out and send all later
+ *   messages straight to the SYSLOG channels.  The flusher thread may not
+ *   run again.
+ *
+ ****************************************************************************/
+
+static int syslog_percpu_notifier(FAR struct notifier_block *nb,
+                                  unsigned long action, FAR void *data)
+{
+  if (action == PANIC_KERNEL)
+    {
+      g_syslog_percpu.ps_crashed = true;
+      syslog_percpu_drain(true);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: syslog_percpu_thread
+ *
+ * Description:
+ *   The flusher thread.  It sleeps until a CPU adds a message to an empty
+ *   buffer, then waits CONFIG_SYSLOG_PERCPU_DELAY milliseconds for more
+ *   messages to arrive and writes all of them out together.
+ *
+ ****************************************************************************/
+
+static int syslog_percpu_thread(int argc, FAR char *argv[])
+{
+  FAR struct syslog_percpu_s *priv = &g_syslog_percpu;
+
+  while (!priv->ps_crashed)
+    {
+      nxsem_wait_uninterruptible(&priv->ps_sem);
+
+#if CONFIG_SYSLOG_PERCPU_DELAY > 0
+      nxsig_usleep(CONFIG_SYSLOG_PERCPU_DELAY * USEC_PER_MSEC);
+#endif
+
+      /* Every CPU that found its buffer empty posted the semaphore.  One
+       * pass drains all of them.
+       */
+
+      while (nxsem_trywait(&priv->ps_sem) >= 0)
+        {
+        }
+
+      syslog_percpu_drain(false);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_add_percpu
+ *
+ * Description:
+ *   Add a message to the buffer of the calling CPU.  This never blocks and
+ *   takes no lock that is shared with another CPU, so it may be called from
+ *   any context.  If the buffer is full, the message is dropped and counted.
+ *   The flusher thread reports the count in the output.
+ *
+ * Input Parameters:
+ *   buffer - The buffer containing the data to be output
+ *   buflen - The number of bytes in the buffer
+ *
+ * Returned Value:
+ *   buflen if the message was buffered or dropped.  A negated errno value
+ *   if the caller must write the message itself:  -EAGAIN before the
+ *   flusher thread runs or after a crash, -E2BIG if the message is larger
+ *   than the buffer.
+ *
+ ****************************************************************************/
+
+ssize_t syslog_add_percpu(FAR const char *buffer, size_t buflen)
+{
+  FAR struct syslog_percpu_s *priv = &g_syslog_percpu;
+  FAR struct syslog_percpu_ring_s *ring;
+  struct syslog_percpu_hdr_s hdr;
+  irqstate_t flags;
+  unsigned int head;
+  unsigned int tail;
+  unsigned int used;
+
+  if (!priv->ps_running || priv->ps_crashed)
+    {
+      return -EAGAIN;
+    }
+
+  if (buflen > UINT16_MAX ||
+      buflen + sizeof(hdr) >= CONFIG_SYSLOG_PERCPU_BUFSIZE)
+    {
+      return -E2BIG;
+    }
+
+  /* Only the local interrupts are disabled:  no other CPU adds to this
+   * buffer.
+   */
+
+  flags = up_irq_save();
+
+  ring = &priv->ps_ring[up_cpu_index()];
+  head = atomic_load_explicit(&ring->pr_head, memory_order_relaxed);
+  tail = atomic_load_explicit(&ring->pr_tail, memory_order_acquire);
+  used = syslog_percpu_used(head, tail);
+
+  /* One byte stays free to tell a full buffer from an empty one */
+
+  if (used + sizeof(hdr) + buflen >= CONFIG_SYSLOG_PERCPU_BUFSIZE)
+    {
+      ring->pr_lost++;
+      up_irq_restore(flags);
+      return buflen;
+    }
+
+  hdr.ph_seqno = atomic_fetch_add(&priv->ps_seqno, 1);
+  hdr.ph_len   = buflen;
+
+  head = syslog_percpu_copyin(ring, head, &hdr, sizeof(hdr));
+  head = syslog_percpu_copyin(ring, head, buffer, buflen);
+
+  /* Publish the message only after it was written */
+
+  atomic_store_explicit(&ring->pr_head, head, memory_order_release);
+
+  up_irq_restore(flags);
+
+  /* While the buffer is not empty the flusher thread already has a wake-up
+   * pending, so the semaphore is only posted once per batch.
+   */
+
+  if (used == 0)
+    {
+      nxsem_post(&priv->ps_sem);
+    }
+
+  return buflen;
+}
+
+/****************************************************************************
+ * Name: syslog_flush_percpu
+ *
+ * Description:
+ *   Called from syslog_flush().  Write the buffered messages out at once.
+ *   Buffering goes on afterwards unless the panic is fatal.
+ *
+ ****************************************************************************/
+
+void syslog_flush_percpu(void)
+{
+  syslog_percpu_drain(true);
+}
+
+/****************************************************************************
+ * Name: syslog_percpu_initialize
+ *
+ * Description:
+ *   Start the flusher thread.  Until it runs, messages are written to the
+ *   SYSLOG channels by the caller.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int syslog_percpu_initialize(void)
+{
+  int ret;
+
+  ret = kthread_create("syslog", CONFIG_SYSLOG_PERCPU_PRIORITY,
+                       CONFIG_SYSLOG_PERCPU_STACKSIZE,
+                       syslog_percpu_thread, NULL);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  g_syslog_percpu.ps_nb.notifier_call = syslog_percpu_notifier;
+  panic_notifier_chain_register(&g_syslog_percpu.ps_nb);
+
+  g_syslog_percpu.ps_running = true;
+  return OK;
+}
+
+#endif /* CONFIG_SYSLOG_PERCPU_BUFFER */
@@ -57,6 +57,21 @@ int syslog_putc(int ch)
 {
   int i;
 
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+  /* Leave the output to the flusher thread if possible.  Each character
+   * is a record of its own:  formatted messages come in one piece through
+   * syslog_write() with CONFIG_SYSLOG_BUFFER, only stray characters from
+   * low-level code take this path.
+   */
+
+  char tmp = ch;
+
+  if (syslog_add_percpu(&tmp, 1) >= 0)
+    {
+      return ch;
+    }
+#endif
+
   /* Is this an attempt to do SYSLOG output from an interrupt handler? */
 
   if (up_interrupt_context() || sched_idletask())
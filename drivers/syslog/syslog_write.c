@@ -146,10 +146,11 @@ static ssize_t syslog_default_write(FAR const char *buffer, size_t buflen)
  ****************************************************************************/
 
 /****************************************************************************
- * Name: syslog_write
+ * Name: syslog_write_channels
  *
  * Description:
- *   This is the low-level, multiple character, system logging interface.
+ *   Write to the SYSLOG channels from the calling context, bypassing the
+ *   per-CPU buffer.
  *
  * Input Parameters:
  *   buffer - The buffer containing the data to be output
@@ -161,7 +162,7 @@ static ssize_t syslog_default_write(FAR const char *buffer, size_t buflen)
  *
  ****************************************************************************/
 
-ssize_t syslog_write(FAR const char *buffer, size_t buflen)
+ssize_t syslog_write_channels(FAR const char *buffer, size_t buflen)
 {
 #ifdef CONFIG_SYSLOG_INTBUFFER
   if (!up_interrupt_context() && !sched_idletask())
@@ -176,3 +177,34 @@ ssize_t syslog_write(FAR const char *buffer, size_t buflen)
 
   return syslog_default_write(buffer, buflen);
 }
+
+/****************************************************************************
+ * Name: syslog_write
+ *
+ * Description:
+ *   This is the low-level, multiple character, system logging interface.
+ *
+ * Input Parameters:
+ *   buffer - The buffer containing the data to be output
+ *   buflen - The number of bytes in the buffer
+ *
+ * Returned Value:
+ *   On success, the number of characters written is returned.  A negated
+ *   errno value is returned on any failure.
+ *
+ ****************************************************************************/
+
+ssize_t syslog_write(FAR const char *buffer, size_t buflen)
+{
+#ifdef CONFIG_SYSLOG_PERCPU_BUFFER
+  /* Leave the output to the flusher thread if possible */
+
+  ssize_t ret = syslog_add_percpu(buffer, buflen);
+  if (ret >= 0)
+    {
+      return ret;
+    }
+#endif
+
+  return syslog_write_channels(buffer, buflen);
+}
@@ -22,14 +22,18 @@
  * Included Files
  ****************************************************************************/
 
+#include <sys/param.h>
+
 #include <debug.h>
 #include <errno.h>
 #include <stdio.h>
 
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
-#include <nuttx/mutex.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/queue.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
 #include <nuttx/virtio/virtio.h>
 
 #include "virtio-blk.h"
@@ -53,10 +57,21 @@
 #define VIRTIO_BLK_S_IOERR          1
 #define VIRTIO_BLK_S_UNSUPP         2
 
+/* Block feature bits */
+
+#define VIRTIO_BLK_F_SEG_MAX        2  /* seg_max is valid */
+
 /* Block device sector size */
 
 #define VIRTIO_BLK_SECTOR_SIZE      512
 
+/* Maximum number of data segments in one (coalesced) virtio request.  The
+ * out and in headers take two more descriptors.  The seg_max of the device
+ * lowers it further.
+ */
+
+#define VIRTIO_BLK_MAX_SEGS         16
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -105,20 +120,59 @@ begin_packed_struct struct virtio_blk_config_s
   uint32_t secure_erase_sector_alignment;
 } end_packed_struct;
 
+/* One block request.  A request sits on the pending queue until the
+ * virtqueue has room for it; adjacent pending requests of the same type
+ * are chained behind the head request and submitted as one virtio request
+ * with several data segments, using the head request's headers.
+ */
+
+struct virtio_blk_ioreq_s
+{
+  sq_entry_t                     node;     /* Free/pending queue link */
+  FAR struct virtio_blk_ioreq_s *next;     /* Next coalesced request */
+  FAR struct virtio_blk_req_s   *req;      /* Virtio block out header */
+  FAR struct virtio_blk_resp_s  *resp;     /* Virtio block in header */
+  FAR void                      *buffer;   /* Read/write buffer */
+  uint64_t                       sector;   /* Start sector */
+  uint32_t                       nsectors; /* Number of sectors */
+  uint32_t                       type;     /* VIRTIO_BLK_T_* */
+  int                            result;   /* Completion result */
+  sem_t                          done;     /* Posted on completion */
+};
+
 struct virtio_blk_priv_s
 {
-  FAR struct virtio_device     *vdev;           /* Virtio deivce */
-  FAR struct virtio_blk_req_s  *req;            /* Virtio block out header */
-  FAR struct virtio_blk_resp_s *resp;           /* Virtio block in header */
-  mutex_t                       lock;           /* Lock */
-  uint64_t                      nsectors;       /* Sectore numbers */
-  char                          name[NAME_MAX]; /* Device name */
+  FAR struct virtio_device      *vdev;           /* Virtio deivce */
+  FAR struct virtio_blk_req_s   *req;            /* Out header array */
+  FAR struct virtio_blk_resp_s  *resp;           /* In header array */
+  FAR struct virtio_blk_ioreq_s *ioreqs;         /* Request pool */
+  unsigned int                   nreqs;          /* Request pool size */
+  unsigned int                   maxsegs;        /* Segments per request */
+  sq_queue_t                     freeq;          /* Free requests */
+  sq_queue_t                     pendq;          /* Not yet submitted */
+  sem_t                          reqsem;         /* Counts free requests */
+  spinlock_t                     lock;           /* Lock */
+  uint64_t                       nsectors;       /* Sectore numbers */
+  char                           name[NAME_MAX]; /* Device name */
 };
 
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
 
+/* Request queue helper functions */
+
+static FAR struct virtio_blk_ioreq_s *
+virtio_blk_allocreq(FAR struct virtio_blk_priv_s *priv);
+static void    virtio_blk_freereq(FAR struct virtio_blk_priv_s *priv,
+                                  FAR struct virtio_blk_ioreq_s *ioreq);
+static void    virtio_blk_coalesce(FAR struct virtio_blk_priv_s *priv,
+                                   FAR struct virtio_blk_ioreq_s *head,
+                                   unsigned int maxsegs);
+static bool    virtio_blk_dispatch(FAR struct virtio_blk_priv_s *priv);
+static int     virtio_blk_transfer(FAR struct virtio_blk_priv_s *priv,
+                                   FAR struct virtio_blk_ioreq_s *ioreq);
+
 /* BLK block_operations functions and they helper function */
 
 static ssize_t virtio_blk_rdwr(FAR struct virtio_blk_priv_s *priv,
@@ -176,73 +230,238 @@ static int g_virtio_blk_idx = 0;
  ****************************************************************************/
 
 /****************************************************************************
- * Name: virtio_blk_rdwr
+ * Name: virtio_blk_allocreq
  *
  * Description:
- *   Common function for read and write
+ *   Take a request from the pool, waiting until one is released if all of
+ *   them are in flight.
  *
  ****************************************************************************/
 
-static ssize_t virtio_blk_rdwr(FAR struct virtio_blk_priv_s *priv,
-                               FAR void *buffer, blkcnt_t startsector,
-                               unsigned int nsectors, bool write)
+static FAR struct virtio_blk_ioreq_s *
+virtio_blk_allocreq(FAR struct virtio_blk_priv_s *priv)
 {
-  FAR struct virtio_device *vdev = priv->vdev;
-  FAR struct virtqueue *vq = vdev->vrings_info[0].vq;
-  FAR struct virtqueue_buf vb[3];
-  sem_t respsem;
-  ssize_t ret;
-  int readnum;
+  FAR struct virtio_blk_ioreq_s *ioreq;
+  irqstate_t flags;
 
-  ret = nxmutex_lock(&priv->lock);
-  if (ret < 0)
+  nxsem_wait_uninterruptible(&priv->reqsem);
+
+  flags = spin_lock_irqsave(&priv->lock);
+  ioreq = (FAR struct virtio_blk_ioreq_s *)sq_remfirst(&priv->freeq);
+  spin_unlock_irqrestore(&priv->lock, flags);
+
+  DEBUGASSERT(ioreq != NULL);
+  ioreq->next = NULL;
+  return ioreq;
+}
+
+/****************************************************************************
+ * Name: virtio_blk_freereq
+ ****************************************************************************/
+
+static void virtio_blk_freereq(FAR struct virtio_blk_priv_s *priv,
+                               FAR struct virtio_blk_ioreq_s *ioreq)
+{
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&priv->lock);
+  sq_addlast(&ioreq->node, &priv->freeq);
+  spin_unlock_irqrestore(&priv->lock, flags);
+
+  nxsem_post(&priv->reqsem);
+}
+
+/****************************************************************************
+ * Name: virtio_blk_coalesce
+ *
+ * Description:
+ *   Chain pending requests that continue where the head request ends
+ *   behind it, so that they are transferred as one virtio request.  Must
+ *   be called with priv->lock held and with head already removed from the
+ *   pending queue.
+ *
+ ****************************************************************************/
+
+static void virtio_blk_coalesce(FAR struct virtio_blk_priv_s *priv,
+                                FAR struct virtio_blk_ioreq_s *head,
+                                unsigned int maxsegs)
+{
+  FAR struct virtio_blk_ioreq_s *tail = head;
+  FAR struct virtio_blk_ioreq_s *ioreq;
+  FAR sq_entry_t *prev;
+  FAR sq_entry_t *curr;
+  unsigned int nsegs = 1;
+
+  if (head->type == VIRTIO_BLK_T_FLUSH)
     {
-      return ret;
+      return;
     }
 
-  nxsem_init(&respsem, 0, 0);
+  while (nsegs < maxsegs)
+    {
+      prev = NULL;
+      for (curr = sq_peek(&priv->pendq); curr != NULL; curr = sq_next(curr))
+        {
+          ioreq = (FAR struct virtio_blk_ioreq_s *)curr;
+          if (ioreq->type == head->type &&
+              ioreq->sector == tail->sector + tail->nsectors)
+            {
+              break;
+            }
+
+          prev = curr;
+        }
+
+      if (curr == NULL)
+        {
+          break;
+        }
+
+      if (prev == NULL)
+        {
+          sq_remfirst(&priv->pendq);
+        }
+      else
+        {
+          sq_remafter(prev, &priv->pendq);
+        }
+
+      tail->next = ioreq;
+      tail       = ioreq;
+      nsegs++;
+    }
+}
 
-  /* Build the block request */
+/****************************************************************************
+ * Name: virtio_blk_dispatch
+ *
+ * Description:
+ *   Move as many pending requests to the virtqueue as it has descriptors
+ *   for.  Must be called with priv->lock held.  Returns true if anything
+ *   was added and the device needs to be kicked.
+ *
+ ****************************************************************************/
+
+static bool virtio_blk_dispatch(FAR struct virtio_blk_priv_s *priv)
+{
+  FAR struct virtqueue *vq = priv->vdev->vrings_info[0].vq;
+  FAR struct virtqueue_buf vb[VIRTIO_BLK_MAX_SEGS + 2];
+  FAR struct virtio_blk_ioreq_s *head;
+  FAR struct virtio_blk_ioreq_s *ioreq;
+  unsigned int maxsegs;
+  bool kick = false;
+  int readnum;
+  int num;
 
-  priv->req->type     = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
-  priv->req->reserved = 0;
-  priv->req->sector   = startsector;
-  priv->resp->status  = VIRTIO_BLK_S_IOERR;
+  while (!sq_empty(&priv->pendq) && vq->vq_free_cnt >= 3)
+    {
+      head    = (FAR struct virtio_blk_ioreq_s *)sq_remfirst(&priv->pendq);
+      maxsegs = MIN(vq->vq_free_cnt - 2, priv->maxsegs);
+      virtio_blk_coalesce(priv, head, maxsegs);
+
+      head->req->type     = head->type;
+      head->req->reserved = 0;
+      head->req->sector   = head->type == VIRTIO_BLK_T_FLUSH ?
+                            0 : head->sector;
+      head->resp->status  = VIRTIO_BLK_S_IOERR;
+
+      /* Fill the virtqueue buffer:
+       * Buffer 0: the block out header;
+       * Buffer 1 ~ n: the read/write buffers of the chained requests;
+       * Buffer n + 1: the block in header, return the status.
+       */
+
+      vb[0].buf = head->req;
+      vb[0].len = VIRTIO_BLK_REQ_HEADER_SIZE;
+      num = 1;
+
+      if (head->type != VIRTIO_BLK_T_FLUSH)
+        {
+          for (ioreq = head; ioreq != NULL; ioreq = ioreq->next)
+            {
+              vb[num].buf = ioreq->buffer;
+              vb[num].len = ioreq->nsectors * VIRTIO_BLK_SECTOR_SIZE;
+              num++;
+            }
+        }
+
+      readnum = head->type == VIRTIO_BLK_T_OUT ? num : 1;
+      vb[num].buf = head->resp;
+      vb[num].len = VIRTIO_BLK_RESP_HEADER_SIZE;
+      num++;
+
+      virtqueue_add_buffer(vq, vb, readnum, num - readnum, head);
+      kick = true;
+    }
 
-  /* Fill the virtqueue buffer:
-   * Buffer 0: the block out header;
-   * Buffer 1: the read/write buffer;
-   * Buffer 2: the block in header, return the status.
-   */
+  return kick;
+}
 
-  vb[0].buf = priv->req;
-  vb[0].len = VIRTIO_BLK_REQ_HEADER_SIZE;
-  vb[1].buf = buffer;
-  vb[1].len = nsectors * VIRTIO_BLK_SECTOR_SIZE;
-  vb[2].buf = priv->resp;
-  vb[2].len = VIRTIO_BLK_RESP_HEADER_SIZE;
-  readnum = write ? 2 : 1;
-  ret = virtqueue_add_buffer(vq, vb, readnum, 3 - readnum, &respsem);
-  if (ret < 0)
+/****************************************************************************
+ * Name: virtio_blk_transfer
+ *
+ * Description:
+ *   Queue a request, submit it to the device as soon as the virtqueue has
+ *   room and wait for its completion.  Other callers keep running and may
+ *   have their requests in flight at the same time.
+ *
+ ****************************************************************************/
+
+static int virtio_blk_transfer(FAR struct virtio_blk_priv_s *priv,
+                               FAR struct virtio_blk_ioreq_s *ioreq)
+{
+  FAR struct virtqueue *vq = priv->vdev->vrings_info[0].vq;
+  irqstate_t flags;
+  int ret;
+
+  flags = spin_lock_irqsave(&priv->lock);
+  sq_addlast(&ioreq->node, &priv->pendq);
+  if (virtio_blk_dispatch(priv))
     {
-      vrterr("virtqueue_add_buffer failed, ret=%zd\n", ret);
-      goto err;
+      virtqueue_kick(vq);
     }
 
-  virtqueue_kick(vq);
+  spin_unlock_irqrestore(&priv->lock, flags);
 
   /* Wait for the request completion */
 
-  nxsem_wait_uninterruptible(&respsem);
-  if (priv->resp->status != VIRTIO_BLK_S_OK)
+  nxsem_wait_uninterruptible(&ioreq->done);
+  ret = ioreq->result;
+  virtio_blk_freereq(priv, ioreq);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: virtio_blk_rdwr
+ *
+ * Description:
+ *   Common function for read and write
+ *
+ ****************************************************************************/
+
+static ssize_t virtio_blk_rdwr(FAR struct virtio_blk_priv_s *priv,
+                               FAR void *buffer, blkcnt_t startsector,
+                               unsigned int nsectors, bool write)
+{
+  FAR struct virtio_blk_ioreq_s *ioreq;
+  int ret;
+
+  /* Build the block request */
+
+  ioreq           = virtio_blk_allocreq(priv);
+  ioreq->type     = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+  ioreq->sector   = startsector;
+  ioreq->nsectors = nsectors;
+  ioreq->buffer   = buffer;
+
+  ret = virtio_blk_transfer(priv, ioreq);
+  if (ret < 0)
     {
       vrterr("%s Error\n", write ? "Write" : "Read");
-      ret = -EIO;
+      return ret;
     }
 
-err:
-  nxmutex_unlock(&priv->lock);
-  return ret >= 0 ? nsectors : ret;
+  return nsectors;
 }
 
 /****************************************************************************
@@ -342,55 +561,28 @@ static int virtio_blk_geometry(FAR struct inode *inode,
 }
 
 /****************************************************************************
- * Name: virtio_blk_ioctl
+ * Name: virtio_blk_flush
+ *
+ * Description:
+ *   Flush the device write cache.  Every write that has returned to its
+ *   caller has completed, so the flush covers all of them.
+ *
  ****************************************************************************/
 
 static int virtio_blk_flush(FAR struct virtio_blk_priv_s *priv)
 {
-  FAR struct virtio_device *vdev = priv->vdev;
-  FAR struct virtqueue *vq = vdev->vrings_info[0].vq;
-  FAR struct virtqueue_buf vb[2];
-  sem_t respsem;
+  FAR struct virtio_blk_ioreq_s *ioreq;
   int ret;
 
-  ret = nxmutex_lock(&priv->lock);
-  if (ret < 0)
-    {
-      return ret;
-    }
-
-  nxsem_init(&respsem, 0, 0);
-
-  /* Build the block request */
+  ioreq       = virtio_blk_allocreq(priv);
+  ioreq->type = VIRTIO_BLK_T_FLUSH;
 
-  priv->req->type     = VIRTIO_BLK_T_FLUSH;
-  priv->req->reserved = 0;
-  priv->req->sector   = 0;
-  priv->resp->status  = VIRTIO_BLK_S_IOERR;
-
-  vb[0].buf = priv->req;
-  vb[0].len = VIRTIO_BLK_REQ_HEADER_SIZE;
-  vb[1].buf = priv->resp;
-  vb[1].len = VIRTIO_BLK_RESP_HEADER_SIZE;
-  ret = virtqueue_add_buffer(vq, vb, 1, 1, &respsem);
+  ret = virtio_blk_transfer(priv, ioreq);
   if (ret < 0)
-    {
-      goto err;
-    }
-
-  virtqueue_kick(vq);
-
-  /* Wait for the request completion */
-
-  nxsem_wait_uninterruptible(&respsem);
-  if (priv->resp->status != VIRTIO_BLK_S_OK)
     {
       vrterr("Flush Error\n");
-      ret = -EIO;
     }
 
-err:
-  nxmutex_unlock(&priv->lock);
   return ret;
 }
 
@@ -419,16 +611,51 @@ static int virtio_blk_ioctl(FAR struct inode *inode, int cmd,
 
 /****************************************************************************
  * Name: virtio_blk_done
+ *
+ * Description:
+ *   Complete every finished request (including the requests coalesced
+ *   behind it) and refill the virtqueue from the pending queue.
+ *
  ****************************************************************************/
 
 static void virtio_blk_done(FAR struct virtqueue *vq)
 {
-  FAR sem_t *respsem;
+  FAR struct virtio_blk_priv_s *priv = vq->vq_dev->priv;
+  FAR struct virtio_blk_ioreq_s *head;
+  FAR struct virtio_blk_ioreq_s *next;
+  sq_queue_t doneq;
+  irqstate_t flags;
+  int result;
+
+  sq_init(&doneq);
+  flags = spin_lock_irqsave(&priv->lock);
+
+  while ((head = virtqueue_get_buffer(vq, NULL, NULL)) != NULL)
+    {
+      sq_addlast(&head->node, &doneq);
+    }
+
+  if (virtio_blk_dispatch(priv))
+    {
+      virtqueue_kick(vq);
+    }
 
-  respsem = virtqueue_get_buffer(vq, NULL, NULL);
-  if (respsem != NULL)
+  spin_unlock_irqrestore(&priv->lock, flags);
+
+  /* Wake up the waiters outside of the lock */
+
+  while ((head = (FAR struct virtio_blk_ioreq_s *)sq_remfirst(&doneq))
+         != NULL)
     {
-      nxsem_post(respsem);
+      result = head->resp->status == VIRTIO_BLK_S_OK ? OK : -EIO;
+      for (; head != NULL; head = next)
+        {
+          /* The waiter may reuse the request as soon as it is posted */
+
+          next         = head->next;
+          head->result = result;
+          nxsem_post(&head->done);
+        }
     }
 }
 
@@ -439,55 +666,109 @@ static void virtio_blk_done(FAR struct virtqueue *vq)
 static int virtio_blk_init(FAR struct virtio_blk_priv_s *priv,
                            FAR struct virtio_device *vdev)
 {
+  FAR struct virtio_blk_ioreq_s *ioreq;
   FAR const char *vqname[1];
   vq_callback callback[1];
+  uint32_t features;
+  uint32_t segmax;
+  unsigned int i;
   int ret;
 
   priv->vdev = vdev;
   vdev->priv = priv;
-  nxmutex_init(&priv->lock);
+  spin_initialize(&priv->lock, SP_UNLOCKED);
+  sq_init(&priv->freeq);
+  sq_init(&priv->pendq);
 
-  /* Alloc the request and in header from tansport layer */
+  /* Initialize the virtio device */
 
-  priv->req = virtio_alloc_buf(vdev, sizeof(*priv->req), 16);
+  virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER);
+  features = virtio_get_features(vdev) & (1 << VIRTIO_BLK_F_SEG_MAX);
+  virtio_set_features(vdev, features);
+  virtio_set_status(vdev, VIRTIO_CONFIG_FEATURES_OK);
+
+  /* Never chain more data segments than the device accepts */
+
+  priv->maxsegs = VIRTIO_BLK_MAX_SEGS;
+  if ((features & (1 << VIRTIO_BLK_F_SEG_MAX)) != 0)
+    {
+      virtio_read_config_member(vdev, struct virtio_blk_config_s, seg_max,
+                                &segmax);
+      if (segmax > 0)
+        {
+          priv->maxsegs = MIN(priv->maxsegs, segmax);
+        }
+    }
+
+  vqname[0]   = "virtio_blk_vq";
+  callback[0] = virtio_blk_done;
+  ret = virtio_create_virtqueues(vdev, 0, 1, vqname, callback);
+  if (ret < 0)
+    {
+      vrterr("virtio_device_create_virtqueue failed, ret=%d\n", ret);
+      return ret;
+    }
+
+  /* Size the request pool larger than the virtqueue capacity:  every
+   * request takes at least three descriptors, so one request per
+   * descriptor is three times what the virtqueue holds at once.  The
+   * requests beyond its capacity wait on the pending queue, where they
+   * can be coalesced.
+   */
+
+#if CONFIG_DRIVERS_VIRTIO_BLK_NREQS > 0
+  priv->nreqs = CONFIG_DRIVERS_VIRTIO_BLK_NREQS;
+#else
+  priv->nreqs = MAX(vdev->vrings_info[0].info.num_descs, 1);
+#endif
+
+  priv->ioreqs = kmm_zalloc(priv->nreqs * sizeof(*priv->ioreqs));
+  if (priv->ioreqs == NULL)
+    {
+      ret = -ENOMEM;
+      goto err_with_vq;
+    }
+
+  /* Alloc the request and in headers from tansport layer */
+
+  priv->req = virtio_alloc_buf(vdev, priv->nreqs * sizeof(*priv->req), 16);
   if (priv->req == NULL)
     {
       ret = -ENOMEM;
-      goto err_with_lock;
+      goto err_with_ioreqs;
     }
 
-  priv->resp = virtio_alloc_buf(vdev, sizeof(*priv->resp), 16);
+  priv->resp = virtio_alloc_buf(vdev, priv->nreqs * sizeof(*priv->resp),
+                                16);
   if (priv->resp == NULL)
     {
       ret = -ENOMEM;
       goto err_with_req;
     }
 
-  /* Initialize the virtio device */
-
-  virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER);
-  virtio_set_features(vdev, 0);
-  virtio_set_status(vdev, VIRTIO_CONFIG_FEATURES_OK);
-
-  vqname[0]   = "virtio_blk_vq";
-  callback[0] = virtio_blk_done;
-  ret = virtio_create_virtqueues(vdev, 0, 1, vqname, callback);
-  if (ret < 0)
+  for (i = 0; i < priv->nreqs; i++)
     {
-      vrterr("virtio_device_create_virtqueue failed, ret=%d\n", ret);
-      goto err_with_resp;
+      ioreq       = &priv->ioreqs[i];
+      ioreq->req  = &priv->req[i];
+      ioreq->resp = &priv->resp[i];
+      nxsem_init(&ioreq->done, 0, 0);
+      sq_addlast(&ioreq->node, &priv->freeq);
     }
 
+  nxsem_init(&priv->reqsem, 0, priv->nreqs);
+  vrtinfo("Virtio blk requests=%u\n", priv->nreqs);
+
   virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER_OK);
   virtqueue_enable_cb(vdev->vrings_info[0].vq);
   return OK;
 
-err_with_resp:
-  virtio_free_buf(vdev, priv->resp);
 err_with_req:
   virtio_free_buf(vdev, priv->req);
-err_with_lock:
-  nxmutex_destroy(&priv->lock);
+err_with_ioreqs:
+  kmm_free(priv->ioreqs);
+err_with_vq:
+  virtio_reset_device(vdev);
+  virtio_delete_virtqueues(vdev);
   return ret;
 }
 
@@ -498,12 +779,20 @@ err_with_lock:
 static void virtio_blk_uninit(FAR struct virtio_blk_priv_s *priv)
 {
   FAR struct virtio_device *vdev = priv->vdev;
+  unsigned int i;
 
   virtio_reset_device(vdev);
   virtio_delete_virtqueues(vdev);
+
+  for (i = 0; i < priv->nreqs; i++)
+    {
+      nxsem_destroy(&priv->ioreqs[i].done);
+    }
+
+  nxsem_destroy(&priv->reqsem);
   virtio_free_buf(vdev, priv->resp);
   virtio_free_buf(vdev, priv->req);
-  nxmutex_destroy(&priv->lock);
+  kmm_free(priv->ioreqs);
 }
 
 /****************************************************************************
@@ -31,6 +31,7 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/net/ip.h>
 #include <nuttx/net/netdev_lowerhalf.h>
+#include <nuttx/net/tcp.h>
 #include <nuttx/virtio/virtio.h>
 
 #include "virtio-net.h"
@@ -56,12 +57,61 @@
 #define VIRTIO_NET_MAX_NIOB \
     ((VIRTIO_NET_MAX_PKT_SIZE + CONFIG_IOB_BUFSIZE - 1) / CONFIG_IOB_BUFSIZE)
 
+/* A TCP super-segment holds at most CONFIG_NETDEV_GSO_MAXSEGS segments */
+
+#ifdef CONFIG_NETDEV_GSO
+#  define VIRTIO_NET_MAX_TXSIZE \
+     (CONFIG_NETDEV_GSO_MAXSEGS * VIRTIO_NET_BUFSIZE)
+#else
+#  define VIRTIO_NET_MAX_TXSIZE VIRTIO_NET_BUFSIZE
+#endif
+
+#define VIRTIO_NET_MAX_TX_NIOB \
+    ((CONFIG_NET_LL_GUARDSIZE - ETH_HDRLEN + VIRTIO_NET_MAX_TXSIZE + \
+      CONFIG_IOB_BUFSIZE - 1) / CONFIG_IOB_BUFSIZE)
+
+/* Virtio net feature bits */
+
+#define VIRTIO_NET_F_CSUM           0  /* Device handles partial checksums */
+#define VIRTIO_NET_F_GUEST_CSUM     1  /* Driver handles partial checksums */
+#define VIRTIO_NET_F_HOST_TSO4      11 /* Device handles TCPv4 GSO */
+#define VIRTIO_NET_F_HOST_TSO6      12 /* Device handles TCPv6 GSO */
+
+/* The features requested by the driver.  Received packets may be left with
+ * a partial checksum, which cannot be forwarded.
+ */
+
+#ifdef CONFIG_NETDEV_GSO
+#  define VIRTIO_NET_TSO_FEATURES ((1 << VIRTIO_NET_F_HOST_TSO4) | \
+                                   (1 << VIRTIO_NET_F_HOST_TSO6))
+#else
+#  define VIRTIO_NET_TSO_FEATURES 0
+#endif
+
+#ifdef CONFIG_NET_IPFORWARD
+#  define VIRTIO_NET_RXCSUM_FEATURES 0
+#else
+#  define VIRTIO_NET_RXCSUM_FEATURES (1 << VIRTIO_NET_F_GUEST_CSUM)
+#endif
+
+#define VIRTIO_NET_FEATURES ((1 << VIRTIO_NET_F_CSUM) | \
+                             VIRTIO_NET_RXCSUM_FEATURES | \
+                             VIRTIO_NET_TSO_FEATURES)
+
+/* Virtio net header flags and GSO types */
+
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1  /* Checksum to be computed */
+#define VIRTIO_NET_HDR_F_DATA_VALID 2  /* Checksum already verified */
+
+#define VIRTIO_NET_HDR_GSO_TCPV4    1
+#define VIRTIO_NET_HDR_GSO_TCPV6    4
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
-/* Virtio net header, just define it here for further, now only use it
- * to calculate the virto net header size, see marco VIRTIO_NET_HDRSIZE
+/* Virtio net header, carries the checksum and segmentation offload
+ * requests, see CONFIG_NETDEV_OFFLOAD
  */
 
 begin_packed_struct struct virtio_net_hdr_s
@@ -84,6 +134,15 @@ struct virtio_net_priv_s
 
   FAR struct virtio_device *vdev;      /* Virtio device pointer */
   int                       bufnum;    /* TX and RX Buffer number */
+  int                       txquota;   /* TX packets that always fit */
+
+  /* Scatter list of the packet being sent, which is too large for the
+   * stack with TCP segmentation offload.  The upper half sends one packet
+   * at a time.
+   */
+
+  struct virtqueue_buf      txvb[VIRTIO_NET_MAX_TX_NIOB];
+  struct iovec              txiov[VIRTIO_NET_MAX_TX_NIOB];
 };
 
 /* Virtio Link Layer Header, follow shows the iob buffer layout:
@@ -257,6 +316,39 @@ static void virtio_net_txfree(FAR struct netdev_lowerhalf_s *dev)
     }
 }
 
+#ifdef CONFIG_NETDEV_OFFLOAD
+/****************************************************************************
+ * Name: virtio_net_txhdr
+ ****************************************************************************/
+
+static void virtio_net_txhdr(FAR struct netdev_lowerhalf_s *dev,
+                             FAR netpkt_t *pkt,
+                             FAR struct virtio_net_hdr_s *vhdr)
+{
+  FAR struct tcp_hdr_s *tcp;
+
+  /* Pass the checksum and segmentation requests of the stack on */
+
+  if ((pkt->io_pktflags & NETPKT_F_CSUM_PARTIAL) != 0)
+    {
+      vhdr->flags       = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+      vhdr->csum_start  = pkt->io_csumstart;
+      vhdr->csum_offset = pkt->io_csumoff;
+    }
+
+  if ((pkt->io_pktflags & NETPKT_F_GSO) != 0)
+    {
+      tcp = (FAR struct tcp_hdr_s *)
+              (netpkt_getdata(dev, pkt) + pkt->io_csumstart);
+
+      vhdr->gso_type = (pkt->io_pktflags & NETPKT_F_GSO_TCPV4) != 0 ?
+                       VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+      vhdr->gso_size = pkt->io_gsosize;
+      vhdr->hdr_len  = pkt->io_csumstart + ((tcp->tcpoffset >> 4) << 2);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: virtio_net_ifup
  ****************************************************************************/
@@ -314,15 +406,22 @@ static int virtio_net_send(FAR struct netdev_lowerhalf_s *dev,
 {
   FAR struct virtio_net_priv_s *priv = (FAR struct virtio_net_priv_s *)dev;
   FAR struct virtqueue *vq = priv->vdev->vrings_info[VIRTIO_NET_TX].vq;
+  FAR struct virtqueue_buf *vb = priv->txvb;
   FAR struct virtio_net_llhdr_s *hdr;
-  struct virtqueue_buf vb[VIRTIO_NET_MAX_NIOB];
-  struct iovec iov[VIRTIO_NET_MAX_NIOB];
+  unsigned int maxlen = VIRTIO_NET_BUFSIZE;
   int iov_cnt;
   int i;
 
-  /* Check the send length */
+  /* Check the send length, a TCP super-segment may be larger */
+
+#ifdef CONFIG_NETDEV_GSO
+  if ((pkt->io_pktflags & NETPKT_F_GSO) != 0)
+    {
+      maxlen = VIRTIO_NET_MAX_TXSIZE;
+    }
+#endif
 
-  if (netpkt_getdatalen(dev, pkt) > VIRTIO_NET_BUFSIZE)
+  if (netpkt_getdatalen(dev, pkt) > maxlen)
     {
       vrterr("net send buffer too large\n");
       return -EINVAL;
@@ -330,11 +429,26 @@ static int virtio_net_send(FAR struct netdev_lowerhalf_s *dev,
 
   /* Convert netpkt to virtqueue_buf */
 
-  iov_cnt = netpkt_to_iov(dev, pkt, iov, VIRTIO_NET_MAX_NIOB);
+  iov_cnt = netpkt_to_iov(dev, pkt, priv->txiov, VIRTIO_NET_MAX_TX_NIOB);
   for (i = 0; i < iov_cnt; i++)
     {
-      vb[i].buf = iov[i].iov_base;
-      vb[i].len = iov[i].iov_len;
+      vb[i].buf = priv->txiov[i].iov_base;
+      vb[i].len = priv->txiov[i].iov_len;
+    }
+
+  /* The TX quota is set so that the packets in flight always fit in the
+   * descriptors, once those of the sent packets are returned.
+   */
+
+  if (iov_cnt > vq->vq_free_cnt)
+    {
+      virtio_net_txfree(dev);
+      if (iov_cnt > vq->vq_free_cnt)
+        {
+          vrterr("no free descriptor for %d buffers\n", iov_cnt);
+          virtqueue_enable_cb(vq);
+          return -EAGAIN;
+        }
     }
 
   /* Prepare virtio net header */
@@ -344,6 +458,9 @@ static int virtio_net_send(FAR struct netdev_lowerhalf_s *dev,
   DEBUGASSERT((FAR uint8_t *)hdr >= netpkt_getbase(pkt));
   hdr->pkt = pkt;
   memset(&hdr->vhdr, 0, sizeof(hdr->vhdr));
+#ifdef CONFIG_NETDEV_OFFLOAD
+  virtio_net_txhdr(dev, pkt, &hdr->vhdr);
+#endif
 
   /* Buffer 0 is the virtio net header */
 
@@ -409,6 +526,19 @@ static netpkt_t *virtio_net_recv(FAR struct netdev_lowerhalf_s *dev)
   /* Set the received pkt length */
 
   netpkt_setdatalen(dev, hdr->pkt, len - VIRTIO_NET_HDRSIZE);
+
+#ifdef CONFIG_NETDEV_OFFLOAD
+  /* The TCP/UDP checksum was verified by the device, or the packet comes
+   * from the host itself and was never summed.
+   */
+
+  if ((hdr->vhdr.flags & (VIRTIO_NET_HDR_F_NEEDS_CSUM |
+                          VIRTIO_NET_HDR_F_DATA_VALID)) != 0)
+    {
+      hdr->pkt->io_pktflags = NETPKT_F_CSUM_VALID;
+    }
+#endif
+
   vrtinfo("Recv, hdr=%p, pkt=%p, len=%" PRIu32 "\n", hdr, hdr->pkt, len);
   return hdr->pkt;
 }
@@ -479,6 +609,11 @@ static int virtio_net_init(FAR struct virtio_net_priv_s *priv,
 {
   FAR const char *vqnames[VIRTIO_NET_NUM];
   vq_callback callbacks[VIRTIO_NET_NUM];
+#ifdef CONFIG_NETDEV_OFFLOAD
+  uint32_t features;
+#endif
+  int txdescs;
+  int txniob;
   int ret;
 
   priv->vdev = vdev;
@@ -487,7 +622,34 @@ static int virtio_net_init(FAR struct virtio_net_priv_s *priv,
   /* Initialize the virtio device */
 
   virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER);
+#ifdef CONFIG_NETDEV_OFFLOAD
+  features = virtio_get_features(vdev) & VIRTIO_NET_FEATURES;
+  virtio_set_features(vdev, features);
+
+  /* Announce the negotiated offloads to the stack */
+
+  if ((features & (1 << VIRTIO_NET_F_CSUM)) != 0)
+    {
+      priv->lower.netdev.d_features |= NETDEV_F_TXCSUM;
+    }
+
+  if ((features & (1 << VIRTIO_NET_F_GUEST_CSUM)) != 0)
+    {
+      priv->lower.netdev.d_features |= NETDEV_F_RXCSUM;
+    }
+
+  if (VIRTIO_NET_TSO_FEATURES != 0 &&
+      (features & VIRTIO_NET_TSO_FEATURES) == VIRTIO_NET_TSO_FEATURES)
+    {
+      priv->lower.netdev.d_features |= NETDEV_F_TSO;
+    }
+
+  /* The upper half may segment and coalesce TCP in software for us */
+
+  priv->lower.netdev.d_features |= NETDEV_F_GSO | NETDEV_F_GRO;
+#else
   virtio_set_features(vdev, 0);
+#endif
   virtio_set_status(vdev, VIRTIO_CONFIG_FEATURES_OK);
 
   vqnames[VIRTIO_NET_RX]   = "virtio_net_rx";
@@ -517,6 +679,23 @@ static int virtio_net_init(FAR struct virtio_net_priv_s *priv,
                      priv->bufnum);
   priv->bufnum = MIN(vdev->vrings_info[VIRTIO_NET_TX].info.num_descs,
                      priv->bufnum);
+
+  /* The upper half drops a packet that the TX queue cannot take, so only
+   * allow as many packets in flight as always fit in its descriptors.  If
+   * a super-segment can never fit, do not send super-segments at all.
+   */
+
+  txdescs = vdev->vrings_info[VIRTIO_NET_TX].info.num_descs;
+  txniob  = VIRTIO_NET_MAX_TX_NIOB;
+#ifdef CONFIG_NETDEV_GSO
+  if (txniob > txdescs)
+    {
+      priv->lower.netdev.d_features &= ~(NETDEV_F_TSO | NETDEV_F_GSO);
+      txniob = VIRTIO_NET_MAX_NIOB;
+    }
+#endif
+
+  priv->txquota = MIN(MAX(txdescs / txniob, 1), priv->bufnum);
   return OK;
 }
 
@@ -548,7 +727,7 @@ static int virtio_net_probe(FAR struct virtio_device *vdev)
 
   netdev = &priv->lower;
   netdev->quota[NETPKT_RX] = priv->bufnum;
-  netdev->quota[NETPKT_TX] = priv->bufnum;
+  netdev->quota[NETPKT_TX] = priv->txquota;
   netdev->ops = &g_virtio_net_ops;
 
   /* Register the net deivce */
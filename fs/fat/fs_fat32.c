@@ -1023,6 +1023,7 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
   int32_t cluster;
   off_t position;
   unsigned int clustersize;
+  uint32_t index;
   int ret;
 
   /* Sanity checks */
@@ -1153,6 +1154,13 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
        */
 
       clustersize = fs->fs_fatsecperclus * fs->fs_hwsectorsize;
+
+      /* Skip the part of the chain that is recorded in the extent map */
+
+      index         = fat_extentfind(ff, position / clustersize, &cluster);
+      filep->f_pos += (off_t)index * clustersize;
+      position     -= (off_t)index * clustersize;
+
       for (; ; )
         {
           /* Skip over clusters prior to the one containing
@@ -1223,6 +1231,11 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
 
           filep->f_pos += clustersize;
           position     -= clustersize;
+
+          /* Remember where the chain leads */
+
+          index++;
+          fat_extentadd(ff, index, cluster);
         }
 
       /* We get here after we have found the sector containing
@@ -1544,6 +1557,8 @@ static int fat_dup(FAR const struct file *oldp, FAR struct file *newp)
   newff->ff_currentsector    = oldff->ff_currentsector;    /* Current sector */
   newff->ff_cachesector      = 0;                          /* Sector in file buffer */
 
+  fat_extentinvalidate(newff);
+
   /* Attach the private date to the struct file instance */
 
   newp->f_priv = newff;
@@ -1884,6 +1899,10 @@ static int fat_truncate(FAR struct file *filep, off_t length)
           ff->ff_size = length;
           ret = OK;
         }
+
+      /* The end of the cluster chain has changed */
+
+      fat_extentinvalidate(ff);
     }
   else
     {
@@ -2302,6 +2321,21 @@ static int fat_unbind(FAR void *handle, FAR struct inode **blkdriver,
       fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
     }
 
+#if FAT_NCACHESECTORS > 0
+  if (fs->fs_cachebuffer)
+    {
+      fat_io_free(fs->fs_cachebuffer,
+                  fs->fs_hwsectorsize * FAT_NCACHESECTORS);
+    }
+#endif
+
+#ifdef CONFIG_FAT_FREEMAP
+  if (fs->fs_freemap)
+    {
+      kmm_free(fs->fs_freemap);
+    }
+#endif
+
   nxmutex_destroy(&fs->fs_lock);
   kmm_free(fs);
   return OK;
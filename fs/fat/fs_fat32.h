@@ -336,6 +336,26 @@
 
 #define UMOUNT_FORCED        8
 
+/* Mountpoint sector cache.  The first CONFIG_FAT_FATCACHE_NSECTORS entries
+ * of fs_cache[] hold FAT sectors, the remaining entries hold sectors from
+ * the rest of the volume.
+ */
+
+#ifndef CONFIG_FAT_FATCACHE_NSECTORS
+#  define CONFIG_FAT_FATCACHE_NSECTORS 0
+#endif
+
+#ifndef CONFIG_FAT_DATACACHE_NSECTORS
+#  define CONFIG_FAT_DATACACHE_NSECTORS 0
+#endif
+
+#define FAT_NCACHESECTORS    (CONFIG_FAT_FATCACHE_NSECTORS + \
+                              CONFIG_FAT_DATACACHE_NSECTORS)
+
+#ifndef CONFIG_FAT_EXTENT_NRUNS
+#  define CONFIG_FAT_EXTENT_NRUNS 0
+#endif
+
 /****************************************************************************
  * These offset describe the FSINFO sector
  */
@@ -853,6 +873,25 @@
  * Public Types
  ****************************************************************************/
 
+/* This structure describes one sector of the mountpoint sector cache */
+
+struct fat_cachesector_s
+{
+  off_t    cs_sector;              /* The sector number buffered, -1: unused */
+  uint32_t cs_stamp;               /* LRU time stamp of the last access */
+  bool     cs_dirty;               /* true: cs_buffer must be written back */
+  uint8_t *cs_buffer;              /* One sector buffer */
+};
+
+/* This structure describes a run of contiguous clusters of an open file */
+
+struct fat_extent_s
+{
+  uint32_t fe_index;               /* Index of the first cluster in the file */
+  uint32_t fe_cluster;             /* Number of the first cluster */
+  uint32_t fe_count;               /* Number of clusters in the run */
+};
+
 /* This structure represents the overall mountpoint state.  An instance of
  * this structure is retained as inode private data on each mountpoint that
  * is mounted with a fat32 filesystem.
@@ -887,6 +926,14 @@ struct fat_mountpt_s
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
   uint8_t *fs_buffer;              /* This is an allocated buffer to hold one
                                     * sector from the device */
+#if FAT_NCACHESECTORS > 0
+  uint32_t fs_cacheclock;          /* LRU clock of the sector cache */
+  uint8_t *fs_cachebuffer;         /* Sector buffers of the sector cache */
+  struct fat_cachesector_s fs_cache[FAT_NCACHESECTORS];
+#endif
+#ifdef CONFIG_FAT_FREEMAP
+  uint32_t *fs_freemap;            /* Bitmap of allocated clusters */
+#endif
 };
 
 /* This structure represents on open file under the mountpoint.  An instance
@@ -908,6 +955,10 @@ struct fat_file_s
   off_t    ff_currentsector;       /* Current sector being operated on */
   off_t    ff_cachesector;         /* Current sector in the file buffer */
   uint8_t *ff_buffer;              /* File buffer (for partial sector accesses) */
+#if CONFIG_FAT_EXTENT_NRUNS > 0
+  uint16_t ff_nextents;            /* Number of valid entries in ff_extents */
+  struct fat_extent_s ff_extents[CONFIG_FAT_EXTENT_NRUNS];
+#endif
 };
 
 /* This structure holds the sequence of directory entries used by one
@@ -1094,6 +1145,25 @@ EXTERN int    fat_ffcacheread(FAR struct fat_mountpt_s *fs,
                               FAR struct fat_file_s *ff, off_t sector);
 EXTERN int    fat_ffcacheinvalidate(FAR struct fat_mountpt_s *fs,
                                     FAR struct fat_file_s *ff);
+#if FAT_NCACHESECTORS > 0
+EXTERN int    fat_fscacheinit(FAR struct fat_mountpt_s *fs);
+EXTERN void   fat_fscacheinvalidate(FAR struct fat_mountpt_s *fs,
+                                    off_t sector, unsigned int nsectors);
+#endif
+
+/* Per-file cluster extent map */
+
+#if CONFIG_FAT_EXTENT_NRUNS > 0
+EXTERN uint32_t fat_extentfind(FAR struct fat_file_s *ff, uint32_t index,
+                               FAR int32_t *cluster);
+EXTERN void   fat_extentadd(FAR struct fat_file_s *ff, uint32_t index,
+                            uint32_t cluster);
+#  define fat_extentinvalidate(ff) ((ff)->ff_nextents = 0)
+#else
+#  define fat_extentfind(ff,i,c)   (0)
+#  define fat_extentadd(ff,i,c)
+#  define fat_extentinvalidate(ff)
+#endif
 
 /* FSINFO sector support */
 
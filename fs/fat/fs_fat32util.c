@@ -30,6 +30,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <assert.h>
 #include <errno.h>
@@ -263,6 +264,389 @@ static int fat_checkbootrecord(struct fat_mountpt_s *fs)
   return OK;
 }
 
+/****************************************************************************
+ * Name: fat_blockwrite
+ *
+ * Description:
+ *   Write sectors to the media without touching the sector cache
+ *
+ ****************************************************************************/
+
+static int fat_blockwrite(FAR struct fat_mountpt_s *fs, FAR uint8_t *buffer,
+                          off_t sector, unsigned int nsectors)
+{
+  int ret = -ENODEV;
+  if (fs && fs->fs_blkdriver)
+    {
+      struct inode *inode = fs->fs_blkdriver;
+      if (inode && inode->u.i_bops && inode->u.i_bops->write)
+        {
+          ssize_t nsectorswritten =
+              inode->u.i_bops->write(inode, buffer, sector, nsectors);
+
+          if (nsectorswritten == nsectors)
+            {
+              ret = OK;
+            }
+          else if (nsectorswritten < 0)
+            {
+              ret = nsectorswritten;
+            }
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fat_writesector
+ *
+ * Description:
+ *   Write one buffered sector to the media.  A sector in the FAT region is
+ *   written to every copy of the FAT.
+ *
+ ****************************************************************************/
+
+static int fat_writesector(FAR struct fat_mountpt_s *fs, FAR uint8_t *buffer,
+                           off_t sector)
+{
+  int ret;
+  int i;
+
+  ret = fat_blockwrite(fs, buffer, sector, 1);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Does the sector lie in the FAT region? */
+
+  if (sector >= fs->fs_fatbase &&
+      sector < fs->fs_fatbase + fs->fs_nfatsects)
+    {
+      /* Yes, then make the change in the FAT copy as well */
+
+      for (i = fs->fs_fatnumfats; i >= 2; i--)
+        {
+          sector += fs->fs_nfatsects;
+          ret = fat_blockwrite(fs, buffer, sector, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_cacheregion
+ *
+ * Description:
+ *   Return the range of fs_cache[] entries that may hold 'sector'.  FAT
+ *   sectors and all other sectors are cached separately.
+ *
+ ****************************************************************************/
+
+#if FAT_NCACHESECTORS > 0
+static void fat_cacheregion(FAR struct fat_mountpt_s *fs, off_t sector,
+                            FAR int *first, FAR int *last)
+{
+  if (sector >= fs->fs_fatbase &&
+      sector < fs->fs_fatbase + fs->fs_nfatsects)
+    {
+      *first = 0;
+      *last  = CONFIG_FAT_FATCACHE_NSECTORS;
+    }
+  else
+    {
+      *first = CONFIG_FAT_FATCACHE_NSECTORS;
+      *last  = FAT_NCACHESECTORS;
+    }
+}
+
+/****************************************************************************
+ * Name: fat_cachefind
+ *
+ * Description:
+ *   Return the cache entry holding 'sector' or NULL if it is not cached
+ *
+ ****************************************************************************/
+
+static FAR struct fat_cachesector_s *
+fat_cachefind(FAR struct fat_mountpt_s *fs, off_t sector)
+{
+  int first;
+  int last;
+
+  fat_cacheregion(fs, sector, &first, &last);
+  for (; first < last; first++)
+    {
+      if (fs->fs_cache[first].cs_sector == sector)
+        {
+          return &fs->fs_cache[first];
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: fat_cachealloc
+ *
+ * Description:
+ *   Return an unused cache entry for 'sector', evicting the least recently
+ *   used entry of its region if necessary.  A dirty victim is written back
+ *   first.  NULL is returned if no entries are configured for the region.
+ *
+ ****************************************************************************/
+
+static int fat_cachealloc(FAR struct fat_mountpt_s *fs, off_t sector,
+                          FAR struct fat_cachesector_s **pcs)
+{
+  FAR struct fat_cachesector_s *victim = NULL;
+  FAR struct fat_cachesector_s *cs;
+  int first;
+  int last;
+  int ret;
+
+  fat_cacheregion(fs, sector, &first, &last);
+  for (; first < last; first++)
+    {
+      cs = &fs->fs_cache[first];
+      if (cs->cs_sector < 0)
+        {
+          victim = cs;
+          break;
+        }
+
+      if (victim == NULL ||
+          (int32_t)(cs->cs_stamp - victim->cs_stamp) < 0)
+        {
+          victim = cs;
+        }
+    }
+
+  if (victim != NULL)
+    {
+      if (victim->cs_dirty)
+        {
+          ret = fat_writesector(fs, victim->cs_buffer, victim->cs_sector);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          victim->cs_dirty = false;
+        }
+
+      victim->cs_sector = -1;
+    }
+
+  *pcs = victim;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_cachesave
+ *
+ * Description:
+ *   Move the modified contents of fs_buffer into the sector cache so that
+ *   fs_buffer can be reused.  The sector is written to the media directly
+ *   if there is no cache for its region.
+ *
+ ****************************************************************************/
+
+static int fat_cachesave(FAR struct fat_mountpt_s *fs)
+{
+  FAR struct fat_cachesector_s *cs;
+  int ret;
+
+  if (!fs->fs_dirty)
+    {
+      return OK;
+    }
+
+  cs = fat_cachefind(fs, fs->fs_currentsector);
+  if (cs == NULL)
+    {
+      ret = fat_cachealloc(fs, fs->fs_currentsector, &cs);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  if (cs == NULL)
+    {
+      ret = fat_writesector(fs, fs->fs_buffer, fs->fs_currentsector);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+  else
+    {
+      memcpy(cs->cs_buffer, fs->fs_buffer, fs->fs_hwsectorsize);
+      cs->cs_sector = fs->fs_currentsector;
+      cs->cs_stamp  = ++fs->fs_cacheclock;
+      cs->cs_dirty  = true;
+    }
+
+  fs->fs_dirty = false;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_freemapupdate
+ *
+ * Description:
+ *   Record the allocation state of a cluster in the free cluster bitmap
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_FREEMAP
+static void fat_freemapupdate(FAR struct fat_mountpt_s *fs,
+                              uint32_t cluster, bool inuse)
+{
+  if (fs->fs_freemap != NULL && cluster >= 2 && cluster < fs->fs_nclusters)
+    {
+      if (inuse)
+        {
+          fs->fs_freemap[cluster >> 5] |= (uint32_t)1 << (cluster & 31);
+        }
+      else
+        {
+          fs->fs_freemap[cluster >> 5] &= ~((uint32_t)1 << (cluster & 31));
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: fat_freemapfind
+ *
+ * Description:
+ *   Return the first free cluster in the range first <= cluster < last, or
+ *   zero if there is none.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemapfind(FAR struct fat_mountpt_s *fs,
+                                uint32_t first, uint32_t last)
+{
+  uint32_t word;
+
+  while (first < last)
+    {
+      /* Treat the clusters below 'first' in this word as allocated */
+
+      word = fs->fs_freemap[first >> 5] |
+             (((uint32_t)1 << (first & 31)) - 1);
+      if (word != UINT32_MAX)
+        {
+          first = (first & ~31) + ffs(~word) - 1;
+          return first < last ? first : 0;
+        }
+
+      first = (first | 31) + 1;
+    }
+
+  return 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_findfreecluster
+ *
+ * Description:
+ *   Find a free cluster, starting the search after 'startcluster' and
+ *   wrapping around to the beginning of the FAT.
+ *
+ * Returned Value:
+ *   <0:error, 0: no free cluster, >=2: free cluster number
+ *
+ ****************************************************************************/
+
+static int32_t fat_findfreecluster(FAR struct fat_mountpt_s *fs,
+                                   uint32_t startcluster)
+{
+  uint32_t newcluster;
+  off_t    startsector;
+
+#ifdef CONFIG_FAT_FREEMAP
+  if (fs->fs_freemap != NULL)
+    {
+      newcluster = fat_freemapfind(fs, startcluster + 1, fs->fs_nclusters);
+      if (newcluster == 0)
+        {
+          newcluster = fat_freemapfind(fs, 2, startcluster + 1);
+        }
+
+      return newcluster;
+    }
+#endif
+
+  /* Loop until (1) we discover that there are not free clusters
+   * (return 0), an errors occurs (return -errno), or (3) we find
+   * the next cluster (return the new cluster number).
+   */
+
+  newcluster = startcluster;
+  for (; ; )
+    {
+      /* Examine the next cluster in the FAT */
+
+      newcluster++;
+      if (newcluster >= fs->fs_nclusters)
+        {
+          /* If we hit the end of the available clusters, then
+           * wrap back to the beginning because we might have
+           * started at a non-optimal place.  But don't continue
+           * past the start cluster.
+           */
+
+          newcluster = 2;
+          if (newcluster > startcluster)
+            {
+              /* We are back past the starting cluster, then there
+               * is no free cluster.
+               */
+
+              return 0;
+            }
+        }
+
+      /* We have a candidate cluster.  Check if the cluster number is
+       * mapped to a group of sectors.
+       */
+
+      startsector = fat_getcluster(fs, newcluster);
+      if (startsector == 0)
+        {
+          /* Found have found a free cluster break out */
+
+          return newcluster;
+        }
+      else if (startsector < 0)
+        {
+          /* Some error occurred, return the error number */
+
+          return startsector;
+        }
+
+      /* We wrap all the back to the starting cluster?  If so, then
+       * there are no free clusters.
+       */
+
+      if (newcluster == startcluster)
+        {
+          return 0;
+        }
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -509,9 +893,19 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   fs->fs_buffer = (FAR uint8_t *)fat_io_alloc(fs->fs_hwsectorsize);
   if (!fs->fs_buffer)
     {
-      ret = -ENOMEM;
-      goto errout;
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+#if FAT_NCACHESECTORS > 0
+  /* Allocate the sector cache */
+
+  ret = fat_fscacheinit(fs);
+  if (ret < 0)
+    {
+      goto errout_with_buffer;
     }
+#endif
 
   /* Search FAT boot record on the drive.  First check the MBR at sector
    * zero.  This could be either the boot record or a partition that refers
@@ -619,9 +1013,24 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
         }
     }
 
-  /* Enforce computation of free clusters if configured */
+#ifdef CONFIG_FAT_FREEMAP
+  /* Allocate the free cluster bitmap.  Cluster allocation falls back to
+   * scanning the FAT if there is not enough memory for it.
+   */
+
+  fs->fs_freemap = kmm_zalloc(((fs->fs_nclusters + 31) >> 5) *
+                              sizeof(uint32_t));
+  if (fs->fs_freemap == NULL)
+    {
+      fwarn("WARNING: No memory for the free cluster bitmap\n");
+    }
+#endif
+
+  /* Enforce computation of free clusters if configured.  This also builds
+   * the free cluster bitmap.
+   */
 
-#ifdef CONFIG_FAT_COMPUTE_FSINFO
+#if defined(CONFIG_FAT_COMPUTE_FSINFO) || defined(CONFIG_FAT_FREEMAP)
   ret = fat_computefreeclusters(fs);
   if (ret != OK)
     {
@@ -651,6 +1060,23 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   return OK;
 
 errout_with_buffer:
+#ifdef CONFIG_FAT_FREEMAP
+  if (fs->fs_freemap)
+    {
+      kmm_free(fs->fs_freemap);
+      fs->fs_freemap = NULL;
+    }
+#endif
+
+#if FAT_NCACHESECTORS > 0
+  if (fs->fs_cachebuffer)
+    {
+      fat_io_free(fs->fs_cachebuffer,
+                  fs->fs_hwsectorsize * FAT_NCACHESECTORS);
+      fs->fs_cachebuffer = NULL;
+    }
+#endif
+
   fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
   fs->fs_buffer = NULL;
 
@@ -748,25 +1174,18 @@ int fat_hwread(struct fat_mountpt_s *fs, uint8_t *buffer,  off_t sector,
 int fat_hwwrite(struct fat_mountpt_s *fs, uint8_t *buffer, off_t sector,
                 unsigned int nsectors)
 {
-  int ret = -ENODEV;
-  if (fs && fs->fs_blkdriver)
+  int ret;
+
+  ret = fat_blockwrite(fs, buffer, sector, nsectors);
+
+#if FAT_NCACHESECTORS > 0
+  if (ret >= 0)
     {
-      struct inode *inode = fs->fs_blkdriver;
-      if (inode && inode->u.i_bops && inode->u.i_bops->write)
-        {
-          ssize_t nsectorswritten =
-              inode->u.i_bops->write(inode, buffer, sector, nsectors);
+      /* Cached copies of the sectors are superseded by this write */
 
-          if (nsectorswritten == nsectors)
-            {
-              ret = OK;
-            }
-          else if (nsectorswritten < 0)
-            {
-              ret = nsectorswritten;
-            }
-        }
+      fat_fscacheinvalidate(fs, sector, nsectors);
     }
+#endif
 
   return ret;
 }
@@ -1092,6 +1511,11 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
       /* Mark the modified sector as "dirty" and return success */
 
       fs->fs_dirty = true;
+
+#ifdef CONFIG_FAT_FREEMAP
+      fat_freemapupdate(fs, clusterno, nextcluster != 0);
+#endif
+
       return OK;
     }
 
@@ -1215,66 +1639,20 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
       startcluster = cluster;
     }
 
-  /* Loop until (1) we discover that there are not free clusters
-   * (return 0), an errors occurs (return -errno), or (3) we find
-   * the next cluster (return the new cluster number).
-   */
+  /* Find a free cluster */
 
-  newcluster = startcluster;
-  for (; ; )
+  ret = fat_findfreecluster(fs, startcluster);
+  if (ret <= 0)
     {
-      /* Examine the next cluster in the FAT */
-
-      newcluster++;
-      if (newcluster >= fs->fs_nclusters)
-        {
-          /* If we hit the end of the available clusters, then
-           * wrap back to the beginning because we might have
-           * started at a non-optimal place.  But don't continue
-           * past the start cluster.
-           */
-
-          newcluster = 2;
-          if (newcluster > startcluster)
-            {
-              /* We are back past the starting cluster, then there
-               * is no free cluster.
-               */
-
-              return 0;
-            }
-        }
-
-      /* We have a candidate cluster.  Check if the cluster number is
-       * mapped to a group of sectors.
-       */
-
-      startsector = fat_getcluster(fs, newcluster);
-      if (startsector == 0)
-        {
-          /* Found have found a free cluster break out */
-
-          break;
-        }
-      else if (startsector < 0)
-        {
-          /* Some error occurred, return the error number */
-
-          return startsector;
-        }
+      /* An error occurred or there is no free cluster */
 
-      /* We wrap all the back to the starting cluster?  If so, then
-       * there are no free clusters.
-       */
-
-      if (newcluster == startcluster)
-        {
-          return 0;
-        }
+      return ret;
     }
 
-  /* We get here only if we break out with an available cluster
-   * number in 'newcluster'  Now mark that cluster as in-use.
+  newcluster = ret;
+
+  /* We get here only if we found an available cluster number in
+   * 'newcluster'.  Now mark that cluster as in-use.
    */
 
   ret = fat_putcluster(fs, newcluster, 0x0fffffff);
@@ -1747,16 +2125,79 @@ int fat_dirextend(FAR struct fat_mountpt_s *fs, FAR struct fat_file_s *ff,
   return OK;
 }
 
+/****************************************************************************
+ * Name: fat_fscacheinit
+ *
+ * Description:
+ *   Allocate and initialize the mountpoint sector cache
+ *
+ ****************************************************************************/
+
+#if FAT_NCACHESECTORS > 0
+int fat_fscacheinit(struct fat_mountpt_s *fs)
+{
+  int i;
+
+  fs->fs_cachebuffer = (FAR uint8_t *)
+    fat_io_alloc(fs->fs_hwsectorsize * FAT_NCACHESECTORS);
+  if (!fs->fs_cachebuffer)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < FAT_NCACHESECTORS; i++)
+    {
+      fs->fs_cache[i].cs_sector = -1;
+      fs->fs_cache[i].cs_dirty  = false;
+      fs->fs_cache[i].cs_buffer = fs->fs_cachebuffer +
+                                  i * fs->fs_hwsectorsize;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_fscacheinvalidate
+ *
+ * Description:
+ *   Discard any cached copies of the sectors 'sector' through
+ *   'sector' + 'nsectors' - 1.  Used when the sectors are written directly.
+ *
+ ****************************************************************************/
+
+void fat_fscacheinvalidate(struct fat_mountpt_s *fs, off_t sector,
+                           unsigned int nsectors)
+{
+  FAR struct fat_cachesector_s *cs;
+  int i;
+
+  for (i = 0; i < FAT_NCACHESECTORS; i++)
+    {
+      cs = &fs->fs_cache[i];
+      if (cs->cs_sector >= sector && cs->cs_sector < sector + nsectors)
+        {
+          cs->cs_sector = -1;
+          cs->cs_dirty  = false;
+        }
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: fat_fscacheflush
  *
  * Description:
- *   Flush any dirty sector if fs_buffer as necessary
+ *   Flush any dirty sector if fs_buffer as necessary, together with all
+ *   dirty sectors of the sector cache
  *
  ****************************************************************************/
 
 int fat_fscacheflush(struct fat_mountpt_s *fs)
 {
+#if FAT_NCACHESECTORS > 0
+  FAR struct fat_cachesector_s *cs;
+  int i;
+#endif
   int ret;
 
   /* Check if the fs_buffer is dirty.  In this case, we will write back the
@@ -1765,39 +2206,49 @@ int fat_fscacheflush(struct fat_mountpt_s *fs)
 
   if (fs->fs_dirty)
     {
-      /* Write the dirty sector */
+      /* Write the dirty sector (and its FAT copies) */
 
-      ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
+      ret = fat_writesector(fs, fs->fs_buffer, fs->fs_currentsector);
       if (ret < 0)
         {
           return ret;
         }
 
-      /* Does the sector lie in the FAT region? */
+#if FAT_NCACHESECTORS > 0
+      /* Keep any cached copy of the sector up to date */
 
-      if (fs->fs_currentsector >= fs->fs_fatbase &&
-          fs->fs_currentsector < fs->fs_fatbase + fs->fs_nfatsects)
+      cs = fat_cachefind(fs, fs->fs_currentsector);
+      if (cs != NULL)
         {
-          int i;
-
-          /* Yes, then make the change in the FAT copy as well */
-
-          for (i = fs->fs_fatnumfats; i >= 2; i--)
-            {
-              fs->fs_currentsector += fs->fs_nfatsects;
-              ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
-              if (ret < 0)
-                {
-                  return ret;
-                }
-            }
+          memcpy(cs->cs_buffer, fs->fs_buffer, fs->fs_hwsectorsize);
+          cs->cs_dirty = false;
         }
+#endif
 
       /* No longer dirty */
 
       fs->fs_dirty = false;
     }
 
+#if FAT_NCACHESECTORS > 0
+  /* Then write back the dirty sectors of the cache */
+
+  for (i = 0; i < FAT_NCACHESECTORS; i++)
+    {
+      cs = &fs->fs_cache[i];
+      if (cs->cs_dirty)
+        {
+          ret = fat_writesector(fs, cs->cs_buffer, cs->cs_sector);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          cs->cs_dirty = false;
+        }
+    }
+#endif
+
   return OK;
 }
 
@@ -1812,6 +2263,9 @@ int fat_fscacheflush(struct fat_mountpt_s *fs)
 
 int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
 {
+#if FAT_NCACHESECTORS > 0
+  FAR struct fat_cachesector_s *cs;
+#endif
   int ret;
 
   /* fs->fs_currentsector holds the current sector that is buffered in
@@ -1821,6 +2275,47 @@ int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
 
   if (fs->fs_currentsector != sector)
     {
+#if FAT_NCACHESECTORS > 0
+      /* Park the modified contents of fs_buffer in the sector cache */
+
+      ret = fat_cachesave(fs);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Then fetch the sector from the cache, reading it into the cache
+       * first if necessary.
+       */
+
+      cs = fat_cachefind(fs, sector);
+      if (cs == NULL)
+        {
+          ret = fat_cachealloc(fs, sector, &cs);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          ret = fat_hwread(fs, cs != NULL ? cs->cs_buffer : fs->fs_buffer,
+                           sector, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          if (cs != NULL)
+            {
+              cs->cs_sector = sector;
+            }
+        }
+
+      if (cs != NULL)
+        {
+          memcpy(fs->fs_buffer, cs->cs_buffer, fs->fs_hwsectorsize);
+          cs->cs_stamp = ++fs->fs_cacheclock;
+        }
+#else
       /* We will need to read the new sector.  First, flush the cached
        * sector if it is dirty.
        */
@@ -1838,6 +2333,7 @@ int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
         {
           return ret;
         }
+#endif
 
       /* Update the cached sector number */
 
@@ -2027,6 +2523,17 @@ int fat_computefreeclusters(struct fat_mountpt_s *fs)
   /* We have to count the number of free clusters */
 
   uint32_t nfreeclusters = 0;
+
+#ifdef CONFIG_FAT_FREEMAP
+  /* The free cluster bitmap is rebuilt along the way */
+
+  if (fs->fs_freemap != NULL)
+    {
+      memset(fs->fs_freemap, 0,
+             ((fs->fs_nclusters + 31) >> 5) * sizeof(uint32_t));
+    }
+#endif
+
   if (fs->fs_type == FSTYPE_FAT12)
     {
       off_t sector;
@@ -2043,6 +2550,12 @@ int fat_computefreeclusters(struct fat_mountpt_s *fs)
             {
               nfreeclusters++;
             }
+#ifdef CONFIG_FAT_FREEMAP
+          else
+            {
+              fat_freemapupdate(fs, sector, true);
+            }
+#endif
         }
     }
   else
@@ -2050,6 +2563,7 @@ int fat_computefreeclusters(struct fat_mountpt_s *fs)
       unsigned int cluster;
       off_t        fatsector;
       unsigned int offset;
+      bool         isfree;
       int          ret;
 
       fatsector    = fs->fs_fatbase;
@@ -2085,22 +2599,25 @@ int fat_computefreeclusters(struct fat_mountpt_s *fs)
 
           if (fs->fs_type == FSTYPE_FAT16)
             {
-              if (FAT_GETFAT16(fs->fs_buffer, offset) == 0)
-                {
-                  nfreeclusters++;
-                }
-
+              isfree  = FAT_GETFAT16(fs->fs_buffer, offset) == 0;
               offset += 2;
             }
           else
             {
-              if (FAT_GETFAT32(fs->fs_buffer, offset) == 0)
-                {
-                  nfreeclusters++;
-                }
-
+              isfree  = FAT_GETFAT32(fs->fs_buffer, offset) == 0;
               offset += 4;
             }
+
+          if (isfree)
+            {
+              nfreeclusters++;
+            }
+#ifdef CONFIG_FAT_FREEMAP
+          else
+            {
+              fat_freemapupdate(fs, fs->fs_nclusters - cluster, true);
+            }
+#endif
         }
     }
 
@@ -2195,3 +2712,111 @@ int fat_currentsector(struct fat_mountpt_s *fs, struct fat_file_s *ff,
 
   return -ENOSPC;
 }
+
+/****************************************************************************
+ * Name: fat_extentfind
+ *
+ * Description:
+ *   Look up the cluster with the given index in the cluster chain of the
+ *   file using the extent map.  On entry, *cluster holds the start cluster
+ *   of the file.  On return, *cluster holds the cluster with the returned
+ *   index, which is the largest recorded index not above 'index'.  The
+ *   caller follows the chain from there.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FAT_EXTENT_NRUNS > 0
+uint32_t fat_extentfind(struct fat_file_s *ff, uint32_t index,
+                        int32_t *cluster)
+{
+  FAR struct fat_extent_s *fe;
+  int low;
+  int high;
+  int mid;
+
+  /* The extent map always starts with the first cluster of the file */
+
+  if (ff->ff_nextents == 0)
+    {
+      fe              = &ff->ff_extents[0];
+      fe->fe_index    = 0;
+      fe->fe_cluster  = *cluster;
+      fe->fe_count    = 1;
+      ff->ff_nextents = 1;
+      return 0;
+    }
+
+  /* Find the last run starting at or before 'index' */
+
+  low  = 0;
+  high = ff->ff_nextents - 1;
+  while (low < high)
+    {
+      mid = (low + high + 1) / 2;
+      if (ff->ff_extents[mid].fe_index <= index)
+        {
+          low = mid;
+        }
+      else
+        {
+          high = mid - 1;
+        }
+    }
+
+  /* The runs cover a prefix of the chain, so only the last run can end
+   * before 'index'.
+   */
+
+  fe = &ff->ff_extents[low];
+  if (index - fe->fe_index >= fe->fe_count)
+    {
+      index = fe->fe_index + fe->fe_count - 1;
+    }
+
+  *cluster = fe->fe_cluster + (index - fe->fe_index);
+  return index;
+}
+
+/****************************************************************************
+ * Name: fat_extentadd
+ *
+ * Description:
+ *   Record that the cluster with the given index in the cluster chain of
+ *   the file is 'cluster'.  Only the cluster immediately following the
+ *   recorded prefix of the chain is recorded.
+ *
+ ****************************************************************************/
+
+void fat_extentadd(struct fat_file_s *ff, uint32_t index, uint32_t cluster)
+{
+  FAR struct fat_extent_s *fe;
+
+  if (ff->ff_nextents == 0)
+    {
+      return;
+    }
+
+  fe = &ff->ff_extents[ff->ff_nextents - 1];
+  if (index != fe->fe_index + fe->fe_count)
+    {
+      return;
+    }
+
+  if (cluster == fe->fe_cluster + fe->fe_count)
+    {
+      /* The cluster extends the last run */
+
+      fe->fe_count++;
+    }
+  else if (ff->ff_nextents < CONFIG_FAT_EXTENT_NRUNS)
+    {
+      /* Start a new run */
+
+      fe++;
+      fe->fe_index    = index;
+      fe->fe_cluster  = cluster;
+      fe->fe_count    = 1;
+      ff->ff_nextents++;
+    }
+}
+#endif
@@ -23,6 +23,9 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include <assert.h>
@@ -32,21 +35,444 @@
 #include <unistd.h>
 
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
+#include <nuttx/queue.h>
 #include <nuttx/sched.h>
 
+#include "inode/inode.h"
 #include "fs_rammap.h"
 
 #ifdef CONFIG_FS_RAMMAP
 
 /****************************************************************************
- * Public Data
+ * Pre-processor Definitions
  ****************************************************************************/
 
+#define RAMMAP_CHUNKSIZE CONFIG_FS_RAMMAP_CHUNKSIZE
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP_SHARED
+/* A copy of one file shared by all of its read-only mappings.  The buffer
+ * covers the whole file, but only the chunks that have been mapped so far
+ * are read.  g_rammap_lock protects the list and crefs, the chunks are read
+ * under the lock of the copy so that the file I/O does not hold up the
+ * writers of other files.
+ */
+
+struct rammap_shared_s
+{
+  sq_entry_t        node;   /* Link in g_rammap_list */
+  FAR struct inode *inode;  /* Inode of the file, referenced */
+  FAR char         *path;   /* Path of the file */
+  FAR uint8_t      *buffer; /* Copy of the file */
+  size_t            size;   /* Size of the buffer */
+  FAR uint8_t      *filled; /* Bitmap of the chunks read */
+  mutex_t           lock;   /* Serializes the reads of the chunks */
+  unsigned int      crefs;  /* Number of mappings */
+  bool              kernel; /* Buffer from the kernel heap */
+  bool              stale;  /* Dropped from g_rammap_list by a write */
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP_SHARED
+static mutex_t g_rammap_lock = NXMUTEX_INITIALIZER;
+static sq_queue_t g_rammap_list;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: rammap_read
+ *
+ * Description:
+ *   Read length bytes of the file at offset into buffer, zeroing whatever
+ *   lies beyond the end of the file.
+ *
+ ****************************************************************************/
+
+static int rammap_read(FAR struct file *filep, FAR uint8_t *buffer,
+                       off_t offset, size_t length)
+{
+  ssize_t nread;
+
+  while (length > 0)
+    {
+      nread = file_pread(filep, buffer, length, offset);
+      if (nread < 0)
+        {
+          /* Handle the special case where the read was interrupted by a
+           * signal.
+           */
+
+          if (nread != -EINTR)
+            {
+              /* All other read errors are bad. */
+
+              ferr("ERROR: Read failed: offset=%zu ret=%zd\n",
+                   (size_t)offset, nread);
+              return nread;
+            }
+
+          continue;
+        }
+
+      /* Check for end of file. */
+
+      if (nread == 0)
+        {
+          break;
+        }
+
+      /* Increment number of bytes read */
+
+      buffer += nread;
+      offset += nread;
+      length -= nread;
+    }
+
+  /* Zero any memory beyond the amount read from the file */
+
+  memset(buffer, 0, length);
+  return OK;
+}
+
+#ifdef CONFIG_FS_RAMMAP_SHARED
+/****************************************************************************
+ * Name: rammap_free_shared
+ ****************************************************************************/
+
+static void rammap_free_shared(FAR struct rammap_shared_s *sh)
+{
+  if (sh->kernel)
+    {
+      kmm_free(sh->buffer);
+    }
+  else
+    {
+      kumm_free(sh->buffer);
+    }
+
+  inode_release(sh->inode);
+  nxmutex_destroy(&sh->lock);
+  kmm_free(sh->filled);
+  kmm_free(sh->path);
+  kmm_free(sh);
+}
+
+/****************************************************************************
+ * Name: rammap_release_shared
+ *
+ * Description:
+ *   Drop one mapping of the shared copy, freeing it with the last one.
+ *
+ ****************************************************************************/
+
+static void rammap_release_shared(FAR struct rammap_shared_s *sh)
+{
+  nxmutex_lock(&g_rammap_lock);
+  if (--sh->crefs > 0)
+    {
+      nxmutex_unlock(&g_rammap_lock);
+      return;
+    }
+
+  if (!sh->stale)
+    {
+      sq_rem(&sh->node, &g_rammap_list);
+    }
+
+  nxmutex_unlock(&g_rammap_lock);
+  rammap_free_shared(sh);
+}
+
+/****************************************************************************
+ * Name: rammap_alloc_shared
+ *
+ * Description:
+ *   Allocate an empty shared copy of the file, large enough for the file
+ *   and for a mapping ending at end.
+ *
+ ****************************************************************************/
+
+static FAR struct rammap_shared_s *
+rammap_alloc_shared(FAR struct file *filep, FAR char *path, size_t end,
+                    bool kernel)
+{
+  FAR struct rammap_shared_s *sh;
+  struct stat buf;
+  size_t nchunks;
+
+  if (file_fstat(filep, &buf) < 0)
+    {
+      return NULL;
+    }
+
+  sh = kmm_zalloc(sizeof(*sh));
+  if (sh == NULL)
+    {
+      return NULL;
+    }
+
+  sh->size   = MAX((size_t)buf.st_size, end);
+  sh->kernel = kernel;
+  sh->buffer = kernel ? kmm_malloc(sh->size) : kumm_malloc(sh->size);
+  nchunks    = (sh->size + RAMMAP_CHUNKSIZE - 1) / RAMMAP_CHUNKSIZE;
+  sh->filled = kmm_zalloc((nchunks + 7) / 8);
+  if (sh->buffer == NULL || sh->filled == NULL)
+    {
+      if (kernel)
+        {
+          kmm_free(sh->buffer);
+        }
+      else
+        {
+          kumm_free(sh->buffer);
+        }
+
+      kmm_free(sh->filled);
+      kmm_free(sh);
+      return NULL;
+    }
+
+  nxmutex_init(&sh->lock);
+  sh->path  = path;
+  sh->inode = filep->f_inode;
+  inode_addref(sh->inode);
+  return sh;
+}
+
+/****************************************************************************
+ * Name: rammap_find_shared
+ *
+ * Description:
+ *   Find the shared copy of the file large enough for a mapping ending at
+ *   end and take a reference to it.  The caller holds g_rammap_lock.
+ *
+ ****************************************************************************/
+
+static FAR struct rammap_shared_s *
+rammap_find_shared(FAR struct inode *inode, FAR const char *path,
+                   size_t end, bool kernel)
+{
+  FAR struct rammap_shared_s *sh;
+  FAR sq_entry_t *node;
+
+  for (node = sq_peek(&g_rammap_list); node != NULL; node = sq_next(node))
+    {
+      sh = (FAR struct rammap_shared_s *)node;
+      if (sh->inode == inode && sh->kernel == kernel &&
+          sh->size >= end && strcmp(sh->path, path) == 0)
+        {
+          sh->crefs++;
+          return sh;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: rammap_fill_shared
+ *
+ * Description:
+ *   Read the chunks of the shared copy covering the range that have not
+ *   been read by an earlier mapping.
+ *
+ ****************************************************************************/
+
+static int rammap_fill_shared(FAR struct rammap_shared_s *sh,
+                              FAR struct file *filep, off_t offset,
+                              size_t length)
+{
+  size_t chunk = offset / RAMMAP_CHUNKSIZE;
+  size_t last = (offset + length - 1) / RAMMAP_CHUNKSIZE;
+  size_t pos;
+  int ret;
+
+  if (length == 0)
+    {
+      return OK;
+    }
+
+  for (; chunk <= last; chunk++)
+    {
+      if ((sh->filled[chunk / 8] & (1 << (chunk % 8))) != 0)
+        {
+          continue;
+        }
+
+      pos = chunk * RAMMAP_CHUNKSIZE;
+      ret = rammap_read(filep, sh->buffer + pos, pos,
+                        MIN(RAMMAP_CHUNKSIZE, sh->size - pos));
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      sh->filled[chunk / 8] |= 1 << (chunk % 8);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: unmap_rammap_shared
+ ****************************************************************************/
+
+static int unmap_rammap_shared(FAR struct task_group_s *group,
+                               FAR struct mm_map_entry_s *entry,
+                               FAR void *start,
+                               size_t length)
+{
+  off_t offset;
+  int ret = OK;
+
+  /* All unmappings must extend to the end of the region, see
+   * unmap_rammap().
+   */
+
+  offset = (uintptr_t)start - (uintptr_t)entry->vaddr;
+  if (offset + length < entry->length)
+    {
+      ferr("ERROR: Cannot umap without unmapping to the end\n");
+      return -ENOSYS;
+    }
+
+  length = entry->length - offset;
+  if (length >= entry->length)
+    {
+      ret = mm_map_remove(get_group_mm(group), entry);
+      rammap_release_shared(entry->priv.p);
+    }
+
+  /* The shared copy cannot be shrunk, the tail is only released with the
+   * rest of the copy.
+   */
+
+  else
+    {
+      entry->length = offset;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: rammap_shared
+ *
+ * Description:
+ *   Map the range from the copy of the file shared by all read-only
+ *   mappings, creating the copy and reading the missing chunks as needed.
+ *   The files are identified by their path, -ENOTTY is returned for the
+ *   files whose path is unknown.
+ *
+ ****************************************************************************/
+
+static int rammap_shared(FAR struct file *filep,
+                         FAR struct mm_map_entry_s *entry, bool kernel)
+{
+  FAR struct rammap_shared_s *found;
+  FAR struct rammap_shared_s *sh;
+  FAR char *path;
+  size_t end;
+  int ret;
+
+  path = kmm_malloc(PATH_MAX);
+  if (path == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = file_ioctl(filep, FIOC_FILEPATH, (unsigned long)(uintptr_t)path);
+  if (ret < 0)
+    {
+      kmm_free(path);
+      return -ENOTTY;
+    }
+
+  end = entry->offset + entry->length;
+  ret = nxmutex_lock(&g_rammap_lock);
+  if (ret < 0)
+    {
+      kmm_free(path);
+      return ret;
+    }
+
+  sh = rammap_find_shared(filep->f_inode, path, end, kernel);
+  nxmutex_unlock(&g_rammap_lock);
+
+  if (sh != NULL)
+    {
+      kmm_free(path);
+    }
+  else
+    {
+      /* Create the copy without the list lock, then check that no other
+       * mapping created one in the meantime.
+       */
+
+      sh = rammap_alloc_shared(filep, path, end, kernel);
+      if (sh == NULL)
+        {
+          kmm_free(path);
+          return -ENOMEM;
+        }
+
+      nxmutex_lock(&g_rammap_lock);
+      found = rammap_find_shared(filep->f_inode, path, end, kernel);
+      if (found == NULL)
+        {
+          sh->crefs = 1;
+          sq_addlast(&sh->node, &g_rammap_list);
+        }
+
+      nxmutex_unlock(&g_rammap_lock);
+
+      if (found != NULL)
+        {
+          rammap_free_shared(sh);
+          sh = found;
+        }
+    }
+
+  ret = nxmutex_lock(&sh->lock);
+  if (ret >= 0)
+    {
+      ret = rammap_fill_shared(sh, filep, entry->offset, entry->length);
+      nxmutex_unlock(&sh->lock);
+    }
+
+  if (ret < 0)
+    {
+      rammap_release_shared(sh);
+      return ret;
+    }
+
+  entry->vaddr  = sh->buffer + entry->offset;
+  entry->priv.p = sh;
+  entry->munmap = unmap_rammap_shared;
+
+  ret = mm_map_add(get_current_mm(), entry);
+  if (ret < 0)
+    {
+      rammap_release_shared(sh);
+    }
+
+  return ret;
+}
+#endif /* CONFIG_FS_RAMMAP_SHARED */
+
 static int unmap_rammap(FAR struct task_group_s *group,
                         FAR struct mm_map_entry_s *entry,
                         FAR void *start,
@@ -153,22 +579,24 @@ int rammap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
            bool kernel)
 {
   FAR uint8_t *rdbuffer;
-  ssize_t nread;
-  off_t fpos;
   int ret;
   size_t length = entry->length;
 
-  /* There is a major design flaw that I have not yet thought of fix for:
-   * The goal is to have a single region of memory that represents a single
-   * file and can be shared by many threads.  That is, given a filename a
-   * thread should be able to open the file, get a file descriptor, and
-   * call mmap() to get a memory region.  Different file descriptors opened
-   * with the same file path should get the same memory region when mapped.
-   *
-   * The design flaw is that I don't have sufficient knowledge to know that
-   * these different file descriptors map to the same file.  So, for the time
-   * being, a new memory region is created each time that rammap() is called.
-   * Not very useful!
+#ifdef CONFIG_FS_RAMMAP_SHARED
+  /* The read-only mappings of the same file share one copy */
+
+  if ((entry->prot & PROT_WRITE) == 0)
+    {
+      ret = rammap_shared(filep, entry, kernel);
+      if (ret != -ENOTTY)
+        {
+          return ret;
+        }
+    }
+#endif
+
+  /* Otherwise a new memory region is created each time that rammap() is
+   * called.
    */
 
   /* Allocate a region of memory of the specified size */
@@ -182,60 +610,14 @@ int rammap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
 
   entry->vaddr = rdbuffer; /* save the buffer firstly */
 
-  /* Seek to the specified file offset */
-
-  fpos = file_seek(filep, entry->offset, SEEK_SET);
-  if (fpos < 0)
-    {
-      /* Seek failed... errno has already been set, but EINVAL is probably
-       * the correct response.
-       */
-
-      ferr("ERROR: Seek to position %zu failed\n", (size_t)entry->offset);
-      ret = fpos;
-      goto errout_with_region;
-    }
-
   /* Read the file data into the memory region */
 
-  while (length > 0)
+  ret = rammap_read(filep, rdbuffer, entry->offset, length);
+  if (ret < 0)
     {
-      nread = file_read(filep, rdbuffer, length);
-      if (nread < 0)
-        {
-          /* Handle the special case where the read was interrupted by a
-           * signal.
-           */
-
-          if (nread != -EINTR)
-            {
-              /* All other read errors are bad. */
-
-              ferr("ERROR: Read failed: offset=%zu ret=%zd\n",
-                   (size_t)entry->offset, nread);
-
-              ret = nread;
-              goto errout_with_region;
-            }
-        }
-
-      /* Check for end of file. */
-
-      if (nread == 0)
-        {
-          break;
-        }
-
-      /* Increment number of bytes read */
-
-      rdbuffer += nread;
-      length   -= nread;
+      goto errout_with_region;
     }
 
-  /* Zero any memory beyond the amount read from the file */
-
-  memset(rdbuffer, 0, length);
-
   /* Add the buffer to the list of regions */
 
   entry->priv.i = kernel;
@@ -262,4 +644,60 @@ errout_with_region:
   return ret;
 }
 
+#ifdef CONFIG_FS_RAMMAP_SHARED
+/****************************************************************************
+ * Name: rammap_invalidate
+ *
+ * Description:
+ *   Called after the file system content behind inode has been modified,
+ *   or its files renamed or unlinked.  The shared copies of the files behind
+ *   the inode are dropped, so that the following mappings read the file
+ *   again.  The existing mappings keep their copy, like a private mapping
+ *   would.
+ *
+ *   The written file is not known, only the inode, so this drops the copies
+ *   of all the files of a mounted file system.  Only the files of mounted
+ *   file systems have shared copies, the writes to drivers return at once.
+ *
+ ****************************************************************************/
+
+void rammap_invalidate(FAR struct inode *inode)
+{
+  FAR struct rammap_shared_s *sh;
+  FAR sq_entry_t *prev = NULL;
+  FAR sq_entry_t *node;
+  FAR sq_entry_t *next;
+
+  if (!INODE_IS_MOUNTPT(inode) || sq_empty(&g_rammap_list))
+    {
+      return;
+    }
+
+  nxmutex_lock(&g_rammap_lock);
+  for (node = sq_peek(&g_rammap_list); node != NULL; node = next)
+    {
+      next = sq_next(node);
+      sh   = (FAR struct rammap_shared_s *)node;
+      if (sh->inode != inode)
+        {
+          prev = node;
+          continue;
+        }
+
+      if (prev == NULL)
+        {
+          sq_remfirst(&g_rammap_list);
+        }
+      else
+        {
+          sq_remafter(prev, &g_rammap_list);
+        }
+
+      sh->stale = true;
+    }
+
+  nxmutex_unlock(&g_rammap_lock);
+}
+#endif
+
 #endif /* CONFIG_FS_RAMMAP */
@@ -33,6 +33,9 @@
  * - All mapped files are read-only.  You can write to the in-memory image,
  *   but the file contents will not change.
  * - There are not access privileges.
+ *
+ * With CONFIG_FS_RAMMAP_SHARED, the read-only mappings of a file share one
+ * reference counted copy, read in chunks as the mappings need them.
  */
 
 #ifndef __FS_MMAP_FS_RAMMAP_H
@@ -89,8 +92,29 @@
 
 int rammap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
            bool kernel);
+
+/****************************************************************************
+ * Name: rammap_invalidate
+ *
+ * Description:
+ *   Drop the shared copies of the files behind the inode after they have
+ *   been written, truncated, renamed or unlinked.  The following read-only
+ *   mappings read the file again, the existing ones keep their copy.
+ *
+ * Input Parameters:
+ *   inode   The inode of the modified file.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP_SHARED
+void rammap_invalidate(FAR struct inode *inode);
+#else
+#  define rammap_invalidate(inode)
+#endif
+
 #else
 #  define rammap(file, entry, kernel) (-ENOSYS)
+#  define rammap_invalidate(inode)
 #endif /* CONFIG_FS_RAMMAP */
 
 #endif /* __FS_MMAP_FS_RAMMAP_H */
@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <stdint.h>
@@ -89,8 +90,22 @@ struct tmpfs_dir_s
 
 static int  tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
               unsigned int nentries);
+#ifdef CONFIG_FS_TMPFS_PAGED
+static FAR uint8_t *tmpfs_lookup_page(FAR struct tmpfs_file_s *tfo,
+              size_t index, bool alloc);
+static void tmpfs_trim_pages(FAR struct tmpfs_file_s *tfo,
+              FAR void **slot, unsigned int height, size_t base,
+              size_t first);
+static void tmpfs_read_pages(FAR struct tmpfs_file_s *tfo,
+              FAR char *buffer, off_t pos, size_t buflen);
+static ssize_t tmpfs_write_pages(FAR struct tmpfs_file_s *tfo,
+              FAR const char *buffer, off_t pos, size_t buflen);
+static FAR void *tmpfs_map_pages(FAR struct tmpfs_file_s *tfo,
+              off_t offset, size_t length);
+#endif
 static int  tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
               size_t newsize);
+static void tmpfs_free_filedata(FAR struct tmpfs_file_s *tfo);
 static void tmpfs_release_lockedobject(FAR struct tmpfs_object_s *to);
 static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo);
 static int  tmpfs_release_file(FAR struct tmpfs_file_s *tfo);
@@ -257,6 +272,286 @@ static int tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
   return ret;
 }
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+/****************************************************************************
+ * Name: tmpfs_lookup_page
+ *
+ * Description:
+ *   Return the data page holding the page index of the file, or NULL if it
+ *   is a hole.  If alloc is true, the missing radix tree levels and the
+ *   page are allocated and NULL means that we ran out of memory.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *tmpfs_lookup_page(FAR struct tmpfs_file_s *tfo,
+                                      size_t index, bool alloc)
+{
+  FAR struct tmpfs_radix_s *node;
+  FAR void **slot;
+  unsigned int height;
+
+  /* Add levels on top of the tree until it covers the page index */
+
+  while ((index >> (tfo->tfo_height * TMPFS_RADIX_SHIFT)) != 0)
+    {
+      if (!alloc)
+        {
+          return NULL;
+        }
+
+      if (tfo->tfo_pages != NULL)
+        {
+          node = kmm_zalloc(sizeof(struct tmpfs_radix_s));
+          if (node == NULL)
+            {
+              return NULL;
+            }
+
+          node->trn_slot[0] = tfo->tfo_pages;
+          tfo->tfo_pages    = node;
+        }
+
+      tfo->tfo_height++;
+    }
+
+  /* Then walk down to the page slot */
+
+  slot = &tfo->tfo_pages;
+  for (height = tfo->tfo_height; height > 0; height--)
+    {
+      if (*slot == NULL)
+        {
+          if (!alloc)
+            {
+              return NULL;
+            }
+
+          *slot = kmm_zalloc(sizeof(struct tmpfs_radix_s));
+          if (*slot == NULL)
+            {
+              return NULL;
+            }
+        }
+
+      node = *slot;
+      slot = &node->trn_slot[(index >> ((height - 1) * TMPFS_RADIX_SHIFT)) &
+                             TMPFS_RADIX_MASK];
+    }
+
+  if (*slot == NULL && alloc)
+    {
+      *slot = kmm_zalloc(TMPFS_PAGE_SIZE);
+      if (*slot != NULL)
+        {
+          tfo->tfo_alloc += TMPFS_PAGE_SIZE;
+        }
+    }
+
+  return *slot;
+}
+
+/****************************************************************************
+ * Name: tmpfs_trim_pages
+ *
+ * Description:
+ *   Free all pages with an index of first or more in the subtree at slot,
+ *   which has the given height and starts at page index base.
+ *
+ ****************************************************************************/
+
+static void tmpfs_trim_pages(FAR struct tmpfs_file_s *tfo,
+                             FAR void **slot, unsigned int height,
+                             size_t base, size_t first)
+{
+  FAR struct tmpfs_radix_s *node = *slot;
+  size_t span;
+  int i;
+
+  if (node == NULL)
+    {
+      return;
+    }
+
+  if (height == 0)
+    {
+      if (base >= first)
+        {
+          kmm_free(*slot);
+          *slot = NULL;
+          tfo->tfo_alloc -= TMPFS_PAGE_SIZE;
+        }
+
+      return;
+    }
+
+  span = (size_t)1 << ((height - 1) * TMPFS_RADIX_SHIFT);
+  for (i = 0; i < TMPFS_RADIX_SIZE; i++)
+    {
+      if (base + (i + 1) * span > first)
+        {
+          tmpfs_trim_pages(tfo, &node->trn_slot[i], height - 1,
+                           base + i * span, first);
+        }
+    }
+
+  if (base >= first)
+    {
+      kmm_free(node);
+      *slot = NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: tmpfs_read_pages
+ ****************************************************************************/
+
+static void tmpfs_read_pages(FAR struct tmpfs_file_s *tfo,
+                             FAR char *buffer, off_t pos, size_t buflen)
+{
+  FAR uint8_t *page;
+  size_t offset;
+  size_t nbytes;
+
+  while (buflen > 0)
+    {
+      offset = pos % TMPFS_PAGE_SIZE;
+      nbytes = MIN(TMPFS_PAGE_SIZE - offset, buflen);
+      page   = tmpfs_lookup_page(tfo, pos / TMPFS_PAGE_SIZE, false);
+      if (page != NULL)
+        {
+          memcpy(buffer, page + offset, nbytes);
+        }
+      else
+        {
+          memset(buffer, 0, nbytes);
+        }
+
+      buffer += nbytes;
+      buflen -= nbytes;
+      pos    += nbytes;
+    }
+}
+
+/****************************************************************************
+ * Name: tmpfs_write_pages
+ *
+ * Description:
+ *   Copy the data into the file pages, allocating the missing pages.  The
+ *   existing pages never move.  Returns the number of bytes written, which
+ *   is short only if we ran out of memory.
+ *
+ ****************************************************************************/
+
+static ssize_t tmpfs_write_pages(FAR struct tmpfs_file_s *tfo,
+                                 FAR const char *buffer, off_t pos,
+                                 size_t buflen)
+{
+  FAR uint8_t *page;
+  ssize_t nwritten = 0;
+  size_t offset;
+  size_t nbytes;
+
+  while (buflen > 0)
+    {
+      offset = pos % TMPFS_PAGE_SIZE;
+      nbytes = MIN(TMPFS_PAGE_SIZE - offset, buflen);
+      page   = tmpfs_lookup_page(tfo, pos / TMPFS_PAGE_SIZE, true);
+      if (page == NULL)
+        {
+          break;
+        }
+
+      memcpy(page + offset, buffer, nbytes);
+      buffer   += nbytes;
+      buflen   -= nbytes;
+      pos      += nbytes;
+      nwritten += nbytes;
+    }
+
+  return nwritten;
+}
+
+/****************************************************************************
+ * Name: tmpfs_map_pages
+ *
+ * Description:
+ *   Return the address of the file data at offset if the pages backing the
+ *   whole range are contiguous in memory, NULL otherwise.  A range within
+ *   one page always is, its page is allocated if it is a hole since the
+ *   mapping may be written.  A range over several pages is only looked up:
+ *   separately allocated pages are practically never adjacent, so filling
+ *   its holes would only waste memory before the copy fallback.
+ *
+ ****************************************************************************/
+
+static FAR void *tmpfs_map_pages(FAR struct tmpfs_file_s *tfo,
+                                 off_t offset, size_t length)
+{
+  FAR uint8_t *first;
+  FAR uint8_t *page;
+  size_t index;
+  size_t last;
+
+  index = offset / TMPFS_PAGE_SIZE;
+  last  = (offset + length - 1) / TMPFS_PAGE_SIZE;
+  first = tmpfs_lookup_page(tfo, index, index == last);
+  if (first == NULL)
+    {
+      return NULL;
+    }
+
+  for (page = first; index < last; page += TMPFS_PAGE_SIZE)
+    {
+      if (tmpfs_lookup_page(tfo, ++index, false) != page + TMPFS_PAGE_SIZE)
+        {
+          return NULL;
+        }
+    }
+
+  return first + offset % TMPFS_PAGE_SIZE;
+}
+
+/****************************************************************************
+ * Name: tmpfs_realloc_file
+ *
+ * Description:
+ *   Set the file size.  Growing only moves the end of file, the pages are
+ *   allocated when written and the holes read as zero.  Shrinking frees the
+ *   pages past the end and clears the tail of the last one, so that a later
+ *   extension reads zeros as well.
+ *
+ ****************************************************************************/
+
+static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
+                              size_t newsize)
+{
+  FAR uint8_t *page;
+  size_t offset;
+
+  if (newsize < tfo->tfo_size)
+    {
+      tmpfs_trim_pages(tfo, &tfo->tfo_pages, tfo->tfo_height, 0,
+                       (newsize + TMPFS_PAGE_SIZE - 1) / TMPFS_PAGE_SIZE);
+      if (tfo->tfo_pages == NULL)
+        {
+          tfo->tfo_height = 0;
+        }
+
+      offset = newsize % TMPFS_PAGE_SIZE;
+      if (offset != 0)
+        {
+          page = tmpfs_lookup_page(tfo, newsize / TMPFS_PAGE_SIZE, false);
+          if (page != NULL)
+            {
+              memset(page + offset, 0, TMPFS_PAGE_SIZE - offset);
+            }
+        }
+    }
+
+  tfo->tfo_size = newsize;
+  return OK;
+}
+#else
 /****************************************************************************
  * Name: tmpfs_realloc_file
  ****************************************************************************/
@@ -314,6 +609,21 @@ static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
   tfo->tfo_data  = newdata;
   return OK;
 }
+#endif
+
+/****************************************************************************
+ * Name: tmpfs_free_filedata
+ ****************************************************************************/
+
+static void tmpfs_free_filedata(FAR struct tmpfs_file_s *tfo)
+{
+#ifdef CONFIG_FS_TMPFS_PAGED
+  tmpfs_trim_pages(tfo, &tfo->tfo_pages, tfo->tfo_height, 0, 0);
+  tfo->tfo_height = 0;
+#else
+  kmm_free(tfo->tfo_data);
+#endif
+}
 
 /****************************************************************************
  * Name: tmpfs_release_lockedobject
@@ -352,7 +662,7 @@ static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo)
     {
       tmpfs_unlock_file(tfo);
       nxrmutex_destroy(&tfo->tfo_lock);
-      kmm_free(tfo->tfo_data);
+      tmpfs_free_filedata(tfo);
       kmm_free(tfo);
     }
 
@@ -548,7 +858,12 @@ static FAR struct tmpfs_file_s *tmpfs_alloc_file(void)
   tfo->tfo_refs  = 1;
   tfo->tfo_flags = 0;
   tfo->tfo_size  = 0;
+#ifdef CONFIG_FS_TMPFS_PAGED
+  tfo->tfo_height = 0;
+  tfo->tfo_pages  = NULL;
+#else
   tfo->tfo_data  = NULL;
+#endif
 
   nxrmutex_init(&tfo->tfo_lock);
   tmpfs_lock_file(tfo);
@@ -1099,7 +1414,16 @@ static int tmpfs_statfs_callout(FAR struct tmpfs_directory_s *tdo,
 
       tmptfo             = (FAR struct tmpfs_file_s *)to;
       tmpbuf->tsf_alloc += sizeof(struct tmpfs_file_s);
-      tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
+
+      /* Sparse paged files may have less memory allocated than their
+       * size.
+       */
+
+      if (to->to_alloc > tmptfo->tfo_size)
+        {
+          tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
+        }
+
       tmpbuf->tsf_files++;
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
@@ -1175,7 +1499,7 @@ static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
           return TMPFS_UNLINKED;
         }
 
-      kmm_free(tfo->tfo_data);
+      tmpfs_free_filedata(tfo);
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
     {
@@ -1496,6 +1820,10 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
 
   /* Copy data from the memory object to the user buffer */
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+  tmpfs_read_pages(tfo, buffer, startpos, nread);
+  filep->f_pos += nread;
+#else
   if (tfo->tfo_data != NULL)
     {
       memcpy(buffer, &tfo->tfo_data[startpos], nread);
@@ -1505,6 +1833,7 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
     {
       DEBUGASSERT(tfo->tfo_size == 0 && nread == 0);
     }
+#endif
 
   /* Release the lock on the file */
 
@@ -1547,6 +1876,26 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
   nwritten = buflen;
   endpos   = startpos + buflen;
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+  /* Copy data from the user buffer to the file pages, the existing data is
+   * never moved.
+   */
+
+  nwritten = tmpfs_write_pages(tfo, buffer, startpos, buflen);
+  if (nwritten == 0 && buflen > 0)
+    {
+      ret = -ENOMEM;
+      goto errout_with_lock;
+    }
+
+  endpos = startpos + nwritten;
+  if (endpos > tfo->tfo_size)
+    {
+      tfo->tfo_size = endpos;
+    }
+
+  filep->f_pos += nwritten;
+#else
   if (endpos > tfo->tfo_size)
     {
       /* Reallocate the file to handle the write past the end of the file. */
@@ -1569,6 +1918,7 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
     {
       DEBUGASSERT(tfo->tfo_size == 0 && nwritten == 0);
     }
+#endif
 
   /* Release the lock on the file */
 
@@ -1689,7 +2039,21 @@ static int tmpfs_mmap(FAR struct file *filep, FAR struct mm_map_entry_s *map)
   if (map->offset >= 0 && map->offset < tfo->tfo_size &&
       map->length && map->offset + map->length <= tfo->tfo_size)
     {
+#ifdef CONFIG_FS_TMPFS_PAGED
+      /* Only a range backed by contiguous pages can be mapped directly,
+       * return -ENOTTY to let mmap() fall back to a copy otherwise.
+       */
+
+      tmpfs_lock_file(tfo);
+      map->vaddr = tmpfs_map_pages(tfo, map->offset, map->length);
+      tmpfs_unlock_file(tfo);
+      if (map->vaddr == NULL)
+        {
+          return -ENOTTY;
+        }
+#else
       map->vaddr = tfo->tfo_data + map->offset;
+#endif
       map->priv.p = tfo;
       map->munmap = tmpfs_unmap;
       ret = mm_map_add(get_current_mm(), map);
@@ -1836,10 +2200,12 @@ static int tmpfs_truncate(FAR struct file *filep, off_t length)
        * memory.
        */
 
+#ifndef CONFIG_FS_TMPFS_PAGED
       if (length > oldsize)
         {
           memset(&tfo->tfo_data[oldsize], 0, length - oldsize);
         }
+#endif
 
       ret = OK;
     }
@@ -2282,7 +2648,7 @@ static int tmpfs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
   else
     {
       nxrmutex_destroy(&tfo->tfo_lock);
-      kmm_free(tfo->tfo_data);
+      tmpfs_free_filedata(tfo);
       kmm_free(tfo);
     }
 
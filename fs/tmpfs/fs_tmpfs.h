@@ -40,6 +40,17 @@
 
 #define TFO_FLAG_UNLINKED (1 << 0)  /* Bit 0: File is unlinked */
 
+/* Page based file storage.  Each radix tree node resolves
+ * TMPFS_RADIX_SHIFT bits of the page index.
+ */
+
+#ifdef CONFIG_FS_TMPFS_PAGED
+#  define TMPFS_PAGE_SIZE   CONFIG_FS_TMPFS_PAGESIZE
+#  define TMPFS_RADIX_SHIFT 4
+#  define TMPFS_RADIX_SIZE  (1 << TMPFS_RADIX_SHIFT)
+#  define TMPFS_RADIX_MASK  (TMPFS_RADIX_SIZE - 1)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -101,6 +112,17 @@ struct tmpfs_directory_s
 
 #define SIZEOF_TMPFS_DIRECTORY(n) ((n) * sizeof(struct tmpfs_dirent_s))
 
+#ifdef CONFIG_FS_TMPFS_PAGED
+/* One interior node of the file page radix tree.  The slots of the lowest
+ * level point to the data pages, holes are NULL and read as zero.
+ */
+
+struct tmpfs_radix_s
+{
+  FAR void *trn_slot[TMPFS_RADIX_SIZE];
+};
+#endif
+
 /* The form of a regular file memory object
  *
  * NOTE that in this very simplified implementation, there is no per-open
@@ -123,7 +145,12 @@ struct tmpfs_file_s
 
   uint8_t       tfo_flags; /* See TFO_FLAG_* definitions */
   size_t        tfo_size;  /* Valid file size */
+#ifdef CONFIG_FS_TMPFS_PAGED
+  uint8_t       tfo_height; /* Height of the page radix tree */
+  FAR void     *tfo_pages;  /* Root of the page radix tree */
+#else
   FAR uint8_t  *tfo_data;  /* File data starts here */
+#endif
 };
 
 /* This structure represents one instance of a TMPFS file system */
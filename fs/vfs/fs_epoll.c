@@ -39,6 +39,7 @@
 #include <nuttx/list.h>
 #include <nuttx/mutex.h>
 #include <nuttx/signal.h>
+#include <nuttx/spinlock.h>
 
 #include "inode/inode.h"
 
@@ -49,6 +50,10 @@
 struct epoll_node_s
 {
   struct list_node      node;
+  struct list_node      rnode;    /* Link in the ready list */
+  pollevent_t           revents;  /* The events not yet reported, protected
+                                   * by the rlock of the epoll head.
+                                   */
   epoll_data_t          data;
   struct pollfd         pfd;
 };
@@ -61,13 +66,21 @@ struct epoll_head_s
   int                   crefs;
   mutex_t               lock;
   sem_t                 sem;
+  spinlock_t            rlock;    /* Protect the ready list, the poll
+                                   * notification may come from interrupt.
+                                   */
+  struct list_node      ready;    /* The ready list, store all the setuped
+                                   * epoll node notified by the driver and
+                                   * not yet reported by epoll_wait.
+                                   */
   struct list_node      setup;    /* The setup list, store all the setuped
                                    * epoll node.
                                    */
-  struct list_node      teardown; /* The teardown list, store all the epoll
-                                   * node notified after epoll_wait finish,
-                                   * these epoll node should be setup again
-                                   * to check the pending poll notification.
+  struct list_node      teardown; /* The teardown list, store all the level
+                                   * triggered epoll node notified after
+                                   * epoll_wait finish, these epoll node
+                                   * should be setup again to check the
+                                   * pending poll notification.
                                    */
   struct list_node      oneshot;  /* The oneshot list, store all the epoll
                                    * node notified after epoll_wait and with
@@ -94,6 +107,9 @@ static int epoll_do_open(FAR struct file *filep);
 static int epoll_do_close(FAR struct file *filep);
 static int epoll_do_poll(FAR struct file *filep,
                          FAR struct pollfd *fds, bool setup);
+static void epoll_default_cb(FAR struct pollfd *fds);
+static void epoll_unready(FAR epoll_head_t *eph, FAR epoll_node_t *epn);
+static bool epoll_ready(FAR epoll_head_t *eph);
 static int epoll_setup(FAR epoll_head_t *eph);
 static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
                           int maxevents);
@@ -213,6 +229,93 @@ static int epoll_do_poll(FAR struct file *filep,
   return OK;
 }
 
+/****************************************************************************
+ * Name: epoll_default_cb
+ *
+ * Description:
+ *   The poll callback of the epoll node, queue the notified node to the
+ *   ready list so that epoll_wait only has to look at the ready nodes, then
+ *   wake up the waiter.  This may be called from interrupt context.
+ *
+ *   The notified events are moved from pfd.revents to the node under the
+ *   rlock, so epoll_wait never touches pfd.revents while another CPU may
+ *   be updating it in poll_notify().
+ *
+ ****************************************************************************/
+
+static void epoll_default_cb(FAR struct pollfd *fds)
+{
+  FAR epoll_node_t *epn = container_of(fds, epoll_node_t, pfd);
+  FAR epoll_head_t *eph = container_of(fds->arg, epoll_head_t, sem);
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  epn->revents |= fds->revents;
+  fds->revents  = 0;
+  if ((epn->revents & (POLLERR | POLLHUP)) != 0)
+    {
+      epn->revents &= ~POLLOUT;
+    }
+
+  if (!list_in_list(&epn->rnode))
+    {
+      list_add_tail(&eph->ready, &epn->rnode);
+    }
+
+  spin_unlock_irqrestore(&eph->rlock, flags);
+  poll_default_cb(fds);
+}
+
+/****************************************************************************
+ * Name: epoll_unready
+ *
+ * Description:
+ *   Remove the epoll node from the ready list and drop the pending events,
+ *   the node must be torn down or about to be setup again.
+ *
+ ****************************************************************************/
+
+static void epoll_unready(FAR epoll_head_t *eph, FAR epoll_node_t *epn)
+{
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  if (list_in_list(&epn->rnode))
+    {
+      list_delete(&epn->rnode);
+    }
+
+  epn->revents = 0;
+  spin_unlock_irqrestore(&eph->rlock, flags);
+}
+
+/****************************************************************************
+ * Name: epoll_ready
+ *
+ * Description:
+ *   Return true if any epoll node is ready.  The stale wakeups left by the
+ *   notifications already reported are consumed first, so a following wait
+ *   on eph->sem only returns for a new notification.
+ *
+ ****************************************************************************/
+
+static bool epoll_ready(FAR epoll_head_t *eph)
+{
+  irqstate_t flags;
+  bool ready;
+
+  while (nxsem_trywait(&eph->sem) >= 0)
+    {
+      /* Drop the stale wakeup */
+    }
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  ready = !list_is_empty(&eph->ready);
+  spin_unlock_irqrestore(&eph->rlock, flags);
+
+  return ready;
+}
+
 static int epoll_do_create(int size, int flags)
 {
   FAR epoll_head_t *eph;
@@ -236,6 +339,8 @@ static int epoll_do_create(int size, int flags)
 
   epn = (FAR epoll_node_t *)(eph + 1);
 
+  spin_initialize(&eph->rlock, SP_UNLOCKED);
+  list_initialize(&eph->ready);
   list_initialize(&eph->setup);
   list_initialize(&eph->teardown);
   list_initialize(&eph->oneshot);
@@ -280,7 +385,7 @@ static int epoll_setup(FAR epoll_head_t *eph)
        * cover the situation several poll event pending on one fd.
        */
 
-      epn->pfd.revents = 0;
+      epoll_unready(eph, epn);
       ret = poll_fdsetup(epn->pfd.fd, &epn->pfd, true);
       if (ret < 0)
         {
@@ -300,28 +405,56 @@ static int epoll_setup(FAR epoll_head_t *eph)
 static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
                           int maxevents)
 {
-  FAR epoll_node_t *tepn;
+  FAR struct list_node *node;
   FAR epoll_node_t *epn;
+  pollevent_t revents;
+  irqstate_t flags;
   int i = 0;
 
   nxmutex_lock(&eph->lock);
 
-  list_for_every_entry_safe(&eph->setup, epn, tepn, epoll_node_t, node)
+  while (i < maxevents)
     {
-      if (epn->pfd.revents != 0 && i < maxevents)
+      flags = spin_lock_irqsave(&eph->rlock);
+      node = list_remove_head(&eph->ready);
+      if (node == NULL)
         {
-          evs[i].data     = epn->data;
-          evs[i++].events = epn->pfd.revents;
-          poll_fdsetup(epn->pfd.fd, &epn->pfd, false);
-          list_delete(&epn->node);
-          if ((epn->pfd.events & EPOLLONESHOT) != 0)
-            {
-              list_add_tail(&eph->oneshot, &epn->node);
-            }
-          else
-            {
-              list_add_tail(&eph->teardown, &epn->node);
-            }
+          spin_unlock_irqrestore(&eph->rlock, flags);
+          break;
+        }
+
+      epn = container_of(node, epoll_node_t, rnode);
+      revents = epn->revents;
+      epn->revents = 0;
+      spin_unlock_irqrestore(&eph->rlock, flags);
+
+      if (revents == 0)
+        {
+          continue;
+        }
+
+      evs[i].data     = epn->data;
+      evs[i++].events = revents;
+
+      /* The edge triggered node stays setup, the driver queues it to the
+       * ready list again on the next notification.
+       */
+
+      if ((epn->pfd.events & (EPOLLET | EPOLLONESHOT)) == EPOLLET)
+        {
+          continue;
+        }
+
+      poll_fdsetup(epn->pfd.fd, &epn->pfd, false);
+      epoll_unready(eph, epn);
+      list_delete(&epn->node);
+      if ((epn->pfd.events & EPOLLONESHOT) != 0)
+        {
+          list_add_tail(&eph->oneshot, &epn->node);
+        }
+      else
+        {
+          list_add_tail(&eph->teardown, &epn->node);
         }
     }
 
@@ -476,8 +609,9 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
         epn->pfd.events  = ev->events;
         epn->pfd.fd      = fd;
         epn->pfd.arg     = &eph->sem;
-        epn->pfd.cb      = poll_default_cb;
+        epn->pfd.cb      = epoll_default_cb;
         epn->pfd.revents = 0;
+        epn->revents     = 0;
 
         ret = poll_fdsetup(fd, &epn->pfd, true);
         if (ret < 0)
@@ -496,6 +630,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
             if (epn->pfd.fd == fd)
               {
                 poll_fdsetup(fd, &epn->pfd, false);
+                epoll_unready(eph, epn);
                 list_delete(&epn->node);
                 list_add_tail(&eph->free, &epn->node);
                 goto out;
@@ -506,6 +641,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
           {
             if (epn->pfd.fd == fd)
               {
+                epoll_unready(eph, epn);
                 list_delete(&epn->node);
                 list_add_tail(&eph->free, &epn->node);
                 goto out;
@@ -516,6 +652,7 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
           {
             if (epn->pfd.fd == fd)
               {
+                epoll_unready(eph, epn);
                 list_delete(&epn->node);
                 list_add_tail(&eph->free, &epn->node);
                 goto out;
@@ -533,11 +670,11 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
                 if (epn->pfd.events != ev->events)
                   {
                     poll_fdsetup(fd, &epn->pfd, false);
+                    epoll_unready(eph, epn);
 
                     epn->data        = ev->data;
                     epn->pfd.events  = ev->events;
                     epn->pfd.fd      = fd;
-                    epn->pfd.revents = 0;
 
                     ret = poll_fdsetup(fd, &epn->pfd, true);
                     if (ret < 0)
@@ -556,10 +693,10 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
               {
                 if (epn->pfd.events != ev->events)
                   {
+                    epoll_unready(eph, epn);
                     epn->data        = ev->data;
                     epn->pfd.events  = ev->events;
                     epn->pfd.fd      = fd;
-                    epn->pfd.revents = 0;
 
                     ret = poll_fdsetup(fd, &epn->pfd, true);
                     if (ret < 0)
@@ -579,10 +716,10 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
           {
             if (epn->pfd.fd == fd)
               {
+                epoll_unready(eph, epn);
                 epn->data        = ev->data;
                 epn->pfd.events  = ev->events;
                 epn->pfd.fd      = fd;
-                epn->pfd.revents = 0;
 
                 ret = poll_fdsetup(fd, &epn->pfd, true);
                 if (ret < 0)
@@ -640,7 +777,7 @@ int epoll_pwait(int epfd, FAR struct epoll_event *evs,
 
   nxsig_procmask(SIG_SETMASK, sigmask, &oldsigmask);
 
-  if (timeout == 0)
+  if (timeout == 0 || epoll_ready(eph))
     {
       ret = OK;
     }
@@ -712,7 +849,7 @@ int epoll_wait(int epfd, FAR struct epoll_event *evs,
 
   /* Wait the poll ready */
 
-  if (timeout == 0)
+  if (timeout == 0 || epoll_ready(eph))
     {
       ret = OK;
     }
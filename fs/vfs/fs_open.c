@@ -38,6 +38,7 @@
 
 #include "inode/inode.h"
 #include "driver/driver.h"
+#include "mmap/fs_rammap.h"
 
 /****************************************************************************
  * Private Functions
@@ -254,6 +255,13 @@ static int file_vopen(FAR struct file *filep, FAR const char *path,
       goto errout_with_inode;
     }
 
+  /* The file content is gone, drop the shared copies of mapped files */
+
+  if ((oflags & O_TRUNC) != 0)
+    {
+      rammap_invalidate(inode);
+    }
+
   RELEASE_SEARCH(&desc);
   return OK;
 
@@ -36,6 +36,7 @@
 #include <nuttx/lib/lib.h>
 
 #include "inode/inode.h"
+#include "mmap/fs_rammap.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -428,6 +429,15 @@ next_subdir:
 
   ret = oldinode->u.i_mops->rename(oldinode, oldrelpath, newrelpath);
 
+  /* The files are now found under other paths, drop the shared copies of
+   * mapped files.
+   */
+
+  if (ret >= 0)
+    {
+      rammap_invalidate(oldinode);
+    }
+
 errout_with_newinode:
   inode_release(newinode);
 
@@ -33,6 +33,7 @@
 #include <nuttx/fs/fs.h>
 
 #include "inode/inode.h"
+#include "mmap/fs_rammap.h"
 
 /****************************************************************************
  * Public Functions
@@ -51,6 +52,7 @@
 int file_truncate(FAR struct file *filep, off_t length)
 {
   struct inode *inode;
+  int ret;
 
   /* Was this file opened for write access? */
 
@@ -99,7 +101,16 @@ int file_truncate(FAR struct file *filep, off_t length)
 
   /* Yes, then tell the file system to truncate this file */
 
-  return inode->u.i_ops->truncate(filep, length);
+  ret = inode->u.i_ops->truncate(filep, length);
+
+  /* Drop the shared copies of mapped files that are now out of date */
+
+  if (ret >= 0)
+    {
+      rammap_invalidate(inode);
+    }
+
+  return ret;
 }
 
 /****************************************************************************
@@ -32,6 +32,7 @@
 #include <nuttx/fs/fs.h>
 
 #include "inode/inode.h"
+#include "mmap/fs_rammap.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -96,6 +97,12 @@ int nx_unlink(FAR const char *pathname)
             {
               goto errout_with_inode;
             }
+
+          /* Drop the shared copies of mapped files, a new file may be
+           * created under the same path.
+           */
+
+          rammap_invalidate(inode);
         }
       else
         {
@@ -34,6 +34,7 @@
 #include <nuttx/cancelpt.h>
 
 #include "inode/inode.h"
+#include "mmap/fs_rammap.h"
 
 /****************************************************************************
  * Public Functions
@@ -68,6 +69,7 @@ ssize_t file_write(FAR struct file *filep, FAR const void *buf,
                    size_t nbytes)
 {
   FAR struct inode *inode;
+  ssize_t ret;
 
   /* Was this file opened for write access? */
 
@@ -86,7 +88,16 @@ ssize_t file_write(FAR struct file *filep, FAR const void *buf,
 
   /* Yes, then let the driver perform the write */
 
-  return inode->u.i_ops->write(filep, buf, nbytes);
+  ret = inode->u.i_ops->write(filep, buf, nbytes);
+
+  /* Drop the shared copies of mapped files that are now out of date */
+
+  if (ret > 0)
+    {
+      rammap_invalidate(inode);
+    }
+
+  return ret;
 }
 
 /****************************************************************************
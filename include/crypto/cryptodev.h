@@ -212,6 +212,8 @@ struct cryptop
   caddr_t crp_mac;
   caddr_t crp_dst;
   caddr_t crp_iv;
+
+  FAR struct cryptop *crp_next;    /* Link in the crypto work queue */
 };
 
 #define CRYPTO_BUF_IOV 0x1
@@ -334,6 +336,44 @@ struct crypt_op
   caddr_t iv;
 };
 
+/* One entry of a multi-operation request (CIOCCRYPTM) */
+
+struct crypt_n_op
+{
+  struct crypt_op op;
+  uint32_t reqid;     /* returns: request id, 0 if not queued */
+  int status;         /* returns: status of this operation */
+  FAR void *opaque;   /* handed back with the asynchronous result */
+};
+
+struct crypt_mop
+{
+#define CRYPT_MOP_F_ASYNC  (1 << 0) /* Queue the operations and return at
+                                     * once, the results are collected
+                                     * with CIOCCRYPTRET after poll()
+                                     * reports POLLIN.
+                                     */
+
+  uint32_t flags;
+  uint32_t count;     /* number of entries in reqs */
+  FAR struct crypt_n_op *reqs;
+};
+
+/* Completion record of an asynchronous operation (CIOCCRYPTRET) */
+
+struct crypt_result
+{
+  uint32_t reqid;
+  int status;
+  FAR void *opaque;
+};
+
+struct cryptret
+{
+  uint32_t count;     /* size of results, returns: entries filled */
+  FAR struct crypt_result *results;
+};
+
 /* hamc buffer, software & hardware need it */
 
 extern const uint8_t hmac_ipad_buffer[HMAC_MAX_BLOCK_LEN];
@@ -354,6 +394,8 @@ extern const uint8_t hmac_opad_buffer[HMAC_MAX_BLOCK_LEN];
 #define CIOCCRYPT               103
 #define CIOCKEY                 104
 #define CIOCASYMFEAT            105
+#define CIOCCRYPTM              106
+#define CIOCCRYPTRET            107
 
 int crypto_newsession(FAR uint64_t *, FAR struct cryptoini *, int);
 int crypto_freesession(uint64_t);
@@ -365,6 +407,8 @@ int crypto_kregister(uint32_t, FAR int *, CODE int (*)(struct cryptkop *));
 int crypto_unregister(uint32_t, int);
 int crypto_get_driverid(uint8_t);
 int crypto_invoke(FAR struct cryptop *);
+int crypto_dispatch(FAR struct cryptop *);
+void crypto_done(FAR struct cryptop *);
 int crypto_kinvoke(FAR struct cryptkop *);
 int crypto_getfeat(FAR int *);
 
@@ -28,8 +28,27 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdbool.h>
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* BCH sector cache statistics returned by the BIOC_CACHESTATS ioctl */
+
+struct bchlib_stats_s
+{
+  uint32_t nsectors;   /* Number of sectors held by the cache */
+  uint32_t hits;       /* Sector lookups satisfied by the cache */
+  uint32_t misses;     /* Sector lookups that required a device read */
+  uint32_t readahead;  /* Sectors fetched ahead of a sequential miss */
+  uint32_t rahits;     /* Read-ahead sectors that were later accessed */
+  uint32_t evictions;  /* Dirty sectors written back on eviction */
+  uint32_t writebacks; /* Dirty sectors written back by a flush */
+  uint32_t writes;     /* Device write requests issued by flushes */
+};
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -313,6 +313,13 @@
                                            *      to return sector numbers.
                                            * OUT: Data return in user-provided
                                            *      buffer. */
+#define BIOC_CACHESTATS _BIOC(0x0011)     /* Used only by BCH to return the
+                                           * sector cache statistics.
+                                           * IN:  Pointer to writable instance
+                                           *      of struct bchlib_stats_s in
+                                           *      which to return statistics.
+                                           * OUT: Data return in user-provided
+                                           *      buffer. */
 
 /* NuttX MTD driver ioctl definitions ***************************************/
 
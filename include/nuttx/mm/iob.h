@@ -114,6 +114,17 @@ struct iob_s
 #endif
   unsigned int io_pktlen; /* Total length of the packet */
 
+#ifdef CONFIG_NETDEV_OFFLOAD
+  /* Offload metadata of a network packet, only valid in the first entry of
+   * the chain.  See NETPKT_F_* in include/nuttx/net/netdev.h.
+   */
+
+  uint8_t  io_pktflags;   /* Offload flags of the packet */
+  uint16_t io_csumstart;  /* Offset of the TCP/UDP header */
+  uint16_t io_csumoff;    /* Offset of the checksum field in that header */
+  uint16_t io_gsosize;    /* Payload size of each segment */
+#endif
+
   uint8_t  io_data[CONFIG_IOB_BUFSIZE];
 };
 
@@ -88,6 +88,34 @@ struct mempool_procfs_entry_s
 };
 #endif
 
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+
+/* This structure describes a magazine, a small stack of free blocks */
+
+struct mempool_magazine_s
+{
+  size_t    nrounds;                                 /* The number of cached blocks */
+  FAR void *rounds[CONFIG_MM_MEMPOOL_MAGAZINE_SIZE]; /* The cached free blocks */
+};
+
+/* This structure describes the per-CPU cache in front of memory pool.
+ * The loaded and previous magazines point into magazine[], and are
+ * swapped instead of touching the pool when one of them runs dry or full.
+ * The lock is only contended when another CPU drains the cache because
+ * the pool ran out of free blocks.
+ */
+
+struct mempool_cpucache_s
+{
+  spinlock_t lock;                         /* The protect lock to cache */
+  FAR struct mempool_magazine_s *loaded;   /* The magazine in use */
+  FAR struct mempool_magazine_s *previous; /* The previous magazine */
+  struct mempool_magazine_s magazine[2];   /* The magazine storage */
+  unsigned long nhit;                      /* Operations served locally */
+  unsigned long nmiss;                     /* Operations reached the pool */
+};
+#endif
+
 /* This structure describes memory buffer pool */
 
 struct mempool_s
@@ -114,6 +142,9 @@ struct mempool_s
 #endif
   spinlock_t lock;      /* The protect lock to mempool */
   sem_t      waitsem;   /* The semaphore of waiter get free block */
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  struct mempool_cpucache_s cache[CONFIG_SMP_NCPUS]; /* The per-CPU cache */
+#endif
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MEMPOOL)
   struct mempool_procfs_entry_s procfs; /* The entry of procfs */
 #endif
@@ -139,6 +170,10 @@ struct mempoolinfo_s
   unsigned long aordblks; /* This is the number of used blocks */
   unsigned long sizeblks; /* This is the size of a mempool blocks */
   unsigned long nwaiter;  /* This is the number of waiter for mempool */
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  unsigned long nhit;     /* This is the number of per-CPU cache hits */
+  unsigned long nmiss;    /* This is the number of per-CPU cache misses */
+#endif
 };
 
 /****************************************************************************
@@ -30,6 +30,10 @@
 
 #include <nuttx/semaphore.h>
 
+#ifdef CONFIG_MUTEX_FASTPATH
+#  include <stdatomic.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -46,7 +50,11 @@
 struct mutex_s
 {
   sem_t sem;
+#ifdef CONFIG_MUTEX_FASTPATH
+  atomic_int holder; /* The pid_t of the holder, updated atomically */
+#else
   pid_t holder;
+#endif
 };
 
 typedef struct mutex_s mutex_t;
@@ -131,6 +139,22 @@ int nxmutex_destroy(FAR mutex_t *mutex);
 
 bool nxmutex_is_hold(FAR mutex_t *mutex);
 
+/****************************************************************************
+ * Name: nxmutex_get_holder
+ *
+ * Description:
+ *   This function get the holder of the mutex referenced by 'mutex'.
+ *
+ * Parameters:
+ *   mutex - mutex descriptor.
+ *
+ * Return Value:
+ *   The pid of the holder, or a negative value if it is not known.
+ *
+ ****************************************************************************/
+
+pid_t nxmutex_get_holder(FAR mutex_t *mutex);
+
 /****************************************************************************
  * Name: nxmutex_is_locked
  *
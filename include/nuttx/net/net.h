@@ -179,6 +179,12 @@ struct sock_intf_s
                     FAR struct file *infile, FAR off_t *offset,
                     size_t count);
 #endif
+  CODE int        (*si_sendmmsg)(FAR struct socket *psock,
+                    FAR struct mmsghdr *msgvec, unsigned int vlen,
+                    int flags);
+  CODE int        (*si_recvmmsg)(FAR struct socket *psock,
+                    FAR struct mmsghdr *msgvec, unsigned int vlen,
+                    int flags);
 };
 
 /* Each socket refers to a connection structure of type FAR void *.  Each
@@ -204,6 +210,14 @@ struct socket_conn_s
   FAR struct devif_callback_s *list;
   FAR struct devif_callback_s *list_tail;
 
+  /* Per-connection lock.  Protects the connection buffers (read-ahead and
+   * write queues) of protocols that have been converted to fine-grained
+   * locking, only UDP so far.  Initialized by the allocator of every
+   * protocol.  See conn_lock().
+   */
+
+  rmutex_t      s_lock;
+
   /* Socket options */
 
 #ifdef CONFIG_NET_SOCKOPTS
@@ -324,6 +338,24 @@ ssize_t net_ioctl_arglen(int cmd);
  *                       momentarily to wait for an IOB to become
  *                       available.
  *
+ * The network lock is a coarse lock that serializes the whole stack.  Two
+ * finer grained locks allow independent devices and connections to make
+ * progress without it:
+ *
+ *   netdev_lock()     - Locks one network device.  Held by the upper
+ *                       half driver while it calls into the lower half,
+ *                       so that receive, transmit and the configuration of
+ *                       the device do not overlap.
+ *   conn_lock()       - Locks one connection.  Protects the read-ahead and
+ *                       write buffer queues of protocols that have been
+ *                       converted to fine-grained locking.  Only UDP has
+ *                       been converted:  TCP and the other protocols rely
+ *                       on net_lock() alone.
+ *
+ * When more than one lock is needed they must be taken in the order
+ * net_lock() -> netdev_lock() -> conn_lock().  The device configuration
+ * paths keep the network locked while they lock the device.
+ *
  ****************************************************************************/
 
 /****************************************************************************
@@ -507,6 +539,121 @@ int net_sem_timedwait_uninterruptible(sem_t *sem, unsigned int timeout);
 
 int net_sem_wait_uninterruptible(sem_t *sem);
 
+/****************************************************************************
+ * Name: netdev_lock
+ *
+ * Description:
+ *   Take the lock of one network device.  The network lock may already be
+ *   held by the caller, but it must not be taken while the device lock is
+ *   held.  The caller must not hold any connection lock.
+ *
+ * Input Parameters:
+ *   dev - The network device to be locked.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+struct net_driver_s; /* Forward reference */
+int netdev_lock(FAR struct net_driver_s *dev);
+
+/****************************************************************************
+ * Name: netdev_unlock
+ *
+ * Description:
+ *   Release the lock of one network device.
+ *
+ * Input Parameters:
+ *   dev - The network device to be unlocked.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void netdev_unlock(FAR struct net_driver_s *dev);
+
+/****************************************************************************
+ * Name: conn_lock
+ *
+ * Description:
+ *   Take the lock of one connection.  The network lock may already be held
+ *   by the caller, but it must not be taken while the connection lock is
+ *   held.
+ *
+ * Input Parameters:
+ *   conn - The connection to be locked.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int conn_lock(FAR struct socket_conn_s *conn);
+
+/****************************************************************************
+ * Name: conn_unlock
+ *
+ * Description:
+ *   Release the lock of one connection.
+ *
+ * Input Parameters:
+ *   conn - The connection to be unlocked.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void conn_unlock(FAR struct socket_conn_s *conn);
+
+/****************************************************************************
+ * Name: conn_sem_timedwait
+ *
+ * Description:
+ *   Atomically wait for sem (or a timeout) while temporarily releasing
+ *   both the connection lock and, if it is held, the network lock.  The
+ *   locks are recovered in the net_lock() -> conn_lock() order.
+ *
+ * Input Parameters:
+ *   conn    - The connection whose lock is held by the caller.
+ *   sem     - A reference to the semaphore to be taken.
+ *   timeout - The relative time to wait until a timeout is declared.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int conn_sem_timedwait(FAR struct socket_conn_s *conn, FAR sem_t *sem,
+                       unsigned int timeout);
+
+/****************************************************************************
+ * Name: conn_sem_timedwait_uninterruptible
+ *
+ * Description:
+ *   This function is wrapped version of conn_sem_timedwait(), which is
+ *   uninterruptible and convenient for use.
+ *
+ * Input Parameters:
+ *   conn    - The connection whose lock is held by the caller.
+ *   sem     - A reference to the semaphore to be taken.
+ *   timeout - The relative time to wait until a timeout is declared.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int conn_sem_timedwait_uninterruptible(FAR struct socket_conn_s *conn,
+                                       FAR sem_t *sem,
+                                       unsigned int timeout);
+
 #ifdef CONFIG_MM_IOB
 
 /****************************************************************************
@@ -925,6 +1072,59 @@ ssize_t psock_sendmsg(FAR struct socket *psock, FAR struct msghdr *msg,
 ssize_t psock_recvmsg(FAR struct socket *psock, FAR struct msghdr *msg,
                       int flags);
 
+/****************************************************************************
+ * Name: psock_sendmmsg
+ *
+ * Description:
+ *   psock_sendmmsg() sends several messages to a socket with one call.  It
+ *   is the internal OS interface of sendmmsg() and differs from it like
+ *   psock_sendmsg() differs from sendmsg().
+ *
+ * Input Parameters:
+ *   psock     A pointer to a NuttX-specific, internal socket structure
+ *   msgvec    The messages to send.  The msg_len field of each message
+ *             sent is set to the number of characters sent.
+ *   vlen      The number of messages in msgvec
+ *   flags     Send flags
+ *
+ * Returned Value:
+ *   On success, returns the number of messages sent.  If the first message
+ *   cannot be sent, a negated errno value is returned.
+ *
+ ****************************************************************************/
+
+int psock_sendmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags);
+
+/****************************************************************************
+ * Name: psock_recvmmsg
+ *
+ * Description:
+ *   psock_recvmmsg() receives several messages from a socket with one
+ *   call.  It is the internal OS interface of recvmmsg() and differs from
+ *   it like psock_recvmsg() differs from recvmsg().
+ *
+ * Input Parameters:
+ *   psock     A pointer to a NuttX-specific, internal socket structure
+ *   msgvec    Buffers to receive the messages.  The msg_len field of each
+ *             message received is set to the number of characters
+ *             received.
+ *   vlen      The number of messages in msgvec
+ *   flags     Receive flags.  With MSG_WAITFORONE, only the first message
+ *             is waited for.
+ *   timeout   If not NULL, no further message is waited for once this
+ *             time has passed
+ *
+ * Returned Value:
+ *   On success, returns the number of messages received.  If no message
+ *   can be received, a negated errno value is returned.
+ *
+ ****************************************************************************/
+
+int psock_recvmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags,
+                   FAR const struct timespec *timeout);
+
 /****************************************************************************
  * Name: psock_send
  *
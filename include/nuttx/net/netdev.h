@@ -54,6 +54,7 @@
 #include <stdint.h>
 
 #include <nuttx/queue.h>
+#include <nuttx/mutex.h>
 
 #include <net/if.h>
 #include <net/ethernet.h>
@@ -157,6 +158,46 @@
 #  define NETDEV_ERRORS(dev)
 #endif
 
+/* Offload capabilities of a network device, see d_features */
+
+#define NETDEV_F_TXCSUM  (1 << 0) /* Fills in the TCP/UDP checksum */
+#define NETDEV_F_RXCSUM  (1 << 1) /* Verifies the TCP/UDP checksum */
+#define NETDEV_F_TSO     (1 << 2) /* Segments TCP super-segments */
+#define NETDEV_F_GSO     (1 << 3) /* Driver segments them in software */
+#define NETDEV_F_GRO     (1 << 4) /* Driver coalesces TCP segments */
+
+/* Offload metadata of a packet, see io_pktflags of the first IOB of d_iob.
+ *
+ * NETPKT_F_CSUM_PARTIAL:  The checksum of the bytes from io_csumstart to
+ *   the end of the packet remains to be stored at io_csumstart +
+ *   io_csumoff.  The checksum field holds the sum of the pseudo-header.
+ * NETPKT_F_CSUM_VALID:  The TCP/UDP checksum was verified by the device.
+ * NETPKT_F_GSO_TCPV4/6:  The packet is a TCP super-segment, to be cut in
+ *   segments of io_gsosize bytes of payload.  NETPKT_F_CSUM_PARTIAL is
+ *   set too.
+ *
+ * io_csumstart is counted from the start of the link layer header, as the
+ * offsets of the netpkt interface of the lower-half drivers.
+ */
+
+#define NETPKT_F_CSUM_PARTIAL (1 << 0)
+#define NETPKT_F_CSUM_VALID   (1 << 1)
+#define NETPKT_F_GSO_TCPV4    (1 << 2)
+#define NETPKT_F_GSO_TCPV6    (1 << 3)
+#define NETPKT_F_GSO          (NETPKT_F_GSO_TCPV4 | NETPKT_F_GSO_TCPV6)
+
+/* Tell whether the TCP/UDP checksum of the packet in d_iob needs no check:
+ * either the device verified it, or the packet was built by this host.
+ */
+
+#ifdef CONFIG_NETDEV_OFFLOAD
+#  define NETDEV_CSUM_TRUSTED(dev) \
+     (((dev)->d_iob->io_pktflags & \
+       (NETPKT_F_CSUM_VALID | NETPKT_F_CSUM_PARTIAL)) != 0)
+#else
+#  define NETDEV_CSUM_TRUSTED(dev) false
+#endif
+
 /* There are some helper pointers for accessing the contents of the IP
  * headers
  */
@@ -271,6 +312,12 @@ struct net_driver_s
 
   uint16_t d_pktsize;           /* Maximum packet size */
 
+#ifdef CONFIG_NETDEV_OFFLOAD
+  /* Offload capabilities.  See NETDEV_F_* definitions above */
+
+  uint32_t d_features;
+#endif
+
   /* Link layer address */
 
 #if defined(CONFIG_NET_ETHERNET) || defined(CONFIG_NET_6LOWPAN) || \
@@ -442,6 +489,10 @@ struct net_driver_s
   /* Drivers may attached device-specific, private information */
 
   FAR void *d_private;
+
+  /* Serializes the calls into the driver.  See netdev_lock(). */
+
+  rmutex_t d_lock;
 };
 
 typedef CODE int (*devif_poll_callback_t)(FAR struct net_driver_s *dev);
@@ -683,6 +734,31 @@ int netdev_ifdown(FAR struct net_driver_s *dev);
 int netdev_carrier_on(FAR struct net_driver_s *dev);
 int netdev_carrier_off(FAR struct net_driver_s *dev);
 
+/****************************************************************************
+ * Name: chksum_partial
+ *
+ * Description:
+ *   Calculate the 16-bit one's complement sum over the memory region
+ *   described by data and len.  The data is read as 16-bit words in native
+ *   byte order, paired from the first byte regardless of its alignment.
+ *
+ *   This is the inner loop of chksum() and chksum_iob().  If
+ *   CONFIG_NET_ARCH_CHKSUM_PARTIAL is defined, then this function must be
+ *   provided by architecture-specific logic, e.g. using SIMD instructions.
+ *   If only CONFIG_NET_ARCH_CHKSUM is defined, chksum_iob() uses the
+ *   architecture-specific chksum() instead.
+ *
+ * Input Parameters:
+ *   data - Beginning of the data to include in the checksum.
+ *   len  - Length of the data to include in the checksum.
+ *
+ * Returned Value:
+ *   The folded, uncomplemented sum in native byte order.
+ *
+ ****************************************************************************/
+
+uint16_t chksum_partial(FAR const uint8_t *data, size_t len);
+
 /****************************************************************************
  * Name: chksum
  *
@@ -77,6 +77,15 @@
 /* We use IOB as our buffer now, we may change to some other structure when
  * needed, so define a type netpkt_t for lower half.
  * TODO: Provide interface of its queue, maybe a simple wrapper of iob_queue.
+ *
+ * With CONFIG_NETDEV_OFFLOAD, the offload metadata of a packet is in the
+ * io_pktflags, io_csumstart, io_csumoff and io_gsosize fields, see
+ * NETPKT_F_* in nuttx/net/netdev.h.  A lower half announces what its
+ * device can do in netdev.d_features (NETDEV_F_*) before it registers,
+ * then reads the metadata of the packets to send and sets
+ * NETPKT_F_CSUM_VALID on the received packets the device verified.
+ * NETDEV_F_GSO and NETDEV_F_GRO are opt-in:  a lower half sets them to let
+ * the upper half segment and coalesce TCP in software for its device.
  */
 
 typedef struct iob_s netpkt_t;
@@ -126,6 +135,9 @@ struct netdev_lowerhalf_s
    *
    * Fields that lowerhalf should never touch (used by upper half):
    *   d_ifup, d_ifdown, d_txavail, d_addmac, d_rmmac, d_ioctl, d_private
+   *
+   * Fields that lowerhalf may set before registering:
+   *   d_features
    */
 
   struct net_driver_s netdev;
@@ -134,6 +146,10 @@ struct netdev_lowerhalf_s
 /* This structure is a set a callback functions used to call from the upper-
  * half, generic netdev driver into lower-half, platform-specific logic that
  * supports the low-level functionality.
+ *
+ * The upper half calls them with the device locked (netdev_lock()), so they
+ * never overlap.  receive() is called without the network lock and must not
+ * take it.
  */
 
 struct netdev_ops_s
@@ -47,6 +47,12 @@
 #define IPT_SO_GET_REVISION_TARGET (IPT_BASE_CTL + 3)
 #define IPT_SO_GET_MAX             IPT_SO_GET_REVISION_TARGET
 
+/* Values for "flag" field in struct ipt_ip (general ip structure). */
+
+#define IPT_F_FRAG                 0x01    /* Set if rule is a frag rule */
+#define IPT_F_GOTO                 0x02    /* Set if jump is a goto */
+#define IPT_F_MASK                 0x03    /* All possible flag bits mask. */
+
 /* Values for "flag" field in struct ip6t_ip6 (general ip6 structure). */
 
 #define IP6T_F_PROTO               0x01    /* Set if rule cares about upper protocols */
@@ -0,0 +1,80 @@
+/****************************************************************************
+ * include/nuttx/net/netfilter/xt_tcpudp.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_NET_NETFILTER_XT_TCPUDP_H
+#define __INCLUDE_NUTTX_NET_NETFILTER_XT_TCPUDP_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Names of the matches, as found in xt_entry_match. */
+
+#define XT_TCP_MATCH        "tcp"
+#define XT_UDP_MATCH        "udp"
+
+/* Values for "invflags" field in struct xt_tcp. */
+
+#define XT_TCP_INV_SRCPT    0x01 /* Invert the sense of source ports. */
+#define XT_TCP_INV_DSTPT    0x02 /* Invert the sense of dest ports. */
+#define XT_TCP_INV_FLAGS    0x04 /* Invert the sense of TCP flags. */
+#define XT_TCP_INV_OPTION   0x08 /* Invert the sense of option test. */
+#define XT_TCP_INV_MASK     0x0f /* All possible flags. */
+
+/* Values for "invflags" field in struct xt_udp. */
+
+#define XT_UDP_INV_SRCPT    0x01 /* Invert the sense of source ports. */
+#define XT_UDP_INV_DSTPT    0x02 /* Invert the sense of dest ports. */
+#define XT_UDP_INV_MASK     0x03 /* All possible flags. */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* TCP matching stuff, the data of a "tcp" xt_entry_match.  Port ranges
+ * are inclusive and in host byte order.
+ */
+
+struct xt_tcp
+{
+  uint16_t spts[2];  /* Source port range. */
+  uint16_t dpts[2];  /* Destination port range. */
+  uint8_t  option;   /* TCP Option iff non-zero */
+  uint8_t  flg_mask; /* TCP flags mask byte */
+  uint8_t  flg_cmp;  /* TCP flags compare byte */
+  uint8_t  invflags; /* Inverse flags */
+};
+
+/* UDP matching stuff, the data of a "udp" xt_entry_match. */
+
+struct xt_udp
+{
+  uint16_t spts[2];  /* Source port range. */
+  uint16_t dpts[2];  /* Destination port range. */
+  uint8_t  invflags; /* Inverse flags */
+};
+
+#endif /* __INCLUDE_NUTTX_NET_NETFILTER_XT_TCPUDP_H */
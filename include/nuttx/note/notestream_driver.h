@@ -0,0 +1,111 @@
+/****************************************************************************
+ * include/nuttx/note/notestream_driver.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_NOTE_NOTESTREAM_DRIVER_H
+#define __INCLUDE_NUTTX_NOTE_NOTESTREAM_DRIVER_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <nuttx/sched_note.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Stream format ************************************************************/
+
+/* /dev/note/stream returns a sequence of binary records, in time order
+ * across all CPUs.  Each record is:
+ *
+ *   uint8_t length   - Total length of the record in bytes
+ *   uint8_t type     - enum note_type_e, NOTESTREAM_NAME or NOTESTREAM_LOST
+ *   uint8_t priority - Priority of the task
+ *   uint8_t cpu      - CPU of the task
+ *   varint  pid      - ID of the task
+ *   varint  delta    - Time since the previous record read through the
+ *                      same open file in nanoseconds, zigzag encoded (see
+ *                      NOTESTREAM_UNZIGZAG).  The first record of a file
+ *                      carries the absolute time.
+ *   ...     payload  - The fields of the note that follow the
+ *                      struct note_common_s, unchanged.  The name of a
+ *                      NOTE_START note, for example.
+ *
+ * A varint is unsigned LEB128:  7 bits per byte, least significant group
+ * first, bit 7 set in all bytes but the last.
+ *
+ * Task names are interned:  a task name is only sent in its NOTE_START
+ * record and, for the tasks that already exist when the device is opened,
+ * in one NOTESTREAM_NAME record per task at the start of the stream.  All
+ * other records only carry the pid.
+ */
+
+#define NOTESTREAM_NAME       0xfe /* Payload: the task name, no NUL */
+#define NOTESTREAM_LOST       0xff /* Payload: varint count of records of
+                                    * this CPU dropped on buffer overflow */
+
+#define NOTESTREAM_ZIGZAG(v)   (((uint64_t)(v) << 1) ^ \
+                                (uint64_t)((int64_t)(v) >> 63))
+#define NOTESTREAM_UNZIGZAG(u) ((int64_t)((u) >> 1) ^ -(int64_t)((u) & 1))
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct notestream_driver_s;
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+#ifdef CONFIG_DRIVERS_NOTESTREAM
+extern struct notestream_driver_s g_notestream_driver;
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#if defined(__KERNEL__) || defined(CONFIG_BUILD_FLAT)
+
+/****************************************************************************
+ * Name: notestream_register
+ *
+ * Description:
+ *   Register the note stream driver at /dev/note/stream.
+ *
+ * Input Parameters:
+ *   None.
+ *
+ * Returned Value:
+ *   Zero on success. A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DRIVERS_NOTESTREAM
+int notestream_register(void);
+#endif
+
+#endif /* defined(__KERNEL__) || defined(CONFIG_BUILD_FLAT) */
+
+#endif /* __INCLUDE_NUTTX_NOTE_NOTESTREAM_DRIVER_H */
@@ -251,6 +251,33 @@ int nxsem_wait(FAR sem_t *sem);
 
 int nxsem_trywait(FAR sem_t *sem);
 
+/****************************************************************************
+ * Name: nxsem_trywait_holder
+ *
+ * Description:
+ *   This function takes a count of the specified semaphore on behalf of
+ *   another task, if the semaphore is currently available.  The task is
+ *   recorded as the holder of that count, so that it is subject to
+ *   priority inheritance just as if it had taken the count itself.  This
+ *   is used by the mutex fast path to hand over the ownership of a
+ *   contended mutex to its semaphore.
+ *
+ * Input Parameters:
+ *   sem    - Semaphore descriptor.
+ *   holder - The pid of the task that will hold the count.
+ *
+ * Returned Value:
+ *   This is an internal OS interface and should not be used by
+ *   applications.  It follows the NuttX internal error return policy:
+ *   Zero (OK) is returned on success.  A negated errno value is returned on
+ *   failure.  Possible returned errors:
+ *
+ *     - EAGAIN - The semaphore is not available.
+ *
+ ****************************************************************************/
+
+int nxsem_trywait_holder(FAR sem_t *sem, pid_t holder);
+
 /****************************************************************************
  * Name: nxsem_timedwait
  *
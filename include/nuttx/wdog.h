@@ -28,6 +28,7 @@
 #include <nuttx/config.h>
 
 #include <nuttx/clock.h>
+#include <nuttx/list.h>
 #include <stdint.h>
 
 /****************************************************************************
@@ -60,22 +61,25 @@ typedef uint32_t  wdparm_t;
 
 typedef CODE void (*wdentry_t)(wdparm_t arg);
 
-/* This is the internal representation of the watchdog timer structure.
- * Notice !!!
- * Carefully with the struct wdog_s order, you may not directly modify
- * this. This struct will combine in struct work_s in union type, and,
- * wqueue will modify/check this struct in kwork work_qcancel().
- */
+/* This is the internal representation of the watchdog timer structure. */
 
 struct wdog_s
 {
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  struct list_node   node;       /* Timing wheel slot list */
+#else
   FAR struct wdog_s *next;       /* Support for singly linked lists. */
+#endif
   wdparm_t           arg;        /* Callback argument */
   wdentry_t          func;       /* Function to execute when delay expires */
 #ifdef CONFIG_PIC
   FAR void          *picbase;    /* PIC base address */
 #endif
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  clock_t            expired;    /* Absolute expiration time in ticks */
+#else
   sclock_t           lag;        /* Timer associated with the delay */
+#endif
 };
 
 /****************************************************************************
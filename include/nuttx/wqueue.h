@@ -248,9 +248,8 @@ struct work_s
     struct
     {
       struct dq_entry_s dq; /* Implements a double linked list */
-      clock_t qtime;        /* Time work queued */
+      clock_t qtime;        /* Time work queued or due */
     } s;
-    struct wdog_s timer;    /* Delay expiry timer */
   } u;
   worker_t  worker;         /* Work callback */
   FAR void *arg;            /* Callback argument */
@@ -294,6 +293,10 @@ struct work_notifier_s
 
 typedef CODE void (*work_foreach_t)(int tid, FAR void *arg);
 
+/* This is an opaque reference to a kernel-mode work queue */
+
+struct kwork_wqueue_s;
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -406,6 +409,89 @@ int work_cancel(int qid, FAR struct work_s *work);
 
 int work_cancel_sync(int qid, FAR struct work_s *work);
 
+/****************************************************************************
+ * Name: work_queue_create
+ *
+ * Description:
+ *   Create a new kernel-mode work queue with its own worker thread(s).  A
+ *   driver can own such a queue so that its bottom half does not compete
+ *   with the rest of the system for the shared HPWORK/LPWORK threads.
+ *
+ * Input Parameters:
+ *   name       - Name of the worker thread(s)
+ *   priority   - Priority of the worker thread(s)
+ *   stack_size - Stack size of each worker thread
+ *   nthreads   - Number of worker threads
+ *
+ * Returned Value:
+ *   The new work queue on success; NULL on failure.
+ *
+ ****************************************************************************/
+
+FAR struct kwork_wqueue_s *work_queue_create(FAR const char *name,
+                                             int priority, int stack_size,
+                                             int nthreads);
+
+/****************************************************************************
+ * Name: work_queue_free
+ *
+ * Description:
+ *   Stop the worker thread(s) of a work queue created by
+ *   work_queue_create() and free it.  Work that is still queued is
+ *   discarded.
+ *
+ * Input Parameters:
+ *   wqueue - The work queue to free
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ ****************************************************************************/
+
+int work_queue_free(FAR struct kwork_wqueue_s *wqueue);
+
+/****************************************************************************
+ * Name: work_queue_wq/work_cancel_wq/work_cancel_sync_wq
+ *
+ * Description:
+ *   The same as work_queue(), work_cancel() and work_cancel_sync(), but on
+ *   a work queue created by work_queue_create().
+ *
+ ****************************************************************************/
+
+int work_queue_wq(FAR struct kwork_wqueue_s *wqueue,
+                  FAR struct work_s *work, worker_t worker,
+                  FAR void *arg, clock_t delay);
+int work_cancel_wq(FAR struct kwork_wqueue_s *wqueue,
+                   FAR struct work_s *work);
+int work_cancel_sync_wq(FAR struct kwork_wqueue_s *wqueue,
+                        FAR struct work_s *work);
+
+/****************************************************************************
+ * Name: work_queue_on/work_cancel_on
+ *
+ * Description:
+ *   Queue work on, or cancel work from, the work queue of one CPU.  The
+ *   worker thread of that queue only runs on that CPU so the worker sees
+ *   the per-CPU state (caches, interrupts) of the CPU it was queued on.
+ *
+ * Input Parameters:
+ *   cpu    - The CPU whose work queue is used
+ *   work, worker, arg, delay - As for work_queue()
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ *   -EINVAL - An invalid CPU was specified
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_PERCPUWORK
+int work_queue_on(int cpu, FAR struct work_s *work, worker_t worker,
+                  FAR void *arg, clock_t delay);
+int work_cancel_on(int cpu, FAR struct work_s *work);
+#endif
+
 /****************************************************************************
  * Name: work_foreach
  *
@@ -460,7 +546,7 @@ void work_foreach(int qid, work_foreach_t handler, FAR void *arg);
  ****************************************************************************/
 
 #ifdef __KERNEL__
-#  define work_timeleft(work) wd_gettime(&((work)->u.timer))
+sclock_t work_timeleft(FAR const struct work_s *work);
 #else
 #  define work_timeleft(work) ((sclock_t)((work)->u.s.qtime - clock()))
 #endif
@@ -131,6 +131,9 @@
 #define MSG_ERRQUEUE     0x002000 /* Fetch message from error queue.  */
 #define MSG_NOSIGNAL     0x004000 /* Do not generate SIGPIPE.  */
 #define MSG_MORE         0x008000 /* Sender will send more.  */
+#define MSG_WAITFORONE   0x010000 /* recvmmsg(): Only wait for the first
+                                   * message.
+                                   */
 #define MSG_CMSG_CLOEXEC 0x100000 /* Set close_on_exit for file
                                    * descriptor received through SCM_RIGHTS.
                                    */
@@ -215,6 +218,12 @@
 #define SO_PEERCRED     18 /* Return the credentials of the peer process
                             * connected to this socket.
                             */
+#define SO_REUSEPORT    19 /* Allow several sockets to bind the same local
+                            * address and port and spread the incoming
+                            * flows over them (get/set).
+                            * arg: pointer to integer containing a boolean
+                            * value
+                            */
 
 /* The options are unsupported but included for compatibility
  * and portability
@@ -348,6 +357,14 @@ struct msghdr
   unsigned int msg_flags;
 };
 
+/* One message of recvmmsg() and sendmmsg() */
+
+struct mmsghdr
+{
+  struct msghdr msg_hdr;        /* The message */
+  unsigned int msg_len;         /* Number of bytes transferred */
+};
+
 struct cmsghdr
 {
   unsigned long cmsg_len;       /* Data byte count, including hdr */
@@ -435,6 +452,12 @@ int getpeername(int sockfd, FAR struct sockaddr *addr,
 ssize_t recvmsg(int sockfd, FAR struct msghdr *msg, int flags);
 ssize_t sendmsg(int sockfd, FAR struct msghdr *msg, int flags);
 
+struct timespec;
+int recvmmsg(int sockfd, FAR struct mmsghdr *msgvec, unsigned int vlen,
+             int flags, FAR struct timespec *timeout);
+int sendmmsg(int sockfd, FAR struct mmsghdr *msgvec, unsigned int vlen,
+             int flags);
+
 #if CONFIG_FORTIFY_SOURCE > 0
 fortify_function(send) ssize_t send(int sockfd, FAR const void *buf,
                                     size_t len, int flags)
@@ -55,6 +55,18 @@
 
 #define LIB_BUFLEN_UNKNOWN INT_MAX
 
+/* Helpers for the word-at-a-time mem*() functions, see
+ * CONFIG_LIBC_MEMFUNC_OPTSPEED.  LIBC_WORD_HASZERO() is non-zero if any byte
+ * of the word is zero.
+ */
+
+#define LIBC_WORDSIZE          sizeof(uintptr_t)
+#define LIBC_WORDMASK          (LIBC_WORDSIZE - 1)
+#define LIBC_WORD_ALIGNED(p)   (((uintptr_t)(p) & LIBC_WORDMASK) == 0)
+#define LIBC_WORD_ONES         ((uintptr_t)-1 / 0xff)
+#define LIBC_WORD_HIGHS        (LIBC_WORD_ONES << 7)
+#define LIBC_WORD_HASZERO(w)   (((w) - LIBC_WORD_ONES) & ~(w) & LIBC_WORD_HIGHS)
+
 #if ((!defined(CONFIG_LIBC_PREVENT_MEMCHR_USER) && !defined(__KERNEL__))  || \
      (!defined(CONFIG_LIBC_PREVENT_MEMCHR_KERNEL) && defined(__KERNEL__)))
 #  define LIBC_BUILD_MEMCHR
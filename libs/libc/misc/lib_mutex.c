@@ -22,10 +22,17 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <errno.h>
 
+#ifdef CONFIG_MUTEX_FASTPATH
+#  include <stdatomic.h>
+#endif
+
 #include <nuttx/sched.h>
 #include <nuttx/clock.h>
+#include <nuttx/irq.h>
 #include <nuttx/mutex.h>
 #include <nuttx/semaphore.h>
 
@@ -35,6 +42,45 @@
 
 #define NXMUTEX_RESET          ((pid_t)-2)
 
+/* With CONFIG_MUTEX_FASTPATH the holder field is atomic and may be changed
+ * by another CPU at any time, so every access goes through these.
+ */
+
+#ifdef CONFIG_MUTEX_FASTPATH
+#  define nxmutex_holder(m)        ((pid_t)atomic_load(&(m)->holder))
+#  define nxmutex_set_holder(m, h) atomic_store(&(m)->holder, (h))
+#else
+#  define nxmutex_holder(m)        ((m)->holder)
+#  define nxmutex_set_holder(m, h) ((m)->holder = (h))
+#endif
+
+/* The fast path needs to fall back to kernel internal interfaces under
+ * contention, so it is only available in the kernel (or a flat build).
+ */
+
+#if defined(CONFIG_MUTEX_FASTPATH) && \
+    (defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__))
+#  define NXMUTEX_FASTPATH 1
+#endif
+
+#ifdef NXMUTEX_FASTPATH
+/* With the fast path, an uncontended mutex is owned by storing the pid of
+ * the holder in mutex->holder with a single compare-and-swap, while the
+ * semaphore keeps its count of one.  Once another task has to wait, the
+ * ownership is transferred to the semaphore (so that priority inheritance
+ * works as before) and NXMUTEX_CONTENDED is set in the holder field.  This
+ * forces the holder to release the mutex through the semaphore.  The
+ * mutex returns to the fast mode once it is released with no waiters.
+ */
+
+#  define NXMUTEX_CONTENDED    ((pid_t)0x40000000)
+#  define NXMUTEX_PIDMASK      ((pid_t)0x3fffffff)
+
+/* Ownership is being handed over to a waiter of the semaphore */
+
+#  define NXMUTEX_HANDOFF      (NXMUTEX_CONTENDED | NXMUTEX_PIDMASK)
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -54,9 +100,110 @@
 
 static bool nxmutex_is_reset(FAR mutex_t *mutex)
 {
-  return mutex->holder == NXMUTEX_RESET;
+  return nxmutex_holder(mutex) == NXMUTEX_RESET;
 }
 
+#ifdef NXMUTEX_FASTPATH
+/****************************************************************************
+ * Name: nxmutex_contend
+ *
+ * Description:
+ *   Handle a failed fast path lock attempt.  Either the mutex was released
+ *   in the meantime and is taken right away, or it is prepared for the
+ *   caller to wait on the semaphore:  If it is still owned through the fast
+ *   path, the ownership is transferred to the semaphore on behalf of the
+ *   holder, so that the holder's priority can be boosted.
+ *
+ * Parameters:
+ *   mutex - mutex descriptor.
+ *
+ * Return Value:
+ *   True if the mutex was taken, false if the caller must wait on the
+ *   semaphore.
+ *
+ * Assumptions:
+ *   Called within a critical section.
+ *
+ ****************************************************************************/
+
+static bool nxmutex_contend(FAR mutex_t *mutex)
+{
+  pid_t holder = nxmutex_holder(mutex);
+
+  for (; ; )
+    {
+      if (holder == NXMUTEX_NO_HOLDER)
+        {
+          if (atomic_compare_exchange_strong(&mutex->holder, &holder,
+                                             _SCHED_GETTID()))
+            {
+              return true;
+            }
+        }
+      else if (holder < 0 || (holder & NXMUTEX_CONTENDED) != 0)
+        {
+          /* Already owned through the semaphore (or reset) */
+
+          return false;
+        }
+      else if (atomic_compare_exchange_strong(&mutex->holder, &holder,
+                                              holder | NXMUTEX_CONTENDED))
+        {
+          /* The holder can no longer release the mutex with the fast path.
+           * Take the semaphore count on its behalf.
+           */
+
+          DEBUGVERIFY(nxsem_trywait_holder(&mutex->sem, holder));
+          return false;
+        }
+
+      /* The holder field changed under us, 'holder' was updated with the
+       * current value.  Try again.
+       */
+    }
+}
+
+/****************************************************************************
+ * Name: nxmutex_release
+ *
+ * Description:
+ *   Release a mutex that is owned through the semaphore.  If there are
+ *   waiters, the ownership is handed over to the first of them; otherwise
+ *   the mutex returns to the fast mode.
+ *
+ * Parameters:
+ *   mutex - mutex descriptor.
+ *
+ * Return Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int nxmutex_release(FAR mutex_t *mutex)
+{
+  irqstate_t flags;
+  pid_t holder;
+  int count;
+  int ret;
+
+  flags  = enter_critical_section();
+  holder = nxmutex_holder(mutex);
+
+  nxsem_get_value(&mutex->sem, &count);
+  nxmutex_set_holder(mutex, count < 0 ? NXMUTEX_HANDOFF :
+                                        NXMUTEX_NO_HOLDER);
+
+  ret = nxsem_post(&mutex->sem);
+  if (ret < 0)
+    {
+      nxmutex_set_holder(mutex, holder);
+    }
+
+  leave_critical_section(flags);
+  return ret;
+}
+#endif /* NXMUTEX_FASTPATH */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -89,7 +236,7 @@ int nxmutex_init(FAR mutex_t *mutex)
       return _SEM_ERRVAL(ret);
     }
 
-  mutex->holder = NXMUTEX_NO_HOLDER;
+  nxmutex_set_holder(mutex, NXMUTEX_NO_HOLDER);
 #ifdef CONFIG_PRIORITY_INHERITANCE
   _SEM_SETPROTOCOL(&mutex->sem, SEM_TYPE_MUTEX | SEM_PRIO_INHERIT);
 #else
@@ -126,7 +273,7 @@ int nxmutex_destroy(FAR mutex_t *mutex)
       return _SEM_ERRVAL(ret);
     }
 
-  mutex->holder = NXMUTEX_NO_HOLDER;
+  nxmutex_set_holder(mutex, NXMUTEX_NO_HOLDER);
   return ret;
 }
 
@@ -146,7 +293,39 @@ int nxmutex_destroy(FAR mutex_t *mutex)
 
 bool nxmutex_is_hold(FAR mutex_t *mutex)
 {
-  return mutex->holder == _SCHED_GETTID();
+  return nxmutex_get_holder(mutex) == _SCHED_GETTID();
+}
+
+/****************************************************************************
+ * Name: nxmutex_get_holder
+ *
+ * Description:
+ *   This function get the holder of the mutex referenced by 'mutex'.
+ *
+ * Parameters:
+ *   mutex - mutex descriptor.
+ *
+ * Return Value:
+ *   The pid of the holder, or a negative value if it is not known.
+ *
+ ****************************************************************************/
+
+pid_t nxmutex_get_holder(FAR mutex_t *mutex)
+{
+  pid_t holder = nxmutex_holder(mutex);
+
+#ifdef NXMUTEX_FASTPATH
+  if (holder == NXMUTEX_HANDOFF)
+    {
+      holder = NXMUTEX_NO_HOLDER;
+    }
+  else if (holder >= 0)
+    {
+      holder &= NXMUTEX_PIDMASK;
+    }
+#endif
+
+  return holder;
 }
 
 /****************************************************************************
@@ -167,6 +346,16 @@ bool nxmutex_is_locked(FAR mutex_t *mutex)
   int cnt;
   int ret;
 
+#ifdef NXMUTEX_FASTPATH
+  /* A mutex owned through the fast path keeps its semaphore count */
+
+  if (nxmutex_holder(mutex) != NXMUTEX_NO_HOLDER &&
+      !nxmutex_is_reset(mutex))
+    {
+      return true;
+    }
+#endif
+
   ret = _SEM_GETVALUE(&mutex->sem, &cnt);
 
   return ret >= 0 && cnt < 1;
@@ -194,17 +383,46 @@ bool nxmutex_is_locked(FAR mutex_t *mutex)
 
 int nxmutex_lock(FAR mutex_t *mutex)
 {
+#ifdef NXMUTEX_FASTPATH
+  pid_t holder = NXMUTEX_NO_HOLDER;
+  irqstate_t flags;
+#endif
   int ret;
 
   DEBUGASSERT(!nxmutex_is_hold(mutex));
+
+#ifdef NXMUTEX_FASTPATH
+  /* Try to take an unowned mutex with a single compare-and-swap */
+
+  if (atomic_compare_exchange_strong(&mutex->holder, &holder,
+                                     _SCHED_GETTID()))
+    {
+      return OK;
+    }
+
+  flags = enter_critical_section();
+#endif
+
   for (; ; )
     {
+#ifdef NXMUTEX_FASTPATH
+      if (nxmutex_contend(mutex))
+        {
+          ret = OK;
+          break;
+        }
+#endif
+
       /* Take the semaphore (perhaps waiting) */
 
       ret = nxsem_wait(&mutex->sem);
       if (ret >= 0)
         {
-          mutex->holder = _SCHED_GETTID();
+#ifdef NXMUTEX_FASTPATH
+          nxmutex_set_holder(mutex, _SCHED_GETTID() | NXMUTEX_CONTENDED);
+#else
+          nxmutex_set_holder(mutex, _SCHED_GETTID());
+#endif
           break;
         }
       else if (ret != -EINTR && ret != -ECANCELED)
@@ -213,6 +431,10 @@ int nxmutex_lock(FAR mutex_t *mutex)
         }
     }
 
+#ifdef NXMUTEX_FASTPATH
+  leave_critical_section(flags);
+#endif
+
   return ret;
 }
 
@@ -239,16 +461,36 @@ int nxmutex_lock(FAR mutex_t *mutex)
 
 int nxmutex_trylock(FAR mutex_t *mutex)
 {
+#ifdef NXMUTEX_FASTPATH
+  pid_t holder = NXMUTEX_NO_HOLDER;
+#endif
   int ret;
 
   DEBUGASSERT(!nxmutex_is_hold(mutex));
+
+#ifdef NXMUTEX_FASTPATH
+  if (atomic_compare_exchange_strong(&mutex->holder, &holder,
+                                     _SCHED_GETTID()))
+    {
+      return OK;
+    }
+  else if (holder != NXMUTEX_RESET)
+    {
+      return -EAGAIN;
+    }
+#endif
+
   ret = _SEM_TRYWAIT(&mutex->sem);
   if (ret < 0)
     {
       return _SEM_ERRVAL(ret);
     }
 
-  mutex->holder = _SCHED_GETTID();
+#ifdef NXMUTEX_FASTPATH
+  nxmutex_set_holder(mutex, _SCHED_GETTID() | NXMUTEX_CONTENDED);
+#else
+  nxmutex_set_holder(mutex, _SCHED_GETTID());
+#endif
   return ret;
 }
 
@@ -283,14 +525,37 @@ int nxmutex_timedlock(FAR mutex_t *mutex, unsigned int timeout)
   struct timespec delay;
   struct timespec rqtp;
 
+#ifdef NXMUTEX_FASTPATH
+  pid_t holder = NXMUTEX_NO_HOLDER;
+  irqstate_t flags;
+
+  if (atomic_compare_exchange_strong(&mutex->holder, &holder,
+                                     _SCHED_GETTID()))
+    {
+      return OK;
+    }
+#endif
+
   clock_gettime(CLOCK_MONOTONIC, &now);
   clock_ticks2time(MSEC2TICK(timeout), &delay);
   clock_timespec_add(&now, &delay, &rqtp);
 
+#ifdef NXMUTEX_FASTPATH
+  flags = enter_critical_section();
+#endif
+
   /* Wait until we get the lock or until the timeout expires */
 
   do
     {
+#ifdef NXMUTEX_FASTPATH
+      if (nxmutex_contend(mutex))
+        {
+          leave_critical_section(flags);
+          return OK;
+        }
+#endif
+
       ret = _SEM_CLOCKWAIT(&mutex->sem, CLOCK_MONOTONIC, &rqtp);
       if (ret < 0)
         {
@@ -301,9 +566,17 @@ int nxmutex_timedlock(FAR mutex_t *mutex, unsigned int timeout)
 
   if (ret >= 0)
     {
-      mutex->holder = _SCHED_GETTID();
+#ifdef NXMUTEX_FASTPATH
+      nxmutex_set_holder(mutex, _SCHED_GETTID() | NXMUTEX_CONTENDED);
+#else
+      nxmutex_set_holder(mutex, _SCHED_GETTID());
+#endif
     }
 
+#ifdef NXMUTEX_FASTPATH
+  leave_critical_section(flags);
+#endif
+
   return ret;
 }
 
@@ -329,6 +602,9 @@ int nxmutex_timedlock(FAR mutex_t *mutex, unsigned int timeout)
 
 int nxmutex_unlock(FAR mutex_t *mutex)
 {
+#ifdef NXMUTEX_FASTPATH
+  pid_t holder;
+#endif
   int ret;
 
   if (nxmutex_is_reset(mutex))
@@ -338,14 +614,29 @@ int nxmutex_unlock(FAR mutex_t *mutex)
 
   DEBUGASSERT(nxmutex_is_hold(mutex));
 
-  mutex->holder = NXMUTEX_NO_HOLDER;
+#ifdef NXMUTEX_FASTPATH
+  /* Release an uncontended mutex with a single compare-and-swap, otherwise
+   * the ownership must be released through the semaphore.
+   */
+
+  holder = _SCHED_GETTID();
+  if (atomic_compare_exchange_strong(&mutex->holder, &holder,
+                                     NXMUTEX_NO_HOLDER))
+    {
+      return OK;
+    }
+
+  ret = nxmutex_release(mutex);
+#else
+  nxmutex_set_holder(mutex, NXMUTEX_NO_HOLDER);
 
   ret = _SEM_POST(&mutex->sem);
   if (ret < 0)
     {
-      mutex->holder = _SCHED_GETTID();
+      nxmutex_set_holder(mutex, _SCHED_GETTID());
       ret = _SEM_ERRVAL(ret);
     }
+#endif
 
   return ret;
 }
@@ -364,7 +655,7 @@ int nxmutex_unlock(FAR mutex_t *mutex)
 #if defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__)
 void nxmutex_reset(FAR mutex_t *mutex)
 {
-  mutex->holder = NXMUTEX_RESET;
+  nxmutex_set_holder(mutex, NXMUTEX_RESET);
 
   nxsem_reset(&mutex->sem, 1);
 }
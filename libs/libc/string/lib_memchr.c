@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
 #include <string.h>
 
 #include "libc.h"
@@ -52,6 +53,40 @@ FAR void *memchr(FAR const void *s, int c, size_t n)
 {
   FAR const unsigned char *p = (FAR const unsigned char *)s;
 
+#ifdef CONFIG_LIBC_MEMFUNC_OPTSPEED
+  /* Skip the words which don't contain c, the bytewise loop below
+   * locates it inside the word.
+   */
+
+  if (n >= LIBC_WORDSIZE)
+    {
+      FAR const uintptr_t *w;
+      uintptr_t mask;
+
+      while (!LIBC_WORD_ALIGNED(p))
+        {
+          if (*p == (unsigned char)c)
+            {
+              return (FAR void *)p;
+            }
+
+          p++;
+          n--;
+        }
+
+      mask = LIBC_WORD_ONES * (unsigned char)c;
+      w    = (FAR const uintptr_t *)p;
+
+      while (n >= LIBC_WORDSIZE && !LIBC_WORD_HASZERO(*w ^ mask))
+        {
+          w++;
+          n -= LIBC_WORDSIZE;
+        }
+
+      p = (FAR const unsigned char *)w;
+    }
+#endif
+
   while (n--)
     {
       if (*p == (unsigned char)c)
@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "libc.h"
@@ -40,6 +41,42 @@ int memcmp(FAR const void *s1, FAR const void *s2, size_t n)
   FAR unsigned char *p1 = (FAR unsigned char *)s1;
   FAR unsigned char *p2 = (FAR unsigned char *)s2;
 
+#ifdef CONFIG_LIBC_MEMFUNC_OPTSPEED
+  /* Skip the equal words, the bytewise loop below finds the difference */
+
+  if (n >= LIBC_WORDSIZE &&
+      LIBC_WORD_ALIGNED((uintptr_t)p1 ^ (uintptr_t)p2))
+    {
+      FAR uintptr_t *w1;
+      FAR uintptr_t *w2;
+
+      while (!LIBC_WORD_ALIGNED(p1))
+        {
+          if (*p1 != *p2)
+            {
+              return *p1 < *p2 ? -1 : 1;
+            }
+
+          p1++;
+          p2++;
+          n--;
+        }
+
+      w1 = (FAR uintptr_t *)p1;
+      w2 = (FAR uintptr_t *)p2;
+
+      while (n >= LIBC_WORDSIZE && *w1 == *w2)
+        {
+          w1++;
+          w2++;
+          n -= LIBC_WORDSIZE;
+        }
+
+      p1 = (FAR unsigned char *)w1;
+      p2 = (FAR unsigned char *)w2;
+    }
+#endif
+
   while (n-- > 0)
     {
       if (*p1 < *p2)
@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "libc.h"
@@ -39,12 +40,45 @@ FAR void *memmove(FAR void *dest, FAR const void *src, size_t count)
 {
   FAR char *tmp;
   FAR char *s;
+#ifdef CONFIG_LIBC_MEMFUNC_OPTSPEED
+  bool words = count >= LIBC_WORDSIZE &&
+               LIBC_WORD_ALIGNED((uintptr_t)dest ^ (uintptr_t)src);
+  FAR uintptr_t *wtmp;
+  FAR uintptr_t *ws;
+#endif
 
   if (dest <= src)
     {
       tmp = (FAR char *) dest;
       s   = (FAR char *) src;
 
+#ifdef CONFIG_LIBC_MEMFUNC_OPTSPEED
+      /* Copying forward word by word is safe as long as dest is below
+       * src, each word is read before anything above it is written.
+       */
+
+      if (words)
+        {
+          while (!LIBC_WORD_ALIGNED(tmp))
+            {
+              *tmp++ = *s++;
+              count--;
+            }
+
+          wtmp = (FAR uintptr_t *)tmp;
+          ws   = (FAR uintptr_t *)s;
+
+          while (count >= LIBC_WORDSIZE)
+            {
+              *wtmp++ = *ws++;
+              count  -= LIBC_WORDSIZE;
+            }
+
+          tmp = (FAR char *)wtmp;
+          s   = (FAR char *)ws;
+        }
+#endif
+
       while (count--)
         {
           *tmp++ = *s++;
@@ -55,6 +89,29 @@ FAR void *memmove(FAR void *dest, FAR const void *src, size_t count)
       tmp = (FAR char *) dest + count;
       s   = (FAR char *) src + count;
 
+#ifdef CONFIG_LIBC_MEMFUNC_OPTSPEED
+      if (words)
+        {
+          while (!LIBC_WORD_ALIGNED(tmp))
+            {
+              *--tmp = *--s;
+              count--;
+            }
+
+          wtmp = (FAR uintptr_t *)tmp;
+          ws   = (FAR uintptr_t *)s;
+
+          while (count >= LIBC_WORDSIZE)
+            {
+              *--wtmp = *--ws;
+              count  -= LIBC_WORDSIZE;
+            }
+
+          tmp = (FAR char *)wtmp;
+          s   = (FAR char *)ws;
+        }
+#endif
+
       while (count--)
         {
           *--tmp = *--s;
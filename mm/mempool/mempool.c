@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <syslog.h>
 
 #include <nuttx/kmalloc.h>
@@ -109,6 +110,226 @@ static inline void mempool_add_backtrace(FAR struct mempool_s *pool,
 }
 #endif
 
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+
+/****************************************************************************
+ * Name: mempool_magazine_usable
+ *
+ * Description:
+ *   Blocks parked in a magazine are invisible to the other CPUs, so a pool
+ *   whose users sleep on waitsem for a freed block bypasses the caches.
+ *
+ ****************************************************************************/
+
+static inline bool mempool_magazine_usable(FAR struct mempool_s *pool)
+{
+  return !(pool->wait && pool->expandsize == 0);
+}
+
+/****************************************************************************
+ * Name: mempool_magazine_init
+ ****************************************************************************/
+
+static void mempool_magazine_init(FAR struct mempool_s *pool)
+{
+  int cpu;
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      FAR struct mempool_cpucache_s *cache = &pool->cache[cpu];
+
+      memset(cache, 0, sizeof(*cache));
+      spin_initialize(&cache->lock, SP_UNLOCKED);
+      cache->loaded   = &cache->magazine[0];
+      cache->previous = &cache->magazine[1];
+    }
+}
+
+/****************************************************************************
+ * Name: mempool_magazine_flush
+ *
+ * Description:
+ *   Return all cached blocks of one magazine to the pool, the caller must
+ *   hold pool->lock.
+ *
+ ****************************************************************************/
+
+static void mempool_magazine_flush(FAR struct mempool_s *pool,
+                                   FAR struct mempool_magazine_s *mag)
+{
+  while (mag->nrounds > 0)
+    {
+      sq_addfirst(mag->rounds[--mag->nrounds], &pool->queue);
+      pool->nalloc--;
+    }
+}
+
+/****************************************************************************
+ * Name: mempool_magazine_drain
+ *
+ * Description:
+ *   Return the cached blocks of all CPUs to the pool.  The caller must not
+ *   hold pool->lock or any cache lock.
+ *
+ ****************************************************************************/
+
+static void mempool_magazine_drain(FAR struct mempool_s *pool)
+{
+  int cpu;
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      FAR struct mempool_cpucache_s *cache = &pool->cache[cpu];
+      irqstate_t flags = spin_lock_irqsave(&cache->lock);
+      irqstate_t lflags = spin_lock_irqsave(&pool->lock);
+
+      mempool_magazine_flush(pool, &cache->magazine[0]);
+      mempool_magazine_flush(pool, &cache->magazine[1]);
+      spin_unlock_irqrestore(&pool->lock, lflags);
+      spin_unlock_irqrestore(&cache->lock, flags);
+    }
+}
+
+/****************************************************************************
+ * Name: mempool_magazine_count
+ *
+ * Description:
+ *   Get the number of free blocks cached by all CPUs, it's only a snapshot
+ *   since the other CPUs may be running the fast path concurrently.
+ *
+ ****************************************************************************/
+
+static size_t mempool_magazine_count(FAR struct mempool_s *pool)
+{
+  size_t count = 0;
+  int cpu;
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      count += pool->cache[cpu].magazine[0].nrounds +
+               pool->cache[cpu].magazine[1].nrounds;
+    }
+
+  return count;
+}
+
+/****************************************************************************
+ * Name: mempool_magazine_alloc
+ *
+ * Description:
+ *   Take a block from the magazines of this CPU. If both are empty, refill
+ *   the loaded one with a whole magazine of blocks under a single
+ *   acquisition of pool->lock.
+ *
+ * Returned Value:
+ *   The block on success; NULL if the pool has no free block in queue, the
+ *   caller should fall back to the slow path then.
+ *
+ ****************************************************************************/
+
+static FAR void *mempool_magazine_alloc(FAR struct mempool_s *pool)
+{
+  FAR struct mempool_cpucache_s *cache;
+  FAR struct mempool_magazine_s *mag;
+  FAR void *blk = NULL;
+  irqstate_t flags;
+
+  /* Even if the thread migrates before the lock is taken, it then just
+   * uses the cache of the previous CPU once, under its lock.
+   */
+
+  cache = &pool->cache[up_cpu_index()];
+  flags = spin_lock_irqsave(&cache->lock);
+  if (cache->loaded->nrounds == 0 && cache->previous->nrounds > 0)
+    {
+      mag             = cache->loaded;
+      cache->loaded   = cache->previous;
+      cache->previous = mag;
+    }
+
+  mag = cache->loaded;
+  if (mag->nrounds > 0)
+    {
+      cache->nhit++;
+    }
+  else
+    {
+      irqstate_t lflags = spin_lock_irqsave(&pool->lock);
+
+      while (mag->nrounds < CONFIG_MM_MEMPOOL_MAGAZINE_SIZE)
+        {
+          blk = mempool_remove_queue(&pool->queue);
+          if (blk == NULL)
+            {
+              break;
+            }
+
+          mag->rounds[mag->nrounds++] = blk;
+          pool->nalloc++;
+        }
+
+      spin_unlock_irqrestore(&pool->lock, lflags);
+      cache->nmiss++;
+    }
+
+  if (mag->nrounds > 0)
+    {
+      blk = mag->rounds[--mag->nrounds];
+    }
+
+  spin_unlock_irqrestore(&cache->lock, flags);
+  return blk;
+}
+
+/****************************************************************************
+ * Name: mempool_magazine_free
+ *
+ * Description:
+ *   Put a block into the magazines of this CPU. If both are full, the
+ *   previous one is flushed to the pool under a single acquisition of
+ *   pool->lock and becomes the new loaded magazine.
+ *
+ ****************************************************************************/
+
+static void mempool_magazine_free(FAR struct mempool_s *pool,
+                                  FAR void *blk)
+{
+  FAR struct mempool_cpucache_s *cache;
+  FAR struct mempool_magazine_s *mag;
+  irqstate_t flags;
+
+  cache = &pool->cache[up_cpu_index()];
+  flags = spin_lock_irqsave(&cache->lock);
+  mag   = cache->loaded;
+  if (mag->nrounds == CONFIG_MM_MEMPOOL_MAGAZINE_SIZE)
+    {
+      if (cache->previous->nrounds == CONFIG_MM_MEMPOOL_MAGAZINE_SIZE)
+        {
+          irqstate_t lflags = spin_lock_irqsave(&pool->lock);
+
+          mempool_magazine_flush(pool, cache->previous);
+          spin_unlock_irqrestore(&pool->lock, lflags);
+          cache->nmiss++;
+        }
+      else
+        {
+          cache->nhit++;
+        }
+
+      cache->loaded   = cache->previous;
+      cache->previous = mag;
+      mag             = cache->loaded;
+    }
+  else
+    {
+      cache->nhit++;
+    }
+
+  mag->rounds[mag->nrounds++] = blk;
+  spin_unlock_irqrestore(&cache->lock, flags);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -187,6 +408,10 @@ int mempool_init(FAR struct mempool_s *pool, FAR const char *name)
     }
 
   spin_initialize(&pool->lock, SP_UNLOCKED);
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  mempool_magazine_init(pool);
+#endif
+
   if (pool->wait && pool->expandsize == 0)
     {
       nxsem_init(&pool->waitsem, 0, 0);
@@ -223,12 +448,44 @@ FAR void *mempool_alloc(FAR struct mempool_s *pool)
 {
   FAR sq_entry_t *blk;
   irqstate_t flags;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  bool drained = false;
+#endif
+
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  if (mempool_magazine_usable(pool))
+    {
+      blk = mempool_magazine_alloc(pool);
+      if (blk != NULL)
+        {
+#  ifdef CONFIG_MM_FILL_ALLOCATIONS
+          memset(blk, 0xaa, pool->blocksize);
+#  endif
+          kasan_unpoison(blk, pool->blocksize);
+          return blk;
+        }
+    }
+#endif
 
 retry:
   flags = spin_lock_irqsave(&pool->lock);
   blk = mempool_remove_queue(&pool->queue);
   if (blk == NULL)
     {
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+      /* The free blocks may be parked in the caches of the other CPUs,
+       * take them back once before expanding or failing.
+       */
+
+      if (mempool_magazine_usable(pool) && !drained)
+        {
+          spin_unlock_irqrestore(&pool->lock, flags);
+          mempool_magazine_drain(pool);
+          drained = true;
+          goto retry;
+        }
+#endif
+
       if (up_interrupt_context())
         {
           blk = mempool_remove_queue(&pool->iqueue);
@@ -302,11 +559,32 @@ out_with_lock:
 
 void mempool_free(FAR struct mempool_s *pool, FAR void *blk)
 {
-  irqstate_t flags = spin_lock_irqsave(&pool->lock);
   size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
+  irqstate_t flags;
 #if CONFIG_MM_BACKTRACE >= 0
   FAR struct mempool_backtrace_s *buf =
     (FAR struct mempool_backtrace_s *)((FAR char *)blk + pool->blocksize);
+#endif
+
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  /* Blocks of the interrupt mempool always go back to iqueue */
+
+  if (mempool_magazine_usable(pool) &&
+      (pool->interruptsize <= blocksize ||
+       (FAR char *)blk < pool->ibase ||
+       (FAR char *)blk >= pool->ibase + pool->interruptsize - blocksize))
+    {
+#  ifdef CONFIG_MM_FILL_ALLOCATIONS
+      memset(blk, 0x55, pool->blocksize);
+#  endif
+      kasan_poison(blk, pool->blocksize);
+      mempool_magazine_free(pool, blk);
+      return;
+    }
+#endif
+
+  flags = spin_lock_irqsave(&pool->lock);
+#if CONFIG_MM_BACKTRACE >= 0
 
   /* Check double free */
 
@@ -369,6 +647,10 @@ int mempool_info(FAR struct mempool_s *pool, FAR struct mempoolinfo_s *info)
 {
   size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
   irqstate_t flags;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  size_t count;
+  int cpu;
+#endif
 
   DEBUGASSERT(pool != NULL && info != NULL);
 
@@ -383,8 +665,23 @@ int mempool_info(FAR struct mempool_s *pool, FAR struct mempoolinfo_s *info)
   info->arena =
     mempool_queue_lenth(&pool->equeue) * sizeof(sq_entry_t) +
     (info->aordblks + info->ordblks + info->iordblks) * blocksize;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  count = mempool_magazine_count(pool);
+  info->ordblks  += count;
+  info->aordblks -= count;
+#endif
   spin_unlock_irqrestore(&pool->lock, flags);
   info->sizeblks = blocksize;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  info->nhit  = 0;
+  info->nmiss = 0;
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      info->nhit  += pool->cache[cpu].nhit;
+      info->nmiss += pool->cache[cpu].nmiss;
+    }
+#endif
+
   if (pool->wait && pool->expandsize == 0)
     {
       int semcount;
@@ -420,14 +717,22 @@ mempool_info_task(FAR struct mempool_s *pool,
       size_t count = mempool_queue_lenth(&pool->queue) +
                      mempool_queue_lenth(&pool->iqueue);
 
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+      count += mempool_magazine_count(pool);
+#endif
       info.aordblks += count;
       info.uordblks += count * blocksize;
     }
 #if CONFIG_MM_BACKTRACE < 0
   else if (task->pid == PID_MM_ALLOC)
     {
-      info.aordblks += pool->nalloc;
-      info.uordblks += pool->nalloc * blocksize;
+      size_t count = pool->nalloc;
+
+#  ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+      count -= mempool_magazine_count(pool);
+#  endif
+      info.aordblks += count;
+      info.uordblks += count * blocksize;
     }
 #else
   else
@@ -476,6 +781,10 @@ void mempool_memdump(FAR struct mempool_s *pool,
                      FAR const struct mm_memdump_s *dump)
 {
   size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  int cpu;
+  int i;
+#endif
 
   if (dump->pid == PID_MM_FREE)
     {
@@ -492,6 +801,24 @@ void mempool_memdump(FAR struct mempool_s *pool,
           syslog(LOG_INFO, "%12zu%*p\n",
                  blocksize, MM_PTR_FMT_WIDTH, (FAR char *)entry);
         }
+
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+      for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+        {
+          for (i = 0; i < 2; i++)
+            {
+              FAR struct mempool_magazine_s *mag =
+                &pool->cache[cpu].magazine[i];
+              size_t n;
+
+              for (n = 0; n < mag->nrounds; n++)
+                {
+                  syslog(LOG_INFO, "%12zu%*p\n",
+                         blocksize, MM_PTR_FMT_WIDTH, mag->rounds[n]);
+                }
+            }
+        }
+#endif
     }
 #if CONFIG_MM_BACKTRACE >= 0
   else
@@ -544,6 +871,11 @@ int mempool_deinit(FAR struct mempool_s *pool)
   size_t blocksize = MEMPOOL_REALBLOCKSIZE(pool);
   FAR sq_entry_t *blk;
   size_t count = 0;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  /* Drain the per-CPU caches so that nalloc only counts the user blocks */
+
+  mempool_magazine_drain(pool);
+#endif
 
 #if CONFIG_MM_BACKTRACE >= 0
   if (!list_is_empty(&pool->alist))
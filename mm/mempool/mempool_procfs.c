@@ -40,7 +40,11 @@
  * to handle the longest line generated by this logic.
  */
 
-#define MEMPOOLINFO_LINELEN 80
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+#  define MEMPOOLINFO_LINELEN 120
+#else
+#  define MEMPOOLINFO_LINELEN 80
+#endif
 
 /****************************************************************************
  * Private Types
@@ -138,10 +142,17 @@ static ssize_t mempool_read(FAR struct file *filep, FAR char *buffer,
 
   offset    = filep->f_pos;
   procfile  = filep->f_priv;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+  linesize  = procfs_snprintf(procfile->line, MEMPOOLINFO_LINELEN,
+                              "%13s%11s%9s%9s%9s%9s%9s%11s%11s%6s\n", "",
+                              "total", "bsize", "nused", "nfree", "nifree",
+                              "nwaiter", "nhit", "nmiss", "hit%");
+#else
   linesize  = procfs_snprintf(procfile->line, MEMPOOLINFO_LINELEN,
                               "%13s%11s%9s%9s%9s%9s%9s\n", "", "total",
                               "bsize", "nused", "nfree", "nifree",
                               "nwaiter");
+#endif
 
   copysize  = procfs_memcpy(procfile->line, linesize, buffer, buflen,
                             &offset);
@@ -154,17 +165,35 @@ static ssize_t mempool_read(FAR struct file *filep, FAR char *buffer,
           FAR struct mempool_s *pool = container_of(entry, struct mempool_s,
                                                     procfs);
           struct mempoolinfo_s minfo;
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+          unsigned long total;
+#endif
 
           buffer    += copysize;
           buflen    -= copysize;
 
           mempool_info(pool, &minfo);
+#ifdef CONFIG_MM_MEMPOOL_MAGAZINE
+          total      = minfo.nhit + minfo.nmiss;
+          linesize   = procfs_snprintf(procfile->line, MEMPOOLINFO_LINELEN,
+                                       "%12s:%11lu%9lu%9lu%9lu%9lu%9lu"
+                                       "%11lu%11lu%5lu%%\n",
+                                       entry->name, minfo.arena,
+                                       minfo.sizeblks, minfo.aordblks,
+                                       minfo.ordblks, minfo.iordblks,
+                                       minfo.nwaiter, minfo.nhit,
+                                       minfo.nmiss, total == 0 ? 0 :
+                                       (unsigned long)
+                                       ((uint64_t)minfo.nhit * 100 /
+                                        total));
+#else
           linesize   = procfs_snprintf(procfile->line, MEMPOOLINFO_LINELEN,
                                        "%12s:%11lu%9lu%9lu%9lu%9lu%9lu\n",
                                        entry->name, minfo.arena,
                                        minfo.sizeblks, minfo.aordblks,
                                        minfo.ordblks, minfo.iordblks,
                                        minfo.nwaiter);
+#endif
           copysize   = procfs_memcpy(procfile->line, linesize, buffer,
                                      buflen, &offset);
           totalsize += copysize;
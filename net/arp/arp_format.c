@@ -50,6 +50,7 @@
 
 #include <nuttx/net/netdev.h>
 
+#include "netdev/netdev.h"
 #include "arp/arp.h"
 
 #ifdef CONFIG_NET_ARP
@@ -85,6 +86,12 @@ void arp_format(FAR struct net_driver_s *dev, in_addr_t ipaddr)
       return;
     }
 
+  /* The ARP request replaces the packet that was queued in d_iob, do not
+   * let the driver apply its checksum or segmentation offload to it.
+   */
+
+  netdev_offload_clear(dev);
+
   arp = ARPBUF;
   eth = ETHBUF;
 
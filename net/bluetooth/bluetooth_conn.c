@@ -152,6 +152,8 @@ FAR struct bluetooth_conn_s *bluetooth_conn_alloc(void)
 
       conn->bc_proto = BTPROTO_NONE;
 
+      nxrmutex_init(&conn->bc_conn.s_lock);
+
       /* Enqueue the connection into the active list */
 
       dq_addlast(&conn->bc_conn.node, &g_active_bluetooth_connections);
@@ -184,6 +186,8 @@ void bluetooth_conn_free(FAR struct bluetooth_conn_s *conn)
   net_lock();
   dq_rem(&conn->bc_conn.node, &g_active_bluetooth_connections);
 
+  nxrmutex_destroy(&conn->bc_conn.s_lock);
+
   /* Check if there any any frames attached to the container */
 
   for (container = conn->bc_rxhead; container != NULL; container = next)
@@ -72,7 +72,11 @@ int devif_iob_send(FAR struct net_driver_s *dev, FAR struct iob_s *iob,
     }
 
 #ifndef CONFIG_NET_IPFRAG
-  if (len > NETDEV_PKTSIZE(dev) - NET_LL_HDRLEN(dev) - target_offset)
+  if (len > NETDEV_PKTSIZE(dev) - NET_LL_HDRLEN(dev) - target_offset
+#ifdef CONFIG_NETDEV_GSO
+      && (dev->d_features & (NETDEV_F_TSO | NETDEV_F_GSO)) == 0
+#endif
+     )
     {
       ret = -EMSGSIZE;
       goto errout;
@@ -49,6 +49,7 @@
 #include "sixlowpan/sixlowpan.h"
 #include "ipfrag/ipfrag.h"
 #include "inet/inet.h"
+#include "netfilter/iptables.h"
 
 /****************************************************************************
  * Private Types
@@ -184,6 +185,31 @@ static void devif_packet_conversion(FAR struct net_driver_s *dev,
 #  define devif_packet_conversion(dev,pkttype)
 #endif /* CONFIG_NET_6LOWPAN */
 
+/****************************************************************************
+ * Name: devif_poll_filter
+ *
+ * Description:
+ *   Run an outgoing IPv4 packet through the OUTPUT chain of the filter
+ *   table, and discard it if it is dropped.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER
+static void devif_poll_filter(FAR struct net_driver_s *dev)
+{
+  if (dev->d_len > 0 && IFF_IS_IPv4(dev->d_flags) &&
+      ipv4_filter_output(dev, IPv4BUF) < 0)
+    {
+      dev->d_len = 0;
+    }
+}
+#else
+#  define devif_poll_filter(dev)
+#endif /* CONFIG_NET_IPFILTER */
+
 /****************************************************************************
  * Name: devif_poll_pkt_connections
  *
@@ -391,6 +417,10 @@ static inline int devif_poll_icmp(FAR struct net_driver_s *dev,
 
           icmp_poll(dev, conn);
 
+          /* Filter locally generated IPv4 packets */
+
+          devif_poll_filter(dev);
+
           /* Perform any necessary conversions on outgoing packets */
 
           devif_packet_conversion(dev, DEVIF_ICMP);
@@ -575,6 +605,10 @@ static int devif_poll_udp_connections(FAR struct net_driver_s *dev,
 
           udp_poll(dev, conn);
 
+          /* Filter locally generated IPv4 packets */
+
+          devif_poll_filter(dev);
+
           /* Perform any necessary conversions on outgoing packets */
 
           devif_packet_conversion(dev, DEVIF_UDP);
@@ -620,6 +654,10 @@ static inline int devif_poll_tcp_connections(FAR struct net_driver_s *dev,
 
           tcp_poll(dev, conn);
 
+          /* Filter locally generated IPv4 packets */
+
+          devif_poll_filter(dev);
+
           /* Perform any necessary conversions on outgoing packets */
 
           devif_packet_conversion(dev, DEVIF_TCP);
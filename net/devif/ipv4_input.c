@@ -105,6 +105,7 @@
 #include "ipforward/ipforward.h"
 #include "devif/devif.h"
 #include "nat/nat.h"
+#include "netfilter/iptables.h"
 #include "ipfrag/ipfrag.h"
 #include "utils/utils.h"
 
@@ -269,6 +270,13 @@ static int ipv4_in(FAR struct net_driver_s *dev)
       if (dev->d_len > 0)
 #endif
         {
+#ifdef CONFIG_NET_IPFILTER
+          if (ipv4_filter_input(dev, ipv4) < 0)
+            {
+              goto drop;
+            }
+#endif
+
           ret = udp_ipv4_input(dev);
         }
 
@@ -297,6 +305,13 @@ static int ipv4_in(FAR struct net_driver_s *dev)
       if (dev->d_len > 0)
 #endif
         {
+#ifdef CONFIG_NET_IPFILTER
+          if (ipv4_filter_input(dev, ipv4) < 0)
+            {
+              goto drop;
+            }
+#endif
+
           ret = udp_ipv4_input(dev);
         }
 
@@ -396,6 +411,18 @@ static int ipv4_in(FAR struct net_driver_s *dev)
       goto drop;
     }
 
+#ifdef CONFIG_NET_IPFILTER
+  /* Run the packet through the INPUT chain of the filter table. */
+
+  if (ipv4_filter_input(dev, ipv4) < 0)
+    {
+#ifdef CONFIG_NET_STATISTICS
+      g_netstats.ipv4.drop++;
+#endif
+      goto drop;
+    }
+#endif
+
   /* Now process the incoming packet according to the protocol. */
 
   switch (ipv4->proto)
@@ -438,6 +465,15 @@ static int ipv4_in(FAR struct net_driver_s *dev)
         goto drop;
     }
 
+#ifdef CONFIG_NET_IPFILTER
+  /* Run any response through the OUTPUT chain of the filter table. */
+
+  if (dev->d_len > 0 && ipv4_filter_output(dev, IPv4BUF) < 0)
+    {
+      goto drop;
+    }
+#endif
+
 #if defined(CONFIG_NET_IPFORWARD) || \
     (defined(CONFIG_NET_BROADCAST) && defined(NET_UDP_HAVE_STACK))
 done:
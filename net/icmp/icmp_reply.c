@@ -180,6 +180,10 @@ void icmp_reply(FAR struct net_driver_s *dev, int type, int code)
       ipv4 = IPBUF(0);
     }
 
+  /* The error message replaces the packet that was in d_iob */
+
+  netdev_offload_clear(dev);
+
   dev->d_len = ipicmplen + datalen;
 
   ipv4_build_header(IPv4BUF, dev->d_len, IP_PROTO_ICMP,
@@ -138,6 +138,8 @@ FAR struct icmpv6_conn_s *icmpv6_alloc(void)
              dq_remfirst(&g_free_icmpv6_connections);
       if (conn != NULL)
         {
+          nxrmutex_init(&conn->sconn.s_lock);
+
           /* Enqueue the connection into the active list */
 
           dq_addlast(&conn->sconn.node, &g_active_icmpv6_connections);
@@ -172,6 +174,8 @@ void icmpv6_free(FAR struct icmpv6_conn_s *conn)
 
   dq_rem(&conn->sconn.node, &g_active_icmpv6_connections);
 
+  nxrmutex_destroy(&conn->sconn.s_lock);
+
   /* If this is a preallocated or a batch allocated connection store it in
    * the free connections list. Else free it.
    */
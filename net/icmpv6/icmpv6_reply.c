@@ -169,6 +169,10 @@ void icmpv6_reply(FAR struct net_driver_s *dev, int type, int code, int data)
       ipv6 = IPBUF(0);
     }
 
+  /* The error message replaces the packet that was in d_iob */
+
+  netdev_offload_clear(dev);
+
   dev->d_len = ipicmplen + datalen;
 
   ipv6_build_header(IPv6BUF, dev->d_len - IPv6_HDRLEN, IP_PROTO_ICMP6,
@@ -97,6 +97,10 @@ void icmpv6_solicit(FAR struct net_driver_s *dev,
   ipv6_build_header(IPv6BUF, l3size, IP_PROTO_ICMP6,
                     dev->d_ipv6addr, dstaddr, 255, 0);
 
+  /* The solicitation replaces the packet that was in d_iob */
+
+  netdev_offload_clear(dev);
+
   /* Set up the ICMPv6 Neighbor Solicitation message */
 
   sol           = IPBUF(IPv6_HDRLEN);
@@ -143,6 +143,7 @@ FAR struct ieee802154_conn_s *ieee802154_conn_alloc(void)
          dq_remfirst(&g_free_ieee802154_connections);
   if (conn)
     {
+      nxrmutex_init(&conn->sconn.s_lock);
       dq_addlast(&conn->sconn.node, &g_active_ieee802154_connections);
     }
 
@@ -173,6 +174,8 @@ void ieee802154_conn_free(FAR struct ieee802154_conn_s *conn)
   net_lock();
   dq_rem(&conn->sconn.node, &g_active_ieee802154_connections);
 
+  nxrmutex_destroy(&conn->sconn.s_lock);
+
   /* Check if there any any frames attached to the container */
 
   for (container = conn->rxhead; container != NULL; container = next)
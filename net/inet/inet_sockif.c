@@ -103,6 +103,12 @@ static ssize_t    inet_sendfile(FAR struct socket *psock,
                     FAR struct file *infile, FAR off_t *offset,
                     size_t count);
 #endif
+static int        inet_sendmmsg(FAR struct socket *psock,
+                    FAR struct mmsghdr *msgvec, unsigned int vlen,
+                    int flags);
+static int        inet_recvmmsg(FAR struct socket *psock,
+                    FAR struct mmsghdr *msgvec, unsigned int vlen,
+                    int flags);
 
 /****************************************************************************
  * Private Data
@@ -133,6 +139,8 @@ static const struct sock_intf_s g_inet_sockif =
 #ifdef CONFIG_NET_SENDFILE
   , inet_sendfile   /* si_sendfile */
 #endif
+  , inet_sendmmsg   /* si_sendmmsg */
+  , inet_recvmmsg   /* si_recvmmsg */
 };
 
 /****************************************************************************
@@ -2300,6 +2308,76 @@ static ssize_t inet_recvmsg(FAR struct socket *psock,
   return ret;
 }
 
+/****************************************************************************
+ * Name: inet_sendmmsg
+ *
+ * Description:
+ *   Implements the sendmmsg interface for the case of the AF_INET and
+ *   AF_INET6 address families.  UDP datagrams are queued in the write
+ *   buffers together.
+ *
+ * Input Parameters:
+ *   psock    A pointer to a NuttX-specific, internal socket structure
+ *   msgvec   The messages to send
+ *   vlen     The number of messages in msgvec
+ *   flags    Send flags
+ *
+ * Returned Value:
+ *   The number of messages sent, a negated errno value if none was sent.
+ *   -ENOSYS if the socket type is not supported:  the messages are then
+ *   sent one by one.
+ *
+ ****************************************************************************/
+
+static int inet_sendmmsg(FAR struct socket *psock,
+                         FAR struct mmsghdr *msgvec, unsigned int vlen,
+                         int flags)
+{
+#if defined(NET_UDP_HAVE_STACK) && defined(CONFIG_NET_UDP_WRITE_BUFFERS) && \
+    !defined(CONFIG_NET_6LOWPAN)
+  if (psock->s_type == SOCK_DGRAM)
+    {
+      return psock_udp_sendmmsg(psock, msgvec, vlen, flags);
+    }
+#endif
+
+  return -ENOSYS;
+}
+
+/****************************************************************************
+ * Name: inet_recvmmsg
+ *
+ * Description:
+ *   Implements the recvmmsg interface for the case of the AF_INET and
+ *   AF_INET6 address families:  take the UDP datagrams that are already
+ *   queued, without waiting.
+ *
+ * Input Parameters:
+ *   psock    A pointer to a NuttX-specific, internal socket structure
+ *   msgvec   Buffers to receive the messages
+ *   vlen     The number of messages in msgvec
+ *   flags    Receive flags
+ *
+ * Returned Value:
+ *   The number of messages received, possibly zero.  -ENOSYS if the
+ *   socket type is not supported.
+ *
+ ****************************************************************************/
+
+static int inet_recvmmsg(FAR struct socket *psock,
+                         FAR struct mmsghdr *msgvec, unsigned int vlen,
+                         int flags)
+{
+#ifdef NET_UDP_HAVE_STACK
+  if (psock->s_type == SOCK_DGRAM)
+    {
+      return psock_udp_recvmmsg(psock, msgvec, vlen, flags);
+    }
+#endif
+
+  return -ENOSYS;
+}
+
 #endif /* NET_UDP_HAVE_STACK || NET_TCP_HAVE_STACK */
 
 /****************************************************************************
@@ -40,6 +40,7 @@
 #include "icmp/icmp.h"
 #include "ipforward/ipforward.h"
 #include "nat/nat.h"
+#include "netfilter/iptables.h"
 #include "devif/devif.h"
 
 #if defined(CONFIG_NET_IPFORWARD) && defined(CONFIG_NET_IPv4)
@@ -462,6 +463,17 @@ int ipv4_forward(FAR struct net_driver_s *dev, FAR struct ipv4_hdr_s *ipv4)
       goto drop;
     }
 
+#ifdef CONFIG_NET_IPFILTER
+  /* Run the packet through the FORWARD chain of the filter table. */
+
+  ret = ipv4_filter_forward(dev, fwddev, ipv4);
+  if (ret < 0)
+    {
+      ninfo("Dropped by the FORWARD chain\n");
+      goto drop;
+    }
+#endif
+
   /* Check if we are forwarding on the same device that we received the
    * packet from.
    */
@@ -1248,6 +1248,15 @@ int32_t ip_fragout(FAR struct net_driver_s *dev)
       return OK;
     }
 
+#ifdef CONFIG_NETDEV_GSO
+  /* A TCP super-segment is cut in segments, not fragmented */
+
+  if ((dev->d_iob->io_pktflags & NETPKT_F_GSO) != 0)
+    {
+      return OK;
+    }
+#endif
+
 #ifdef CONFIG_NET_6LOWPAN
   if (dev->d_lltype == NET_LL_IEEE802154 ||
       dev->d_lltype == NET_LL_PKTRADIO)
@@ -105,6 +105,33 @@ enum local_state_s
 
 struct devif_callback_s;       /* Forward reference */
 
+#ifdef CONFIG_NET_LOCAL_RING
+/* One direction of a connection carried by the in-kernel ring transport.
+ * The ring is shared by the two endpoints: the sender holds it as
+ * lc_txring and the receiver as lc_rxring.  SOCK_DGRAM packets are framed
+ * with a uint16_t length, SOCK_STREAM data is stored as is.
+ */
+
+struct local_ring_s
+{
+  mutex_t lr_lock;               /* Protects all of the fields below */
+  sem_t lr_rdsem;                /* Readers waiting for data */
+  sem_t lr_wrsem;                /* Writers waiting for space */
+  FAR struct pollfd *lr_rdfds[LOCAL_NPOLLWAITERS];
+  FAR struct pollfd *lr_wrfds[LOCAL_NPOLLWAITERS];
+  size_t lr_size;                /* Size of lr_buf */
+  size_t lr_rpos;                /* Offset of the oldest byte */
+  size_t lr_count;               /* Number of bytes in the ring */
+  uint8_t lr_nrdwait;            /* Number of threads on lr_rdsem */
+  uint8_t lr_nwrwait;            /* Number of threads on lr_wrsem */
+  uint8_t lr_crefs;              /* Endpoints still attached */
+  bool lr_dgram;                 /* Data is framed as packets */
+  bool lr_rdclosed;              /* Receiver closed or shut down */
+  bool lr_wrclosed;              /* Sender closed or shut down */
+  uint8_t lr_buf[1];             /* Data, lr_size bytes */
+};
+#endif
+
 struct local_conn_s
 {
   /* Common prologue of all connection structures. */
@@ -130,6 +157,12 @@ struct local_conn_s
 
   FAR struct local_conn_s *
                         lc_peer; /* Peer connection instance */
+#ifdef CONFIG_NET_LOCAL_RING
+  FAR struct local_ring_s *
+                      lc_rxring; /* Ring carrying data to this socket */
+  FAR struct local_ring_s *
+                      lc_txring; /* Ring carrying data to the peer */
+#endif /* CONFIG_NET_LOCAL_RING */
 #ifdef CONFIG_NET_LOCAL_SCM
   uint16_t lc_cfpcount;          /* Control file pointer counter */
   FAR struct file *
@@ -699,6 +732,115 @@ int local_set_pollthreshold(FAR struct local_conn_s *conn,
                             unsigned long threshold);
 #endif
 
+/****************************************************************************
+ * Name: local_ring_pair
+ *
+ * Description:
+ *   Connect two local sockets with a ring buffer per direction.  No inode
+ *   is created and the data never passes through the VFS.
+ *
+ * Input Parameters:
+ *   conn1 - One endpoint of the connection
+ *   conn2 - The other endpoint of the connection
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_LOCAL_RING
+int local_ring_pair(FAR struct local_conn_s *conn1,
+                    FAR struct local_conn_s *conn2);
+
+/****************************************************************************
+ * Name: local_ring_release
+ *
+ * Description:
+ *   Detach a socket from both of its rings.  The peer sees end-of-file on
+ *   receive and EPIPE on send.
+ *
+ ****************************************************************************/
+
+void local_ring_release(FAR struct local_conn_s *conn);
+
+/****************************************************************************
+ * Name: local_ring_shutdown
+ *
+ * Description:
+ *   Disable the receive (SHUT_RD) and/or send (SHUT_WR) direction of a
+ *   ring-connected socket.
+ *
+ ****************************************************************************/
+
+void local_ring_shutdown(FAR struct local_conn_s *conn, int how);
+
+/****************************************************************************
+ * Name: local_ring_send
+ *
+ * Description:
+ *   Send data to the peer of a ring-connected socket.
+ *
+ * Input Parameters:
+ *   conn     - The sending socket
+ *   iov      - The data to send
+ *   iovcnt   - Number of entries in iov
+ *   nonblock - Return -EAGAIN instead of waiting for space
+ *
+ * Returned Value:
+ *   The number of bytes sent on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t local_ring_send(FAR struct local_conn_s *conn,
+                        FAR const struct iovec *iov, size_t iovcnt,
+                        bool nonblock);
+
+/****************************************************************************
+ * Name: local_ring_recv
+ *
+ * Description:
+ *   Receive data from the peer of a ring-connected socket.  A SOCK_DGRAM
+ *   socket receives one packet per call, the rest of a packet that does
+ *   not fit in buf is discarded.
+ *
+ * Input Parameters:
+ *   conn     - The receiving socket
+ *   buf      - Buffer to receive the data
+ *   len      - Size of buf
+ *   flags    - MSG_PEEK and MSG_DONTWAIT are honoured
+ *
+ * Returned Value:
+ *   The number of bytes received, zero at end-of-file; a negated errno
+ *   value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t local_ring_recv(FAR struct local_conn_s *conn, FAR void *buf,
+                        size_t len, int flags);
+
+/****************************************************************************
+ * Name: local_ring_ioctl
+ *
+ * Description:
+ *   Handle FIONREAD, FIONWRITE and FIONSPACE for a ring-connected socket.
+ *
+ ****************************************************************************/
+
+int local_ring_ioctl(FAR struct local_conn_s *conn, int cmd,
+                     unsigned long arg);
+
+/****************************************************************************
+ * Name: local_ring_poll
+ *
+ * Description:
+ *   Setup or teardown poll() monitoring of a ring-connected socket.
+ *
+ ****************************************************************************/
+
+int local_ring_poll(FAR struct local_conn_s *conn, FAR struct pollfd *fds,
+                    bool setup);
+#endif /* CONFIG_NET_LOCAL_RING */
+
 #undef EXTERN
 #ifdef __cplusplus
 }
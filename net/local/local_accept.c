@@ -103,7 +103,9 @@ int local_accept(FAR struct socket *psock, FAR struct sockaddr *addr,
   FAR struct local_conn_s *client;
   FAR struct local_conn_s *conn;
   FAR dq_entry_t *waiter;
+#ifndef CONFIG_NET_LOCAL_RING
   bool nonblock = !!(flags & SOCK_NONBLOCK);
+#endif
   int ret;
 
   /* Some sanity checks */
@@ -177,6 +179,11 @@ int local_accept(FAR struct socket *psock, FAR struct sockaddr *addr,
               strlcpy(conn->lc_path, client->lc_path, sizeof(conn->lc_path));
               conn->lc_instance_id = client->lc_instance_id;
 
+#ifdef CONFIG_NET_LOCAL_RING
+              /* Connect both ends directly with a pair of rings */
+
+              ret = local_ring_pair(client, conn);
+#else
               /* Open the server-side write-only FIFO.  This should not
                * block.
                */
@@ -187,8 +194,10 @@ int local_accept(FAR struct socket *psock, FAR struct sockaddr *addr,
                   nerr("ERROR: Failed to open write-only FIFOs for %s: %d\n",
                      conn->lc_path, ret);
                 }
+#endif
             }
 
+#ifndef CONFIG_NET_LOCAL_RING
           /* Do we have a connection?  Is the write-side FIFO opened? */
 
           if (ret == OK)
@@ -213,7 +222,11 @@ int local_accept(FAR struct socket *psock, FAR struct sockaddr *addr,
           if (ret == OK)
             {
               DEBUGASSERT(conn->lc_infile.f_inode != NULL);
+            }
+#endif
 
+          if (ret == OK)
+            {
               /* Return the address family */
 
               if (addr != NULL)
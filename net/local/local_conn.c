@@ -130,6 +130,7 @@ FAR struct local_conn_s *local_alloc(void)
 
       nxmutex_init(&conn->lc_sendlock);
       nxmutex_init(&conn->lc_polllock);
+      nxrmutex_init(&conn->lc_conn.s_lock);
 
 #ifdef CONFIG_NET_LOCAL_SCM
       conn->lc_cred.pid = nxsched_getpid();
@@ -177,6 +178,12 @@ void local_free(FAR struct local_conn_s *conn)
 
   net_unlock();
 
+#ifdef CONFIG_NET_LOCAL_RING
+  /* Detach from the rings, the peer sees end-of-file */
+
+  local_ring_release(conn);
+#endif
+
   /* Make sure that the read-only FIFO is closed */
 
   if (conn->lc_infile.f_inode != NULL)
@@ -219,6 +226,7 @@ void local_free(FAR struct local_conn_s *conn)
 
   nxmutex_destroy(&conn->lc_sendlock);
   nxmutex_destroy(&conn->lc_polllock);
+  nxrmutex_destroy(&conn->lc_conn.s_lock);
 
   /* And free the connection structure */
 
@@ -91,6 +91,7 @@ static int inline local_stream_connect(FAR struct local_conn_s *client,
   server->u.server.lc_pending++;
   DEBUGASSERT(server->u.server.lc_pending != 0);
 
+#ifndef CONFIG_NET_LOCAL_RING
   /* Create the FIFOs needed for the connection */
 
   ret = local_create_fifos(client);
@@ -116,8 +117,12 @@ static int inline local_stream_connect(FAR struct local_conn_s *client,
     }
 
   DEBUGASSERT(client->lc_outfile.f_inode != NULL);
+#endif /* CONFIG_NET_LOCAL_RING */
 
-  /* Set the busy "result" before giving the semaphore. */
+  /* Set the busy "result" before giving the semaphore.  With the ring
+   * transport local_accept() attaches the rings to both ends, so there is
+   * nothing to open here.
+   */
 
   client->u.client.lc_result = -EBUSY;
   client->lc_state = LOCAL_STATE_ACCEPT;
@@ -148,10 +153,16 @@ static int inline local_stream_connect(FAR struct local_conn_s *client,
       if (ret < 0)
         {
           nerr("ERROR: Failed to connect: %d\n", ret);
+#ifdef CONFIG_NET_LOCAL_RING
+          client->lc_state = LOCAL_STATE_BOUND;
+          return ret;
+#else
           goto errout_with_outfd;
+#endif
         }
     }
 
+#ifndef CONFIG_NET_LOCAL_RING
   /* Yes.. open the read-only FIFO */
 
   ret = local_open_client_rx(client, nonblock);
@@ -163,6 +174,7 @@ static int inline local_stream_connect(FAR struct local_conn_s *client,
     }
 
   DEBUGASSERT(client->lc_infile.f_inode != NULL);
+#endif /* CONFIG_NET_LOCAL_RING */
 
   nxsem_post(&client->lc_donesem);
 
@@ -175,6 +187,7 @@ static int inline local_stream_connect(FAR struct local_conn_s *client,
   client->lc_state = LOCAL_STATE_CONNECTING;
   return -EINPROGRESS;
 
+#ifndef CONFIG_NET_LOCAL_RING
 errout_with_outfd:
   file_close(&client->lc_outfile);
   client->lc_outfile.f_inode = NULL;
@@ -183,6 +196,7 @@ errout_with_fifos:
   local_release_fifos(client);
   client->lc_state = LOCAL_STATE_BOUND;
   return ret;
+#endif /* CONFIG_NET_LOCAL_RING */
 }
 
 /****************************************************************************
@@ -165,6 +165,13 @@ int local_pollsetup(FAR struct socket *psock, FAR struct pollfd *fds)
 
   conn = psock->s_conn;
 
+#ifdef CONFIG_NET_LOCAL_RING
+  if (conn->lc_rxring != NULL)
+    {
+      return local_ring_poll(conn, fds, true);
+    }
+#endif
+
   if (conn->lc_proto == SOCK_DGRAM)
     {
       return ret;
@@ -318,6 +325,15 @@ int local_pollteardown(FAR struct socket *psock, FAR struct pollfd *fds)
 
   conn = psock->s_conn;
 
+#ifdef CONFIG_NET_LOCAL_RING
+  /* Only a pollfd set up by local_ring_poll() points back to conn */
+
+  if (conn->lc_rxring != NULL && fds->priv == conn)
+    {
+      return local_ring_poll(conn, fds, false);
+    }
+#endif
+
   if (conn->lc_proto == SOCK_DGRAM)
     {
       return -ENOSYS;
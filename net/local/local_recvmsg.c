@@ -201,6 +201,39 @@ out:
 }
 #endif /* CONFIG_NET_LOCAL_SCM */
 
+/****************************************************************************
+ * Name: psock_ring_recvfrom
+ *
+ * Description:
+ *   psock_ring_recvfrom() receives messages from a local socket connected
+ *   by the ring transport, either SOCK_STREAM or SOCK_DGRAM.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_LOCAL_RING
+static ssize_t psock_ring_recvfrom(FAR struct socket *psock, FAR void *buf,
+                                   size_t len, int flags,
+                                   FAR struct sockaddr *from,
+                                   FAR socklen_t *fromlen)
+{
+  FAR struct local_conn_s *conn = psock->s_conn;
+  ssize_t nread;
+  int ret;
+
+  nread = local_ring_recv(conn, buf, len, flags);
+  if (nread >= 0 && from != NULL)
+    {
+      ret = local_getaddr(conn, from, fromlen);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  return nread;
+}
+#endif /* CONFIG_NET_LOCAL_RING */
+
 /****************************************************************************
  * Name: psock_stream_recvfrom
  *
@@ -511,6 +544,16 @@ ssize_t local_recvmsg(FAR struct socket *psock, FAR struct msghdr *msg,
 
   DEBUGASSERT(buf);
 
+#ifdef CONFIG_NET_LOCAL_RING
+  /* Check for a connection carried by the ring transport */
+
+  if (((FAR struct local_conn_s *)psock->s_conn)->lc_rxring != NULL)
+    {
+      len = psock_ring_recvfrom(psock, buf, len, flags, from, fromlen);
+    }
+  else
+#endif
+
   /* Check for a stream socket */
 
 #ifdef CONFIG_NET_LOCAL_STREAM
@@ -0,0 +1,808 @@
+/****************************************************************************
+ * net/local/local_ring.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/net/net.h>
+
+#include "socket/socket.h"
+#include "local/local.h"
+
+#if defined(CONFIG_NET) && defined(CONFIG_NET_LOCAL_RING)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: local_ring_alloc
+ ****************************************************************************/
+
+static FAR struct local_ring_s *local_ring_alloc(bool dgram)
+{
+  FAR struct local_ring_s *ring;
+
+  ring = kmm_zalloc(sizeof(struct local_ring_s) +
+                    CONFIG_NET_LOCAL_RING_SIZE - 1);
+  if (ring != NULL)
+    {
+      nxmutex_init(&ring->lr_lock);
+      nxsem_init(&ring->lr_rdsem, 0, 0);
+      nxsem_init(&ring->lr_wrsem, 0, 0);
+
+      ring->lr_size  = CONFIG_NET_LOCAL_RING_SIZE;
+      ring->lr_dgram = dgram;
+      ring->lr_crefs = 2;
+    }
+
+  return ring;
+}
+
+/****************************************************************************
+ * Name: local_ring_free
+ ****************************************************************************/
+
+static void local_ring_free(FAR struct local_ring_s *ring)
+{
+  nxsem_destroy(&ring->lr_wrsem);
+  nxsem_destroy(&ring->lr_rdsem);
+  nxmutex_destroy(&ring->lr_lock);
+  kmm_free(ring);
+}
+
+/****************************************************************************
+ * Name: local_ring_copyin
+ *
+ * Description:
+ *   Append len bytes to the ring.  The caller has checked the free space.
+ *
+ ****************************************************************************/
+
+static void local_ring_copyin(FAR struct local_ring_s *ring,
+                              FAR const void *src, size_t len)
+{
+  size_t wpos;
+  size_t chunk;
+
+  wpos = ring->lr_rpos + ring->lr_count;
+  if (wpos >= ring->lr_size)
+    {
+      wpos -= ring->lr_size;
+    }
+
+  chunk = MIN(len, ring->lr_size - wpos);
+  memcpy(&ring->lr_buf[wpos], src, chunk);
+  memcpy(ring->lr_buf, (FAR const uint8_t *)src + chunk, len - chunk);
+  ring->lr_count += len;
+}
+
+/****************************************************************************
+ * Name: local_ring_copyout
+ *
+ * Description:
+ *   Copy len bytes starting off bytes after the oldest byte in the ring,
+ *   without consuming them.
+ *
+ ****************************************************************************/
+
+static void local_ring_copyout(FAR struct local_ring_s *ring, size_t off,
+                               FAR void *dest, size_t len)
+{
+  size_t rpos;
+  size_t chunk;
+
+  rpos = ring->lr_rpos + off;
+  if (rpos >= ring->lr_size)
+    {
+      rpos -= ring->lr_size;
+    }
+
+  chunk = MIN(len, ring->lr_size - rpos);
+  memcpy(dest, &ring->lr_buf[rpos], chunk);
+  memcpy((FAR uint8_t *)dest + chunk, ring->lr_buf, len - chunk);
+}
+
+/****************************************************************************
+ * Name: local_ring_consume
+ ****************************************************************************/
+
+static void local_ring_consume(FAR struct local_ring_s *ring, size_t len)
+{
+  ring->lr_count -= len;
+  if (ring->lr_count == 0)
+    {
+      /* Restart at the beginning so that the next copies do not wrap */
+
+      ring->lr_rpos = 0;
+    }
+  else
+    {
+      ring->lr_rpos += len;
+      if (ring->lr_rpos >= ring->lr_size)
+        {
+          ring->lr_rpos -= ring->lr_size;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: local_ring_rdevents and local_ring_wrevents
+ *
+ * Description:
+ *   Return the poll events seen by the receiving and the sending end of a
+ *   ring.  A datagram is only writable once its length header fits.
+ *
+ ****************************************************************************/
+
+static pollevent_t local_ring_rdevents(FAR struct local_ring_s *ring)
+{
+  pollevent_t eventset = 0;
+
+  if (ring->lr_count > 0 || ring->lr_rdclosed)
+    {
+      eventset |= POLLIN;
+    }
+
+  if (ring->lr_wrclosed)
+    {
+      eventset |= POLLHUP;
+    }
+
+  return eventset;
+}
+
+static pollevent_t local_ring_wrevents(FAR struct local_ring_s *ring)
+{
+  pollevent_t eventset = 0;
+  size_t space = ring->lr_size - ring->lr_count;
+
+  if (space > (ring->lr_dgram ? sizeof(uint16_t) : 0))
+    {
+      eventset |= POLLOUT;
+    }
+
+  if (ring->lr_rdclosed || ring->lr_wrclosed)
+    {
+      eventset |= POLLERR;
+    }
+
+  return eventset;
+}
+
+/****************************************************************************
+ * Name: local_ring_wait
+ *
+ * Description:
+ *   Drop the ring lock and wait for the other end.  The waker clears the
+ *   waiter count, so a waiter interrupted by a signal only costs a spurious
+ *   wakeup later on.
+ *
+ ****************************************************************************/
+
+static int local_ring_wait(FAR struct local_ring_s *ring, FAR sem_t *sem,
+                           FAR uint8_t *nwait)
+{
+  int ret;
+
+  (*nwait)++;
+  nxmutex_unlock(&ring->lr_lock);
+  ret = nxsem_wait(sem);
+  nxmutex_lock(&ring->lr_lock);
+  return ret;
+}
+
+static void local_ring_wake(FAR sem_t *sem, FAR uint8_t *nwait)
+{
+  while (*nwait > 0)
+    {
+      (*nwait)--;
+      nxsem_post(sem);
+    }
+}
+
+/****************************************************************************
+ * Name: local_ring_notify_reader and local_ring_notify_writer
+ *
+ * Assumptions:
+ *   The ring is locked.
+ *
+ ****************************************************************************/
+
+static void local_ring_notify_reader(FAR struct local_ring_s *ring)
+{
+  local_ring_wake(&ring->lr_rdsem, &ring->lr_nrdwait);
+  poll_notify(ring->lr_rdfds, LOCAL_NPOLLWAITERS,
+              local_ring_rdevents(ring));
+}
+
+static void local_ring_notify_writer(FAR struct local_ring_s *ring)
+{
+  local_ring_wake(&ring->lr_wrsem, &ring->lr_nwrwait);
+  poll_notify(ring->lr_wrfds, LOCAL_NPOLLWAITERS,
+              local_ring_wrevents(ring));
+}
+
+/****************************************************************************
+ * Name: local_ring_close
+ *
+ * Description:
+ *   Close the receiving (reader == true) or the sending end of a ring.
+ *   Data that can no longer be received is dropped.
+ *
+ ****************************************************************************/
+
+static void local_ring_close(FAR struct local_ring_s *ring, bool reader)
+{
+  nxmutex_lock(&ring->lr_lock);
+  if (reader)
+    {
+      if (!ring->lr_rdclosed)
+        {
+          ring->lr_rdclosed = true;
+          ring->lr_count    = 0;
+          ring->lr_rpos     = 0;
+          local_ring_notify_writer(ring);
+          local_ring_notify_reader(ring);
+        }
+    }
+  else if (!ring->lr_wrclosed)
+    {
+      ring->lr_wrclosed = true;
+      local_ring_notify_reader(ring);
+      local_ring_notify_writer(ring);
+    }
+
+  nxmutex_unlock(&ring->lr_lock);
+}
+
+/****************************************************************************
+ * Name: local_ring_subref
+ ****************************************************************************/
+
+static void local_ring_subref(FAR struct local_ring_s *ring)
+{
+  bool last;
+
+  nxmutex_lock(&ring->lr_lock);
+  DEBUGASSERT(ring->lr_crefs > 0);
+  last = --ring->lr_crefs == 0;
+  nxmutex_unlock(&ring->lr_lock);
+
+  if (last)
+    {
+      local_ring_free(ring);
+    }
+}
+
+/****************************************************************************
+ * Name: local_ring_pollsetup
+ ****************************************************************************/
+
+static int local_ring_pollsetup(FAR struct local_ring_s *ring,
+                                FAR struct pollfd *fds, bool reader)
+{
+  FAR struct pollfd **afds = reader ? ring->lr_rdfds : ring->lr_wrfds;
+  pollevent_t eventset;
+  int i;
+
+  nxmutex_lock(&ring->lr_lock);
+
+  for (i = 0; i < LOCAL_NPOLLWAITERS; i++)
+    {
+      if (afds[i] == NULL)
+        {
+          afds[i] = fds;
+          break;
+        }
+    }
+
+  if (i >= LOCAL_NPOLLWAITERS)
+    {
+      nxmutex_unlock(&ring->lr_lock);
+      return -EBUSY;
+    }
+
+  eventset = reader ? local_ring_rdevents(ring) : local_ring_wrevents(ring);
+  poll_notify(&fds, 1, eventset);
+
+  nxmutex_unlock(&ring->lr_lock);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: local_ring_pollteardown
+ ****************************************************************************/
+
+static void local_ring_pollteardown(FAR struct local_ring_s *ring,
+                                    FAR struct pollfd *fds, bool reader)
+{
+  FAR struct pollfd **afds = reader ? ring->lr_rdfds : ring->lr_wrfds;
+  int i;
+
+  nxmutex_lock(&ring->lr_lock);
+
+  for (i = 0; i < LOCAL_NPOLLWAITERS; i++)
+    {
+      if (afds[i] == fds)
+        {
+          afds[i] = NULL;
+        }
+    }
+
+  nxmutex_unlock(&ring->lr_lock);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: local_ring_pair
+ *
+ * Description:
+ *   Connect two local sockets with a ring buffer per direction.  No inode
+ *   is created and the data never passes through the VFS.
+ *
+ * Input Parameters:
+ *   conn1 - One endpoint of the connection
+ *   conn2 - The other endpoint of the connection
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int local_ring_pair(FAR struct local_conn_s *conn1,
+                    FAR struct local_conn_s *conn2)
+{
+  FAR struct local_ring_s *ring12;
+  FAR struct local_ring_s *ring21;
+  bool dgram = conn1->lc_proto == SOCK_DGRAM;
+
+  DEBUGASSERT(conn1->lc_proto == conn2->lc_proto);
+  DEBUGASSERT(conn1->lc_txring == NULL && conn2->lc_txring == NULL);
+
+  ring12 = local_ring_alloc(dgram);
+  ring21 = local_ring_alloc(dgram);
+  if (ring12 == NULL || ring21 == NULL)
+    {
+      nerr("ERROR: Failed to allocate the rings\n");
+
+      if (ring12 != NULL)
+        {
+          local_ring_free(ring12);
+        }
+
+      if (ring21 != NULL)
+        {
+          local_ring_free(ring21);
+        }
+
+      return -ENOMEM;
+    }
+
+  conn1->lc_txring = ring12;
+  conn2->lc_rxring = ring12;
+  conn2->lc_txring = ring21;
+  conn1->lc_rxring = ring21;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: local_ring_release
+ *
+ * Description:
+ *   Detach a socket from both of its rings.  The peer sees end-of-file on
+ *   receive and EPIPE on send.
+ *
+ ****************************************************************************/
+
+void local_ring_release(FAR struct local_conn_s *conn)
+{
+  if (conn->lc_rxring != NULL)
+    {
+      local_ring_close(conn->lc_rxring, true);
+      local_ring_subref(conn->lc_rxring);
+      conn->lc_rxring = NULL;
+    }
+
+  if (conn->lc_txring != NULL)
+    {
+      local_ring_close(conn->lc_txring, false);
+      local_ring_subref(conn->lc_txring);
+      conn->lc_txring = NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: local_ring_shutdown
+ *
+ * Description:
+ *   Disable the receive (SHUT_RD) and/or send (SHUT_WR) direction of a
+ *   ring-connected socket.
+ *
+ ****************************************************************************/
+
+void local_ring_shutdown(FAR struct local_conn_s *conn, int how)
+{
+  if ((how & SHUT_RD) != 0 && conn->lc_rxring != NULL)
+    {
+      local_ring_close(conn->lc_rxring, true);
+    }
+
+  if ((how & SHUT_WR) != 0 && conn->lc_txring != NULL)
+    {
+      local_ring_close(conn->lc_txring, false);
+    }
+}
+
+/****************************************************************************
+ * Name: local_ring_send
+ *
+ * Description:
+ *   Send data to the peer of a ring-connected socket.
+ *
+ * Input Parameters:
+ *   conn     - The sending socket
+ *   iov      - The data to send
+ *   iovcnt   - Number of entries in iov
+ *   nonblock - Return -EAGAIN instead of waiting for space
+ *
+ * Returned Value:
+ *   The number of bytes sent on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t local_ring_send(FAR struct local_conn_s *conn,
+                        FAR const struct iovec *iov, size_t iovcnt,
+                        bool nonblock)
+{
+  FAR struct local_ring_s *ring = conn->lc_txring;
+  FAR const struct iovec *end = iov + iovcnt;
+  size_t total = 0;
+  size_t space;
+  size_t off;
+  size_t n;
+  uint16_t len16;
+  ssize_t ret;
+
+  DEBUGASSERT(ring != NULL);
+
+  ret = nxmutex_lock(&ring->lr_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (ring->lr_dgram)
+    {
+      /* A packet goes into the ring as a whole, with its length first */
+
+      for (; iov != end; iov++)
+        {
+          total += iov->iov_len;
+        }
+
+      if (total > UINT16_MAX || total + sizeof(uint16_t) > ring->lr_size)
+        {
+          nerr("ERROR: Packet is too big: %zu\n", total);
+          ret = -EMSGSIZE;
+          goto out;
+        }
+
+      while (!ring->lr_rdclosed && !ring->lr_wrclosed &&
+             ring->lr_size - ring->lr_count < total + sizeof(uint16_t))
+        {
+          if (nonblock)
+            {
+              ret = -EAGAIN;
+              goto out;
+            }
+
+          ret = local_ring_wait(ring, &ring->lr_wrsem, &ring->lr_nwrwait);
+          if (ret < 0)
+            {
+              goto out;
+            }
+        }
+
+      if (ring->lr_rdclosed || ring->lr_wrclosed)
+        {
+          ret = -EPIPE;
+          goto out;
+        }
+
+      len16 = total;
+      local_ring_copyin(ring, &len16, sizeof(uint16_t));
+      for (iov = end - iovcnt; iov != end; iov++)
+        {
+          local_ring_copyin(ring, iov->iov_base, iov->iov_len);
+        }
+
+      local_ring_notify_reader(ring);
+      ret = total;
+      goto out;
+    }
+
+  /* Stream data is copied in as space becomes available.  The reader is
+   * woken up before the writer blocks so that it can drain the ring.
+   */
+
+  for (; iov != end; iov++)
+    {
+      off = 0;
+      while (off < iov->iov_len)
+        {
+          if (ring->lr_rdclosed || ring->lr_wrclosed)
+            {
+              ret = -EPIPE;
+              goto out;
+            }
+
+          space = ring->lr_size - ring->lr_count;
+          if (space == 0)
+            {
+              if (nonblock)
+                {
+                  ret = -EAGAIN;
+                  goto out;
+                }
+
+              local_ring_notify_reader(ring);
+              ret = local_ring_wait(ring, &ring->lr_wrsem,
+                                    &ring->lr_nwrwait);
+              if (ret < 0)
+                {
+                  goto out;
+                }
+
+              continue;
+            }
+
+          n = MIN(space, iov->iov_len - off);
+          local_ring_copyin(ring, (FAR const uint8_t *)iov->iov_base + off,
+                            n);
+          off   += n;
+          total += n;
+        }
+    }
+
+  ret = total;
+
+out:
+  if (!ring->lr_dgram && total > 0)
+    {
+      local_ring_notify_reader(ring);
+      ret = total;
+    }
+
+  nxmutex_unlock(&ring->lr_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: local_ring_recv
+ *
+ * Description:
+ *   Receive data from the peer of a ring-connected socket.  A SOCK_DGRAM
+ *   socket receives one packet per call, the rest of a packet that does
+ *   not fit in buf is discarded.
+ *
+ * Input Parameters:
+ *   conn     - The receiving socket
+ *   buf      - Buffer to receive the data
+ *   len      - Size of buf
+ *   flags    - MSG_PEEK and MSG_DONTWAIT are honoured
+ *
+ * Returned Value:
+ *   The number of bytes received, zero at end-of-file; a negated errno
+ *   value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t local_ring_recv(FAR struct local_conn_s *conn, FAR void *buf,
+                        size_t len, int flags)
+{
+  FAR struct local_ring_s *ring = conn->lc_rxring;
+  bool nonblock;
+  uint16_t len16;
+  size_t used;
+  ssize_t ret;
+
+  DEBUGASSERT(ring != NULL);
+
+  nonblock = (flags & MSG_DONTWAIT) != 0 ||
+             _SS_ISNONBLOCK(conn->lc_conn.s_flags);
+
+  ret = nxmutex_lock(&ring->lr_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  while (ring->lr_count == 0)
+    {
+      if (ring->lr_rdclosed || ring->lr_wrclosed)
+        {
+          ret = 0;
+          goto out;
+        }
+
+      if (nonblock)
+        {
+          ret = -EAGAIN;
+          goto out;
+        }
+
+      ret = local_ring_wait(ring, &ring->lr_rdsem, &ring->lr_nrdwait);
+      if (ret < 0)
+        {
+          goto out;
+        }
+    }
+
+  if (ring->lr_dgram)
+    {
+      local_ring_copyout(ring, 0, &len16, sizeof(uint16_t));
+      len  = MIN(len, len16);
+      local_ring_copyout(ring, sizeof(uint16_t), buf, len);
+      used = sizeof(uint16_t) + len16;
+    }
+  else
+    {
+      len  = MIN(len, ring->lr_count);
+      local_ring_copyout(ring, 0, buf, len);
+      used = len;
+    }
+
+  if ((flags & MSG_PEEK) == 0)
+    {
+      local_ring_consume(ring, used);
+      local_ring_notify_writer(ring);
+    }
+
+  ret = len;
+
+out:
+  nxmutex_unlock(&ring->lr_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: local_ring_ioctl
+ *
+ * Description:
+ *   Handle FIONREAD, FIONWRITE and FIONSPACE for a ring-connected socket.
+ *
+ ****************************************************************************/
+
+int local_ring_ioctl(FAR struct local_conn_s *conn, int cmd,
+                     unsigned long arg)
+{
+  FAR struct local_ring_s *ring;
+  FAR int *value = (FAR int *)(uintptr_t)arg;
+  uint16_t len16;
+
+  ring = cmd == FIONREAD ? conn->lc_rxring : conn->lc_txring;
+  if (ring == NULL)
+    {
+      return -ENOTCONN;
+    }
+
+  nxmutex_lock(&ring->lr_lock);
+
+  switch (cmd)
+    {
+      case FIONREAD:
+
+        /* A datagram socket reports the size of the next packet */
+
+        if (ring->lr_dgram && ring->lr_count > 0)
+          {
+            local_ring_copyout(ring, 0, &len16, sizeof(uint16_t));
+            *value = len16;
+          }
+        else
+          {
+            *value = ring->lr_count;
+          }
+        break;
+
+      case FIONWRITE:
+        *value = ring->lr_count;
+        break;
+
+      case FIONSPACE:
+        *value = ring->lr_size - ring->lr_count;
+        break;
+
+      default:
+        nxmutex_unlock(&ring->lr_lock);
+        return -ENOTTY;
+    }
+
+  nxmutex_unlock(&ring->lr_lock);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: local_ring_poll
+ *
+ * Description:
+ *   Setup or teardown poll() monitoring of a ring-connected socket.  The
+ *   pollfd is registered with the receive ring for POLLIN and with the
+ *   send ring for POLLOUT.
+ *
+ ****************************************************************************/
+
+int local_ring_poll(FAR struct local_conn_s *conn, FAR struct pollfd *fds,
+                    bool setup)
+{
+  int ret = OK;
+
+  if (!setup)
+    {
+      if (conn->lc_rxring != NULL)
+        {
+          local_ring_pollteardown(conn->lc_rxring, fds, true);
+        }
+
+      if (conn->lc_txring != NULL)
+        {
+          local_ring_pollteardown(conn->lc_txring, fds, false);
+        }
+
+      fds->priv = NULL;
+      return OK;
+    }
+
+  if ((fds->events & POLLIN) != 0 && conn->lc_rxring != NULL)
+    {
+      ret = local_ring_pollsetup(conn->lc_rxring, fds, true);
+    }
+
+  if (ret >= 0 && (fds->events & POLLOUT) != 0 && conn->lc_txring != NULL)
+    {
+      ret = local_ring_pollsetup(conn->lc_txring, fds, false);
+      if (ret < 0 && (fds->events & POLLIN) != 0)
+        {
+          local_ring_pollteardown(conn->lc_rxring, fds, true);
+        }
+    }
+
+  fds->priv = ret >= 0 ? conn : NULL;
+  return ret;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_LOCAL_RING */
@@ -182,6 +182,26 @@ static ssize_t local_send(FAR struct socket *psock,
           DEBUGASSERT(buf);
           peer = psock->s_conn;
 
+#ifdef CONFIG_NET_LOCAL_RING
+          /* Connections carried by the ring transport bypass the FIFOs */
+
+          if (peer->lc_state == LOCAL_STATE_CONNECTED &&
+              peer->lc_txring != NULL)
+            {
+              ret = nxmutex_lock(&peer->lc_sendlock);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              ret = local_ring_send(peer, buf, len,
+                                    _SS_ISNONBLOCK(peer->lc_conn.s_flags) ||
+                                    (flags & MSG_DONTWAIT) != 0);
+              nxmutex_unlock(&peer->lc_sendlock);
+              break;
+            }
+#endif
+
           /* Verify that this is a connected peer socket and that it has
            * opened the outgoing FIFO for write-only access.
            */
@@ -582,11 +582,23 @@ static int local_getsockopt(FAR struct socket *psock, int level, int option,
 
           case SO_SNDBUF:
             {
+#ifdef CONFIG_NET_LOCAL_RING
+              FAR struct local_conn_s *conn = psock->s_conn;
+#endif
+
               if (*value_len != sizeof(int))
                 {
                   return -EINVAL;
                 }
 
+#ifdef CONFIG_NET_LOCAL_RING
+              if (conn->lc_txring != NULL)
+                {
+                  *(FAR int *)value = conn->lc_txring->lr_size;
+                  return OK;
+                }
+#endif
+
               *(FAR int *)value = LOCAL_SEND_LIMIT;
               return OK;
             }
@@ -819,6 +831,14 @@ static int local_ioctl(FAR struct socket *psock, int cmd, unsigned long arg)
 
   conn = psock->s_conn;
 
+#ifdef CONFIG_NET_LOCAL_RING
+  if (conn->lc_rxring != NULL &&
+      (cmd == FIONREAD || cmd == FIONWRITE || cmd == FIONSPACE))
+    {
+      return local_ring_ioctl(conn, cmd, arg);
+    }
+#endif
+
   switch (cmd)
     {
       case FIONBIO:
@@ -902,7 +922,9 @@ static int local_ioctl(FAR struct socket *psock, int cmd, unsigned long arg)
 static int local_socketpair(FAR struct socket *psocks[2])
 {
   FAR struct local_conn_s *conns[2];
+#ifndef CONFIG_NET_LOCAL_RING
   bool nonblock;
+#endif
   int ret;
   int i;
 
@@ -924,6 +946,19 @@ static int local_socketpair(FAR struct socket *psocks[2])
                            = -1;
 #endif
 
+#ifdef CONFIG_NET_LOCAL_RING
+  /* Connect the pair directly, no FIFO is needed */
+
+  ret = local_ring_pair(conns[0], conns[1]);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  conns[0]->lc_state = conns[1]->lc_state
+                     = LOCAL_STATE_CONNECTED;
+  return OK;
+#else
   /* Create the FIFOs needed for the connection */
 
   ret = local_create_fifos(conns[0]);
@@ -984,6 +1019,7 @@ static int local_socketpair(FAR struct socket *psocks[2])
 errout:
   local_release_fifos(conns[0]);
   return ret;
+#endif /* CONFIG_NET_LOCAL_RING */
 }
 
 /****************************************************************************
@@ -1017,6 +1053,11 @@ static int local_shutdown(FAR struct socket *psock, int how)
       case SOCK_STREAM:
         {
           FAR struct local_conn_s *conn = psock->s_conn;
+
+#ifdef CONFIG_NET_LOCAL_RING
+          local_ring_shutdown(conn, how);
+#endif
+
           if (how & SHUT_RD)
             {
               if (conn->lc_infile.f_inode != NULL)
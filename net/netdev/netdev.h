@@ -37,6 +37,20 @@
 #  include <nuttx/wqueue.h>
 #endif
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Forget the offload metadata of the packet in d_iob, when d_iob is reused
+ * for another packet.
+ */
+
+#ifdef CONFIG_NETDEV_OFFLOAD
+#  define netdev_offload_clear(dev) ((dev)->d_iob->io_pktflags = 0)
+#else
+#  define netdev_offload_clear(dev)
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -495,6 +509,75 @@ void netdown_notifier_teardown(int key);
 void netdown_notifier_signal(FAR struct net_driver_s *dev);
 #endif
 
+/****************************************************************************
+ * Name: netdev_offload_txcsum
+ *
+ * Description:
+ *   Leave the TCP or UDP checksum of the packet in d_iob to the device, if
+ *   it can compute it:  store the sum of the pseudo-header in the checksum
+ *   field and mark the packet with NETPKT_F_CSUM_PARTIAL.  The IP header
+ *   must be complete.
+ *
+ * Input Parameters:
+ *   dev    - The network device, the packet is in d_iob
+ *   proto  - IP_PROTO_TCP or IP_PROTO_UDP
+ *   iplen  - The length of the IP header
+ *   field  - The checksum field of the TCP or UDP header
+ *
+ * Returned Value:
+ *   True if the device computes the checksum, false if the caller must.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_OFFLOAD
+bool netdev_offload_txcsum(FAR struct net_driver_s *dev, uint8_t proto,
+                           unsigned int iplen, FAR uint16_t *field);
+#else
+#  define netdev_offload_txcsum(dev, proto, iplen, field) false
+#endif
+
+/****************************************************************************
+ * Name: netdev_offload_gso
+ *
+ * Description:
+ *   Mark the TCP packet in d_iob as a super-segment if its payload is
+ *   larger than the MSS.  The device or the upper-half driver will cut it
+ *   in segments of MSS bytes.  Must be called before
+ *   netdev_offload_txcsum().
+ *
+ * Input Parameters:
+ *   dev   - The network device, the packet is in d_iob
+ *   iplen - The length of the IP header
+ *   mss   - The maximum segment size of the connection
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_GSO
+void netdev_offload_gso(FAR struct net_driver_s *dev, unsigned int iplen,
+                        uint16_t mss);
+#else
+#  define netdev_offload_gso(dev, iplen, mss)
+#endif
+
+/****************************************************************************
+ * Name: netdev_offload_maxseg
+ *
+ * Description:
+ *   Return the largest TCP payload to put in one packet:  a multiple of the
+ *   MSS if the device accepts super-segments, the MSS otherwise.
+ *
+ * Input Parameters:
+ *   dev - The network device
+ *   mss - The maximum segment size of the connection
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_GSO
+uint32_t netdev_offload_maxseg(FAR struct net_driver_s *dev, uint16_t mss);
+#else
+#  define netdev_offload_maxseg(dev, mss) (mss)
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
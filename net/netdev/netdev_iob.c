@@ -29,6 +29,8 @@
 
 #include <nuttx/net/netdev.h>
 
+#include "netdev/netdev.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -76,6 +78,7 @@ int netdev_iob_prepare(FAR struct net_driver_s *dev, bool throttled,
   /* Update l2 gruard size */
 
   iob_reserve(dev->d_iob, CONFIG_NET_LL_GUARDSIZE);
+  netdev_offload_clear(dev);
 
   /* Set the device buffer to l2 */
 
@@ -0,0 +1,218 @@
+/****************************************************************************
+ * net/netdev/netdev_offload.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <nuttx/net/ip.h>
+#include <nuttx/net/netdev.h>
+#include <nuttx/net/tcp.h>
+
+#include "netdev/netdev.h"
+
+#ifdef CONFIG_NETDEV_OFFLOAD
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The largest IP and TCP headers, options included */
+
+#define NETDEV_GSO_HDRLEN (60 + 60)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: netdev_offload_ipv4
+ *
+ * Description:
+ *   Tell whether the packet in d_iob is an IPv4 packet.
+ *
+ ****************************************************************************/
+
+static inline bool netdev_offload_ipv4(FAR struct net_driver_s *dev)
+{
+#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+  return (IPv4BUF->vhl & 0xf0) == IPv4_VERSION;
+#elif defined(CONFIG_NET_IPv4)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: netdev_offload_txcsum
+ *
+ * Description:
+ *   Leave the TCP or UDP checksum of the packet in d_iob to the device, if
+ *   it can compute it:  store the sum of the pseudo-header in the checksum
+ *   field and mark the packet with NETPKT_F_CSUM_PARTIAL.  The IP header
+ *   must be complete.
+ *
+ * Input Parameters:
+ *   dev    - The network device, the packet is in d_iob
+ *   proto  - IP_PROTO_TCP or IP_PROTO_UDP
+ *   iplen  - The length of the IP header
+ *   field  - The checksum field of the TCP or UDP header
+ *
+ * Returned Value:
+ *   True if the device computes the checksum, false if the caller must.
+ *
+ ****************************************************************************/
+
+bool netdev_offload_txcsum(FAR struct net_driver_s *dev, uint8_t proto,
+                           unsigned int iplen, FAR uint16_t *field)
+{
+  FAR struct iob_s *iob = dev->d_iob;
+  uint8_t pktflags = 0;
+  uint16_t sum;
+
+  if (proto == IP_PROTO_TCP)
+    {
+      pktflags = iob->io_pktflags & NETPKT_F_GSO;
+    }
+
+  /* A super-segment is always completed later, by the device or by the
+   * upper-half driver.  Otherwise the device must support it, and the
+   * packet must not need IP fragmentation:  a fragment cannot be summed
+   * alone.
+   */
+
+  if (pktflags == 0 &&
+      ((dev->d_features & NETDEV_F_TXCSUM) == 0 ||
+       dev->d_len > NETDEV_PKTSIZE(dev) - NET_LL_HDRLEN(dev)))
+    {
+      iob->io_pktflags = 0;
+      return false;
+    }
+
+  /* Sum the pseudo-header:  the protocol and length, which cannot carry,
+   * then the source and destination addresses.
+   */
+
+  sum = dev->d_len - iplen + proto;
+
+#ifdef CONFIG_NET_IPv4
+  if (netdev_offload_ipv4(dev))
+    {
+      sum = chksum(sum, (FAR uint8_t *)IPv4BUF->srcipaddr,
+                   2 * sizeof(in_addr_t));
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (!netdev_offload_ipv4(dev))
+    {
+      sum = chksum(sum, (FAR uint8_t *)IPv6BUF->srcipaddr,
+                   2 * sizeof(net_ipv6addr_t));
+    }
+#endif
+
+  *field            = HTONS(sum);
+
+  iob->io_pktflags  = pktflags | NETPKT_F_CSUM_PARTIAL;
+  iob->io_csumstart = NET_LL_HDRLEN(dev) + iplen;
+  iob->io_csumoff   = (FAR uint8_t *)field - (FAR uint8_t *)IPBUF(iplen);
+  return true;
+}
+
+#ifdef CONFIG_NETDEV_GSO
+
+/****************************************************************************
+ * Name: netdev_offload_gso
+ *
+ * Description:
+ *   Mark the TCP packet in d_iob as a super-segment if its payload is
+ *   larger than the MSS.  The device or the upper-half driver will cut it
+ *   in segments of MSS bytes.  Must be called before
+ *   netdev_offload_txcsum().
+ *
+ * Input Parameters:
+ *   dev   - The network device, the packet is in d_iob
+ *   iplen - The length of the IP header
+ *   mss   - The maximum segment size of the connection
+ *
+ ****************************************************************************/
+
+void netdev_offload_gso(FAR struct net_driver_s *dev, unsigned int iplen,
+                        uint16_t mss)
+{
+  FAR struct iob_s *iob = dev->d_iob;
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+  unsigned int hdrlen;
+
+  hdrlen = iplen + ((tcp->tcpoffset >> 4) << 2);
+
+  if ((dev->d_features & (NETDEV_F_TSO | NETDEV_F_GSO)) == 0 ||
+      dev->d_len <= hdrlen + mss)
+    {
+      iob->io_pktflags = 0;
+      return;
+    }
+
+  iob->io_pktflags = netdev_offload_ipv4(dev) ? NETPKT_F_GSO_TCPV4 :
+                                                NETPKT_F_GSO_TCPV6;
+  iob->io_gsosize  = mss;
+}
+
+/****************************************************************************
+ * Name: netdev_offload_maxseg
+ *
+ * Description:
+ *   Return the largest TCP payload to put in one packet:  a multiple of the
+ *   MSS if the device accepts super-segments, the MSS otherwise.
+ *
+ * Input Parameters:
+ *   dev - The network device
+ *   mss - The maximum segment size of the connection
+ *
+ ****************************************************************************/
+
+uint32_t netdev_offload_maxseg(FAR struct net_driver_s *dev, uint16_t mss)
+{
+  uint32_t maxseg;
+
+  if ((dev->d_features & (NETDEV_F_TSO | NETDEV_F_GSO)) == 0 || mss == 0)
+    {
+      return mss;
+    }
+
+  /* The whole frame must fit in d_len and the IP length field */
+
+  maxseg = (UINT16_MAX - NET_LL_HDRLEN(dev) - NETDEV_GSO_HDRLEN) / mss;
+  maxseg = MIN(maxseg, CONFIG_NETDEV_GSO_MAXSEGS);
+  return MAX(maxseg, 1) * mss;
+}
+
+#endif /* CONFIG_NETDEV_GSO */
+#endif /* CONFIG_NETDEV_OFFLOAD */
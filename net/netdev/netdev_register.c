@@ -389,6 +389,8 @@ int netdev_register(FAR struct net_driver_s *dev, enum net_lltype_e lltype)
       dev->d_conncb_tail = NULL;
       dev->d_devcb = NULL;
 
+      nxrmutex_init(&dev->d_lock);
+
       /* We need exclusive access for the following operations */
 
       net_lock();
@@ -0,0 +1,1132 @@
+/****************************************************************************
+ * net/netfilter/ipt_filter.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <debug.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/net/netdev.h>
+#include <nuttx/net/tcp.h>
+#include <nuttx/net/udp.h>
+#include <nuttx/net/netfilter/xt_tcpudp.h>
+
+#include "netfilter/iptables.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TABLE_NAME_FILTER     "filter"
+
+#define IPT_FILTER_HOOKS      ((1 << NF_INET_LOCAL_IN) | \
+                               (1 << NF_INET_FORWARD) | \
+                               (1 << NF_INET_LOCAL_OUT))
+
+/* Verdicts of a compiled rule, NF_DROP and NF_ACCEPT besides these. */
+
+#define IPT_FILTER_RETURN     2   /* Use the policy of the chain */
+#define IPT_FILTER_CONTINUE   3   /* Only count, go on with the next rule */
+
+/* The packet fields hashed by a rule class besides the masked addresses */
+
+#define IPT_CLASS_PROTO       0x01
+#define IPT_CLASS_DPORT       0x02
+
+/* Rule flags */
+
+#define IPT_RULE_IFACE        0x01  /* Check the interface names */
+#define IPT_RULE_TCP          0x02  /* Has a "tcp" match */
+#define IPT_RULE_UDP          0x04  /* Has a "udp" match */
+
+/* True if a test fails, taking the inverse flag of the test into account */
+
+#define IPT_FILTER_FAIL(test, invflags, flag) \
+  ((test) ^ (((invflags) & (flag)) != 0))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A rule of a chain, compiled from one ipt_entry. */
+
+struct ipt_filter_rule_s
+{
+  FAR struct ipt_filter_rule_s *flink; /* Next rule in the hash bucket */
+  struct ipt_ip ip;                    /* Copy of the IP matches */
+  uint16_t spts[2];                    /* Source port range */
+  uint16_t dpts[2];                    /* Destination port range */
+  uint8_t  flg_mask;                   /* TCP flags mask */
+  uint8_t  flg_cmp;                    /* TCP flags compare */
+  uint8_t  l4inv;                      /* Inverse flags of tcp/udp match */
+  uint8_t  flags;                      /* See IPT_RULE_* definitions */
+  uint8_t  verdict;                    /* See IPT_FILTER_* definitions */
+  unsigned int index;                  /* Position in the chain */
+  unsigned int offset;                 /* Offset of the entry in the table */
+  struct xt_counters counters;         /* Packet and byte counters */
+};
+
+/* A rule class holds all terminal rules of a chain that look at the same
+ * address masks and the same exact fields.  A packet is hashed once per
+ * class with the masks of the class, and only the rules in that bucket
+ * are checked.  The rules of a bucket are in chain order.
+ */
+
+struct ipt_filter_class_s
+{
+  in_addr_t smsk;                      /* Source address mask */
+  in_addr_t dmsk;                      /* Destination address mask */
+  uint8_t   fields;                    /* See IPT_CLASS_* definitions */
+  unsigned int first;                  /* Index of the first rule */
+  unsigned int nrules;                 /* Number of rules */
+  unsigned int mask;                   /* Number of buckets - 1 */
+  FAR struct ipt_filter_rule_s **buckets;
+};
+
+/* A compiled chain.  The classes are in the order of their first rule, so
+ * the search stops at the first class that starts after the best match.
+ * Rules without verdict only count packets and are kept in a list.
+ */
+
+struct ipt_filter_chain_s
+{
+  FAR struct ipt_filter_class_s *classes;
+  unsigned int nclasses;
+  FAR struct ipt_filter_rule_s **counting;
+  unsigned int ncounting;
+  FAR struct ipt_filter_rule_s *policy;
+};
+
+/* The compiled filter table */
+
+struct ipt_filter_s
+{
+  struct ipt_filter_chain_s chains[NF_INET_NUMHOOKS];
+  FAR struct ipt_filter_rule_s *rules;
+  unsigned int nrules;
+};
+
+/* The fields of a packet looked at by the rules */
+
+struct ipt_filter_pkt_s
+{
+  in_addr_t src;
+  in_addr_t dst;
+  uint16_t  sport;
+  uint16_t  dport;
+  uint16_t  len;
+  uint8_t   proto;
+  uint8_t   tcpflags;
+  bool      frag;                      /* Not the first fragment */
+  bool      l4;                        /* Ports and TCP flags are valid */
+  FAR const char *indev;
+  FAR const char *outdev;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The active rules, changed and used with the network locked. */
+
+static FAR struct ipt_filter_s *g_filter;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipt_filter_hash
+ *
+ * Description:
+ *   Hash the key of a rule class.
+ *
+ ****************************************************************************/
+
+static uint32_t ipt_filter_mix(uint32_t hash)
+{
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+static uint32_t ipt_filter_hash(in_addr_t src, in_addr_t dst,
+                                uint8_t proto, uint16_t dport)
+{
+  uint32_t hash;
+
+  hash = ipt_filter_mix(src) ^ dst;
+  hash = ipt_filter_mix(hash) ^ ((uint32_t)proto << 16 | dport);
+  return ipt_filter_mix(hash);
+}
+
+/****************************************************************************
+ * Name: ipt_filter_ifmatch
+ *
+ * Description:
+ *   Compare a device name with the interface name of a rule.  Only the
+ *   bytes selected by the mask are compared, so "eth+" matches all
+ *   interfaces starting with "eth".
+ *
+ ****************************************************************************/
+
+static bool ipt_filter_ifmatch(FAR const char *name, FAR const char *iface,
+                               FAR const uint8_t *mask)
+{
+  char ch = '\0';
+  int i;
+
+  for (i = 0; i < IFNAMSIZ; i++)
+    {
+      /* Compare the bytes after the end of the name as zero. */
+
+      if (i == 0 || ch != '\0')
+        {
+          ch = name[i];
+        }
+
+      if (((ch ^ iface[i]) & mask[i]) != 0)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_match
+ *
+ * Description:
+ *   Check whether a packet matches a rule.
+ *
+ ****************************************************************************/
+
+static bool ipt_filter_match(FAR const struct ipt_filter_rule_s *rule,
+                             FAR const struct ipt_filter_pkt_s *pkt)
+{
+  FAR const struct ipt_ip *ip = &rule->ip;
+
+  if (IPT_FILTER_FAIL((pkt->src & ip->smsk.s_addr) != ip->src.s_addr,
+                      ip->invflags, IPT_INV_SRCIP) ||
+      IPT_FILTER_FAIL((pkt->dst & ip->dmsk.s_addr) != ip->dst.s_addr,
+                      ip->invflags, IPT_INV_DSTIP))
+    {
+      return false;
+    }
+
+  if (ip->proto != 0 &&
+      IPT_FILTER_FAIL(pkt->proto != ip->proto, ip->invflags, IPT_INV_PROTO))
+    {
+      return false;
+    }
+
+  if ((ip->flags & IPT_F_FRAG) != 0 &&
+      IPT_FILTER_FAIL(!pkt->frag, ip->invflags, IPT_INV_FRAG))
+    {
+      return false;
+    }
+
+  if ((rule->flags & IPT_RULE_IFACE) != 0 &&
+      (IPT_FILTER_FAIL(!ipt_filter_ifmatch(pkt->indev, ip->iniface,
+                                           ip->iniface_mask),
+                       ip->invflags, IPT_INV_VIA_IN) ||
+       IPT_FILTER_FAIL(!ipt_filter_ifmatch(pkt->outdev, ip->outiface,
+                                           ip->outiface_mask),
+                       ip->invflags, IPT_INV_VIA_OUT)))
+    {
+      return false;
+    }
+
+  if ((rule->flags & (IPT_RULE_TCP | IPT_RULE_UDP)) != 0)
+    {
+      /* Fragments other than the first one have no ports. */
+
+      if (!pkt->l4 ||
+          IPT_FILTER_FAIL(pkt->sport < rule->spts[0] ||
+                          pkt->sport > rule->spts[1],
+                          rule->l4inv, XT_TCP_INV_SRCPT) ||
+          IPT_FILTER_FAIL(pkt->dport < rule->dpts[0] ||
+                          pkt->dport > rule->dpts[1],
+                          rule->l4inv, XT_TCP_INV_DSTPT))
+        {
+          return false;
+        }
+
+      if ((rule->flags & IPT_RULE_TCP) != 0 &&
+          IPT_FILTER_FAIL((pkt->tcpflags & rule->flg_mask) != rule->flg_cmp,
+                          rule->l4inv, XT_TCP_INV_FLAGS))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_lookup
+ *
+ * Description:
+ *   Find the first terminal rule of a chain that matches a packet.
+ *
+ * Returned Value:
+ *   The matching rule, or NULL if the policy of the chain applies.
+ *
+ ****************************************************************************/
+
+static FAR struct ipt_filter_rule_s *
+ipt_filter_lookup(FAR const struct ipt_filter_chain_s *chain,
+                  FAR const struct ipt_filter_pkt_s *pkt)
+{
+  FAR const struct ipt_filter_class_s *cls;
+  FAR struct ipt_filter_rule_s *best = NULL;
+  FAR struct ipt_filter_rule_s *rule;
+  unsigned int i;
+  uint32_t hash;
+
+  for (i = 0; i < chain->nclasses; i++)
+    {
+      cls = &chain->classes[i];
+
+      /* The rest of the classes start after the best match. */
+
+      if (best != NULL && cls->first > best->index)
+        {
+          break;
+        }
+
+      if ((cls->fields & IPT_CLASS_DPORT) != 0 && !pkt->l4)
+        {
+          continue;
+        }
+
+      hash = ipt_filter_hash(pkt->src & cls->smsk, pkt->dst & cls->dmsk,
+                             (cls->fields & IPT_CLASS_PROTO) != 0 ?
+                             pkt->proto : 0,
+                             (cls->fields & IPT_CLASS_DPORT) != 0 ?
+                             pkt->dport : 0);
+
+      for (rule = cls->buckets[hash & cls->mask]; rule != NULL;
+           rule = rule->flink)
+        {
+          if (best != NULL && rule->index > best->index)
+            {
+              break;
+            }
+
+          if (ipt_filter_match(rule, pkt))
+            {
+              best = rule;
+              break;
+            }
+        }
+    }
+
+  return best;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_count
+ *
+ * Description:
+ *   Count a packet for a rule.
+ *
+ ****************************************************************************/
+
+static void ipt_filter_count(FAR struct ipt_filter_rule_s *rule,
+                             FAR const struct ipt_filter_pkt_s *pkt)
+{
+  rule->counters.pcnt++;
+  rule->counters.bcnt += pkt->len;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_hook
+ *
+ * Description:
+ *   Run a packet through a chain of the filter table.
+ *
+ ****************************************************************************/
+
+static int ipt_filter_hook(unsigned int hook,
+                           FAR struct net_driver_s *indev,
+                           FAR struct net_driver_s *outdev,
+                           FAR struct ipv4_hdr_s *ipv4)
+{
+  FAR struct ipt_filter_chain_s *chain;
+  FAR struct ipt_filter_rule_s *rule;
+  struct ipt_filter_pkt_s pkt;
+  unsigned int iphdrlen;
+  unsigned int i;
+
+  if (g_filter == NULL)
+    {
+      return OK;
+    }
+
+  chain = &g_filter->chains[hook];
+  if (chain->policy == NULL)
+    {
+      return OK;
+    }
+
+  /* Get the fields of the packet */
+
+  iphdrlen     = (ipv4->vhl & IPv4_HLMASK) << 2;
+  pkt.src      = net_ip4addr_conv32(ipv4->srcipaddr);
+  pkt.dst      = net_ip4addr_conv32(ipv4->destipaddr);
+  pkt.len      = (ipv4->len[0] << 8) + ipv4->len[1];
+  pkt.proto    = ipv4->proto;
+  pkt.frag     = (ipv4->ipoffset[0] & 0x1f) != 0 || ipv4->ipoffset[1] != 0;
+  pkt.l4       = false;
+  pkt.sport    = 0;
+  pkt.dport    = 0;
+  pkt.tcpflags = 0;
+  pkt.indev    = indev != NULL ? indev->d_ifname : "";
+  pkt.outdev   = outdev != NULL ? outdev->d_ifname : "";
+
+  if (!pkt.frag && pkt.proto == IP_PROTO_TCP &&
+      pkt.len >= iphdrlen + TCP_HDRLEN)
+    {
+      FAR struct tcp_hdr_s *tcp =
+        (FAR struct tcp_hdr_s *)((FAR uint8_t *)ipv4 + iphdrlen);
+
+      pkt.sport    = NTOHS(tcp->srcport);
+      pkt.dport    = NTOHS(tcp->destport);
+      pkt.tcpflags = tcp->flags;
+      pkt.l4       = true;
+    }
+  else if (!pkt.frag && pkt.proto == IP_PROTO_UDP &&
+           pkt.len >= iphdrlen + UDP_HDRLEN)
+    {
+      FAR struct udp_hdr_s *udp =
+        (FAR struct udp_hdr_s *)((FAR uint8_t *)ipv4 + iphdrlen);
+
+      pkt.sport    = NTOHS(udp->srcport);
+      pkt.dport    = NTOHS(udp->destport);
+      pkt.l4       = true;
+    }
+
+  rule = ipt_filter_lookup(chain, &pkt);
+
+  /* Count the rules without verdict in front of the match. */
+
+  for (i = 0; i < chain->ncounting; i++)
+    {
+      if (rule != NULL && chain->counting[i]->index > rule->index)
+        {
+          break;
+        }
+
+      if (ipt_filter_match(chain->counting[i], &pkt))
+        {
+          ipt_filter_count(chain->counting[i], &pkt);
+        }
+    }
+
+  if (rule != NULL)
+    {
+      ipt_filter_count(rule, &pkt);
+    }
+
+  if (rule == NULL || rule->verdict == IPT_FILTER_RETURN)
+    {
+      rule = chain->policy;
+      ipt_filter_count(rule, &pkt);
+    }
+
+  if (rule->verdict == NF_DROP)
+    {
+      ninfo("Dropped by filter rule %u of hook %u\n", rule->index, hook);
+      return -EPERM;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_free
+ *
+ * Description:
+ *   Free a compiled filter table.
+ *
+ ****************************************************************************/
+
+static void ipt_filter_free(FAR struct ipt_filter_s *filter)
+{
+  FAR struct ipt_filter_chain_s *chain;
+  unsigned int hook;
+  unsigned int i;
+
+  if (filter == NULL)
+    {
+      return;
+    }
+
+  for (hook = 0; hook < NF_INET_NUMHOOKS; hook++)
+    {
+      chain = &filter->chains[hook];
+      if (chain->classes != NULL)
+        {
+          for (i = 0; i < chain->nclasses; i++)
+            {
+              kmm_free(chain->classes[i].buckets);
+            }
+
+          kmm_free(chain->classes);
+        }
+
+      kmm_free(chain->counting);
+    }
+
+  kmm_free(filter->rules);
+  kmm_free(filter);
+}
+
+/****************************************************************************
+ * Name: ipt_filter_l4match
+ *
+ * Description:
+ *   Compile a "tcp" or "udp" match of an entry into a rule.
+ *
+ ****************************************************************************/
+
+static int ipt_filter_l4match(FAR struct ipt_filter_rule_s *rule,
+                              FAR const struct xt_entry_match *match)
+{
+  FAR const char *name = match->u.user.name;
+  size_t size = match->u.match_size - offsetof(struct xt_entry_match, data);
+  FAR const struct xt_tcp *tcp;
+  FAR const struct xt_udp *udp;
+
+  if ((rule->flags & (IPT_RULE_TCP | IPT_RULE_UDP)) != 0)
+    {
+      return -EOPNOTSUPP;
+    }
+
+  if (strncmp(name, XT_TCP_MATCH, sizeof(match->u.user.name)) == 0)
+    {
+      tcp = (FAR const struct xt_tcp *)match->data;
+      if (rule->ip.proto != IP_PROTO_TCP ||
+          (rule->ip.invflags & IPT_INV_PROTO) != 0 ||
+          size < sizeof(*tcp) || (tcp->invflags & ~XT_TCP_INV_MASK) != 0)
+        {
+          return -EINVAL;
+        }
+
+      if (tcp->option != 0)
+        {
+          return -EOPNOTSUPP;
+        }
+
+      memcpy(rule->spts, tcp->spts, sizeof(rule->spts));
+      memcpy(rule->dpts, tcp->dpts, sizeof(rule->dpts));
+      rule->flg_mask = tcp->flg_mask;
+      rule->flg_cmp  = tcp->flg_cmp;
+      rule->l4inv    = tcp->invflags;
+      rule->flags   |= IPT_RULE_TCP;
+    }
+  else if (strncmp(name, XT_UDP_MATCH, sizeof(match->u.user.name)) == 0)
+    {
+      udp = (FAR const struct xt_udp *)match->data;
+      if (rule->ip.proto != IP_PROTO_UDP ||
+          (rule->ip.invflags & IPT_INV_PROTO) != 0 ||
+          size < sizeof(*udp) || (udp->invflags & ~XT_UDP_INV_MASK) != 0)
+        {
+          return -EINVAL;
+        }
+
+      memcpy(rule->spts, udp->spts, sizeof(rule->spts));
+      memcpy(rule->dpts, udp->dpts, sizeof(rule->dpts));
+      rule->l4inv    = udp->invflags;
+      rule->flags   |= IPT_RULE_UDP;
+    }
+  else
+    {
+      nwarn("WARNING: Unsupported match: %.*s\n",
+            (int)sizeof(match->u.user.name), name);
+      return -EOPNOTSUPP;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_rule
+ *
+ * Description:
+ *   Compile an entry of a chain into a rule.
+ *
+ * Input Parameters:
+ *   rule   - The rule to fill in.
+ *   entry  - The entry, already checked to be inside the table.
+ *   offset - The offset of the entry in the table.
+ *
+ ****************************************************************************/
+
+static int ipt_filter_rule(FAR struct ipt_filter_rule_s *rule,
+                           FAR const struct ipt_entry *entry,
+                           unsigned int offset)
+{
+  FAR const struct xt_entry_match *match;
+  FAR const struct xt_entry_target *target;
+  FAR const char *name;
+  unsigned int off;
+  unsigned int i;
+  int verdict;
+  int ret;
+
+  rule->ip     = entry->ip;
+  rule->offset = offset;
+
+  if ((rule->ip.flags & ~IPT_F_MASK) != 0 ||
+      (rule->ip.invflags & ~IPT_INV_MASK) != 0)
+    {
+      return -EINVAL;
+    }
+
+  rule->ip.src.s_addr &= rule->ip.smsk.s_addr;
+  rule->ip.dst.s_addr &= rule->ip.dmsk.s_addr;
+
+  if ((rule->ip.invflags & (IPT_INV_VIA_IN | IPT_INV_VIA_OUT)) != 0)
+    {
+      rule->flags |= IPT_RULE_IFACE;
+    }
+
+  for (i = 0; i < IFNAMSIZ; i++)
+    {
+      if (rule->ip.iniface_mask[i] != 0 || rule->ip.outiface_mask[i] != 0)
+        {
+          rule->flags |= IPT_RULE_IFACE;
+        }
+    }
+
+  /* Matches fill the space between the entry and the target. */
+
+  off = offsetof(struct ipt_entry, elems);
+  while (off + offsetof(struct xt_entry_match, data) <= entry->target_offset)
+    {
+      match = (FAR const struct xt_entry_match *)
+              ((FAR const uint8_t *)entry + off);
+      if (match->u.match_size < offsetof(struct xt_entry_match, data) ||
+          match->u.match_size > entry->target_offset - off)
+        {
+          return -EINVAL;
+        }
+
+      ret = ipt_filter_l4match(rule, match);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      off += match->u.match_size;
+    }
+
+  target = IPT_TARGET(entry);
+  name   = target->u.user.name;
+  if (target->u.target_size > entry->next_offset - entry->target_offset)
+    {
+      return -EINVAL;
+    }
+
+  if (strncmp(name, XT_STANDARD_TARGET, sizeof(target->u.user.name)) != 0)
+    {
+      nwarn("WARNING: Unsupported target: %.*s\n",
+            (int)sizeof(target->u.user.name), name);
+      return strncmp(name, XT_ERROR_TARGET,
+                     sizeof(target->u.user.name)) == 0 ?
+             -EINVAL : -EOPNOTSUPP;
+    }
+
+  if (target->u.target_size < sizeof(struct xt_standard_target))
+    {
+      return -EINVAL;
+    }
+
+  verdict = ((FAR const struct xt_standard_target *)target)->verdict;
+  if (verdict == -NF_DROP - 1)
+    {
+      rule->verdict = NF_DROP;
+    }
+  else if (verdict == -NF_ACCEPT - 1)
+    {
+      rule->verdict = NF_ACCEPT;
+    }
+  else if (verdict == XT_RETURN)
+    {
+      rule->verdict = IPT_FILTER_RETURN;
+    }
+  else if (verdict == (int)(offset + entry->next_offset))
+    {
+      /* A jump to the next entry, the rule has no target. */
+
+      rule->verdict = IPT_FILTER_CONTINUE;
+    }
+  else
+    {
+      nwarn("WARNING: Jumps are not supported: %d\n", verdict);
+      return -EOPNOTSUPP;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_class
+ *
+ * Description:
+ *   Find the class of a rule in a chain, or add it if create is true.
+ *
+ ****************************************************************************/
+
+static FAR struct ipt_filter_class_s *
+ipt_filter_class(FAR struct ipt_filter_chain_s *chain,
+                 FAR const struct ipt_filter_rule_s *rule, bool create)
+{
+  FAR struct ipt_filter_class_s *cls;
+  in_addr_t smsk = rule->ip.smsk.s_addr;
+  in_addr_t dmsk = rule->ip.dmsk.s_addr;
+  uint8_t fields = 0;
+  unsigned int i;
+
+  /* Inverted fields cannot be hashed and are left to ipt_filter_match. */
+
+  if ((rule->ip.invflags & IPT_INV_SRCIP) != 0)
+    {
+      smsk = 0;
+    }
+
+  if ((rule->ip.invflags & IPT_INV_DSTIP) != 0)
+    {
+      dmsk = 0;
+    }
+
+  if (rule->ip.proto != 0 && (rule->ip.invflags & IPT_INV_PROTO) == 0)
+    {
+      fields |= IPT_CLASS_PROTO;
+
+      if ((rule->flags & (IPT_RULE_TCP | IPT_RULE_UDP)) != 0 &&
+          rule->dpts[0] == rule->dpts[1] &&
+          (rule->l4inv & XT_TCP_INV_DSTPT) == 0)
+        {
+          fields |= IPT_CLASS_DPORT;
+        }
+    }
+
+  for (i = 0; i < chain->nclasses; i++)
+    {
+      cls = &chain->classes[i];
+      if (cls->smsk == smsk && cls->dmsk == dmsk &&
+          cls->fields == fields)
+        {
+          return cls;
+        }
+    }
+
+  if (!create)
+    {
+      return NULL;
+    }
+
+  cls         = &chain->classes[chain->nclasses++];
+  cls->smsk   = smsk;
+  cls->dmsk   = dmsk;
+  cls->fields = fields;
+  cls->first  = rule->index;
+  return cls;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_chain
+ *
+ * Description:
+ *   Compile the entries of a hook into a chain.
+ *
+ * Input Parameters:
+ *   chain  - The chain to fill in.
+ *   rules  - The rules of the chain, the last one is the policy.
+ *   nrules - The number of entries of the hook.
+ *   repl   - The table with the entries.
+ *   hook   - The hook to compile.
+ *
+ ****************************************************************************/
+
+static int ipt_filter_chain(FAR struct ipt_filter_chain_s *chain,
+                            FAR struct ipt_filter_rule_s *rules,
+                            unsigned int nrules,
+                            FAR const struct ipt_replace *repl,
+                            unsigned int hook)
+{
+  FAR struct ipt_filter_class_s *cls;
+  FAR struct ipt_filter_rule_s *rule;
+  FAR struct ipt_entry *entry;
+  unsigned int offset = repl->hook_entry[hook];
+  unsigned int nbuckets;
+  unsigned int i;
+  uint32_t hash;
+  int ret;
+
+  for (i = 0; i < nrules; i++)
+    {
+      entry = (FAR struct ipt_entry *)
+              ((FAR uint8_t *)repl->entries + offset);
+      rule  = &rules[i];
+
+      rule->index = i;
+      ret = ipt_filter_rule(rule, entry, offset);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      offset += entry->next_offset;
+    }
+
+  /* The policy must be an unconditional ACCEPT or DROP. */
+
+  chain->policy = &rules[nrules - 1];
+  if (chain->policy->flags != 0 || chain->policy->ip.proto != 0 ||
+      chain->policy->ip.flags != 0 || chain->policy->ip.invflags != 0 ||
+      chain->policy->ip.smsk.s_addr != 0 ||
+      chain->policy->ip.dmsk.s_addr != 0 ||
+      (chain->policy->verdict != NF_DROP &&
+       chain->policy->verdict != NF_ACCEPT))
+    {
+      return -EINVAL;
+    }
+
+  if (--nrules == 0)
+    {
+      return OK;
+    }
+
+  chain->classes  = kmm_zalloc(nrules * sizeof(*chain->classes));
+  chain->counting = kmm_malloc(nrules * sizeof(*chain->counting));
+  if (chain->classes == NULL || chain->counting == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* Sort the rules into classes, the classes are created in the order of
+   * their first rule.
+   */
+
+  for (i = 0; i < nrules; i++)
+    {
+      rule = &rules[i];
+      if (rule->verdict == IPT_FILTER_CONTINUE)
+        {
+          chain->counting[chain->ncounting++] = rule;
+        }
+      else
+        {
+          ipt_filter_class(chain, rule, true)->nrules++;
+        }
+    }
+
+  for (i = 0; i < chain->nclasses; i++)
+    {
+      cls = &chain->classes[i];
+      for (nbuckets = 1; nbuckets < cls->nrules; nbuckets <<= 1);
+
+      cls->mask    = nbuckets - 1;
+      cls->buckets = kmm_zalloc(nbuckets * sizeof(*cls->buckets));
+      if (cls->buckets == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
+
+  /* Add the rules backwards, so that the buckets are in chain order. */
+
+  for (i = nrules; i-- > 0; )
+    {
+      rule = &rules[i];
+      if (rule->verdict == IPT_FILTER_CONTINUE)
+        {
+          continue;
+        }
+
+      cls = ipt_filter_class(chain, rule, false);
+      hash  = ipt_filter_hash(rule->ip.src.s_addr & cls->smsk,
+                              rule->ip.dst.s_addr & cls->dmsk,
+                              (cls->fields & IPT_CLASS_PROTO) != 0 ?
+                              rule->ip.proto : 0,
+                              (cls->fields & IPT_CLASS_DPORT) != 0 ?
+                              rule->dpts[0] : 0);
+
+      rule->flink = cls->buckets[hash & cls->mask];
+      cls->buckets[hash & cls->mask] = rule;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_hook_size
+ *
+ * Description:
+ *   Get the number of entries of a hook, including the policy.
+ *
+ * Returned Value:
+ *   The number of entries, or -EINVAL if the hook_entry or underflow
+ *   offset is not at the start of an entry.
+ *
+ ****************************************************************************/
+
+static int ipt_filter_hook_size(FAR const struct ipt_replace *repl,
+                                unsigned int hook)
+{
+  FAR struct ipt_entry *entry;
+  unsigned int offset = 0;
+  bool found = false;
+  int nrules = 0;
+
+  ipt_entry_for_every(entry, repl->entries, repl->size)
+    {
+      if (offset == repl->hook_entry[hook])
+        {
+          found = true;
+        }
+
+      if (found)
+        {
+          nrules++;
+          if (offset == repl->underflow[hook])
+            {
+              return nrules;
+            }
+        }
+
+      offset += entry->next_offset;
+    }
+
+  return -EINVAL;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_compile
+ *
+ * Description:
+ *   Compile the filter table.
+ *
+ ****************************************************************************/
+
+static int ipt_filter_compile(FAR const struct ipt_replace *repl,
+                              FAR struct ipt_filter_s **filter)
+{
+  FAR struct ipt_filter_s *new_filter;
+  int nrules[NF_INET_NUMHOOKS];
+  unsigned int total = 0;
+  unsigned int hook;
+  int ret;
+
+  for (hook = 0; hook < NF_INET_NUMHOOKS; hook++)
+    {
+      nrules[hook] = 0;
+      if ((IPT_FILTER_HOOKS & (1 << hook)) != 0)
+        {
+          nrules[hook] = ipt_filter_hook_size(repl, hook);
+          if (nrules[hook] < 0)
+            {
+              return nrules[hook];
+            }
+
+          total += nrules[hook];
+        }
+    }
+
+  new_filter = kmm_zalloc(sizeof(*new_filter));
+  if (new_filter == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  new_filter->nrules = total;
+  new_filter->rules  = kmm_zalloc(total * sizeof(*new_filter->rules));
+  if (new_filter->rules == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  for (total = 0, hook = 0; hook < NF_INET_NUMHOOKS; hook++)
+    {
+      if (nrules[hook] > 0)
+        {
+          ret = ipt_filter_chain(&new_filter->chains[hook],
+                                 &new_filter->rules[total], nrules[hook],
+                                 repl, hook);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+
+          total += nrules[hook];
+        }
+    }
+
+  *filter = new_filter;
+  return OK;
+
+errout:
+  ipt_filter_free(new_filter);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipt_filter_init
+ *
+ * Description:
+ *   Init filter table data.
+ *
+ ****************************************************************************/
+
+FAR struct ipt_replace *ipt_filter_init(void)
+{
+  return ipt_alloc_table(TABLE_NAME_FILTER, IPT_FILTER_HOOKS);
+}
+
+/****************************************************************************
+ * Name: ipt_filter_apply
+ *
+ * Description:
+ *   Compile the filter rules and replace the active rules with them.  The
+ *   active rules are kept if the new rules cannot be compiled.
+ *
+ * Input Parameters:
+ *   repl   - The config got from user space to control filter table.
+ *
+ * Returned Value:
+ *   Zero (OK) on success, a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int ipt_filter_apply(FAR const struct ipt_replace *repl)
+{
+  FAR struct ipt_filter_s *filter;
+  int ret;
+
+  ret = ipt_filter_compile(repl, &filter);
+  if (ret < 0)
+    {
+      nwarn("WARNING: Failed to compile filter rules: %d\n", ret);
+      return ret;
+    }
+
+  ipt_filter_free(g_filter);
+  g_filter = filter;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ipt_filter_counters
+ *
+ * Description:
+ *   Fill the packet and byte counters of the active filter rules into a
+ *   copy of the filter table entries.
+ *
+ * Input Parameters:
+ *   entries - The copy of the entries of the filter table.
+ *   size    - The size of the entries.
+ *
+ ****************************************************************************/
+
+void ipt_filter_counters(FAR struct ipt_entry *entries, unsigned int size)
+{
+  FAR struct ipt_filter_rule_s *rule;
+  FAR struct ipt_entry *entry;
+  unsigned int i;
+
+  if (g_filter == NULL)
+    {
+      return;
+    }
+
+  for (i = 0; i < g_filter->nrules; i++)
+    {
+      rule = &g_filter->rules[i];
+      if (rule->offset + sizeof(*entry) <= size)
+        {
+          entry = (FAR struct ipt_entry *)
+                  ((FAR uint8_t *)entries + rule->offset);
+          entry->counters = rule->counters;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: ipv4_filter_input
+ *
+ * Description:
+ *   Run a received IPv4 packet for this host through the INPUT chain.
+ *
+ ****************************************************************************/
+
+int ipv4_filter_input(FAR struct net_driver_s *dev,
+                      FAR struct ipv4_hdr_s *ipv4)
+{
+  return ipt_filter_hook(NF_INET_LOCAL_IN, dev, NULL, ipv4);
+}
+
+/****************************************************************************
+ * Name: ipv4_filter_output
+ *
+ * Description:
+ *   Run an IPv4 packet sent by this host through the OUTPUT chain.
+ *
+ ****************************************************************************/
+
+int ipv4_filter_output(FAR struct net_driver_s *dev,
+                       FAR struct ipv4_hdr_s *ipv4)
+{
+  return ipt_filter_hook(NF_INET_LOCAL_OUT, NULL, dev, ipv4);
+}
+
+/****************************************************************************
+ * Name: ipv4_filter_forward
+ *
+ * Description:
+ *   Run an IPv4 packet to be forwarded through the FORWARD chain.
+ *
+ ****************************************************************************/
+
+int ipv4_filter_forward(FAR struct net_driver_s *dev,
+                        FAR struct net_driver_s *fwddev,
+                        FAR struct ipv4_hdr_s *ipv4)
+{
+  return ipt_filter_hook(NF_INET_FORWARD, dev, fwddev, ipv4);
+}
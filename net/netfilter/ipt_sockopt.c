@@ -44,7 +44,8 @@
  ****************************************************************************/
 
 /* Structure to store all info we need, including table data and
- * init/apply functions.
+ * init/apply functions, and optionally a function filling the rule
+ * counters into a copy of the entries.
  */
 
 struct ipt_table_s
@@ -52,6 +53,7 @@ struct ipt_table_s
   FAR struct ipt_replace *repl;
   FAR struct ipt_replace *(*init_func)(void);
   FAR int (*apply_func)(FAR const struct ipt_replace *);
+  void (*counters_func)(FAR struct ipt_entry *, unsigned int);
 };
 
 /* Following structs represent the layout of an entry with standard/error
@@ -79,7 +81,10 @@ struct ipt_error_entry_s
 static struct ipt_table_s g_tables[] =
 {
 #ifdef CONFIG_NET_NAT
-  {NULL, ipt_nat_init, ipt_nat_apply},
+  {NULL, ipt_nat_init, ipt_nat_apply, NULL},
+#endif
+#ifdef CONFIG_NET_IPFILTER
+  {NULL, ipt_filter_init, ipt_filter_apply, ipt_filter_counters},
 #endif
 };
 
@@ -194,25 +199,30 @@ static int get_info(FAR struct ipt_getinfo *get, FAR socklen_t *len)
 
 static int get_entries(FAR struct ipt_get_entries *get, FAR socklen_t *len)
 {
-  FAR struct ipt_replace *repl;
+  FAR struct ipt_table_s *table;
 
   if (*len < sizeof(*get) || *len != sizeof(*get) + get->size)
     {
       return -EINVAL;
     }
 
-  repl = ipt_table_repl(get->name);
-  if (repl == NULL)
+  table = ipt_table(get->name);
+  if (table == NULL)
     {
       return -ENOENT;
     }
 
-  if (get->size != repl->size)
+  if (get->size != table->repl->size)
     {
       return -EAGAIN;
     }
 
-  memcpy(get->entrytable, repl->entries, get->size);
+  memcpy(get->entrytable, table->repl->entries, get->size);
+
+  if (table->counters_func != NULL)
+    {
+      table->counters_func(get->entrytable, get->size);
+    }
 
   return OK;
 }
@@ -235,9 +245,24 @@ static int check_replace(FAR const struct ipt_replace *repl)
 {
   FAR struct ipt_entry *entry;
   unsigned int entry_count = 0;
+  size_t remain;
 
   ipt_entry_for_every(entry, repl->entries, repl->size)
     {
+      /* The entry, its target header and the next entry must be inside
+       * the table, or the walk would never end.
+       */
+
+      remain = (uintptr_t)repl->entries + repl->size - (uintptr_t)entry;
+      if (remain < sizeof(*entry) ||
+          entry->target_offset < offsetof(struct ipt_entry, elems) ||
+          entry->next_offset > remain ||
+          entry->next_offset < entry->target_offset +
+                               offsetof(struct xt_entry_target, data))
+        {
+          return -EINVAL;
+        }
+
       entry_count++;
     }
 
@@ -27,6 +27,7 @@
 
 #include <nuttx/config.h>
 
+#include <nuttx/net/ip.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netfilter/ip_tables.h>
 
@@ -105,5 +106,81 @@ FAR struct ipt_replace *ipt_nat_init(void);
 int ipt_nat_apply(FAR const struct ipt_replace *repl);
 #endif
 
+/****************************************************************************
+ * Name: ipt_filter_init
+ *
+ * Description:
+ *   Init filter table data.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER
+FAR struct ipt_replace *ipt_filter_init(void);
+#endif
+
+/****************************************************************************
+ * Name: ipt_filter_apply
+ *
+ * Description:
+ *   Compile the filter rules and replace the active rules with them.  The
+ *   active rules are kept if the new rules cannot be compiled.
+ *
+ * Input Parameters:
+ *   repl   - The config got from user space to control filter table.
+ *
+ * Returned Value:
+ *   Zero (OK) on success, a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER
+int ipt_filter_apply(FAR const struct ipt_replace *repl);
+#endif
+
+/****************************************************************************
+ * Name: ipt_filter_counters
+ *
+ * Description:
+ *   Fill the packet and byte counters of the active filter rules into a
+ *   copy of the filter table entries.
+ *
+ * Input Parameters:
+ *   entries - The copy of the entries of the filter table.
+ *   size    - The size of the entries.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER
+void ipt_filter_counters(FAR struct ipt_entry *entries, unsigned int size);
+#endif
+
+/****************************************************************************
+ * Name: ipv4_filter_input, ipv4_filter_output and ipv4_filter_forward
+ *
+ * Description:
+ *   Run an IPv4 packet through the INPUT, OUTPUT or FORWARD chain of the
+ *   filter table.
+ *
+ * Input Parameters:
+ *   dev    - The device on which the packet is received or sent.
+ *   fwddev - The device on which the packet will be forwarded.
+ *   ipv4   - Points to the IPv4 header with dev->d_buf.
+ *
+ * Returned Value:
+ *   Zero is returned if the packet is accepted;
+ *   -EPERM is returned if the packet must be dropped.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER
+int ipv4_filter_input(FAR struct net_driver_s *dev,
+                      FAR struct ipv4_hdr_s *ipv4);
+int ipv4_filter_output(FAR struct net_driver_s *dev,
+                       FAR struct ipv4_hdr_s *ipv4);
+int ipv4_filter_forward(FAR struct net_driver_s *dev,
+                        FAR struct net_driver_s *fwddev,
+                        FAR struct ipv4_hdr_s *ipv4);
+#endif
+
 #endif /* CONFIG_NET_IPTABLES */
 #endif /* __NET_NETFILTER_IPTABLES_H */
@@ -166,6 +166,8 @@ FAR struct netlink_conn_s *netlink_alloc(void)
            dq_remfirst(&g_free_netlink_connections);
   if (conn != NULL)
     {
+      nxrmutex_init(&conn->sconn.s_lock);
+
       /* Enqueue the connection into the active list */
 
       dq_addlast(&conn->sconn.node, &g_active_netlink_connections);
@@ -198,6 +200,8 @@ void netlink_free(FAR struct netlink_conn_s *conn)
 
   dq_rem(&conn->sconn.node, &g_active_netlink_connections);
 
+  nxrmutex_destroy(&conn->sconn.s_lock);
+
   /* Free any unclaimed responses */
 
   while ((resp = sq_remfirst(&conn->resplist)) != NULL)
@@ -139,6 +139,8 @@ FAR struct pkt_conn_s *pkt_alloc(void)
   conn = (FAR struct pkt_conn_s *)dq_remfirst(&g_free_pkt_connections);
   if (conn)
     {
+      nxrmutex_init(&conn->sconn.s_lock);
+
       /* Enqueue the connection into the active list */
 
       dq_addlast(&conn->sconn.node, &g_active_pkt_connections);
@@ -169,6 +171,8 @@ void pkt_free(FAR struct pkt_conn_s *conn)
 
   dq_rem(&conn->sconn.node, &g_active_pkt_connections);
 
+  nxrmutex_destroy(&conn->sconn.s_lock);
+
   /* If this is a preallocated or a batch allocated connection store it in
    * the free connections list. Else free it.
    */
@@ -90,6 +90,9 @@ static ssize_t netprocfs_udpstats(FAR struct netprocfs_file_s *priv,
       laddr = net_ip_binding_laddr(&conn->u, domain);
       raddr = net_ip_binding_raddr(&conn->u, domain);
 
+      /* The connection buffers are protected by the connection lock */
+
+      conn_lock(&conn->sconn);
       len += snprintf(buffer + len, buflen - len,
                       "    %2" PRIu8
                       ": %3" PRIx8
@@ -103,6 +106,7 @@ static ssize_t netprocfs_udpstats(FAR struct netprocfs_file_s *priv,
                       udp_wrbuffer_inqueue_size(conn),
 #endif
                       (conn->readahead) ? conn->readahead->io_pktlen : 0);
+      conn_unlock(&conn->sconn);
 
       len += snprintf(buffer + len, buflen - len,
                       " %*s:%-6" PRIu16 " %*s:%-6" PRIu16 "\n",
@@ -31,9 +31,11 @@
 #include <debug.h>
 
 #include <nuttx/fs/fs.h>
+#include <nuttx/net/net.h>
 #include <nuttx/net/ip.h>
 
 #include "route/fileroute.h"
+#include "route/trieroute.h"
 #include "route/route.h"
 
 #if defined(CONFIG_ROUTE_IPv4_FILEROUTE) || defined(CONFIG_ROUTE_IPv6_FILEROUTE)
@@ -79,9 +81,19 @@ int net_addroute_ipv4(in_addr_t target, in_addr_t netmask, in_addr_t router)
       return ret;
     }
 
-  /* Then append the new entry to the end of the routing table */
+  /* Then append the new entry to the end of the routing table, and to the
+   * route trie.  The network is locked so that the trie cannot be rebuilt
+   * in between.
+   */
 
+  net_lock();
   nwritten = net_writeroute_ipv4(&fshandle, &route);
+  if (nwritten >= 0)
+    {
+      net_addtrie_ipv4(&route);
+    }
+
+  net_unlock();
 
   net_closeroute_ipv4(&fshandle);
   return nwritten >= 0 ? 0 : (int)nwritten;
@@ -113,9 +125,19 @@ int net_addroute_ipv6(net_ipv6addr_t target, net_ipv6addr_t netmask,
       return ret;
     }
 
-  /* Then append the new entry to the end of the routing table */
+  /* Then append the new entry to the end of the routing table, and to the
+   * route trie.  The network is locked so that the trie cannot be rebuilt
+   * in between.
+   */
 
+  net_lock();
   nwritten = net_writeroute_ipv6(&fshandle, &route);
+  if (nwritten >= 0)
+    {
+      net_addtrie_ipv6(&route);
+    }
+
+  net_unlock();
 
   net_closeroute_ipv6(&fshandle);
   return nwritten >= 0 ? 0 : (int)nwritten;
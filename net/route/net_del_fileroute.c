@@ -34,10 +34,12 @@
 #include <arpa/inet.h>
 
 #include <nuttx/fs/fs.h>
+#include <nuttx/net/net.h>
 #include <nuttx/net/ip.h>
 
 #include "route/fileroute.h"
 #include "route/cacheroute.h"
+#include "route/trieroute.h"
 #include "route/route.h"
 
 #if defined(CONFIG_ROUTE_IPv4_FILEROUTE) || defined(CONFIG_ROUTE_IPv6_FILEROUTE)
@@ -187,12 +189,15 @@ int net_delroute_ipv4(in_addr_t target, in_addr_t netmask)
   int ret;
 
   /* We must lock out other accesses to the routing table while we remove
-   * entry
+   * entry.  The network is locked first, as in the route lookups, so that
+   * the route trie cannot be rebuilt from a partially modified table.
    */
 
+  net_lock();
   ret = net_lockroute_ipv4();
   if (ret < 0)
     {
+      net_unlock();
       nerr("ERROR: net_lockroute_ipv4 faled: %d\n", ret);
       return ret;
     }
@@ -312,12 +317,19 @@ int net_delroute_ipv4(in_addr_t target, in_addr_t netmask)
 
   filesize = (nentries - 1) * sizeof(struct net_route_ipv4_s);
   ret = file_truncate(&fshandle, filesize);
+  if (ret >= 0)
+    {
+      /* Remove the same entry from the route trie */
+
+      net_deltrie_ipv4(target, netmask);
+    }
 
 errout_with_fshandle:
   net_closeroute_ipv4(&fshandle);
 
 errout_with_lock:
   net_unlockroute_ipv4();
+  net_unlock();
   return ret;
 }
 #endif
@@ -337,12 +349,15 @@ int net_delroute_ipv6(net_ipv6addr_t target, net_ipv6addr_t netmask)
   int ret;
 
   /* We must lock out other accesses to the routing table while we remove
-   * entry
+   * entry.  The network is locked first, as in the route lookups, so that
+   * the route trie cannot be rebuilt from a partially modified table.
    */
 
+  net_lock();
   ret = net_lockroute_ipv6();
   if (ret < 0)
     {
+      net_unlock();
       nerr("ERROR: net_lockroute_ipv6 failed: %d\n", ret);
       return ret;
     }
@@ -463,12 +478,19 @@ int net_delroute_ipv6(net_ipv6addr_t target, net_ipv6addr_t netmask)
 
   filesize = (nentries - 1) * sizeof(struct net_route_ipv6_s);
   ret = file_truncate(&fshandle, filesize);
+  if (ret >= 0)
+    {
+      /* Remove the same entry from the route trie */
+
+      net_deltrie_ipv6(target, netmask);
+    }
 
 errout_with_fshandle:
   net_closeroute_ipv6(&fshandle);
 
 errout_with_lock:
   net_unlockroute_ipv6();
+  net_unlock();
   return ret;
 }
 #endif
@@ -33,6 +33,7 @@
 #include <nuttx/net/ip.h>
 
 #include "route/ramroute.h"
+#include "route/trieroute.h"
 #include "route/route.h"
 
 #if defined(CONFIG_ROUTE_IPv4_RAMROUTE) || defined(CONFIG_ROUTE_IPv6_RAMROUTE)
@@ -109,6 +110,10 @@ static int net_match_ipv4(FAR struct net_route_ipv4_s *route, FAR void *arg)
           ramroute_ipv4_remfirst(&g_ipv4_routes);
         }
 
+      /* Remove it from the route trie, too */
+
+      net_deltrie_ipv4(route->target, route->netmask);
+
       /* And free the routing table entry by adding it to the free list */
 
       net_freeroute_ipv4(route);
@@ -165,6 +170,10 @@ static int net_match_ipv6(
           ramroute_ipv6_remfirst(&g_ipv6_routes);
         }
 
+      /* Remove it from the route trie, too */
+
+      net_deltrie_ipv6(route->target, route->netmask);
+
       /* And free the routing table entry by adding it to the free list */
 
       net_freeroute_ipv6(route);
@@ -34,6 +34,7 @@
 
 #include "devif/devif.h"
 #include "route/cacheroute.h"
+#include "route/trieroute.h"
 #include "route/route.h"
 
 #if defined(CONFIG_NET) && defined(CONFIG_NET_ROUTE)
@@ -108,7 +109,8 @@ static int net_ipv4_match(FAR struct net_route_ipv4_s *route, FAR void *arg)
                                (FAR struct route_ipv4_match_s *)arg;
 
   /* To match, the masked target addresses must be the same.  In the event
-   * of multiple matches, only the first is returned.  There is not (yet) any
+   * of multiple matches, only the first is returned.  The route trie
+   * presents the longest prefixes first, otherwise there is not any
    * concept for the precedence of networks.
    */
 
@@ -152,7 +154,8 @@ static int net_ipv6_match(FAR struct net_route_ipv6_s *route, FAR void *arg)
                                 (FAR struct route_ipv6_match_s *)arg;
 
   /* To match, the masked target addresses must be the same.  In the event
-   * of multiple matches, only the first is returned.  There is not (yet) any
+   * of multiple matches, only the first is returned.  The route trie
+   * presents the longest prefixes first, otherwise there is not any
    * concept for the precedence of networks.
    */
 
@@ -213,7 +216,12 @@ int net_ipv4_router(in_addr_t target, FAR in_addr_t *router)
   memset(&match, 0, sizeof(struct route_ipv4_match_s));
   net_ipv4addr_copy(match.target, target);
 
-#ifdef CONFIG_ROUTE_IPv4_CACHEROUTE
+#if defined(CONFIG_ROUTE_IPv4_TRIEROUTE)
+  /* Look up the routes with the longest matching prefix in the trie */
+
+  ret = net_foreachtrie_ipv4(target, net_ipv4_match, &match);
+  if (ret < 0)
+#elif defined(CONFIG_ROUTE_IPv4_CACHEROUTE)
   /* First see if we can find a router entry in the cache */
 
   ret = net_foreachcache_ipv4(net_ipv4_match, &match);
@@ -288,7 +296,12 @@ int net_ipv6_router(const net_ipv6addr_t target, net_ipv6addr_t router)
   memset(&match, 0, sizeof(struct route_ipv6_match_s));
   net_ipv6addr_copy(match.target, target);
 
-#ifdef CONFIG_ROUTE_IPv6_CACHEROUTE
+#if defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
+  /* Look up the routes with the longest matching prefix in the trie */
+
+  ret = net_foreachtrie_ipv6(target, net_ipv6_match, &match);
+  if (ret < 0)
+#elif defined(CONFIG_ROUTE_IPv6_CACHEROUTE)
   /* First see if we can find a router entry in the cache */
 
   ret = net_foreachcache_ipv6(net_ipv6_match, &match);
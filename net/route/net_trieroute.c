@@ -0,0 +1,790 @@
+/****************************************************************************
+ * net/route/net_trieroute.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/net/net.h>
+#include <nuttx/net/ip.h>
+
+#include "route/trieroute.h"
+#include "route/route.h"
+
+#if defined(CONFIG_ROUTE_IPv4_TRIEROUTE) || defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The state of a trie */
+
+#define TRIEROUTE_STALE  0 /* Not built, build on the next lookup */
+#define TRIEROUTE_VALID  1 /* Mirrors the routing table */
+#define TRIEROUTE_FAILED 2 /* Could not be built, look up in the table
+                            * until the next change of the table */
+
+/* The number of prefix lengths of an address, 0 to 8 * size */
+
+#define TRIEROUTE_MAXPATH(s) (8 * (s) + 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One route of the trie, a copy of the routing table entry */
+
+struct trieroute_entry_s
+{
+  FAR struct trieroute_entry_s *flink; /* Next route with the same prefix */
+  union
+  {
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+    struct net_route_ipv4_s ipv4;
+#endif
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+    struct net_route_ipv6_s ipv6;
+#endif
+  } u;
+};
+
+/* One node of the path-compressed binary trie.  Each node holds one
+ * prefix.  The prefix of a node is a prefix of the prefixes of all nodes
+ * below it, and the first bit past the prefix of the node selects the
+ * child.  Nodes without routes are only kept where two subtries branch.
+ */
+
+struct trieroute_node_s
+{
+  FAR struct trieroute_node_s *child[2];  /* Subtries for the next bit */
+  FAR struct trieroute_entry_s *routes;   /* Routes with exactly this
+                                           * prefix, in table order */
+  uint8_t plen;                           /* Prefix length in bits */
+  uint8_t key[1];                         /* Prefix (network order), the
+                                           * bits past plen are zero */
+};
+
+struct trieroute_s
+{
+  FAR struct trieroute_node_s *root;      /* Node with the shortest prefix */
+  uint8_t size;                           /* Size of an address in bytes */
+  uint8_t state;                          /* See TRIEROUTE_* definitions */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+static struct trieroute_s g_ipv4_trie =
+{
+  NULL, sizeof(in_addr_t), TRIEROUTE_STALE
+};
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+static struct trieroute_s g_ipv6_trie =
+{
+  NULL, sizeof(net_ipv6addr_t), TRIEROUTE_STALE
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trieroute_bit
+ *
+ * Description:
+ *   Return bit n of an address in network order, bit 0 being the most
+ *   significant bit of the first byte.
+ *
+ ****************************************************************************/
+
+static inline unsigned int trieroute_bit(FAR const uint8_t *key,
+                                         unsigned int n)
+{
+  return (key[n >> 3] >> (7 - (n & 7))) & 1;
+}
+
+/****************************************************************************
+ * Name: trieroute_common
+ *
+ * Description:
+ *   Return the number of leading bits that two addresses have in common,
+ *   up to maxbits.
+ *
+ ****************************************************************************/
+
+static unsigned int trieroute_common(FAR const uint8_t *a,
+                                     FAR const uint8_t *b,
+                                     unsigned int maxbits)
+{
+  unsigned int nbits;
+  uint8_t diff;
+
+  for (nbits = 0; nbits < maxbits; nbits += 8)
+    {
+      diff = a[nbits >> 3] ^ b[nbits >> 3];
+      if (diff != 0)
+        {
+          while ((diff & 0x80) == 0)
+            {
+              diff <<= 1;
+              nbits++;
+            }
+
+          break;
+        }
+    }
+
+  return nbits < maxbits ? nbits : maxbits;
+}
+
+/****************************************************************************
+ * Name: trieroute_prefixlen
+ *
+ * Description:
+ *   Return the prefix length of a netmask, or -EINVAL if the netmask is not
+ *   a prefix mask.
+ *
+ ****************************************************************************/
+
+static int trieroute_prefixlen(FAR const uint8_t *netmask, unsigned int size)
+{
+  unsigned int plen = 0;
+  unsigned int i;
+
+  while (plen < 8 * size && trieroute_bit(netmask, plen) != 0)
+    {
+      plen++;
+    }
+
+  for (i = plen; i < 8 * size; i++)
+    {
+      if (trieroute_bit(netmask, i) != 0)
+        {
+          return -EINVAL;
+        }
+    }
+
+  return plen;
+}
+
+/****************************************************************************
+ * Name: trieroute_newnode
+ *
+ * Description:
+ *   Allocate a node without routes for the first plen bits of key.
+ *
+ ****************************************************************************/
+
+static FAR struct trieroute_node_s *
+  trieroute_newnode(FAR struct trieroute_s *trie, FAR const uint8_t *key,
+                    unsigned int plen)
+{
+  FAR struct trieroute_node_s *node;
+  unsigned int nbytes = (plen + 7) >> 3;
+
+  node = kmm_zalloc(sizeof(struct trieroute_node_s) - 1 + trie->size);
+  if (node != NULL)
+    {
+      node->plen = plen;
+      memcpy(node->key, key, nbytes);
+      if ((plen & 7) != 0)
+        {
+          node->key[nbytes - 1] &= 0xff << (8 - (plen & 7));
+        }
+    }
+
+  return node;
+}
+
+/****************************************************************************
+ * Name: trieroute_insert
+ *
+ * Description:
+ *   Return the node of a prefix, inserting it if it is not in the trie yet.
+ *
+ ****************************************************************************/
+
+static FAR struct trieroute_node_s *
+  trieroute_insert(FAR struct trieroute_s *trie, FAR const uint8_t *key,
+                   unsigned int plen)
+{
+  FAR struct trieroute_node_s **pp = &trie->root;
+  FAR struct trieroute_node_s *node;
+  FAR struct trieroute_node_s *newnode;
+  FAR struct trieroute_node_s *glue;
+  unsigned int common = 0;
+
+  /* Descend while the prefix of the node is a prefix of the new one */
+
+  while ((node = *pp) != NULL)
+    {
+      common = trieroute_common(node->key, key,
+                                node->plen < plen ? node->plen : plen);
+      if (common < node->plen)
+        {
+          break;
+        }
+
+      if (node->plen == plen)
+        {
+          return node;
+        }
+
+      pp = &node->child[trieroute_bit(key, node->plen)];
+    }
+
+  newnode = trieroute_newnode(trie, key, plen);
+  if (newnode == NULL || node == NULL)
+    {
+      /* Out of memory, or a new leaf */
+
+      if (newnode != NULL)
+        {
+          *pp = newnode;
+        }
+
+      return newnode;
+    }
+
+  if (common == plen)
+    {
+      /* The new prefix is a prefix of the node:  insert it above */
+
+      newnode->child[trieroute_bit(node->key, plen)] = node;
+      *pp = newnode;
+      return newnode;
+    }
+
+  /* The two prefixes differ at bit common:  branch there */
+
+  glue = trieroute_newnode(trie, key, common);
+  if (glue == NULL)
+    {
+      kmm_free(newnode);
+      return NULL;
+    }
+
+  glue->child[trieroute_bit(key, common)]       = newnode;
+  glue->child[trieroute_bit(node->key, common)] = node;
+  *pp = glue;
+  return newnode;
+}
+
+/****************************************************************************
+ * Name: trieroute_add
+ *
+ * Description:
+ *   Append a copy of a route to the routes of its prefix.
+ *
+ ****************************************************************************/
+
+static int trieroute_add(FAR struct trieroute_s *trie,
+                         FAR const uint8_t *target,
+                         FAR const uint8_t *netmask,
+                         FAR const void *route, size_t routesize)
+{
+  FAR struct trieroute_entry_s **tail;
+  FAR struct trieroute_entry_s *entry;
+  FAR struct trieroute_node_s *node;
+  int plen;
+
+  plen = trieroute_prefixlen(netmask, trie->size);
+  if (plen < 0)
+    {
+      nwarn("WARNING: Route with a non-prefix netmask\n");
+      return plen;
+    }
+
+  entry = kmm_zalloc(sizeof(struct trieroute_entry_s));
+  if (entry == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  node = trieroute_insert(trie, target, plen);
+  if (node == NULL)
+    {
+      kmm_free(entry);
+      return -ENOMEM;
+    }
+
+  memcpy(&entry->u, route, routesize);
+  for (tail = &node->routes; *tail != NULL; tail = &(*tail)->flink);
+  *tail = entry;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trieroute_del
+ *
+ * Description:
+ *   Remove the first route of a prefix, and the nodes that are no longer
+ *   needed.
+ *
+ ****************************************************************************/
+
+static int trieroute_del(FAR struct trieroute_s *trie,
+                         FAR const uint8_t *target,
+                         FAR const uint8_t *netmask)
+{
+  FAR struct trieroute_node_s **parentp = NULL;
+  FAR struct trieroute_node_s **pp = &trie->root;
+  FAR struct trieroute_entry_s *entry;
+  FAR struct trieroute_node_s *parent;
+  FAR struct trieroute_node_s *node;
+  int plen;
+
+  plen = trieroute_prefixlen(netmask, trie->size);
+  if (plen < 0)
+    {
+      return plen;
+    }
+
+  while ((node = *pp) != NULL && node->plen < plen)
+    {
+      parentp = pp;
+      pp      = &node->child[trieroute_bit(target, node->plen)];
+    }
+
+  if (node == NULL || node->plen != plen || node->routes == NULL ||
+      trieroute_common(node->key, target, plen) < plen)
+    {
+      return -ENOENT;
+    }
+
+  entry        = node->routes;
+  node->routes = entry->flink;
+  kmm_free(entry);
+
+  if (node->routes != NULL ||
+      (node->child[0] != NULL && node->child[1] != NULL))
+    {
+      return OK;
+    }
+
+  /* The node has no routes left and at most one child:  replace it with
+   * the child.  Its parent may then be a node without routes and with one
+   * child, too.
+   */
+
+  *pp = node->child[0] != NULL ? node->child[0] : node->child[1];
+  kmm_free(node);
+
+  if (parentp != NULL)
+    {
+      parent = *parentp;
+      if (parent->routes == NULL &&
+          (parent->child[0] == NULL || parent->child[1] == NULL))
+        {
+          *parentp = parent->child[0] != NULL ? parent->child[0] :
+                                                parent->child[1];
+          kmm_free(parent);
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trieroute_flush
+ *
+ * Description:
+ *   Free all nodes and routes of a trie.  Rotating the left child up keeps
+ *   this iterative.
+ *
+ ****************************************************************************/
+
+static void trieroute_flush(FAR struct trieroute_s *trie)
+{
+  FAR struct trieroute_entry_s *entry;
+  FAR struct trieroute_node_s *node = trie->root;
+  FAR struct trieroute_node_s *next;
+
+  while (node != NULL)
+    {
+      if (node->child[0] != NULL)
+        {
+          next                 = node->child[0];
+          node->child[0]       = next->child[1];
+          next->child[1]       = node;
+        }
+      else
+        {
+          next = node->child[1];
+          while ((entry = node->routes) != NULL)
+            {
+              node->routes = entry->flink;
+              kmm_free(entry);
+            }
+
+          kmm_free(node);
+        }
+
+      node = next;
+    }
+
+  trie->root = NULL;
+}
+
+/****************************************************************************
+ * Name: trieroute_path
+ *
+ * Description:
+ *   Collect the nodes with routes whose prefix matches an address, from the
+ *   shortest prefix to the longest.  Returns the number of nodes.
+ *
+ ****************************************************************************/
+
+static unsigned int trieroute_path(FAR struct trieroute_s *trie,
+                                   FAR const uint8_t *addr,
+                                   FAR struct trieroute_node_s **path)
+{
+  FAR struct trieroute_node_s *node = trie->root;
+  unsigned int npath = 0;
+
+  while (node != NULL &&
+         trieroute_common(node->key, addr, node->plen) == node->plen)
+    {
+      if (node->routes != NULL)
+        {
+          path[npath++] = node;
+        }
+
+      if (node->plen >= 8 * trie->size)
+        {
+          break;
+        }
+
+      node = node->child[trieroute_bit(addr, node->plen)];
+    }
+
+  return npath;
+}
+
+/****************************************************************************
+ * Name: trieroute_changed
+ *
+ * Description:
+ *   Handle the result of an incremental update of a trie.  A failed update
+ *   drops the trie, a change of the table gives a trie that could not be
+ *   built another chance.
+ *
+ ****************************************************************************/
+
+static void trieroute_changed(FAR struct trieroute_s *trie, int ret)
+{
+  if (trie->state == TRIEROUTE_VALID && ret < 0)
+    {
+      nwarn("WARNING: Dropping the route trie: %d\n", ret);
+      trieroute_flush(trie);
+      trie->state = TRIEROUTE_FAILED;
+    }
+  else if (trie->state == TRIEROUTE_FAILED)
+    {
+      trie->state = TRIEROUTE_STALE;
+    }
+}
+
+/****************************************************************************
+ * Name: net_buildtrie_ipv4 and net_buildtrie_ipv6
+ *
+ * Description:
+ *   net_foreachroute_ipv4/6() handlers that add every route of the table to
+ *   the trie.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+static int net_buildtrie_ipv4(FAR struct net_route_ipv4_s *route,
+                              FAR void *arg)
+{
+  return trieroute_add(&g_ipv4_trie, (FAR const uint8_t *)&route->target,
+                       (FAR const uint8_t *)&route->netmask, route,
+                       sizeof(struct net_route_ipv4_s));
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+static int net_buildtrie_ipv6(FAR struct net_route_ipv6_s *route,
+                              FAR void *arg)
+{
+  return trieroute_add(&g_ipv6_trie, (FAR const uint8_t *)route->target,
+                       (FAR const uint8_t *)route->netmask, route,
+                       sizeof(struct net_route_ipv6_s));
+}
+#endif
+
+/****************************************************************************
+ * Name: trieroute_ready
+ *
+ * Description:
+ *   Make sure that a trie mirrors the routing table, building it if
+ *   needed.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+static int trieroute_ready(FAR struct trieroute_s *trie)
+{
+  int ret;
+
+  if (trie->state == TRIEROUTE_VALID)
+    {
+      return OK;
+    }
+  else if (trie->state == TRIEROUTE_FAILED)
+    {
+      return -ENOENT;
+    }
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+  if (trie == &g_ipv4_trie)
+#endif
+    {
+      ret = net_foreachroute_ipv4(net_buildtrie_ipv4, NULL);
+    }
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+  else
+#endif
+    {
+      ret = net_foreachroute_ipv6(net_buildtrie_ipv6, NULL);
+    }
+#endif
+
+  if (ret < 0)
+    {
+      nwarn("WARNING: Failed to build the route trie: %d\n", ret);
+      trieroute_flush(trie);
+      trie->state = TRIEROUTE_FAILED;
+      return ret;
+    }
+
+  trie->state = TRIEROUTE_VALID;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: net_addtrie_ipv4 and net_addtrie_ipv6
+ *
+ * Description:
+ *   Add one route to the longest-prefix-match trie.
+ *
+ * Input Parameters:
+ *   route - The route that was added to the routing table
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+void net_addtrie_ipv4(FAR const struct net_route_ipv4_s *route)
+{
+  int ret = OK;
+
+  net_lock();
+  if (g_ipv4_trie.state == TRIEROUTE_VALID)
+    {
+      ret = trieroute_add(&g_ipv4_trie,
+                          (FAR const uint8_t *)&route->target,
+                          (FAR const uint8_t *)&route->netmask, route,
+                          sizeof(struct net_route_ipv4_s));
+    }
+
+  trieroute_changed(&g_ipv4_trie, ret);
+  net_unlock();
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+void net_addtrie_ipv6(FAR const struct net_route_ipv6_s *route)
+{
+  int ret = OK;
+
+  net_lock();
+  if (g_ipv6_trie.state == TRIEROUTE_VALID)
+    {
+      ret = trieroute_add(&g_ipv6_trie,
+                          (FAR const uint8_t *)route->target,
+                          (FAR const uint8_t *)route->netmask, route,
+                          sizeof(struct net_route_ipv6_s));
+    }
+
+  trieroute_changed(&g_ipv6_trie, ret);
+  net_unlock();
+}
+#endif
+
+/****************************************************************************
+ * Name: net_deltrie_ipv4 and net_deltrie_ipv6
+ *
+ * Description:
+ *   Remove one route from the longest-prefix-match trie.
+ *
+ * Input Parameters:
+ *   target  - The target of the route that was removed
+ *   netmask - The netmask of the route that was removed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+void net_deltrie_ipv4(in_addr_t target, in_addr_t netmask)
+{
+  int ret = OK;
+
+  net_lock();
+  if (g_ipv4_trie.state == TRIEROUTE_VALID)
+    {
+      ret = trieroute_del(&g_ipv4_trie, (FAR const uint8_t *)&target,
+                          (FAR const uint8_t *)&netmask);
+    }
+
+  trieroute_changed(&g_ipv4_trie, ret);
+  net_unlock();
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+void net_deltrie_ipv6(FAR const uint16_t *target,
+                      FAR const uint16_t *netmask)
+{
+  int ret = OK;
+
+  net_lock();
+  if (g_ipv6_trie.state == TRIEROUTE_VALID)
+    {
+      ret = trieroute_del(&g_ipv6_trie, (FAR const uint8_t *)target,
+                          (FAR const uint8_t *)netmask);
+    }
+
+  trieroute_changed(&g_ipv6_trie, ret);
+  net_unlock();
+}
+#endif
+
+/****************************************************************************
+ * Name: net_foreachtrie_ipv4 and net_foreachtrie_ipv6
+ *
+ * Description:
+ *   Traverse the routes that match a target address, from the longest
+ *   prefix to the shortest.
+ *
+ * Input Parameters:
+ *   target  - The address to look up
+ *   handler - Will be called for each matching route
+ *   arg     - An arbitrary value that will be passed to the handler.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned if all matching routes were visited.  Handlers
+ *   may terminate the search early with any non-zero, non-negative value.
+ *   A negated errno value is returned if the trie cannot be used.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+int net_foreachtrie_ipv4(in_addr_t target, route_handler_ipv4_t handler,
+                         FAR void *arg)
+{
+  FAR struct trieroute_node_s *path[TRIEROUTE_MAXPATH(sizeof(in_addr_t))];
+  FAR struct trieroute_entry_s *entry;
+  unsigned int npath;
+  int ret;
+
+  net_lock();
+
+  ret = trieroute_ready(&g_ipv4_trie);
+  if (ret >= 0)
+    {
+      npath = trieroute_path(&g_ipv4_trie, (FAR const uint8_t *)&target,
+                             path);
+      while (ret == OK && npath-- > 0)
+        {
+          for (entry = path[npath]->routes; entry != NULL && ret == OK;
+               entry = entry->flink)
+            {
+              ret = handler(&entry->u.ipv4, arg);
+            }
+        }
+    }
+
+  net_unlock();
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+int net_foreachtrie_ipv6(FAR const uint16_t *target,
+                         route_handler_ipv6_t handler, FAR void *arg)
+{
+  FAR struct trieroute_node_s *path[TRIEROUTE_MAXPATH(
+                                      sizeof(net_ipv6addr_t))];
+  FAR struct trieroute_entry_s *entry;
+  unsigned int npath;
+  int ret;
+
+  net_lock();
+
+  ret = trieroute_ready(&g_ipv6_trie);
+  if (ret >= 0)
+    {
+      npath = trieroute_path(&g_ipv6_trie, (FAR const uint8_t *)target,
+                             path);
+      while (ret == OK && npath-- > 0)
+        {
+          for (entry = path[npath]->routes; entry != NULL && ret == OK;
+               entry = entry->flink)
+            {
+              ret = handler(&entry->u.ipv6, arg);
+            }
+        }
+    }
+
+  net_unlock();
+  return ret;
+}
+#endif
+
+#endif /* CONFIG_ROUTE_IPv4_TRIEROUTE || CONFIG_ROUTE_IPv6_TRIEROUTE */
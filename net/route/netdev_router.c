@@ -33,6 +33,7 @@
 
 #include "netdev/netdev.h"
 #include "route/cacheroute.h"
+#include "route/trieroute.h"
 #include "route/route.h"
 
 #if defined(CONFIG_NET) && defined(CONFIG_NET_ROUTE)
@@ -113,8 +114,9 @@ static int net_ipv4_devmatch(FAR struct net_route_ipv4_s *route,
   /* To match, (1) the masked target addresses must be the same, and (2) the
    * router address must like on the network provided by the device.
    *
-   * In the event of multiple matches, only the first is returned.  There
-   * not (yet) any concept for the precedence of networks.
+   * In the event of multiple matches, only the first is returned.  The
+   * route trie presents the longest prefixes first, otherwise there is not
+   * any concept for the precedence of networks.
    */
 
   if (net_ipv4addr_maskcmp(route->target, match->target, route->netmask) &&
@@ -162,8 +164,9 @@ static int net_ipv6_devmatch(FAR struct net_route_ipv6_s *route,
   /* To match, (1) the masked target addresses must be the same, and (2) the
    * router address must like on the network provided by the device.
    *
-   * In the event of multiple matches, only the first is returned.  There
-   * not (yet) any concept for the precedence of networks.
+   * In the event of multiple matches, only the first is returned.  The
+   * route trie presents the longest prefixes first, otherwise there is not
+   * any concept for the precedence of networks.
    */
 
   if (net_ipv6addr_maskcmp(route->target, match->target, route->netmask) &&
@@ -224,7 +227,12 @@ void netdev_ipv4_router(FAR struct net_driver_s *dev, in_addr_t target,
   match.dev = dev;
   net_ipv4addr_copy(match.target, target);
 
-#ifdef CONFIG_ROUTE_IPv4_CACHEROUTE
+#if defined(CONFIG_ROUTE_IPv4_TRIEROUTE)
+  /* Look up the routes with the longest matching prefix in the trie */
+
+  ret = net_foreachtrie_ipv4(target, net_ipv4_devmatch, &match);
+  if (ret < 0)
+#elif defined(CONFIG_ROUTE_IPv4_CACHEROUTE)
   /* First see if we can find a router entry in the cache */
 
   ret = net_foreachcache_ipv4(net_ipv4_devmatch, &match);
@@ -303,7 +311,12 @@ void netdev_ipv6_router(FAR struct net_driver_s *dev,
   match.dev = dev;
   net_ipv6addr_copy(match.target, target);
 
-#ifdef CONFIG_ROUTE_IPv6_CACHEROUTE
+#if defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
+  /* Look up the routes with the longest matching prefix in the trie */
+
+  ret = net_foreachtrie_ipv6(target, net_ipv6_devmatch, &match);
+  if (ret < 0)
+#elif defined(CONFIG_ROUTE_IPv6_CACHEROUTE)
   /* First see if we can find a router entry in the cache */
 
   ret = net_foreachcache_ipv6(net_ipv6_devmatch, &match);
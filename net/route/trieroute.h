@@ -0,0 +1,137 @@
+/****************************************************************************
+ * net/route/trieroute.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __NET_ROUTE_TRIEROUTE_H
+#define __NET_ROUTE_TRIEROUTE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include "route/route.h"
+
+#if defined(CONFIG_ROUTE_IPv4_TRIEROUTE) || defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: net_addtrie_ipv4 and net_addtrie_ipv6
+ *
+ * Description:
+ *   Add one route to the longest-prefix-match trie.  Called by the routing
+ *   table back-ends after the route has been appended to the table.  A
+ *   trie that cannot hold the route (no memory, or a netmask that is not a
+ *   prefix mask) is dropped and lookups fall back to the routing table.
+ *
+ * Input Parameters:
+ *   route - The route that was added to the routing table
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+void net_addtrie_ipv4(FAR const struct net_route_ipv4_s *route);
+#else
+#  define net_addtrie_ipv4(r)
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+void net_addtrie_ipv6(FAR const struct net_route_ipv6_s *route);
+#else
+#  define net_addtrie_ipv6(r)
+#endif
+
+/****************************************************************************
+ * Name: net_deltrie_ipv4 and net_deltrie_ipv6
+ *
+ * Description:
+ *   Remove one route from the longest-prefix-match trie.  Called by the
+ *   routing table back-ends after the first route with this target and
+ *   netmask has been removed from the table.
+ *
+ * Input Parameters:
+ *   target  - The target of the route that was removed
+ *   netmask - The netmask of the route that was removed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+void net_deltrie_ipv4(in_addr_t target, in_addr_t netmask);
+#else
+#  define net_deltrie_ipv4(t,n)
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+void net_deltrie_ipv6(FAR const uint16_t *target,
+                      FAR const uint16_t *netmask);
+#else
+#  define net_deltrie_ipv6(t,n)
+#endif
+
+/****************************************************************************
+ * Name: net_foreachtrie_ipv4 and net_foreachtrie_ipv6
+ *
+ * Description:
+ *   Traverse the routes that match a target address, from the longest
+ *   prefix to the shortest.  Routes with the same prefix are visited in
+ *   routing table order.  The trie is built from the routing table on the
+ *   first use after it was dropped.
+ *
+ * Input Parameters:
+ *   target  - The address to look up
+ *   handler - Will be called for each matching route
+ *   arg     - An arbitrary value that will be passed to the handler.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned if all matching routes were visited.  Handlers
+ *   may terminate the search early with any non-zero, non-negative value.
+ *   A negated errno value is returned if the trie cannot be used; the
+ *   caller must then traverse the routing table itself.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+int net_foreachtrie_ipv4(in_addr_t target, route_handler_ipv4_t handler,
+                         FAR void *arg);
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+int net_foreachtrie_ipv6(FAR const uint16_t *target,
+                         route_handler_ipv6_t handler, FAR void *arg);
+#endif
+
+#else
+
+#  define net_addtrie_ipv4(r)
+#  define net_addtrie_ipv6(r)
+#  define net_deltrie_ipv4(t,n)
+#  define net_deltrie_ipv6(t,n)
+
+#endif /* CONFIG_ROUTE_IPv4_TRIEROUTE || CONFIG_ROUTE_IPv6_TRIEROUTE */
+#endif /* __NET_ROUTE_TRIEROUTE_H */
@@ -150,6 +150,7 @@ static int psock_socketlevel_option(FAR struct socket *psock, int option,
                            * periodic transmission of probes */
       case SO_OOBINLINE:  /* Leaves received out-of-band data inline */
       case SO_REUSEADDR:  /* Allow reuse of local addresses */
+      case SO_REUSEPORT:  /* Allow reuse of local addresses and ports */
         {
           sockopt_t optionset;
 
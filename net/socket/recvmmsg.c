@@ -0,0 +1,220 @@
+/****************************************************************************
+ * net/socket/recvmmsg.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/cancelpt.h>
+#include <nuttx/net/net.h>
+
+#include "socket/socket.h"
+
+#ifdef CONFIG_NET
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psock_recvmmsg
+ *
+ * Description:
+ *   psock_recvmmsg() receives several messages from a socket with one
+ *   call.  It is the internal OS interface of recvmmsg() and differs from
+ *   it like psock_recvmsg() differs from recvmsg().
+ *
+ *   After each message, the messages that are already queued are taken
+ *   with one call to the si_recvmmsg() method of the address family, if it
+ *   has one and supports the socket.
+ *
+ * Input Parameters:
+ *   psock     A pointer to a NuttX-specific, internal socket structure
+ *   msgvec    Buffers to receive the messages.  The msg_len field of each
+ *             message received is set to the number of characters
+ *             received.
+ *   vlen      The number of messages in msgvec
+ *   flags     Receive flags.  With MSG_WAITFORONE, only the first message
+ *             is waited for.
+ *   timeout   If not NULL, no further message is waited for once this
+ *             time has passed
+ *
+ * Returned Value:
+ *   On success, returns the number of messages received.  If no message
+ *   can be received, a negated errno value is returned.
+ *
+ ****************************************************************************/
+
+int psock_recvmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags,
+                   FAR const struct timespec *timeout)
+{
+  clock_t deadline = 0;
+  unsigned int count = 0;
+  sclock_t ticks;
+  ssize_t ret = 0;
+  bool batch;
+
+  if (msgvec == NULL)
+    {
+      return -EINVAL;
+    }
+
+  if (psock == NULL || psock->s_conn == NULL)
+    {
+      return -EBADF;
+    }
+
+  DEBUGASSERT(psock->s_sockif != NULL);
+  batch = psock->s_sockif->si_recvmmsg != NULL;
+
+  if (timeout != NULL)
+    {
+      ret = clock_time2ticks(timeout, &ticks);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      deadline = clock_systime_ticks() + ticks;
+    }
+
+  if (vlen > INT_MAX)
+    {
+      vlen = INT_MAX;
+    }
+
+  while (count < vlen)
+    {
+      /* Receive one message, waiting for it if the flags allow */
+
+      ret = psock_recvmsg(psock, &msgvec[count].msg_hdr, flags);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      msgvec[count++].msg_len = ret;
+
+      if ((flags & MSG_WAITFORONE) != 0)
+        {
+          flags |= MSG_DONTWAIT;
+        }
+
+      /* Then take all messages that are already queued at once */
+
+      if (batch && count < vlen)
+        {
+          ret = psock->s_sockif->si_recvmmsg(psock, &msgvec[count],
+                                             vlen - count, flags);
+          if (ret == -ENOSYS)
+            {
+              /* The address family cannot batch for this type of socket */
+
+              batch = false;
+            }
+          else if (ret < 0)
+            {
+              break;
+            }
+          else
+            {
+              count += ret;
+            }
+        }
+
+      if (timeout != NULL &&
+          (sclock_t)(clock_systime_ticks() - deadline) >= 0)
+        {
+          break;
+        }
+    }
+
+  /* An error after the first message is not reported.  The next call will
+   * see it again if it persists.
+   */
+
+  return count > 0 ? (int)count : (int)ret;
+}
+
+/****************************************************************************
+ * Function: recvmmsg
+ *
+ * Description:
+ *   recvmmsg() receives several messages from a socket with one call.
+ *   Each element of msgvec is used like the message of recvmsg().
+ *
+ * Parameters:
+ *   sockfd   Socket descriptor of socket
+ *   msgvec   Buffers to receive the messages
+ *   vlen     The number of messages in msgvec
+ *   flags    Receive flags.  With MSG_WAITFORONE, MSG_DONTWAIT is set after
+ *            the first message.
+ *   timeout  If not NULL, no further message is waited for once this time
+ *            has passed.  As on Linux, it is only checked after each
+ *            message:  the wait for one message is not cut short.
+ *
+ * Returned Value:
+ *   On success, returns the number of messages received and the msg_len
+ *   field of each message is set to its length.  On error, -1 is returned
+ *   and errno is set as by recvmsg().
+ *
+ ****************************************************************************/
+
+int recvmmsg(int sockfd, FAR struct mmsghdr *msgvec, unsigned int vlen,
+             int flags, FAR struct timespec *timeout)
+{
+  FAR struct socket *psock;
+  int ret;
+
+  /* recvmmsg() is a cancellation point */
+
+  enter_cancellation_point();
+
+  /* Get the underlying socket structure */
+
+  ret = sockfd_socket(sockfd, &psock);
+
+  /* Let psock_recvmmsg() do all of the work */
+
+  if (ret == OK)
+    {
+      ret = psock_recvmmsg(psock, msgvec, vlen, flags, timeout);
+    }
+
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      ret = ERROR;
+    }
+
+  leave_cancellation_point();
+  return ret;
+}
+
+#endif /* CONFIG_NET */
@@ -0,0 +1,172 @@
+/****************************************************************************
+ * net/socket/sendmmsg.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <nuttx/cancelpt.h>
+#include <nuttx/net/net.h>
+
+#include "socket/socket.h"
+
+#ifdef CONFIG_NET
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psock_sendmmsg
+ *
+ * Description:
+ *   psock_sendmmsg() sends several messages to a socket with one call.  It
+ *   is the internal OS interface of sendmmsg() and differs from it like
+ *   psock_sendmsg() differs from sendmsg().
+ *
+ *   The messages are passed to the si_sendmmsg() method of the address
+ *   family at once, if it has one and supports the socket.  Otherwise,
+ *   they are sent one by one.
+ *
+ * Input Parameters:
+ *   psock     A pointer to a NuttX-specific, internal socket structure
+ *   msgvec    The messages to send.  The msg_len field of each message
+ *             sent is set to the number of characters sent.
+ *   vlen      The number of messages in msgvec
+ *   flags     Send flags
+ *
+ * Returned Value:
+ *   On success, returns the number of messages sent.  If the first message
+ *   cannot be sent, a negated errno value is returned.
+ *
+ ****************************************************************************/
+
+int psock_sendmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags)
+{
+  unsigned int count;
+  ssize_t ret = 0;
+
+  if (msgvec == NULL)
+    {
+      return -EINVAL;
+    }
+
+  if (psock == NULL || psock->s_conn == NULL)
+    {
+      return -EBADF;
+    }
+
+  DEBUGASSERT(psock->s_sockif != NULL);
+
+  if (vlen > INT_MAX)
+    {
+      vlen = INT_MAX;
+    }
+
+  /* -ENOSYS means that the address family cannot batch for this type of
+   * socket.
+   */
+
+  if (psock->s_sockif->si_sendmmsg != NULL)
+    {
+      ret = psock->s_sockif->si_sendmmsg(psock, msgvec, vlen, flags);
+      if (ret != -ENOSYS)
+        {
+          return ret;
+        }
+    }
+
+  for (count = 0; count < vlen; count++)
+    {
+      ret = psock_sendmsg(psock, &msgvec[count].msg_hdr, flags);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      msgvec[count].msg_len = ret;
+    }
+
+  /* An error after the first message is not reported.  The next call will
+   * see it again if it persists.
+   */
+
+  return count > 0 ? (int)count : (int)ret;
+}
+
+/****************************************************************************
+ * Function: sendmmsg
+ *
+ * Description:
+ *   sendmmsg() sends several messages to a socket with one call.  Each
+ *   element of msgvec is used like the message of sendmsg().
+ *
+ * Parameters:
+ *   sockfd   Socket descriptor of socket
+ *   msgvec   The messages to send
+ *   vlen     The number of messages in msgvec
+ *   flags    Send flags
+ *
+ * Returned Value:
+ *   On success, returns the number of messages sent and the msg_len field
+ *   of each message sent is set to the number of bytes sent.  On error, -1
+ *   is returned and errno is set as by sendmsg().
+ *
+ ****************************************************************************/
+
+int sendmmsg(int sockfd, FAR struct mmsghdr *msgvec, unsigned int vlen,
+             int flags)
+{
+  FAR struct socket *psock;
+  int ret;
+
+  /* sendmmsg() is a cancellation point */
+
+  enter_cancellation_point();
+
+  /* Get the underlying socket structure */
+
+  ret = sockfd_socket(sockfd, &psock);
+
+  /* Let psock_sendmmsg() do all of the work */
+
+  if (ret == OK)
+    {
+      ret = psock_sendmmsg(psock, msgvec, vlen, flags);
+    }
+
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      ret = ERROR;
+    }
+
+  leave_cancellation_point();
+  return ret;
+}
+
+#endif /* CONFIG_NET */
@@ -63,10 +63,11 @@
 #define _SO_TYPE         _SO_BIT(SO_TYPE)
 #define _SO_TIMESTAMP    _SO_BIT(SO_TIMESTAMP)
 #define _SO_BINDTODEVICE _SO_BIT(SO_BINDTODEVICE)
+#define _SO_REUSEPORT    _SO_BIT(SO_REUSEPORT)
 
 /* This is the largest option value.  REVISIT: belongs in sys/socket.h */
 
-#define _SO_MAXOPT       (18)
+#define _SO_MAXOPT       (19)
 
 /* Macros to set, test, clear options */
 
@@ -129,6 +129,12 @@
 #define TCP_RTO_MAX 240 /* 120s,The unit is half a second */
 #define TCP_RTO_MIN 1   /* 0.5s */
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+/* The bucket of a local port (network byte order) in the port hashes */
+
+#  define TCP_PORT_HASH(p)    (NTOHS(p) % CONFIG_NET_TCP_CONN_HASHSIZE)
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -211,6 +217,13 @@ struct tcp_conn_s
   /* TCP-specific content follows */
 
   union ip_binding_u u;   /* IP address binding */
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  dq_entry_t hnode;       /* Link in the 4-tuple hash of active
+                           * connections */
+  dq_entry_t pnode;       /* Link in the local port hash of active
+                           * connections */
+  dq_entry_t lnode;       /* Link in the local port hash of listeners */
+#endif
   uint8_t  rcvseq[4];     /* The sequence number that we expect to
                            * receive next */
   uint8_t  sndseq[4];     /* The sequence number that was last sent by us */
@@ -1058,6 +1071,34 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
                                         uint16_t portno);
 #endif
 
+/****************************************************************************
+ * Name: tcp_selectlistener
+ *
+ * Description:
+ *   Given the listener found by tcp_findlistener() for a new connection,
+ *   pick the member of its SO_REUSEPORT group that handles the connection.
+ *   The choice is a hash of the 4-tuple, so the SYN, the ACK and the
+ *   timeout of one connection all reach the same listener.  A listener
+ *   without SO_REUSEPORT is returned unchanged.
+ *
+ * Input Parameters:
+ *   listener - The listener returned by tcp_findlistener(), may be NULL
+ *   uaddr    - The local and remote address of the new connection
+ *   rport    - The remote port of the new connection
+ *
+ * Assumptions:
+ *   The network is locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SOCKOPTS
+FAR struct tcp_conn_s *
+  tcp_selectlistener(FAR struct tcp_conn_s *listener,
+                     FAR union ip_binding_u *uaddr, uint16_t rport);
+#else
+#  define tcp_selectlistener(l,u,r) (l)
+#endif
+
 /****************************************************************************
  * Name: tcp_unlisten
  *
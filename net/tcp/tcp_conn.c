@@ -57,6 +57,7 @@
 
 #include <nuttx/clock.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/nuttx.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev.h>
@@ -70,6 +71,7 @@
 #include "icmpv6/icmpv6.h"
 #include "nat/nat.h"
 #include "netdev/netdev.h"
+#include "socket/socket.h"
 
 /****************************************************************************
  * Private Data
@@ -89,10 +91,175 @@ static dq_queue_t g_free_tcp_connections;
 
 static dq_queue_t g_active_tcp_connections;
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+/* The active connections hashed by the 4-tuple, for the lookup of the
+ * connection of a received segment, and by the local port, for the port
+ * availability checks.
+ */
+
+static dq_queue_t g_tcp_conn_hash[CONFIG_NET_TCP_CONN_HASHSIZE];
+static dq_queue_t g_tcp_port_hash[CONFIG_NET_TCP_CONN_HASHSIZE];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+
+/****************************************************************************
+ * Name: tcp_hash
+ *
+ * Description:
+ *   Return the 4-tuple hash bucket of a connection.  The local address is
+ *   left out since an active connection may be bound to INADDR_ANY.
+ *
+ ****************************************************************************/
+
+static inline unsigned int tcp_hash(uint16_t lport, uint16_t rport,
+                                    uint32_t raddr)
+{
+  uint32_t hash = raddr ^ ((uint32_t)lport << 16) ^ rport;
+
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+
+  return hash % CONFIG_NET_TCP_CONN_HASHSIZE;
+}
+
+/****************************************************************************
+ * Name: tcp_hash_ipv6addr
+ *
+ * Description:
+ *   Fold an IPv6 address into 32 bits for tcp_hash().
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv6
+static inline uint32_t tcp_hash_ipv6addr(FAR const uint16_t *addr)
+{
+  uint32_t hash = 0;
+  int i;
+
+  for (i = 0; i < 8; i += 2)
+    {
+      hash ^= ((uint32_t)addr[i] << 16) | addr[i + 1];
+    }
+
+  return hash;
+}
+#endif
+
+/****************************************************************************
+ * Name: tcp_hash_conn
+ *
+ * Description:
+ *   Return the 4-tuple hash bucket of an active connection.
+ *
+ ****************************************************************************/
+
+static unsigned int tcp_hash_conn(FAR struct tcp_conn_s *conn)
+{
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (conn->domain == PF_INET)
+#endif
+    {
+      return tcp_hash(conn->lport, conn->rport, conn->u.ipv4.raddr);
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      return tcp_hash(conn->lport, conn->rport,
+                      tcp_hash_ipv6addr(conn->u.ipv6.raddr));
+    }
+#endif /* CONFIG_NET_IPv6 */
+}
+
+/****************************************************************************
+ * Name: tcp_hnode_conn and tcp_pnode_conn
+ *
+ * Description:
+ *   Convert a hash link of a connection to the connection, or NULL to NULL.
+ *
+ ****************************************************************************/
+
+static inline FAR struct tcp_conn_s *tcp_hnode_conn(FAR dq_entry_t *node)
+{
+  return node ? container_of(node, struct tcp_conn_s, hnode) : NULL;
+}
+
+static inline FAR struct tcp_conn_s *tcp_pnode_conn(FAR dq_entry_t *node)
+{
+  return node ? container_of(node, struct tcp_conn_s, pnode) : NULL;
+}
+
+/****************************************************************************
+ * Name: tcp_nextport
+ *
+ * Description:
+ *   Traverse the active TCP connections which may use the local port
+ *   portno, i.e. those in the same bucket of the port hash.
+ *
+ ****************************************************************************/
+
+static inline FAR struct tcp_conn_s *
+  tcp_nextport(FAR struct tcp_conn_s *conn, uint16_t portno)
+{
+  if (!conn)
+    {
+      FAR dq_queue_t *bucket = &g_tcp_port_hash[TCP_PORT_HASH(portno)];
+
+      return tcp_pnode_conn(dq_peek(bucket));
+    }
+  else
+    {
+      return tcp_pnode_conn(dq_next(&conn->pnode));
+    }
+}
+#endif /* CONFIG_NET_TCP_CONN_HASH */
+
+/****************************************************************************
+ * Name: tcp_addactive
+ *
+ * Description:
+ *   Put a connection into the list (and the hashes) of active connections.
+ *   The local and remote port and address must be set up already.
+ *
+ ****************************************************************************/
+
+static void tcp_addactive(FAR struct tcp_conn_s *conn)
+{
+  dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  dq_addlast(&conn->hnode, &g_tcp_conn_hash[tcp_hash_conn(conn)]);
+  dq_addlast(&conn->pnode, &g_tcp_port_hash[TCP_PORT_HASH(conn->lport)]);
+#endif
+}
+
+/****************************************************************************
+ * Name: tcp_remactive
+ *
+ * Description:
+ *   Remove a connection from the list (and the hashes) of active
+ *   connections.
+ *
+ ****************************************************************************/
+
+static void tcp_remactive(FAR struct tcp_conn_s *conn)
+{
+  dq_rem(&conn->sconn.node, &g_active_tcp_connections);
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  dq_rem(&conn->hnode, &g_tcp_conn_hash[tcp_hash_conn(conn)]);
+  dq_rem(&conn->pnode, &g_tcp_port_hash[TCP_PORT_HASH(conn->lport)]);
+#endif
+}
+
 /****************************************************************************
  * Name: tcp_listener
  *
@@ -103,17 +270,24 @@ static dq_queue_t g_active_tcp_connections;
  *   Primary uses: (1) to determine if a port number is available, (2) to
  *   To identify the socket that will accept new connections on a local port.
  *
+ *   If reuseport is true, the connections that have SO_REUSEPORT are
+ *   skipped:  they may share the port with a socket that has it as well.
+ *
  ****************************************************************************/
 
 static FAR struct tcp_conn_s *
   tcp_listener(uint8_t domain, FAR const union ip_addr_u *ipaddr,
-               uint16_t portno)
+               uint16_t portno, bool reuseport)
 {
   FAR struct tcp_conn_s *conn = NULL;
 
   /* Check if this port number is in use by any active UIP TCP connection */
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  while ((conn = tcp_nextport(conn, portno)) != NULL)
+#else
   while ((conn = tcp_nextconn(conn)) != NULL)
+#endif
     {
       /* Check if this connection is open and the local port assignment
        * matches the requested port number.
@@ -125,6 +299,13 @@ static FAR struct tcp_conn_s *
 #endif
          )
         {
+#ifdef CONFIG_NET_SOCKOPTS
+          if (reuseport && _SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT))
+            {
+              continue;
+            }
+#endif
+
           /* If there are multiple interface devices, then the local IP
            * address of the connection must also match.  INADDR_ANY is a
            * special case:  There can only be instance of a port number
@@ -166,6 +347,27 @@ static FAR struct tcp_conn_s *
   return NULL;
 }
 
+/****************************************************************************
+ * Name: tcp_portinuse
+ *
+ * Description:
+ *   Return true if the local port number (in network byte order) is used
+ *   by another TCP connection or by a NAT entry.  See tcp_listener() for
+ *   reuseport.
+ *
+ ****************************************************************************/
+
+static bool tcp_portinuse(uint8_t domain, FAR const union ip_addr_u *ipaddr,
+                          uint16_t portno, bool reuseport)
+{
+  return tcp_listener(domain, ipaddr, portno, reuseport) != NULL
+#if defined(CONFIG_NET_NAT) && defined(CONFIG_NET_IPv4)
+         || (domain == PF_INET &&
+             ipv4_nat_port_inuse(IP_PROTO_TCP, ipaddr->ipv4, portno))
+#endif
+         ;
+}
+
 /****************************************************************************
  * Name: tcp_ipv4_active
  *
@@ -187,9 +389,14 @@ static inline FAR struct tcp_conn_s *
   in_addr_t srcipaddr;
   in_addr_t destipaddr;
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = net_ip4addr_conv32(ip->srcipaddr);
   destipaddr = net_ip4addr_conv32(ip->destipaddr);
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  conn       = tcp_hnode_conn(dq_peek(&g_tcp_conn_hash[
+                 tcp_hash(tcp->destport, tcp->srcport, srcipaddr)]));
+#else
+  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
+#endif
 
   while (conn)
     {
@@ -226,7 +433,11 @@ static inline FAR struct tcp_conn_s *
 
       /* Look at the next active connection */
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+      conn = tcp_hnode_conn(dq_next(&conn->hnode));
+#else
       conn = (FAR struct tcp_conn_s *)conn->sconn.node.flink;
+#endif
     }
 
   return conn;
@@ -254,9 +465,15 @@ static inline FAR struct tcp_conn_s *
   net_ipv6addr_t *srcipaddr;
   net_ipv6addr_t *destipaddr;
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = (net_ipv6addr_t *)ip->srcipaddr;
   destipaddr = (net_ipv6addr_t *)ip->destipaddr;
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  conn       = tcp_hnode_conn(dq_peek(&g_tcp_conn_hash[
+                 tcp_hash(tcp->destport, tcp->srcport,
+                          tcp_hash_ipv6addr(ip->srcipaddr))]));
+#else
+  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
+#endif
 
   while (conn)
     {
@@ -293,7 +510,11 @@ static inline FAR struct tcp_conn_s *
 
       /* Look at the next active connection */
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+      conn = tcp_hnode_conn(dq_next(&conn->hnode));
+#else
       conn = (FAR struct tcp_conn_s *)conn->sconn.node.flink;
+#endif
     }
 
   return conn;
@@ -356,11 +577,28 @@ static inline int tcp_ipv4_bind(FAR struct tcp_conn_s *conn,
         }
     }
 
-  /* Verify or select a local port (network byte order) */
+  /* Verify or select a local port (network byte order).  A SO_REUSEPORT
+   * socket may share its port with the other SO_REUSEPORT sockets and
+   * with the connections that they accepted, tcp_listen() checks the
+   * group.
+   */
 
-  port = tcp_selectport(PF_INET,
+#ifdef CONFIG_NET_SOCKOPTS
+  if (addr->sin_port != 0 &&
+      _SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT))
+    {
+      port = tcp_portinuse(PF_INET,
+                 (FAR const union ip_addr_u *)&addr->sin_addr.s_addr,
+                 addr->sin_port, true) ? -EADDRINUSE : addr->sin_port;
+    }
+  else
+#endif
+    {
+      port = tcp_selectport(PF_INET,
                        (FAR const union ip_addr_u *)&addr->sin_addr.s_addr,
                        addr->sin_port);
+    }
+
   if (port < 0)
     {
       nerr("ERROR: tcp_selectport failed: %d\n", port);
@@ -457,11 +695,26 @@ static inline int tcp_ipv6_bind(FAR struct tcp_conn_s *conn,
 
   /* Verify or select a local port (network byte order) */
 
-  /* The port number must be unique for this address binding */
+  /* The port number must be unique for this address binding, unless the
+   * socket has SO_REUSEPORT (see tcp_ipv4_bind()).
+   */
 
-  port = tcp_selectport(PF_INET6,
+#ifdef CONFIG_NET_SOCKOPTS
+  if (addr->sin6_port != 0 &&
+      _SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT))
+    {
+      port = tcp_portinuse(PF_INET6,
+                (FAR const union ip_addr_u *)addr->sin6_addr.in6_u.u6_addr16,
+                addr->sin6_port, true) ? -EADDRINUSE : addr->sin6_port;
+    }
+  else
+#endif
+    {
+      port = tcp_selectport(PF_INET6,
                 (FAR const union ip_addr_u *)addr->sin6_addr.in6_u.u6_addr16,
                 addr->sin6_port);
+    }
+
   if (port < 0)
     {
       nerr("ERROR: tcp_selectport failed: %d\n", port);
@@ -628,12 +881,7 @@ int tcp_selectport(uint8_t domain,
 
           portno = HTONS(g_last_tcp_port);
         }
-      while (tcp_listener(domain, ipaddr, portno)
-#if defined(CONFIG_NET_NAT) && defined(CONFIG_NET_IPv4)
-             || (domain == PF_INET &&
-                 ipv4_nat_port_inuse(IP_PROTO_TCP, ipaddr->ipv4, portno))
-#endif
-      );
+      while (tcp_portinuse(domain, ipaddr, portno, false));
     }
   else
     {
@@ -641,12 +889,7 @@ int tcp_selectport(uint8_t domain,
        * connection is using this local port.
        */
 
-      if (tcp_listener(domain, ipaddr, portno)
-#if defined(CONFIG_NET_NAT) && defined(CONFIG_NET_IPv4)
-          || (domain == PF_INET &&
-              ipv4_nat_port_inuse(IP_PROTO_TCP, ipaddr->ipv4, portno))
-#endif
-      )
+      if (tcp_portinuse(domain, ipaddr, portno, false))
         {
           /* It is in use... return EADDRINUSE */
 
@@ -802,6 +1045,7 @@ FAR struct tcp_conn_s *tcp_alloc(uint8_t domain)
   if (conn)
     {
       memset(conn, 0, sizeof(struct tcp_conn_s));
+      nxrmutex_init(&conn->sconn.s_lock);
       conn->sconn.ttl     = IP_TTL_DEFAULT;
       conn->tcpstateflags = TCP_ALLOCATED;
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
@@ -942,7 +1186,7 @@ void tcp_free(FAR struct tcp_conn_s *conn)
     {
       /* Remove the connection from the active list */
 
-      dq_rem(&conn->sconn.node, &g_active_tcp_connections);
+      tcp_remactive(conn);
     }
 
   tcp_free_rx_buffers(conn);
@@ -991,6 +1235,7 @@ void tcp_free(FAR struct tcp_conn_s *conn)
   /* Mark the connection available. */
 
   conn->tcpstateflags = TCP_CLOSED;
+  nxrmutex_destroy(&conn->sconn.s_lock);
 
   /* If this is a preallocated or a batch allocated connection store it in
    * the free connections list. Else free it.
@@ -1190,6 +1435,15 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
 #  ifdef CONFIG_NET_BINDTODEVICE
       conn->sconn.s_boundto  = listener->sconn.s_boundto;
 #  endif
+
+      /* An accepted connection stays in the SO_REUSEPORT group of its
+       * listener, so that more members can still bind the port.
+       */
+
+      if (_SO_GETOPT(listener->sconn.s_options, SO_REUSEPORT))
+        {
+          _SO_SETOPT(conn->sconn.s_options, SO_REUSEPORT);
+        }
 #endif
 
       conn->sconn.s_tos      = listener->sconn.s_tos;
@@ -1251,7 +1505,7 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
        * Interrupts should already be disabled in this context.
        */
 
-      dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+      tcp_addactive(conn);
       tcp_update_retrantimer(conn, TCP_RTO);
     }
 
@@ -1559,7 +1813,7 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
 
   /* And, finally, put the connection structure into the active list. */
 
-  dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+  tcp_addactive(conn);
   ret = OK;
 
 errout_with_lock:
@@ -722,7 +722,7 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 
   /* Start of TCP input header processing code. */
 
-  if (tcp_chksum(dev) != 0xffff)
+  if (!NETDEV_CSUM_TRUSTED(dev) && tcp_chksum(dev) != 0xffff)
     {
       /* Compute and check the TCP checksum. */
 
@@ -776,6 +776,7 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 #  endif
         {
           net_ipv6addr_copy(&uaddr.ipv6.laddr, IPv6BUF->destipaddr);
+          net_ipv6addr_copy(&uaddr.ipv6.raddr, IPv6BUF->srcipaddr);
         }
 #endif
 
@@ -786,14 +787,21 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
         {
           net_ipv4addr_copy(uaddr.ipv4.laddr,
                             net_ip4addr_conv32(IPv4BUF->destipaddr));
+          net_ipv4addr_copy(uaddr.ipv4.raddr,
+                            net_ip4addr_conv32(IPv4BUF->srcipaddr));
         }
 #endif
 
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
-      if ((conn = tcp_findlistener(&uaddr, tmp16, domain)) != NULL)
+      conn = tcp_findlistener(&uaddr, tmp16, domain);
 #else
-      if ((conn = tcp_findlistener(&uaddr, tmp16)) != NULL)
+      conn = tcp_findlistener(&uaddr, tmp16);
 #endif
+
+      /* Pick the listener of a SO_REUSEPORT group for this connection */
+
+      conn = tcp_selectlistener(conn, &uaddr, tcp->srcport);
+      if (conn != NULL)
         {
           if (!tcp_backlogavailable(conn))
             {
@@ -933,6 +941,7 @@ found:
 #else
           listener = tcp_findlistener(&uaddr, conn->lport);
 #endif
+          listener = tcp_selectlistener(listener, &conn->u, conn->rport);
 
           /* We must free this TCP connection structure; this connection
            * will never be established.  There should only be one reference
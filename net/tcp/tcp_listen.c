@@ -48,11 +48,13 @@
 #include <stdbool.h>
 #include <debug.h>
 
+#include <nuttx/nuttx.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
 
 #include "devif/devif.h"
 #include "inet/inet.h"
+#include "socket/socket.h"
 #include "tcp/tcp.h"
 
 /****************************************************************************
@@ -63,6 +65,12 @@
 
 static FAR struct tcp_conn_s *tcp_listenports[CONFIG_NET_MAX_LISTENPORTS];
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+/* The same listeners hashed by the local port */
+
+static dq_queue_t g_tcp_listen_hash[CONFIG_NET_TCP_CONN_HASHSIZE];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -87,17 +95,31 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
                                         uint16_t portno)
 #endif
 {
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  FAR dq_entry_t *node;
+
+  /* Examine each listener in the bucket of this port */
+
+  for (node = dq_peek(&g_tcp_listen_hash[TCP_PORT_HASH(portno)]);
+       node != NULL; node = dq_next(node))
+#else
   int ndx;
 
   /* Examine each connection structure in each slot of the listener list */
 
   for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+#endif
     {
       /* Is this slot assigned?  If so, does the connection have the same
        * local port number?
        */
 
+#ifdef CONFIG_NET_TCP_CONN_HASH
+      FAR struct tcp_conn_s *conn =
+        container_of(node, struct tcp_conn_s, lnode);
+#else
       FAR struct tcp_conn_s *conn = tcp_listenports[ndx];
+#endif
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
       if (conn && conn->lport == portno && conn->domain == domain)
 #else
@@ -141,10 +163,186 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
   return NULL;
 }
 
+#ifdef CONFIG_NET_SOCKOPTS
+
+/****************************************************************************
+ * Name: tcp_samegroup
+ *
+ * Description:
+ *   Return true if conn is a listener of the same SO_REUSEPORT group as
+ *   first:  the same domain, local port and local address.
+ *
+ ****************************************************************************/
+
+static bool tcp_samegroup(FAR struct tcp_conn_s *first,
+                          FAR struct tcp_conn_s *conn)
+{
+  if (conn == NULL || conn->lport != first->lport ||
+      !_SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT))
+    {
+      return false;
+    }
+
+#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+  if (conn->domain != first->domain)
+    {
+      return false;
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (first->domain == PF_INET)
+#endif
+    {
+      return net_ipv4addr_cmp(conn->u.ipv4.laddr, first->u.ipv4.laddr);
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      return net_ipv6addr_cmp(conn->u.ipv6.laddr, first->u.ipv6.laddr);
+    }
+#endif /* CONFIG_NET_IPv6 */
+}
+
+/****************************************************************************
+ * Name: tcp_listenhash
+ *
+ * Description:
+ *   Hash the remote address and port of a new connection to the listener
+ *   first.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_listenhash(FAR struct tcp_conn_s *first,
+                               FAR union ip_binding_u *uaddr,
+                               uint16_t rport)
+{
+  uint32_t hash = ((uint32_t)rport << 16) ^ first->lport;
+#ifdef CONFIG_NET_IPv6
+  int i;
+#endif
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (first->domain == PF_INET)
+#endif
+    {
+      hash ^= uaddr->ipv4.raddr;
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      for (i = 0; i < 8; i += 2)
+        {
+          hash ^= ((uint32_t)uaddr->ipv6.raddr[i] << 16) |
+                  uaddr->ipv6.raddr[i + 1];
+        }
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+#endif /* CONFIG_NET_SOCKOPTS */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_selectlistener
+ *
+ * Description:
+ *   Given the listener found by tcp_findlistener() for a new connection,
+ *   pick the member of its SO_REUSEPORT group that handles the connection.
+ *   The choice is a hash of the 4-tuple, so the SYN, the ACK and the
+ *   timeout of one connection all reach the same listener as long as the
+ *   group does not change.
+ *
+ * Assumptions:
+ *   This function is called from network logic with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SOCKOPTS
+FAR struct tcp_conn_s *
+  tcp_selectlistener(FAR struct tcp_conn_s *listener,
+                     FAR union ip_binding_u *uaddr, uint16_t rport)
+{
+  FAR struct tcp_conn_s *conn;
+  uint32_t count = 0;
+  uint32_t hash;
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  FAR dq_queue_t *bucket;
+  FAR dq_entry_t *node;
+#else
+  int ndx;
+#endif
+
+  if (listener == NULL ||
+      !_SO_GETOPT(listener->sconn.s_options, SO_REUSEPORT))
+    {
+      return listener;
+    }
+
+  /* Count the members of the group, then pick one by the hash.  Both
+   * passes visit the listeners in the same order.
+   */
+
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  bucket = &g_tcp_listen_hash[TCP_PORT_HASH(listener->lport)];
+
+  for (node = dq_peek(bucket); node != NULL; node = dq_next(node))
+#else
+  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+#endif
+    {
+#ifdef CONFIG_NET_TCP_CONN_HASH
+      conn = container_of(node, struct tcp_conn_s, lnode);
+#else
+      conn = tcp_listenports[ndx];
+#endif
+      if (tcp_samegroup(listener, conn))
+        {
+          count++;
+        }
+    }
+
+  hash = tcp_listenhash(listener, uaddr, rport) % count;
+
+#ifdef CONFIG_NET_TCP_CONN_HASH
+  for (node = dq_peek(bucket); node != NULL; node = dq_next(node))
+#else
+  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+#endif
+    {
+#ifdef CONFIG_NET_TCP_CONN_HASH
+      conn = container_of(node, struct tcp_conn_s, lnode);
+#else
+      conn = tcp_listenports[ndx];
+#endif
+      if (tcp_samegroup(listener, conn) && hash-- == 0)
+        {
+          return conn;
+        }
+    }
+
+  return listener;
+}
+#endif
+
 /****************************************************************************
  * Name: tcp_unlisten
  *
@@ -167,6 +365,10 @@ int tcp_unlisten(FAR struct tcp_conn_s *conn)
       if (tcp_listenports[ndx] == conn)
         {
           tcp_listenports[ndx] = NULL;
+#ifdef CONFIG_NET_TCP_CONN_HASH
+          dq_rem(&conn->lnode,
+                 &g_tcp_listen_hash[TCP_PORT_HASH(conn->lport)]);
+#endif
           ret = OK;
           break;
         }
@@ -189,6 +391,7 @@ int tcp_unlisten(FAR struct tcp_conn_s *conn)
 
 int tcp_listen(FAR struct tcp_conn_s *conn)
 {
+  FAR struct tcp_conn_s *listener;
   int ndx;
   int ret;
 
@@ -198,13 +401,27 @@ int tcp_listen(FAR struct tcp_conn_s *conn)
 
   net_lock();
 
-  /* First, check if there is already a socket listening on this port */
+  /* First, check if there is already a socket listening on this port.
+   * If both sockets have SO_REUSEPORT, the new one joins the group of the
+   * existing one instead.
+   */
 
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
-  if (tcp_islistener(&conn->u, conn->lport, conn->domain))
+  listener = tcp_findlistener(&conn->u, conn->lport, conn->domain);
 #else
-  if (tcp_islistener(&conn->u, conn->lport))
+  listener = tcp_findlistener(&conn->u, conn->lport);
 #endif
+
+#ifdef CONFIG_NET_SOCKOPTS
+  if (listener != NULL &&
+      _SO_GETOPT(listener->sconn.s_options, SO_REUSEPORT) &&
+      _SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT))
+    {
+      listener = NULL;
+    }
+#endif
+
+  if (listener != NULL)
     {
       /* Yes, then we must refuse this request */
 
@@ -229,6 +446,10 @@ int tcp_listen(FAR struct tcp_conn_s *conn)
               /* Yes.. we found it */
 
               tcp_listenports[ndx] = conn;
+#ifdef CONFIG_NET_TCP_CONN_HASH
+              dq_addlast(&conn->lnode,
+                         &g_tcp_listen_hash[TCP_PORT_HASH(conn->lport)]);
+#endif
               ret = OK;
               break;
             }
@@ -290,6 +511,7 @@ int tcp_accept_connection(FAR struct net_driver_s *dev,
 #else
   listener = tcp_findlistener(&conn->u, portno);
 #endif
+  listener = tcp_selectlistener(listener, &conn->u, conn->rport);
   if (listener != NULL)
     {
       /* Yes, there is a listener.  Is it accepting connections now? */
@@ -184,10 +184,16 @@ static void tcp_sendcommon(FAR struct net_driver_s *dev,
                         IP_PROTO_TCP, dev->d_ipv6addr, conn->u.ipv6.raddr,
                         conn->sconn.ttl, conn->sconn.s_tclass);
 
-      /* Calculate TCP checksum. */
+      /* Calculate TCP checksum, unless the device does it. */
+
+      netdev_offload_gso(dev, IPv6_HDRLEN, conn->mss);
+      if (!netdev_offload_txcsum(dev, IP_PROTO_TCP, IPv6_HDRLEN,
+                                 &tcp->tcpchksum))
+        {
+          tcp->tcpchksum = 0;
+          tcp->tcpchksum = ~tcp_ipv6_chksum(dev);
+        }
 
-      tcp->tcpchksum = 0;
-      tcp->tcpchksum = ~tcp_ipv6_chksum(dev);
 #ifdef CONFIG_NET_STATISTICS
       g_netstats.ipv6.sent++;
 #endif
@@ -204,10 +210,16 @@ static void tcp_sendcommon(FAR struct net_driver_s *dev,
                         &dev->d_ipaddr, &conn->u.ipv4.raddr,
                         conn->sconn.ttl, conn->sconn.s_tos, NULL);
 
-      /* Calculate TCP checksum. */
+      /* Calculate TCP checksum, unless the device does it. */
+
+      netdev_offload_gso(dev, IPv4_HDRLEN, conn->mss);
+      if (!netdev_offload_txcsum(dev, IP_PROTO_TCP, IPv4_HDRLEN,
+                                 &tcp->tcpchksum))
+        {
+          tcp->tcpchksum = 0;
+          tcp->tcpchksum = ~tcp_ipv4_chksum(dev);
+        }
 
-      tcp->tcpchksum = 0;
-      tcp->tcpchksum = ~tcp_ipv4_chksum(dev);
 #ifdef CONFIG_NET_STATISTICS
       g_netstats.ipv4.sent++;
 #endif
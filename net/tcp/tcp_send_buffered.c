@@ -1008,12 +1008,16 @@ static uint16_t psock_send_eventhandler(FAR struct net_driver_s *dev,
       if (TCP_SEQ_LT(seq, snd_wnd_edge))
         {
           uint32_t remaining_snd_wnd;
+          uint32_t maxseg;
           int ret;
 
+          /* Send up to a whole super-segment if the device cuts it */
+
+          maxseg = netdev_offload_maxseg(dev, conn->mss);
           sndlen = TCP_WBPKTLEN(wrb) - TCP_WBSENT(wrb);
-          if (sndlen > conn->mss)
+          if (sndlen > maxseg)
             {
-              sndlen = conn->mss;
+              sndlen = maxseg;
             }
 
           remaining_snd_wnd = TCP_SEQ_SUB(snd_wnd_edge, seq);
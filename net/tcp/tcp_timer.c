@@ -535,6 +535,8 @@ void tcp_timer(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn)
 #else
                   listener = tcp_findlistener(&conn->u, conn->lport);
 #endif
+                  listener = tcp_selectlistener(listener, &conn->u,
+                                                conn->rport);
                   if (listener != NULL)
                     {
                       /* We call tcp_callback() for the connection with
@@ -73,6 +73,12 @@
 
 #define _UDP_ISCONNECTMODE(f) (((f) & _UDP_FLAG_CONNECTMODE) != 0)
 
+#ifdef CONFIG_NET_UDP_CONN_HASH
+/* The bucket of a local port (network byte order) in the port hash */
+
+#  define UDP_PORT_HASH(p)    (NTOHS(p) % CONFIG_NET_UDP_CONN_HASHSIZE)
+#endif
+
 /* This is a helper pointer for accessing the contents of the udp header */
 
 #define UDPIPv4BUF ((FAR struct udp_hdr_s *)IPBUF(IPv4_HDRLEN))
@@ -117,6 +123,10 @@ struct udp_conn_s
   uint8_t  domain;        /* IP domain: PF_INET or PF_INET6 */
   uint8_t  crefs;         /* Reference counts on this instance */
 
+#ifdef CONFIG_NET_UDP_CONN_HASH
+  dq_entry_t pnode;       /* Link in the local port hash */
+#endif
+
 #if CONFIG_NET_RECV_BUFSIZE > 0
   int32_t  rcvbufs;       /* Maximum amount of bytes queued in recv */
 #endif
@@ -248,6 +258,22 @@ FAR struct udp_conn_s *udp_active(FAR struct net_driver_s *dev,
 
 FAR struct udp_conn_s *udp_nextconn(FAR struct udp_conn_s *conn);
 
+/****************************************************************************
+ * Name: udp_setport
+ *
+ * Description:
+ *   Set the local port of a UDP connection.  All assignments of lport go
+ *   through here so that the connection is kept in the right bucket of the
+ *   local port hash.
+ *
+ * Input Parameters:
+ *   conn   - The UDP connection
+ *   portno - The new local port (network byte order), zero to unbind
+ *
+ ****************************************************************************/
+
+void udp_setport(FAR struct udp_conn_s *conn, uint16_t portno);
+
 /****************************************************************************
  * Name: udp_select_port
  *
@@ -546,7 +572,7 @@ void udp_wrbuffer_release(FAR struct udp_wrbuffer_s *wrb);
  *   conn - The UDP connection of interest
  *
  * Assumptions:
- *   Called from user logic with the network locked.
+ *   Called from user logic with the connection locked.
  *
  ****************************************************************************/
 
@@ -711,6 +737,28 @@ uint16_t udp_callback(FAR struct net_driver_s *dev,
 ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
                            int flags);
 
+/****************************************************************************
+ * Name: psock_udp_recvmmsg
+ *
+ * Description:
+ *   Take the datagrams that are already queued in the read-ahead buffers
+ *   of a UDP socket, with one acquisition of the connection lock.  Never
+ *   waits.
+ *
+ * Input Parameters:
+ *   psock    Pointer to the socket structure for the SOCK_DRAM socket
+ *   msgvec   Buffers to receive the datagrams
+ *   vlen     The number of buffers in msgvec
+ *   flags    Receive flags
+ *
+ * Returned Value:
+ *   The number of datagrams received, zero if none is queued.
+ *
+ ****************************************************************************/
+
+int psock_udp_recvmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                       unsigned int vlen, int flags);
+
 /****************************************************************************
  * Name: psock_udp_sendto
  *
@@ -740,6 +788,32 @@ ssize_t psock_udp_sendto(FAR struct socket *psock,
                          FAR const void *buf, size_t len, int flags,
                          FAR const struct sockaddr *to, socklen_t tolen);
 
+/****************************************************************************
+ * Name: psock_udp_sendmmsg
+ *
+ * Description:
+ *   Send several datagrams.  Their write buffers are prepared one by one,
+ *   then added to the write queue together, with one acquisition of the
+ *   connection lock and of the network lock.
+ *
+ * Input Parameters:
+ *   psock    A pointer to a NuttX-specific, internal socket structure
+ *   msgvec   The datagrams to send.  msg_len is set for each one sent.
+ *   vlen     The number of datagrams in msgvec
+ *   flags    Send flags
+ *
+ * Returned Value:
+ *   The number of datagrams sent.  If the first one cannot be sent, a
+ *   negated errno value.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_UDP_WRITE_BUFFERS
+int psock_udp_sendmmsg(FAR struct socket *psock,
+                       FAR struct mmsghdr *msgvec, unsigned int vlen,
+                       int flags);
+#endif
+
 /****************************************************************************
  * Name: udp_pollsetup
  *
@@ -283,7 +283,8 @@ net_dataevent(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn,
  *   OK if packet has been processed, otherwise ERROR.
  *
  * Assumptions:
- *   This function must be called with the network locked.
+ *   This function must be called with the network locked.  The connection
+ *   is locked here while its callbacks run.
  *
  ****************************************************************************/
 
@@ -296,6 +297,12 @@ uint16_t udp_callback(FAR struct net_driver_s *dev,
 
   if (conn)
     {
+      /* The callbacks and the read-ahead buffering below both touch the
+       * connection buffers.
+       */
+
+      conn_lock(&conn->sconn);
+
       /* Perform the callback */
 
       flags = devif_conn_event(dev, flags, conn->sconn.list);
@@ -306,6 +313,8 @@ uint16_t udp_callback(FAR struct net_driver_s *dev,
 
           flags = net_dataevent(dev, conn, flags);
         }
+
+      conn_unlock(&conn->sconn);
     }
 
   return flags;
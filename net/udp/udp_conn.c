@@ -89,10 +89,193 @@ static mutex_t g_free_lock = NXMUTEX_INITIALIZER;
 
 static dq_queue_t g_active_udp_connections;
 
+#ifdef CONFIG_NET_UDP_CONN_HASH
+/* The bound connections hashed by the local port */
+
+static dq_queue_t g_udp_port_hash[CONFIG_NET_UDP_CONN_HASHSIZE];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: udp_nextport
+ *
+ * Description:
+ *   Traverse the UDP connections which may be bound to the local port
+ *   portno (network byte order):  those in the same bucket of the port
+ *   hash, or all connections without the hash.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+static inline FAR struct udp_conn_s *
+  udp_nextport(FAR struct udp_conn_s *conn, uint16_t portno)
+{
+#ifdef CONFIG_NET_UDP_CONN_HASH
+  FAR dq_entry_t *node;
+
+  if (!conn)
+    {
+      node = dq_peek(&g_udp_port_hash[UDP_PORT_HASH(portno)]);
+    }
+  else
+    {
+      node = dq_next(&conn->pnode);
+    }
+
+  return node ? container_of(node, struct udp_conn_s, pnode) : NULL;
+#else
+  UNUSED(portno);
+  return udp_nextconn(conn);
+#endif
+}
+
+#ifdef CONFIG_NET_SOCKOPTS
+
+/****************************************************************************
+ * Name: udp_hash
+ *
+ * Description:
+ *   Hash the addresses and ports of a received datagram.  This selects the
+ *   member of a SO_REUSEPORT group that receives the datagram, so all
+ *   datagrams of one flow go to the same socket.
+ *
+ ****************************************************************************/
+
+static inline uint32_t udp_hash(uint32_t addr, uint16_t srcport,
+                                uint16_t destport)
+{
+  uint32_t hash = addr ^ ((uint32_t)srcport << 16) ^ destport;
+
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name: udp_hash_ipv6addr
+ *
+ * Description:
+ *   Fold an IPv6 address into 32 bits for udp_hash().
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv6
+static inline uint32_t udp_hash_ipv6addr(FAR const uint16_t *addr)
+{
+  uint32_t hash = 0;
+  int i;
+
+  for (i = 0; i < 8; i += 2)
+    {
+      hash ^= ((uint32_t)addr[i] << 16) | addr[i + 1];
+    }
+
+  return hash;
+}
+#endif
+
+/****************************************************************************
+ * Name: udp_reuseport
+ *
+ * Description:
+ *   Return true if conn takes part in a SO_REUSEPORT group:  it has the
+ *   option set and is not connected to a peer.  A connected socket only
+ *   receives the datagrams of its peer and is never load-balanced.
+ *
+ ****************************************************************************/
+
+static inline bool udp_reuseport(FAR struct udp_conn_s *conn)
+{
+  return _SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT) &&
+         !_UDP_ISCONNECTMODE(conn->flags);
+}
+
+/****************************************************************************
+ * Name: udp_samegroup
+ *
+ * Description:
+ *   Return true if conn is in the same SO_REUSEPORT group as first:  the
+ *   same domain, local port and local address.
+ *
+ ****************************************************************************/
+
+static bool udp_samegroup(FAR struct udp_conn_s *first,
+                          FAR struct udp_conn_s *conn)
+{
+  if (conn->lport != first->lport || conn->domain != first->domain ||
+      !udp_reuseport(conn))
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (first->domain == PF_INET)
+#endif
+    {
+      return net_ipv4addr_cmp(conn->u.ipv4.laddr, first->u.ipv4.laddr);
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      return net_ipv6addr_cmp(conn->u.ipv6.laddr, first->u.ipv6.laddr);
+    }
+#endif /* CONFIG_NET_IPv6 */
+}
+
+/****************************************************************************
+ * Name: udp_selectgroup
+ *
+ * Description:
+ *   first is the first connection that matches a received datagram and is
+ *   in a SO_REUSEPORT group.  Pick the member of the group that receives
+ *   the datagram from the flow hash.
+ *
+ *   All members match the datagram in the same way as first, so none of
+ *   them precedes first in the traversal.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+static FAR struct udp_conn_s *
+  udp_selectgroup(FAR struct udp_conn_s *first, uint32_t hash)
+{
+  FAR struct udp_conn_s *conn;
+  uint32_t count = 0;
+
+  for (conn = first; conn != NULL; conn = udp_nextport(conn, first->lport))
+    {
+      if (udp_samegroup(first, conn))
+        {
+          count++;
+        }
+    }
+
+  hash %= count;
+
+  for (conn = first; ; conn = udp_nextport(conn, first->lport))
+    {
+      if (udp_samegroup(first, conn) && hash-- == 0)
+        {
+          return conn;
+        }
+    }
+}
+#endif /* CONFIG_NET_SOCKOPTS */
+
 /****************************************************************************
  * Name: udp_find_conn()
  *
@@ -105,6 +288,7 @@ static dq_queue_t g_active_udp_connections;
  *   portno - The port to use in the lookup
  *   opt    - The option from another conn to match the conflict conn
  *              SO_REUSEADDR: If both sockets have this, they never confilct.
+ *              SO_REUSEPORT: If both sockets have this, they never confilct.
  *
  * Assumptions:
  *   This function must be called with the network locked.
@@ -118,18 +302,22 @@ static FAR struct udp_conn_s *udp_find_conn(uint8_t domain,
   FAR struct udp_conn_s *conn = NULL;
 #ifdef CONFIG_NET_SOCKOPTS
   bool skip_reusable = _SO_GETOPT(opt, SO_REUSEADDR);
+  bool skip_reuseport = _SO_GETOPT(opt, SO_REUSEPORT);
 #endif
 
   /* Now search each connection structure. */
 
-  while ((conn = udp_nextconn(conn)) != NULL)
+  while ((conn = udp_nextport(conn, portno)) != NULL)
     {
-      /* With SO_REUSEADDR set for both sockets, we do not need to check its
-       * address and port.
+      /* With SO_REUSEADDR (or SO_REUSEPORT) set for both sockets, we do not
+       * need to check its address and port.
        */
 
 #ifdef CONFIG_NET_SOCKOPTS
-      if (skip_reusable && _SO_GETOPT(conn->sconn.s_options, SO_REUSEADDR))
+      if ((skip_reusable &&
+           _SO_GETOPT(conn->sconn.s_options, SO_REUSEADDR)) ||
+          (skip_reuseport &&
+           _SO_GETOPT(conn->sconn.s_options, SO_REUSEPORT)))
         {
           continue;
         }
@@ -195,7 +383,7 @@ static inline FAR struct udp_conn_s *
   FAR struct ipv4_hdr_s *ip = IPv4BUF;
   FAR struct udp_conn_s *conn;
 
-  conn = (FAR struct udp_conn_s *)g_active_udp_connections.head;
+  conn = udp_nextport(NULL, udp->destport);
   while (conn)
     {
       /* If the local UDP port is non-zero, the connection is considered
@@ -308,8 +496,20 @@ static inline FAR struct udp_conn_s *
 
       /* Look at the next active connection */
 
-      conn = (FAR struct udp_conn_s *)conn->sconn.node.flink;
+      conn = udp_nextport(conn, udp->destport);
+    }
+
+#ifdef CONFIG_NET_SOCKOPTS
+  /* Spread the flows to a SO_REUSEPORT group over its members */
+
+  if (conn != NULL && udp_reuseport(conn))
+    {
+      conn = udp_selectgroup(conn,
+               udp_hash(net_ip4addr_conv32(ip->srcipaddr) ^
+                        net_ip4addr_conv32(ip->destipaddr),
+                        udp->srcport, udp->destport));
     }
+#endif
 
   return conn;
 }
@@ -334,7 +534,7 @@ static inline FAR struct udp_conn_s *
   FAR struct ipv6_hdr_s *ip = IPv6BUF;
   FAR struct udp_conn_s *conn;
 
-  conn = (FAR struct udp_conn_s *)g_active_udp_connections.head;
+  conn = udp_nextport(NULL, udp->destport);
   while (conn != NULL)
     {
       /* If the local UDP port is non-zero, the connection is considered
@@ -447,9 +647,21 @@ static inline FAR struct udp_conn_s *
 
       /* Look at the next active connection */
 
-      conn = (FAR struct udp_conn_s *)conn->sconn.node.flink;
+      conn = udp_nextport(conn, udp->destport);
     }
 
+#ifdef CONFIG_NET_SOCKOPTS
+  /* Spread the flows to a SO_REUSEPORT group over its members */
+
+  if (conn != NULL && udp_reuseport(conn))
+    {
+      conn = udp_selectgroup(conn,
+               udp_hash(udp_hash_ipv6addr(ip->srcipaddr) ^
+                        udp_hash_ipv6addr(ip->destipaddr),
+                        udp->srcport, udp->destport));
+    }
+#endif
+
   return conn;
 }
 #endif /* CONFIG_NET_IPv6 */
@@ -582,6 +794,42 @@ uint16_t udp_select_port(uint8_t domain, FAR union ip_binding_u *u)
   return portno;
 }
 
+/****************************************************************************
+ * Name: udp_setport
+ *
+ * Description:
+ *   Set the local port of a UDP connection.  All assignments of lport go
+ *   through here so that the connection is kept in the right bucket of the
+ *   local port hash.
+ *
+ * Input Parameters:
+ *   conn   - The UDP connection
+ *   portno - The new local port (network byte order), zero to unbind
+ *
+ ****************************************************************************/
+
+void udp_setport(FAR struct udp_conn_s *conn, uint16_t portno)
+{
+  net_lock();
+
+#ifdef CONFIG_NET_UDP_CONN_HASH
+  /* Only the connections with a local port are in the hash */
+
+  if (conn->lport != 0)
+    {
+      dq_rem(&conn->pnode, &g_udp_port_hash[UDP_PORT_HASH(conn->lport)]);
+    }
+
+  if (portno != 0)
+    {
+      dq_addlast(&conn->pnode, &g_udp_port_hash[UDP_PORT_HASH(portno)]);
+    }
+#endif
+
+  conn->lport = portno;
+  net_unlock();
+}
+
 /****************************************************************************
  * Name: udp_initialize
  *
@@ -642,6 +890,7 @@ FAR struct udp_conn_s *udp_alloc(uint8_t domain)
       conn->domain    = domain;
 #endif
       conn->lport     = 0;
+      nxrmutex_init(&conn->sconn.s_lock);
 #if CONFIG_NET_RECV_BUFSIZE > 0
       conn->rcvbufs   = CONFIG_NET_RECV_BUFSIZE;
 #endif
@@ -685,12 +934,16 @@ void udp_free(FAR struct udp_conn_s *conn)
   DEBUGASSERT(conn->crefs == 0);
 
   nxmutex_lock(&g_free_lock);
-  conn->lport = 0;
+  udp_setport(conn, 0);
 
   /* Remove the connection from the active list */
 
   dq_rem(&conn->sconn.node, &g_active_udp_connections);
 
+  /* Wait for any user of the connection buffers to leave */
+
+  conn_lock(&conn->sconn);
+
   /* Release any read-ahead buffers attached to the connection, NULL is ok */
 
   iob_free_chain(conn->readahead);
@@ -712,6 +965,9 @@ void udp_free(FAR struct udp_conn_s *conn)
 
 #endif
 
+  conn_unlock(&conn->sconn);
+  nxrmutex_destroy(&conn->sconn.s_lock);
+
   /* Free the connection.
    * If this is a preallocated or a batch allocated connection store it in
    * the free connections list. Else free it.
@@ -916,8 +1172,8 @@ int udp_bind(FAR struct udp_conn_s *conn, FAR const struct sockaddr *addr)
     {
       /* Yes.. Select any unused local port number */
 
-      conn->lport = HTONS(udp_select_port(conn->domain, &conn->u));
-      ret         = OK;
+      udp_setport(conn, HTONS(udp_select_port(conn->domain, &conn->u)));
+      ret = OK;
     }
   else
     {
@@ -945,12 +1201,12 @@ int udp_bind(FAR struct udp_conn_s *conn, FAR const struct sockaddr *addr)
         {
           /* No.. then bind the socket to the port */
 
-          conn->lport = portno;
-          ret         = OK;
+          udp_setport(conn, portno);
+          ret = OK;
         }
       else
         {
-          ret         = -EADDRINUSE;
+          ret = -EADDRINUSE;
         }
 
       net_unlock();
@@ -998,7 +1254,7 @@ int udp_connect(FAR struct udp_conn_s *conn, FAR const struct sockaddr *addr)
        * connection structure.
        */
 
-      conn->lport = HTONS(udp_select_port(conn->domain, &conn->u));
+      udp_setport(conn, HTONS(udp_select_port(conn->domain, &conn->u)));
     }
 
   /* Is there a remote port (rport)? */
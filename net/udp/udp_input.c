@@ -121,7 +121,7 @@ static int udp_input(FAR struct net_driver_s *dev, unsigned int iplen)
   dev->d_appdata = IPBUF(udpiplen);
 
 #ifdef CONFIG_NET_UDP_CHECKSUMS
-  chksum = udp->udpchksum;
+  chksum = NETDEV_CSUM_TRUSTED(dev) ? 0 : udp->udpchksum;
   if (chksum != 0)
     {
 #ifdef CONFIG_NET_IPv6
@@ -117,7 +117,9 @@ int udp_ioctl(FAR struct udp_conn_s *conn, int cmd, unsigned long arg)
   FAR struct iob_s *iob;
   int ret = OK;
 
-  net_lock();
+  /* Everything reported here lives in the connection itself */
+
+  conn_lock(&conn->sconn);
 
   switch (cmd)
     {
@@ -155,7 +157,7 @@ int udp_ioctl(FAR struct udp_conn_s *conn, int cmd, unsigned long arg)
         break;
     }
 
-  net_unlock();
+  conn_unlock(&conn->sconn);
 
   return ret;
 }
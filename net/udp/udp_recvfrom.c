@@ -520,7 +520,7 @@ static void udp_recvfrom_initialize(FAR struct udp_conn_s *conn,
  *   Evaluate the result of the recv operations
  *
  * Input Parameters:
- *   result   The result of the net_sem_timedwait operation
+ *   result   The result of the conn_sem_timedwait operation
  *            (may indicate EINTR)
  *   pstate   A pointer to the state structure to be initialized
  *
@@ -546,8 +546,8 @@ static ssize_t udp_recvfrom_result(int result, struct udp_recvfrom_s *pstate)
       return pstate->ir_result;
     }
 
-  /* If net_sem_timedwait failed, then we were probably reawakened by a
-   * signal. In this case, net_sem_timedwait will have returned negated
+  /* If conn_sem_timedwait failed, then we were probably reawakened by a
+   * signal. In this case, conn_sem_timedwait will have returned negated
    * errno appropriately.
    */
 
@@ -591,15 +591,14 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
 
   /* Perform the UDP recvfrom() operation */
 
-  /* Initialize the state structure.  This is done with the network locked
-   * because we don't want anything to happen until we are ready.
-   */
-
-  net_lock();
   udp_recvfrom_initialize(conn, msg, &state, flags);
 
-  /* Copy the read-ahead data from the packet */
+  /* Copy the read-ahead data from the packet.  The read-ahead buffer is
+   * protected by the connection lock, so datagrams that have already been
+   * queued are consumed without taking the network lock.
+   */
 
+  conn_lock(&conn->sconn);
   udp_readahead(&state);
 
   /* The default return value is the number of bytes that we just copied
@@ -636,50 +635,156 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
 
   else if (state.ir_recvlen <= 0)
     {
-      /* Get the device that will handle the packet transfers.  This may be
-       * NULL if the UDP socket is bound to INADDR_ANY.  In that case, no
-       * NETDEV_DOWN notifications will be received.
+      /* Setting up the callback needs the network lock, which must be
+       * taken before the connection lock.  Another datagram may have been
+       * queued while the connection was unlocked, so check again.
        */
 
-      dev = udp_find_laddr_device(conn);
+      conn_unlock(&conn->sconn);
+      net_lock();
+      conn_lock(&conn->sconn);
 
-      /* Set up the callback in the connection */
+      udp_readahead(&state);
+      ret = state.ir_recvlen;
 
-      state.ir_cb = udp_callback_alloc(dev, conn);
-      if (state.ir_cb)
+      if (state.ir_recvlen <= 0)
         {
+          /* Get the device that will handle the packet transfers.  This may
+           * be NULL if the UDP socket is bound to INADDR_ANY.  In that
+           * case, no NETDEV_DOWN notifications will be received.
+           */
+
+          dev = udp_find_laddr_device(conn);
+
           /* Set up the callback in the connection */
 
-          state.ir_cb->flags = (UDP_NEWDATA | NETDEV_DOWN);
-          state.ir_cb->priv  = (FAR void *)&state;
-          state.ir_cb->event = udp_eventhandler;
+          state.ir_cb = udp_callback_alloc(dev, conn);
+          if (state.ir_cb)
+            {
+              /* Set up the callback in the connection */
+
+              state.ir_cb->flags = (UDP_NEWDATA | NETDEV_DOWN);
+              state.ir_cb->priv  = (FAR void *)&state;
+              state.ir_cb->event = udp_eventhandler;
 
-          /* Wait for either the receive to complete or for an error/timeout
-           * to occur.  net_sem_timedwait will also terminate if a signal is
-           * received.
-           */
+              /* Wait for either the receive to complete or for an
+               * error/timeout to occur.  conn_sem_timedwait will also
+               * terminate if a signal is received.
+               */
+
+              ret = conn_sem_timedwait(&conn->sconn, &state.ir_sem,
+                                       _SO_TIMEOUT(conn->sconn.s_rcvtimeo));
+              if (ret == -ETIMEDOUT)
+                {
+                  ret = -EAGAIN;
+                }
+
+              /* Make sure that no further events are processed */
 
-          ret = net_sem_timedwait(&state.ir_sem,
-                              _SO_TIMEOUT(conn->sconn.s_rcvtimeo));
-          if (ret == -ETIMEDOUT)
+              udp_callback_free(dev, conn, state.ir_cb);
+              ret = udp_recvfrom_result(ret, &state);
+            }
+          else
             {
-              ret = -EAGAIN;
+              ret = -EBUSY;
             }
+        }
 
-          /* Make sure that no further events are processed */
+      net_unlock();
+    }
 
-          udp_callback_free(dev, conn, state.ir_cb);
-          ret = udp_recvfrom_result(ret, &state);
-        }
-      else
+  conn_unlock(&conn->sconn);
+  udp_recvfrom_uninitialize(&state);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: psock_udp_recvmmsg
+ *
+ * Description:
+ *   Take the datagrams that are already queued in the read-ahead buffers
+ *   of a UDP socket, with one acquisition of the connection lock.  Never
+ *   waits.
+ *
+ * Input Parameters:
+ *   psock    Pointer to the socket structure for the SOCK_DRAM socket
+ *   msgvec   Buffers to receive the datagrams
+ *   vlen     The number of buffers in msgvec
+ *   flags    Receive flags
+ *
+ * Returned Value:
+ *   The number of datagrams received, zero if none is queued.  A buffer
+ *   that psock_recvmsg() would refuse ends the batch, so that the error is
+ *   reported by the next call.
+ *
+ ****************************************************************************/
+
+int psock_udp_recvmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                       unsigned int vlen, int flags)
+{
+  FAR struct udp_conn_s *conn = psock->s_conn;
+  struct udp_recvfrom_s state;
+  unsigned long msg_controllen;
+  FAR struct msghdr *msg;
+  FAR void *msg_control;
+  unsigned int count;
+  socklen_t minlen;
+
+  /* Peeking would return the same datagram again and again */
+
+  if ((flags & MSG_PEEK) != 0)
+    {
+      return 0;
+    }
+
+#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
+  minlen = conn->domain == PF_INET ? sizeof(struct sockaddr_in) :
+                                     sizeof(struct sockaddr_in6);
+#elif defined(CONFIG_NET_IPv4)
+  minlen = sizeof(struct sockaddr_in);
+#else
+  minlen = sizeof(struct sockaddr_in6);
+#endif
+
+  /* No wait is needed, so the state is only set up once and without the
+   * semaphore.
+   */
+
+  memset(&state, 0, sizeof(state));
+  state.ir_conn  = conn;
+  state.ir_flags = flags;
+
+  conn_lock(&conn->sconn);
+
+  for (count = 0; count < vlen && conn->readahead != NULL; count++)
+    {
+      msg = &msgvec[count].msg_hdr;
+
+      /* The checks of psock_recvmsg() and inet_recvmsg() */
+
+      if (msg->msg_iov == NULL || msg->msg_iov->iov_base == NULL ||
+          msg->msg_iovlen != 1 ||
+          (msg->msg_name != NULL && msg->msg_namelen < minlen))
         {
-          ret = -EBUSY;
+          break;
         }
+
+      msg_control    = msg->msg_control;
+      msg_controllen = msg->msg_controllen;
+
+      state.ir_msg = msg;
+      udp_readahead(&state);
+
+      /* Recover the pointer and calculate the cmsg's true data length */
+
+      msg->msg_control    = msg_control;
+      msg->msg_controllen = msg_controllen - msg->msg_controllen;
+
+      msgvec[count].msg_len = state.ir_recvlen;
     }
 
-  net_unlock();
-  udp_recvfrom_uninitialize(&state);
-  return ret;
+  conn_unlock(&conn->sconn);
+  return count;
 }
 
 #endif /* CONFIG_NET && CONFIG_NET_UDP */
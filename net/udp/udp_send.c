@@ -58,6 +58,7 @@
 
 #include "devif/devif.h"
 #include "inet/inet.h"
+#include "netdev/netdev.h"
 #include "utils/utils.h"
 #include "udp/udp.h"
 
@@ -186,7 +187,11 @@ void udp_send(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn)
            ip6_is_ipv4addr((FAR struct in6_addr *)conn->u.ipv6.raddr)))
 #endif
         {
-          udp->udpchksum = ~udp_ipv4_chksum(dev);
+          if (!netdev_offload_txcsum(dev, IP_PROTO_UDP, IPv4_HDRLEN,
+                                     &udp->udpchksum))
+            {
+              udp->udpchksum = ~udp_ipv4_chksum(dev);
+            }
         }
 #endif /* CONFIG_NET_IPv4 */
 
@@ -195,7 +200,11 @@ void udp_send(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn)
       else
 #endif
         {
-          udp->udpchksum = ~udp_ipv6_chksum(dev);
+          if (!netdev_offload_txcsum(dev, IP_PROTO_UDP, IPv6_HDRLEN,
+                                     &udp->udpchksum))
+            {
+              udp->udpchksum = ~udp_ipv6_chksum(dev);
+            }
         }
 #endif /* CONFIG_NET_IPv6 */
 
@@ -262,7 +262,7 @@ static int sendto_next_transfer(FAR struct udp_conn_s *conn)
        * connection structure.
        */
 
-      conn->lport = HTONS(udp_select_port(conn->domain, &conn->u));
+      udp_setport(conn, HTONS(udp_select_port(conn->domain, &conn->u)));
     }
 
   /* Get the device that will handle the remote packet transfers.  This
@@ -369,10 +369,13 @@ static uint16_t sendto_eventhandler(FAR struct net_driver_s *dev,
       ninfo("Device down: %04x\n", flags);
 
       /* Free the write buffer at the head of the queue and attempt to setup
-       * the next transfer.
+       * the next transfer.  Device events do not come through
+       * udp_callback(), so the connection is not locked yet.
        */
 
+      conn_lock(&conn->sconn);
       sendto_writebuffer_release(conn);
+      conn_unlock(&conn->sconn);
       return flags;
     }
 
@@ -497,51 +500,102 @@ static unsigned int udp_send_gettimeout(clock_t start, unsigned int timeout)
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: sendto_checkaddr
+ *
+ * Description:
+ *   Check a destination address as inet_sendto() does for sendto().
+ *
  ****************************************************************************/
 
+static int sendto_checkaddr(FAR const struct sockaddr *to, socklen_t tolen)
+{
+  socklen_t minlen;
+
+  if (to == NULL)
+    {
+      return OK;
+    }
+
+  switch (to->sa_family)
+    {
+#ifdef CONFIG_NET_IPv4
+    case AF_INET:
+      minlen = sizeof(struct sockaddr_in);
+      break;
+#endif
+
+#ifdef CONFIG_NET_IPv6
+    case AF_INET6:
+      minlen = sizeof(struct sockaddr_in6);
+      break;
+#endif
+
+    default:
+      nerr("ERROR: Unrecognized address family: %d\n", to->sa_family);
+      return -EAFNOSUPPORT;
+    }
+
+  if (tolen < minlen || tolen > sizeof(struct sockaddr_storage))
+    {
+      nerr("ERROR: Invalid address length: %d\n", tolen);
+      return -EBADF;
+    }
+
+  return OK;
+}
+
 /****************************************************************************
- * Name: psock_udp_sendto
+ * Name: sendto_prepare
  *
  * Description:
- *   This function implements the UDP-specific logic of the standard
- *   sendto() socket operation.
+ *   Check a datagram and copy it into a new write buffer.  The write buffer
+ *   is private to the caller until sendto_enqueue() queues it, so no lock
+ *   is held while it is allocated and filled.
  *
  * Input Parameters:
  *   psock    A pointer to a NuttX-specific, internal socket structure
- *   buf      Data to send
- *   len      Length of data to send
+ *   iov      The data to send
+ *   iovcnt   The number of elements in iov
  *   flags    Send flags
  *   to       Address of recipient
  *   tolen    The length of the address structure
- *
- *   NOTE: All input parameters were verified by sendto() before this
- *   function was called.
+ *   pending  Bytes prepared by the caller that are not queued yet
+ *   wrbp     Location to return the write buffer, NULL for an empty
+ *            datagram
  *
  * Returned Value:
- *   On success, returns the number of characters sent.  On  error,
- *   a negated errno value is returned.  See the description in
- *   net/socket/sendto.c for the list of appropriate return value.
+ *   The length of the datagram on success.  On error, a negated errno
+ *   value.
  *
  ****************************************************************************/
 
-ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
-                         size_t len, int flags,
-                         FAR const struct sockaddr *to, socklen_t tolen)
+static ssize_t sendto_prepare(FAR struct socket *psock,
+                              FAR const struct iovec *iov, int iovcnt,
+                              int flags, FAR const struct sockaddr *to,
+                              socklen_t tolen, size_t pending,
+                              FAR struct udp_wrbuffer_s **wrbp)
 {
   FAR struct udp_wrbuffer_s *wrb;
   FAR struct udp_conn_s *conn;
   unsigned int timeout;
   uint16_t udpiplen;
+  size_t len = 0;
   bool nonblock;
-  bool empty;
   int ret = OK;
   clock_t start;
+  int i;
+
+  *wrbp = NULL;
 
   /* Get the underlying the UDP connection structure.  */
 
   conn = psock->s_conn;
 
+  for (i = 0; i < iovcnt; i++)
+    {
+      len += iov[i].iov_len;
+    }
+
   /* The length of a datagram to be up to 65,535 octets */
 
   if (len > 65535)
@@ -665,216 +719,427 @@ ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
     }
 #endif /* CONFIG_NET_ARP_SEND || CONFIG_NET_ICMPv6_NEIGHBOR */
 
+  if (len == 0)
+    {
+      return 0;
+    }
+
   nonblock = _SS_ISNONBLOCK(conn->sconn.s_flags) ||
                             (flags & MSG_DONTWAIT) != 0;
   start    = clock_systime_ticks();
   timeout  = _SO_TIMEOUT(conn->sconn.s_sndtimeo);
 
-  /* Dump the incoming buffer */
-
-  BUF_DUMP("psock_udp_sendto", buf, len);
-
-  if (len > 0)
-    {
-      net_lock();
-
 #if CONFIG_NET_SEND_BUFSIZE > 0
-      /* If the send buffer size exceeds the send limit,
-       * wait for the write buffer to be released
-       */
-
-      while (udp_wrbuffer_inqueue_size(conn) + len > conn->sndbufs)
-        {
-          if (nonblock)
-            {
-              ret = -EAGAIN;
-              goto errout_with_lock;
-            }
-
-          ret = net_sem_timedwait_uninterruptible(&conn->sndsem,
-            udp_send_gettimeout(start, timeout));
-          if (ret < 0)
-            {
-              if (ret == -ETIMEDOUT)
-                {
-                  ret = -EAGAIN;
-                }
-
-              goto errout_with_lock;
-            }
-        }
-#endif /* CONFIG_NET_SEND_BUFSIZE */
-
-      /* Allocate a write buffer.  Careful, the network will be momentarily
-       * unlocked here.
-       */
+  /* If the send buffer size exceeds the send limit,
+   * wait for the write buffer to be released
+   */
 
+  conn_lock(&conn->sconn);
+  while (udp_wrbuffer_inqueue_size(conn) + pending + len > conn->sndbufs)
+    {
       if (nonblock)
         {
-          wrb = udp_wrbuffer_tryalloc();
+          conn_unlock(&conn->sconn);
+          return -EAGAIN;
         }
-      else
+
+      ret = conn_sem_timedwait_uninterruptible(&conn->sconn,
+        &conn->sndsem, udp_send_gettimeout(start, timeout));
+      if (ret < 0)
         {
-          wrb = udp_wrbuffer_timedalloc(udp_send_gettimeout(start,
-                                                            timeout));
+          conn_unlock(&conn->sconn);
+          return ret == -ETIMEDOUT ? -EAGAIN : ret;
         }
+    }
 
-      if (wrb == NULL)
-        {
-          /* A buffer allocation error occurred */
+  conn_unlock(&conn->sconn);
+#else
+  UNUSED(pending);
+#endif /* CONFIG_NET_SEND_BUFSIZE */
 
-          nerr("ERROR: Failed to allocate write buffer\n");
+  /* Allocate a write buffer */
 
-          if (nonblock || timeout != UINT_MAX)
-            {
-              ret = -EAGAIN;
-            }
-          else
-            {
-              ret = -ENOMEM;
-            }
+  if (nonblock)
+    {
+      wrb = udp_wrbuffer_tryalloc();
+    }
+  else
+    {
+      wrb = udp_wrbuffer_timedalloc(udp_send_gettimeout(start, timeout));
+    }
 
-          goto errout_with_lock;
-        }
+  if (wrb == NULL)
+    {
+      /* A buffer allocation error occurred */
 
-      /* Initialize the write buffer
-       *
-       * Check if the socket is connected
-       */
+      nerr("ERROR: Failed to allocate write buffer\n");
 
-      if (_SS_ISCONNECTED(conn->sconn.s_flags))
+      if (nonblock || timeout != UINT_MAX)
         {
-          /* Yes.. get the connection address from the connection structure */
+          return -EAGAIN;
+        }
+
+      return -ENOMEM;
+    }
+
+  /* Initialize the write buffer
+   *
+   * Check if the socket is connected
+   */
+
+  if (_SS_ISCONNECTED(conn->sconn.s_flags))
+    {
+      /* Yes.. get the connection address from the connection structure */
 
 #ifdef CONFIG_NET_IPv4
 #ifdef CONFIG_NET_IPv6
-          if (conn->domain == PF_INET)
+      if (conn->domain == PF_INET)
 #endif
-            {
-              FAR struct sockaddr_in *addr4 =
-                (FAR struct sockaddr_in *)&wrb->wb_dest;
+        {
+          FAR struct sockaddr_in *addr4 =
+            (FAR struct sockaddr_in *)&wrb->wb_dest;
 
-              addr4->sin_family = AF_INET;
-              addr4->sin_port   = conn->rport;
-              net_ipv4addr_copy(addr4->sin_addr.s_addr, conn->u.ipv4.raddr);
-              memset(addr4->sin_zero, 0, sizeof(addr4->sin_zero));
-            }
+          addr4->sin_family = AF_INET;
+          addr4->sin_port   = conn->rport;
+          net_ipv4addr_copy(addr4->sin_addr.s_addr, conn->u.ipv4.raddr);
+          memset(addr4->sin_zero, 0, sizeof(addr4->sin_zero));
+        }
 #endif /* CONFIG_NET_IPv4 */
 
 #ifdef CONFIG_NET_IPv6
 #ifdef CONFIG_NET_IPv4
-          else
+      else
 #endif
-            {
-              FAR struct sockaddr_in6 *addr6 =
-                (FAR struct sockaddr_in6 *)&wrb->wb_dest;
+        {
+          FAR struct sockaddr_in6 *addr6 =
+            (FAR struct sockaddr_in6 *)&wrb->wb_dest;
 
-              addr6->sin6_family = AF_INET6;
-              addr6->sin6_port   = conn->rport;
-              net_ipv6addr_copy(addr6->sin6_addr.s6_addr,
-                                conn->u.ipv6.raddr);
-            }
-#endif /* CONFIG_NET_IPv6 */
+          addr6->sin6_family = AF_INET6;
+          addr6->sin6_port   = conn->rport;
+          net_ipv6addr_copy(addr6->sin6_addr.s6_addr,
+                            conn->u.ipv6.raddr);
         }
+#endif /* CONFIG_NET_IPv6 */
+    }
 
-      /* Not connected.  Use the provided destination address */
+  /* Not connected.  Use the provided destination address */
 
-      else
-        {
-          memcpy(&wrb->wb_dest, to, tolen);
-        }
+  else
+    {
+      memcpy(&wrb->wb_dest, to, tolen);
+    }
 
-      /* Skip l2/l3/l4 offset before copy */
+  /* Skip l2/l3/l4 offset before copy */
 
-      udpiplen = udpip_hdrsize(conn);
+  udpiplen = udpip_hdrsize(conn);
 
-      iob_reserve(wrb->wb_iob, CONFIG_NET_LL_GUARDSIZE);
-      iob_update_pktlen(wrb->wb_iob, udpiplen, false);
+  iob_reserve(wrb->wb_iob, CONFIG_NET_LL_GUARDSIZE);
+  iob_update_pktlen(wrb->wb_iob, udpiplen, false);
 
-      /* Copy the user data into the write buffer.  We cannot wait for
-       * buffer space if the socket was opened non-blocking.
-       */
+  /* Copy the user data into the write buffer.  We cannot wait for
+   * buffer space if the socket was opened non-blocking.
+   */
+
+  for (i = 0, len = 0; i < iovcnt; i++)
+    {
+      if (iov[i].iov_len == 0)
+        {
+          continue;
+        }
+
+      /* Dump the incoming buffer */
+
+      BUF_DUMP("psock_udp_sendto", iov[i].iov_base, iov[i].iov_len);
 
       if (nonblock)
         {
-          ret = iob_trycopyin(wrb->wb_iob, (FAR uint8_t *)buf,
-                              len, udpiplen, false);
+          ret = iob_trycopyin(wrb->wb_iob, iov[i].iov_base,
+                              iov[i].iov_len, udpiplen + len, false);
         }
       else
         {
-          unsigned int count;
-          int blresult;
-
-          /* iob_copyin might wait for buffers to be freed, but if
-           * network is locked this might never happen, since network
-           * driver is also locked, therefore we need to break the lock
-           */
-
-          blresult = net_breaklock(&count);
-          ret = iob_copyin(wrb->wb_iob, (FAR uint8_t *)buf,
-                           len, udpiplen, false);
-          if (blresult >= 0)
-            {
-              net_restorelock(count);
-            }
+          ret = iob_copyin(wrb->wb_iob, iov[i].iov_base,
+                           iov[i].iov_len, udpiplen + len, false);
         }
 
       if (ret < 0)
         {
-          goto errout_with_wrb;
+          udp_wrbuffer_release(wrb);
+          return ret;
         }
 
-      /* Dump I/O buffer chain */
+      len += iov[i].iov_len;
+    }
 
-      UDP_WBDUMP("I/O buffer chain", wrb, wrb->wb_iob->io_pktlen, 0);
+  /* Dump I/O buffer chain */
 
-      /* sendto_eventhandler() will send data in FIFO order from the
-       * conn->write_q.
-       *
-       * REVISIT:  Why FIFO order?  Because it is easy.  In a real world
-       * environment where there are multiple network devices this might
-       * be inefficient because we could be sending data to different
-       * device out-of-queued-order to optimize performance.  Sending
-       * data to different networks from a single UDP socket is probably
-       * not a very common use case, however.
+  UDP_WBDUMP("I/O buffer chain", wrb, wrb->wb_iob->io_pktlen, 0);
+
+  *wrbp = wrb;
+  return len;
+}
+
+/****************************************************************************
+ * Name: sendto_enqueue
+ *
+ * Description:
+ *   Add prepared write buffers to the write queue of the connection and,
+ *   if the queue was empty, set up the transfer of its head.
+ *
+ * Input Parameters:
+ *   conn   The UDP connection of interest
+ *   queue  The write buffers to add, in order.  Emptied on success.
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  On failure, a negated errno value and the
+ *   write buffers are still in queue.
+ *
+ ****************************************************************************/
+
+static int sendto_enqueue(FAR struct udp_conn_s *conn,
+                          FAR sq_queue_t *queue)
+{
+  bool empty;
+  int ret;
+
+  /* sendto_eventhandler() will send data in FIFO order from the
+   * conn->write_q.
+   *
+   * REVISIT:  Why FIFO order?  Because it is easy.  In a real world
+   * environment where there are multiple network devices this might
+   * be inefficient because we could be sending data to different
+   * device out-of-queued-order to optimize performance.  Sending
+   * data to different networks from a single UDP socket is probably
+   * not a very common use case, however.
+   *
+   * If the write queue is not empty, the transfer of its head is
+   * already set up and the new buffers will be picked up when the
+   * buffers ahead of them have been sent.  Only the connection lock is
+   * needed in that case.
+   */
+
+  conn_lock(&conn->sconn);
+  if (!sq_empty(&conn->write_q))
+    {
+      sq_cat(queue, &conn->write_q);
+      conn_unlock(&conn->sconn);
+      return OK;
+    }
+
+  conn_unlock(&conn->sconn);
+
+  /* Setting up the transfer needs the network lock, which must be
+   * taken before the connection lock.
+   */
+
+  net_lock();
+  conn_lock(&conn->sconn);
+
+  empty = sq_empty(&conn->write_q);
+
+  sq_cat(queue, &conn->write_q);
+  ninfo("Queued write_q(%p,%p)\n", conn->write_q.head, conn->write_q.tail);
+
+  if (empty)
+    {
+      /* The new write buffers lie at the head of the write queue.  Set
+       * up for the next packet transfer by setting the connection
+       * address to the address of the next packet now at the header of
+       * the write buffer queue.
        */
 
-      empty = sq_empty(&conn->write_q);
+      ret = sendto_next_transfer(conn);
+      if (ret < 0)
+        {
+          sq_move(&conn->write_q, queue);
+          conn_unlock(&conn->sconn);
+          net_unlock();
+          return ret;
+        }
+    }
 
-      sq_addlast(&wrb->wb_node, &conn->write_q);
-      ninfo("Queued WRB=%p pktlen=%u write_q(%p,%p)\n",
-            wrb, wrb->wb_iob->io_pktlen,
-            conn->write_q.head, conn->write_q.tail);
+  conn_unlock(&conn->sconn);
+  net_unlock();
+  return OK;
+}
 
-      if (empty)
+/****************************************************************************
+ * Name: sendto_release
+ *
+ * Description:
+ *   Release the write buffers of a queue that could not be queued.
+ *
+ ****************************************************************************/
+
+static void sendto_release(FAR sq_queue_t *queue)
+{
+  FAR struct udp_wrbuffer_s *wrb;
+
+  while ((wrb = (FAR struct udp_wrbuffer_s *)sq_remfirst(queue)) != NULL)
+    {
+      udp_wrbuffer_release(wrb);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psock_udp_sendto
+ *
+ * Description:
+ *   This function implements the UDP-specific logic of the standard
+ *   sendto() socket operation.
+ *
+ * Input Parameters:
+ *   psock    A pointer to a NuttX-specific, internal socket structure
+ *   buf      Data to send
+ *   len      Length of data to send
+ *   flags    Send flags
+ *   to       Address of recipient
+ *   tolen    The length of the address structure
+ *
+ *   NOTE: All input parameters were verified by sendto() before this
+ *   function was called.
+ *
+ * Returned Value:
+ *   On success, returns the number of characters sent.  On  error,
+ *   a negated errno value is returned.  See the description in
+ *   net/socket/sendto.c for the list of appropriate return value.
+ *
+ ****************************************************************************/
+
+ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
+                         size_t len, int flags,
+                         FAR const struct sockaddr *to, socklen_t tolen)
+{
+  FAR struct udp_wrbuffer_s *wrb;
+  struct iovec iov;
+  sq_queue_t queue;
+  ssize_t ret;
+  int err;
+
+  iov.iov_base = (FAR void *)buf;
+  iov.iov_len  = len;
+
+  ret = sendto_prepare(psock, &iov, 1, flags, to, tolen, 0, &wrb);
+  if (ret <= 0)
+    {
+      return ret;
+    }
+
+  sq_init(&queue);
+  sq_addlast(&wrb->wb_node, &queue);
+
+  err = sendto_enqueue(psock->s_conn, &queue);
+  if (err < 0)
+    {
+      sendto_release(&queue);
+      return err;
+    }
+
+  /* Return the number of bytes that will be sent */
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: psock_udp_sendmmsg
+ *
+ * Description:
+ *   Send several datagrams.  Their write buffers are prepared one by one,
+ *   then added to the write queue together, with one acquisition of the
+ *   connection lock and of the network lock.
+ *
+ *   While prepared datagrams are held, the next one is prepared without
+ *   waiting.  If it would have to wait, the held datagrams are queued first
+ *   so that the wait can end.
+ *
+ * Input Parameters:
+ *   psock    A pointer to a NuttX-specific, internal socket structure
+ *   msgvec   The datagrams to send.  msg_len is set for each one sent.
+ *   vlen     The number of datagrams in msgvec
+ *   flags    Send flags
+ *
+ * Returned Value:
+ *   The number of datagrams sent.  If the first one cannot be sent, a
+ *   negated errno value.
+ *
+ ****************************************************************************/
+
+int psock_udp_sendmmsg(FAR struct socket *psock,
+                       FAR struct mmsghdr *msgvec, unsigned int vlen,
+                       int flags)
+{
+  FAR struct udp_wrbuffer_s *wrb;
+  FAR struct msghdr *msg;
+  unsigned int first = 0;
+  unsigned int count = 0;
+  sq_queue_t queue;
+  size_t pending = 0;
+  ssize_t ret = 0;
+
+  sq_init(&queue);
+
+  while (count < vlen)
+    {
+      msg = &msgvec[count].msg_hdr;
+      if (msg->msg_iov == NULL || msg->msg_iov->iov_base == NULL)
         {
-          /* The new write buffer lies at the head of the write queue.  Set
-           * up for the next packet transfer by setting the connection
-           * address to the address of the next packet now at the header of
-           * the write buffer queue.
-           */
+          ret = -EINVAL;
+          break;
+        }
 
-          ret = sendto_next_transfer(conn);
+      ret = sendto_checkaddr(msg->msg_name, msg->msg_namelen);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      ret = sendto_prepare(psock, msg->msg_iov, msg->msg_iovlen,
+                           sq_empty(&queue) ? flags : flags | MSG_DONTWAIT,
+                           msg->msg_name, msg->msg_namelen, pending, &wrb);
+      if (ret == -EAGAIN && !sq_empty(&queue))
+        {
+          /* Queue the datagrams held so far, then try again */
+
+          ret = sendto_enqueue(psock->s_conn, &queue);
           if (ret < 0)
             {
-              sq_remlast(&conn->write_q);
-              goto errout_with_wrb;
+              count = first;
+              break;
             }
-        }
 
-      net_unlock();
-    }
+          first   = count;
+          pending = 0;
+          continue;
+        }
+      else if (ret < 0)
+        {
+          break;
+        }
 
-  /* Return the number of bytes that will be sent */
+      if (wrb != NULL)
+        {
+          sq_addlast(&wrb->wb_node, &queue);
+          pending += ret;
+        }
 
-  return len;
+      msgvec[count++].msg_len = ret;
+    }
 
-errout_with_wrb:
-  udp_wrbuffer_release(wrb);
+  if (!sq_empty(&queue))
+    {
+      ret = sendto_enqueue(psock->s_conn, &queue);
+      if (ret < 0)
+        {
+          count = first;
+        }
+    }
 
-errout_with_lock:
-  net_unlock();
-  return ret;
+  sendto_release(&queue);
+  return count > 0 ? (int)count : (int)ret;
 }
 
 /****************************************************************************
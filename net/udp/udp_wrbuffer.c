@@ -315,7 +315,7 @@ void udp_wrbuffer_release(FAR struct udp_wrbuffer_s *wrb)
  *   conn - The UDP connection of interest
  *
  * Assumptions:
- *   Called from user logic with the network locked.
+ *   Called from user logic with the connection locked.
  *
  ****************************************************************************/
 
@@ -27,66 +27,196 @@
 
 #include "utils/utils.h"
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: chksum_add
+ *
+ * Description:
+ *   Add two 16-bit values in one's complement arithmetic.
+ *
+ ****************************************************************************/
+
+static inline uint16_t chksum_add(uint16_t a, uint16_t b)
+{
+  uint32_t sum = (uint32_t)a + b;
+
+  return (uint16_t)((sum & 0xffff) + (sum >> 16));
+}
+
+/****************************************************************************
+ * Name: chksum_swap
+ *
+ * Description:
+ *   Swap the bytes of a 16-bit partial sum.  The one's complement sum is
+ *   byte order independent, so this converts a sum of 16-bit words read in
+ *   native byte order into the network byte order one or back, and also
+ *   fixes up a sum which started at an odd position of the data.
+ *
+ ****************************************************************************/
+
+static inline uint16_t chksum_swap(uint16_t sum)
+{
+  return (uint16_t)((sum << 8) | (sum >> 8));
+}
+
+/****************************************************************************
+ * Name: chksum_block
+ *
+ * Description:
+ *   Sum one I/O buffer of an iob chain like chksum_partial().  If only
+ *   CONFIG_NET_ARCH_CHKSUM is defined, the architecture-specific chksum()
+ *   is used, so that the iob path benefits from it as well.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_IOB
+static inline uint16_t chksum_block(FAR const uint8_t *data, uint16_t len)
+{
+#if defined(CONFIG_NET_ARCH_CHKSUM) && \
+    !defined(CONFIG_NET_ARCH_CHKSUM_PARTIAL)
+  return HTONS(chksum(0, data, len));
+#else
+  return chksum_partial(data, len);
+#endif
+}
+#endif /* CONFIG_MM_IOB */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
 /****************************************************************************
- * Name: chksum
+ * Name: chksum_partial
  *
  * Description:
- *   Calculate the raw change sum over the memory region described by
- *   data and len.
+ *   Calculate the 16-bit one's complement sum over the memory region
+ *   described by data and len.  The data is read as 16-bit words in native
+ *   byte order, paired from the first byte regardless of its alignment.
+ *
+ *   The data is summed as aligned 32-bit words into a 64-bit accumulator,
+ *   so the carries are folded only once at the end.
  *
  * Input Parameters:
- *   sum  - Partial calculations carried over from a previous call to
- *          chksum().  This should be zero on the first time that check
- *          sum is called.
  *   data - Beginning of the data to include in the checksum.
  *   len  - Length of the data to include in the checksum.
  *
  * Returned Value:
- *   The updated checksum value.
+ *   The folded, uncomplemented sum in native byte order.
  *
  ****************************************************************************/
 
-#ifndef CONFIG_NET_ARCH_CHKSUM
-uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
+#ifndef CONFIG_NET_ARCH_CHKSUM_PARTIAL
+uint16_t chksum_partial(FAR const uint8_t *data, size_t len)
 {
-  FAR const uint8_t *dataptr;
-  FAR const uint8_t *last_byte;
-  uint16_t t;
+  FAR const uint32_t *data32;
+  uint64_t sum = 0;
+  bool odd;
+
+  if (len == 0)
+    {
+      return 0;
+    }
 
-  dataptr = data;
-  last_byte = data + len - 1;
+  /* Align to a 16-bit boundary.  The leading byte then becomes the second
+   * byte of a word and the final sum is swapped back below.
+   */
 
-  while (dataptr < last_byte)
+  odd = ((uintptr_t)data & 1) != 0;
+  if (odd)
     {
-      /* At least two more bytes */
+#ifdef CONFIG_ENDIAN_BIG
+      sum = *data;
+#else
+      sum = (uint16_t)*data << 8;
+#endif
+      data++;
+      len--;
+    }
 
-      t = ((uint16_t)dataptr[0] << 8) + dataptr[1];
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
+  /* Align to a 32-bit boundary */
 
-      dataptr += 2;
+  if (len >= 2 && ((uintptr_t)data & 2) != 0)
+    {
+      sum  += *(FAR const uint16_t *)data;
+      data += 2;
+      len  -= 2;
     }
 
-  if (dataptr == last_byte)
+  /* Loop while there are at least 128-bits left */
+
+  data32 = (FAR const uint32_t *)data;
+  while (len >= 16)
     {
-      t = (dataptr[0] << 8) + 0;
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
+      sum += data32[0];
+      sum += data32[1];
+      sum += data32[2];
+      sum += data32[3];
+      data32 += 4;
+      len    -= 16;
+    }
+
+  while (len >= 4)
+    {
+      sum += *data32++;
+      len -= 4;
+    }
+
+  data = (FAR const uint8_t *)data32;
+  if (len >= 2)
+    {
+      sum  += *(FAR const uint16_t *)data;
+      data += 2;
+      len  -= 2;
     }
 
+  if (len > 0)
+    {
+#ifdef CONFIG_ENDIAN_BIG
+      sum += (uint16_t)*data << 8;
+#else
+      sum += *data;
+#endif
+    }
+
+  /* Fold the 64-bit accumulator into 16 bits */
+
+  sum = (sum & 0xffffffff) + (sum >> 32);
+  sum = (sum & 0xffffffff) + (sum >> 32);
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+
+  return odd ? chksum_swap((uint16_t)sum) : (uint16_t)sum;
+}
+#endif /* CONFIG_NET_ARCH_CHKSUM_PARTIAL */
+
+/****************************************************************************
+ * Name: chksum
+ *
+ * Description:
+ *   Calculate the raw change sum over the memory region described by
+ *   data and len.
+ *
+ * Input Parameters:
+ *   sum  - Partial calculations carried over from a previous call to
+ *          chksum().  This should be zero on the first time that check
+ *          sum is called.
+ *   data - Beginning of the data to include in the checksum.
+ *   len  - Length of the data to include in the checksum.
+ *
+ * Returned Value:
+ *   The updated checksum value.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NET_ARCH_CHKSUM
+uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
+{
   /* Return sum in host byte order. */
 
-  return sum;
+  return chksum_add(sum, NTOHS(chksum_partial(data, len)));
 }
 #endif /* CONFIG_NET_ARCH_CHKSUM */
 
@@ -96,6 +226,11 @@ uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
  * Description:
  *   Calculate the Internet checksum over an iob chain buffer.
  *
+ *   The buffers are summed as one stream, so a buffer with an odd length
+ *   doesn't restart the 16-bit pairing of the following data.  Each buffer
+ *   is summed by chksum_partial(), or by chksum() if only
+ *   CONFIG_NET_ARCH_CHKSUM is defined.
+ *
  * Input Parameters:
  *   sum    - Partial calculations carried over from a previous call to
  *            chksum().  This should be zero on the first time that check
@@ -111,6 +246,9 @@ uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
 #ifdef CONFIG_MM_IOB
 uint16_t chksum_iob(uint16_t sum, FAR struct iob_s *iob, uint16_t offset)
 {
+  uint16_t partial = 0;
+  bool odd = false;
+
   /* Skip to the I/O buffer containing the data offset */
 
   while (iob != NULL && offset > iob->io_len)
@@ -125,13 +263,20 @@ uint16_t chksum_iob(uint16_t sum, FAR struct iob_s *iob, uint16_t offset)
 
   while (iob != NULL)
     {
-      sum = chksum(sum, iob->io_data + iob->io_offset + offset,
-                   iob->io_len - offset);
-      iob = iob->io_flink;
-      offset = 0;
+      uint16_t len = iob->io_len - offset;
+      uint16_t tmp;
+
+      tmp = chksum_block(iob->io_data + iob->io_offset + offset, len);
+
+      /* Data following an odd number of bytes is paired the other way */
+
+      partial = chksum_add(partial, odd ? chksum_swap(tmp) : tmp);
+      odd    ^= (len & 1) != 0;
+      iob     = iob->io_flink;
+      offset  = 0;
     }
 
-  return sum;
+  return chksum_add(sum, NTOHS(partial));
 }
 #endif /* CONFIG_MM_IOB */
 
@@ -37,6 +37,7 @@
 #include <nuttx/sched.h>
 #include <nuttx/mm/iob.h>
 #include <nuttx/net/net.h>
+#include <nuttx/net/netdev.h>
 
 #include "utils/utils.h"
 
@@ -112,6 +113,33 @@ _net_timedwait(sem_t *sem, bool interruptible, unsigned int timeout)
   return ret;
 }
 
+/****************************************************************************
+ * Name: _conn_timedwait
+ ****************************************************************************/
+
+static int _conn_timedwait(FAR struct socket_conn_s *conn, FAR sem_t *sem,
+                           bool interruptible, unsigned int timeout)
+{
+  unsigned int count;
+  int          blresult;
+  int          ret;
+
+  /* Release the connection lock first, then wait while also releasing the
+   * network lock.  _net_timedwait() recovers the network lock before we
+   * recover the connection lock, preserving the lock ordering.
+   */
+
+  blresult = nxrmutex_breaklock(&conn->s_lock, &count);
+  ret      = _net_timedwait(sem, interruptible, timeout);
+
+  if (blresult >= 0)
+    {
+      nxrmutex_restorelock(&conn->s_lock, count);
+    }
+
+  return ret;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -386,6 +414,134 @@ int net_sem_wait_uninterruptible(sem_t *sem)
   return net_sem_timedwait_uninterruptible(sem, UINT_MAX);
 }
 
+/****************************************************************************
+ * Name: netdev_lock
+ *
+ * Description:
+ *   Take the lock of one network device.  The network lock may already be
+ *   held by the caller, the device configuration keeps it across the wait.
+ *
+ * Input Parameters:
+ *   dev - The network device to be locked.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int netdev_lock(FAR struct net_driver_s *dev)
+{
+  return nxrmutex_lock(&dev->d_lock);
+}
+
+/****************************************************************************
+ * Name: netdev_unlock
+ *
+ * Description:
+ *   Release the lock of one network device.
+ *
+ * Input Parameters:
+ *   dev - The network device to be unlocked.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void netdev_unlock(FAR struct net_driver_s *dev)
+{
+  nxrmutex_unlock(&dev->d_lock);
+}
+
+/****************************************************************************
+ * Name: conn_lock
+ *
+ * Description:
+ *   Take the lock of one connection.
+ *
+ * Input Parameters:
+ *   conn - The connection to be locked.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int conn_lock(FAR struct socket_conn_s *conn)
+{
+  return nxrmutex_lock(&conn->s_lock);
+}
+
+/****************************************************************************
+ * Name: conn_unlock
+ *
+ * Description:
+ *   Release the lock of one connection.
+ *
+ * Input Parameters:
+ *   conn - The connection to be unlocked.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void conn_unlock(FAR struct socket_conn_s *conn)
+{
+  nxrmutex_unlock(&conn->s_lock);
+}
+
+/****************************************************************************
+ * Name: conn_sem_timedwait
+ *
+ * Description:
+ *   Atomically wait for sem (or a timeout) while temporarily releasing
+ *   both the connection lock and, if it is held, the network lock.
+ *
+ * Input Parameters:
+ *   conn    - The connection whose lock is held by the caller.
+ *   sem     - A reference to the semaphore to be taken.
+ *   timeout - The relative time to wait until a timeout is declared.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int conn_sem_timedwait(FAR struct socket_conn_s *conn, FAR sem_t *sem,
+                       unsigned int timeout)
+{
+  return _conn_timedwait(conn, sem, true, timeout);
+}
+
+/****************************************************************************
+ * Name: conn_sem_timedwait_uninterruptible
+ *
+ * Description:
+ *   This function is wrapped version of conn_sem_timedwait(), which is
+ *   uninterruptible and convenient for use.
+ *
+ * Input Parameters:
+ *   conn    - The connection whose lock is held by the caller.
+ *   sem     - A reference to the semaphore to be taken.
+ *   timeout - The relative time to wait until a timeout is declared.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int conn_sem_timedwait_uninterruptible(FAR struct socket_conn_s *conn,
+                                       FAR sem_t *sem,
+                                       unsigned int timeout)
+{
+  return _conn_timedwait(conn, sem, false, timeout);
+}
+
 #ifdef CONFIG_MM_IOB
 
 /****************************************************************************
@@ -195,6 +195,13 @@ static inline void nx_workqueues(void)
 
 #endif /* CONFIG_SCHED_LPWORK */
 
+#ifdef CONFIG_SCHED_PERCPUWORK
+  /* Start one worker thread bound to each CPU for work_queue_on() */
+
+  work_start_percpu();
+
+#endif /* CONFIG_SCHED_PERCPUWORK */
+
 #ifdef CONFIG_LIBC_USRWORK
   /* Start the user-space work queue */
 
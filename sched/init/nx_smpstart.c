@@ -78,6 +78,10 @@ void nx_idle_trampoline(void)
 
   for (; ; )
     {
+      /* Pick up any ready-to-run task left behind for this CPU */
+
+      nxsched_idle_steal();
+
       /* Perform any processor-specific idle state operations */
 
       up_idle();
@@ -419,7 +419,7 @@ void nx_start(void)
 #else
       tasklist = TLIST_HEAD(&g_idletcb[i].cmn);
 #endif
-      dq_addfirst((FAR dq_entry_t *)&g_idletcb[i], tasklist);
+      nxsched_addfirst_prioritized(&g_idletcb[i].cmn, tasklist);
 
       /* Mark the idle task as the running task */
 
@@ -705,6 +705,10 @@ void nx_start(void)
 #ifndef CONFIG_DISABLE_IDLE_LOOP
   for (; ; )
     {
+      /* Pick up any ready-to-run task left behind for this CPU */
+
+      nxsched_idle_steal();
+
       /* Perform any processor-specific idle state operations */
 
       up_idle();
@@ -68,7 +68,7 @@ static void collect_deadlock(FAR struct tcb_s *tcb, FAR void *arg)
               pid_t next;
               size_t i;
 
-              next = ((FAR mutex_t *)sem)->holder;
+              next = nxmutex_get_holder((FAR mutex_t *)sem);
               for (i = info->found; i < index; i++)
                 {
                   if (info->pid[i] == next)
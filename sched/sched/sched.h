@@ -91,6 +91,14 @@
 #  define TLIST_BLOCKED(t)       __TLIST_HEAD(t)
 #endif
 
+/* Geometry of the ready-to-run priority bitmap */
+
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+#  define RTRINDEX_SHIFT         5
+#  define RTRINDEX_MASK          ((1 << RTRINDEX_SHIFT) - 1)
+#  define RTRINDEX_NWORDS        ((SCHED_PRIORITY_MAX >> RTRINDEX_SHIFT) + 1)
+#endif
+
 #ifdef CONFIG_SCHED_CRITMONITOR_MAXTIME_PANIC
 #  define CRITMONITOR_PANIC(fmt, ...) \
           do \
@@ -117,6 +125,21 @@ struct tasklist_s
   uint8_t attr;          /* List attribute flags */
 };
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+/* This structure indexes a prioritized ready-to-run list.  The list itself
+ * stays sorted by priority, so the TCBs of each priority form a contiguous
+ * FIFO run.  The bitmap records which priorities have a run in the list
+ * and tail[] points to the last TCB of each run so that a TCB can be
+ * inserted behind its peers without walking the list.
+ */
+
+struct rtrindex_s
+{
+  uint32_t bitmap[RTRINDEX_NWORDS];               /* Priorities present */
+  FAR struct tcb_s *tail[SCHED_PRIORITY_MAX + 1]; /* Last TCB of each run */
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -328,6 +351,28 @@ int nxthread_create(FAR const char *name, uint8_t ttype, int priority,
 bool nxsched_add_readytorun(FAR struct tcb_s *rtrtcb);
 bool nxsched_remove_readytorun(FAR struct tcb_s *rtrtcb, bool merge);
 bool nxsched_add_prioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list);
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+void nxsched_remove_prioritized(FAR struct tcb_s *tcb, FAR dq_queue_t *list);
+void nxsched_addfirst_prioritized(FAR struct tcb_s *tcb,
+                                  FAR dq_queue_t *list);
+void nxsched_sethead_priority(FAR struct tcb_s *tcb, FAR dq_queue_t *list,
+                              uint8_t priority);
+FAR struct rtrindex_s *nxsched_rtrindex(FAR dq_queue_t *list);
+FAR struct tcb_s *nxsched_rtrindex_prev(FAR struct rtrindex_s *index,
+                                        uint8_t priority);
+void nxsched_rtrindex_insert(FAR struct rtrindex_s *index,
+                             FAR struct tcb_s *tcb);
+void nxsched_rtrindex_remove(FAR struct rtrindex_s *index,
+                             FAR struct tcb_s *tcb);
+void nxsched_rtrindex_reset(FAR struct rtrindex_s *index);
+#else
+#  define nxsched_remove_prioritized(tcb,list) \
+     dq_rem((FAR dq_entry_t *)(tcb), list)
+#  define nxsched_addfirst_prioritized(tcb,list) \
+     dq_addfirst((FAR dq_entry_t *)(tcb), list)
+#  define nxsched_sethead_priority(tcb,list,priority) \
+     ((void)(list), (tcb)->sched_priority = (priority))
+#endif
 void nxsched_merge_prioritized(FAR dq_queue_t *list1, FAR dq_queue_t *list2,
                                uint8_t task_state);
 bool nxsched_merge_pending(void);
@@ -384,6 +429,16 @@ void nxsched_suspend(FAR struct tcb_s *tcb);
 FAR struct tcb_s *this_task(void);
 
 int  nxsched_select_cpu(cpu_set_t affinity);
+#ifdef CONFIG_SCHED_CPUSELECT_LOAD
+int  nxsched_select_tcbcpu(FAR struct tcb_s *tcb);
+#else
+#  define nxsched_select_tcbcpu(tcb) nxsched_select_cpu((tcb)->affinity)
+#endif
+#ifdef CONFIG_SCHED_IDLE_STEAL
+void nxsched_idle_steal(void);
+#else
+#  define nxsched_idle_steal()
+#endif
 int  nxsched_pause_cpu(FAR struct tcb_s *tcb);
 
 #  define nxsched_islocked_global() spin_is_locked(&g_cpu_schedlock)
@@ -391,6 +446,8 @@ int  nxsched_pause_cpu(FAR struct tcb_s *tcb);
 
 #else
 #  define nxsched_select_cpu(a)     (0)
+#  define nxsched_select_tcbcpu(t)  (0)
+#  define nxsched_idle_steal()
 #  define nxsched_pause_cpu(t)      (-38)  /* -ENOSYS */
 #  define nxsched_islocked_tcb(tcb) ((tcb)->lockcount > 0)
 #endif
@@ -66,6 +66,9 @@ bool nxsched_add_prioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
 {
   FAR struct tcb_s *next;
   FAR struct tcb_s *prev;
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  FAR struct rtrindex_s *index;
+#endif
   uint8_t sched_priority = tcb->sched_priority;
   bool ret = false;
 
@@ -73,13 +76,29 @@ bool nxsched_add_prioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
 
   DEBUGASSERT(sched_priority >= SCHED_PRIORITY_MIN);
 
-  /* Search the list to find the location to insert the new Tcb.
-   * Each is list is maintained in descending sched_priority order.
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  /* The ready-to-run lists are indexed by priority.  The new TCB goes just
+   * after the last TCB of equal or higher priority, which the index gives
+   * us without walking the list.
    */
 
-  for (next = (FAR struct tcb_s *)list->head;
-       (next && sched_priority <= next->sched_priority);
-       next = next->flink);
+  index = nxsched_rtrindex(list);
+  if (index != NULL)
+    {
+      prev = nxsched_rtrindex_prev(index, sched_priority);
+      next = prev != NULL ? prev->flink : (FAR struct tcb_s *)list->head;
+    }
+  else
+#endif
+    {
+      /* Search the list to find the location to insert the new Tcb.
+       * Each is list is maintained in descending sched_priority order.
+       */
+
+      for (next = (FAR struct tcb_s *)list->head;
+           (next && sched_priority <= next->sched_priority);
+           next = next->flink);
+    }
 
   /* Add the tcb to the spot found in the list.  Check if the tcb
    * goes at the end of the list. NOTE:  This could only happen if list
@@ -137,5 +156,12 @@ bool nxsched_add_prioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
         }
     }
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  if (index != NULL)
+    {
+      nxsched_rtrindex_insert(index, tcb);
+    }
+#endif
+
   return ret;
 }
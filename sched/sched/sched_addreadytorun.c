@@ -173,7 +173,7 @@ bool nxsched_add_readytorun(FAR struct tcb_s *btcb)
        * (possibly its IDLE task).
        */
 
-      cpu = nxsched_select_cpu(btcb->affinity);
+      cpu = nxsched_select_tcbcpu(btcb);
     }
 
   /* Get the task currently running on the CPU (may be the IDLE task) */
@@ -327,7 +327,7 @@ bool nxsched_add_readytorun(FAR struct tcb_s *btcb)
             {
               /* Remove the task from the assigned task list */
 
-              dq_rem((FAR dq_entry_t *)next, tasklist);
+              nxsched_remove_prioritized(next, tasklist);
 
               /* Add the task to the g_readytorun or to the g_pendingtasks
                * list.  NOTE: That the above operations may cause the
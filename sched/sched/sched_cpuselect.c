@@ -28,6 +28,7 @@
 #include <assert.h>
 
 #include <nuttx/sched.h>
+#include <nuttx/queue.h>
 
 #include "sched/sched.h"
 
@@ -39,6 +40,123 @@
 
 #define IMPOSSIBLE_CPU 0xff
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUSELECT_LOAD
+/****************************************************************************
+ * Name:  nxsched_cpu_nready
+ *
+ * Description:
+ *   Return the number of tasks assigned to a CPU, not counting its IDLE
+ *   task.
+ *
+ ****************************************************************************/
+
+static inline int nxsched_cpu_nready(int cpu)
+{
+  return (int)dq_count(&g_assignedtasks[cpu]) - 1;
+}
+
+/****************************************************************************
+ * Name:  nxsched_cpu_idleticks
+ *
+ * Description:
+ *   Return the recent run time of the IDLE task of a CPU.  A larger value
+ *   means a CPU that has been less busy.  The IDLE task is always the last
+ *   task in the assigned task list.
+ *
+ ****************************************************************************/
+
+static inline uint32_t nxsched_cpu_idleticks(int cpu)
+{
+#ifdef CONFIG_SCHED_CPULOAD
+  return ((FAR struct tcb_s *)g_assignedtasks[cpu].tail)->ticks;
+#else
+  return 0;
+#endif
+}
+
+/****************************************************************************
+ * Name:  nxsched_select_load
+ *
+ * Description:
+ *   Load aware CPU selection.  Priority still comes first:  only CPUs
+ *   running the lowest priority task (possibly their IDLE task) are
+ *   candidates, so the highest priority ready tasks are always the ones
+ *   running.  Among the candidates, prefer the CPU with the fewest
+ *   assigned tasks and then the one that has been idle the most.  The
+ *   previous CPU of the task wins if it is a candidate and is not carrying
+ *   more than CONFIG_SCHED_CPUSELECT_IMBALANCE extra tasks.
+ *
+ * Input Parameters:
+ *   affinity - The set of CPUs on which the thread is permitted to run.
+ *   prevcpu  - The CPU on which the thread last ran or -1 if none.
+ *
+ * Returned Value:
+ *   Index of the selected CPU
+ *
+ ****************************************************************************/
+
+static int nxsched_select_load(cpu_set_t affinity, int prevcpu)
+{
+  uint32_t maxidle = 0;
+  uint32_t idle;
+  uint8_t minprio = SCHED_PRIORITY_MAX;
+  uint8_t prio;
+  int minready = 0;
+  int prevready = 0;
+  int nready;
+  int cpu = IMPOSSIBLE_CPU;
+  int i;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      /* Is the thread permitted to run on this CPU? */
+
+      if ((affinity & (1 << i)) == 0)
+        {
+          continue;
+        }
+
+      prio   = current_task(i)->sched_priority;
+      nready = nxsched_cpu_nready(i);
+      idle   = nxsched_cpu_idleticks(i);
+
+      if (i == prevcpu)
+        {
+          prevready = nready;
+        }
+
+      if (cpu == IMPOSSIBLE_CPU || prio < minprio ||
+          (prio == minprio &&
+           (nready < minready || (nready == minready && idle > maxidle))))
+        {
+          minprio  = prio;
+          minready = nready;
+          maxidle  = idle;
+          cpu      = i;
+        }
+    }
+
+  DEBUGASSERT(cpu != IMPOSSIBLE_CPU);
+
+  /* Stay on the previous CPU, where the cache is still warm, unless it is
+   * noticeably busier than the best candidate.
+   */
+
+  if (prevcpu >= 0 && prevcpu != cpu && (affinity & (1 << prevcpu)) != 0 &&
+      current_task(prevcpu)->sched_priority == minprio &&
+      prevready <= minready + CONFIG_SCHED_CPUSELECT_IMBALANCE)
+    {
+      cpu = prevcpu;
+    }
+
+  return cpu;
+}
+#endif /* CONFIG_SCHED_CPUSELECT_LOAD */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -63,6 +181,9 @@
 
 int nxsched_select_cpu(cpu_set_t affinity)
 {
+#ifdef CONFIG_SCHED_CPUSELECT_LOAD
+  return nxsched_select_load(affinity, -1);
+#else
   uint8_t minprio;
   int cpu;
   int i;
@@ -103,6 +224,33 @@ int nxsched_select_cpu(cpu_set_t affinity)
 
   DEBUGASSERT(cpu != IMPOSSIBLE_CPU);
   return cpu;
+#endif
+}
+
+/****************************************************************************
+ * Name:  nxsched_select_tcbcpu
+ *
+ * Description:
+ *   Select the CPU on which a ready-to-run thread should be placed.  Like
+ *   nxsched_select_cpu(), but the load aware policy also considers the CPU
+ *   on which the thread last ran.
+ *
+ * Input Parameters:
+ *   tcb - The TCB of the thread to be placed.
+ *
+ * Returned Value:
+ *   Index of the selected CPU
+ *
+ * Assumptions:
+ *   Called from within a critical section.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUSELECT_LOAD
+int nxsched_select_tcbcpu(FAR struct tcb_s *tcb)
+{
+  return nxsched_select_load(tcb->affinity, tcb->cpu);
 }
+#endif
 
 #endif /* CONFIG_SMP */
@@ -99,7 +99,7 @@ void nxsched_get_stateinfo(FAR struct tcb_s *tcb, FAR char *state,
   if (tcb->task_state == TSTATE_WAIT_SEM &&
       ((FAR sem_t *)(tcb->waitobj))->flags & SEM_TYPE_MUTEX)
     {
-      pid_t holder = ((FAR mutex_t *)(tcb->waitobj))->holder;
+      pid_t holder = nxmutex_get_holder((FAR mutex_t *)tcb->waitobj);
       leave_critical_section(flags);
 
       snprintf(state, length, "Waiting,Mutex:%d", holder);
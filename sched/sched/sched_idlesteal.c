@@ -0,0 +1,121 @@
+/****************************************************************************
+ * sched/sched/sched_idlesteal.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sched.h>
+#include <assert.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/sched.h>
+#include <nuttx/arch.h>
+
+#include "irq/irq.h"
+#include "sched/sched.h"
+
+#if defined(CONFIG_SMP) && defined(CONFIG_SCHED_IDLE_STEAL)
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxsched_idle_steal
+ *
+ * Description:
+ *   Called from the IDLE loop of each CPU.  A ready-to-run task can be left
+ *   behind in g_readytorun while a CPU idles:  for example, when the CPU
+ *   went idle while pre-emption was disabled, or when the pending task list
+ *   was merged with more tasks than there were CPUs to run them on.  If the
+ *   calling CPU is idle and g_readytorun holds a task that may run on it,
+ *   move that task onto a CPU now instead of waiting for the next
+ *   scheduling event.
+ *
+ *   Only g_readytorun is searched:  tasks in the g_assignedtasks[] lists
+ *   are locked to their CPU and cannot migrate.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxsched_idle_steal(void)
+{
+  FAR struct tcb_s *rtcb;
+  FAR struct tcb_s *tcb;
+  irqstate_t flags;
+  bool check;
+  int me;
+
+  /* Peek without the lock first.  This is the common case and keeps the
+   * IDLE loop from contending for the critical section.
+   */
+
+  if (g_readytorun.head == NULL)
+    {
+      return;
+    }
+
+  flags = enter_critical_section();
+
+  me   = this_cpu();
+  rtcb = this_task();
+
+  if (is_idle_task(rtcb) && !nxsched_islocked_global() &&
+      !irq_cpu_locked(me))
+    {
+      /* Find the highest priority task that can run on this CPU */
+
+      for (tcb = (FAR struct tcb_s *)g_readytorun.head;
+           tcb != NULL && !CPU_ISSET(me, &tcb->affinity);
+           tcb = tcb->flink);
+
+      if (tcb != NULL)
+        {
+          /* Take the task out of g_readytorun.  It is not running, so the
+           * head of no runnable list changes.
+           */
+
+          check = nxsched_remove_readytorun(tcb, false);
+          DEBUGASSERT(check == false);
+          UNUSED(check);
+
+          /* And place it again.  There is at least one idle CPU, this one,
+           * so the task will now be started on an idle CPU.
+           */
+
+          if (nxsched_add_readytorun(tcb))
+            {
+              up_switch_context(this_task(), rtcb);
+            }
+        }
+    }
+
+  leave_critical_section(flags);
+}
+
+#endif /* CONFIG_SMP && CONFIG_SCHED_IDLE_STEAL */
@@ -76,6 +76,9 @@ bool nxsched_merge_pending(void)
   FAR struct tcb_s *pnext;
   FAR struct tcb_s *rtcb;
   FAR struct tcb_s *rprev;
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  FAR struct rtrindex_s *index = nxsched_rtrindex(&g_readytorun);
+#endif
   bool ret = false;
 
   /* Initialize the inner search loop */
@@ -99,6 +102,15 @@ bool nxsched_merge_pending(void)
            * list and call nxsched_add_readytorun?
            */
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+          /* The ready-to-run list is indexed by priority:  ptcb goes just
+           * after the last TCB of equal or higher priority.
+           */
+
+          rprev = nxsched_rtrindex_prev(index, ptcb->sched_priority);
+          rtcb  = rprev != NULL ? rprev->flink :
+                  (FAR struct tcb_s *)g_readytorun.head;
+#else
           /* Search the ready-to-run list to find the location to insert the
            * new ptcb. Each is list is maintained in ascending sched_priority
            * order.
@@ -109,6 +121,7 @@ bool nxsched_merge_pending(void)
                rtcb = rtcb->flink)
             {
             }
+#endif
 
           /* Add the ptcb to the spot found in the list.  Check if the
            * ptcb goes at the ends of the ready-to-run list. This would be
@@ -144,6 +157,10 @@ bool nxsched_merge_pending(void)
               ptcb->task_state  = TSTATE_TASK_READYTORUN;
             }
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+          nxsched_rtrindex_insert(index, ptcb);
+#endif
+
           /* Set up for the next time through */
 
           rtcb = ptcb;
@@ -68,6 +68,9 @@ void nxsched_merge_prioritized(FAR dq_queue_t *list1, FAR dq_queue_t *list2,
   FAR struct tcb_s *tcb1;
   FAR struct tcb_s *tcb2;
   FAR struct tcb_s *tmp;
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  FAR struct rtrindex_s *index;
+#endif
 
   DEBUGASSERT(list1 != NULL && list2 != NULL);
 
@@ -78,6 +81,16 @@ void nxsched_merge_prioritized(FAR dq_queue_t *list1, FAR dq_queue_t *list2,
 
   dq_move(list1, &clone);
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  /* If list1 was indexed, its index is now stale */
+
+  index = nxsched_rtrindex(list1);
+  if (index != NULL)
+    {
+      nxsched_rtrindex_reset(index);
+    }
+#endif
+
   /* Get the TCB at the head of list1 */
 
   tcb1 = (FAR struct tcb_s *)dq_peek(&clone);
@@ -100,6 +113,23 @@ void nxsched_merge_prioritized(FAR dq_queue_t *list1, FAR dq_queue_t *list2,
       tmp->task_state = task_state;
     }
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  /* If list2 is indexed, insert each TCB through the index.  Each insertion
+   * is O(1) and, since list1 is sorted, TCBs of the same priority keep
+   * their relative order.
+   */
+
+  if (nxsched_rtrindex(list2) != NULL)
+    {
+      while ((tmp = (FAR struct tcb_s *)dq_remfirst(&clone)) != NULL)
+        {
+          nxsched_add_prioritized(tmp, list2);
+        }
+
+      return;
+    }
+#endif
+
   /* Get the head of list2 */
 
   tcb2 = (FAR struct tcb_s *)dq_peek(list2);
@@ -91,7 +91,7 @@ bool nxsched_remove_readytorun(FAR struct tcb_s *rtcb, bool merge)
    * is always the g_readytorun list.
    */
 
-  dq_rem((FAR dq_entry_t *)rtcb, tasklist);
+  nxsched_remove_prioritized(rtcb, tasklist);
 
   /* Since the TCB is not in any list, it is now invalid */
 
@@ -188,7 +188,7 @@ bool nxsched_remove_readytorun(FAR struct tcb_s *rtcb, bool merge)
        * or the g_assignedtasks[cpu] list.
        */
 
-      dq_rem((FAR dq_entry_t *)rtcb, tasklist);
+      nxsched_remove_prioritized(rtcb, tasklist);
 
       /* Which task will go at the head of the list?  It will be either the
        * next tcb in the assigned task list (nxttcb) or a TCB in the
@@ -225,8 +225,8 @@ bool nxsched_remove_readytorun(FAR struct tcb_s *rtcb, bool merge)
            * list and add to the head of the g_assignedtasks[cpu] list.
            */
 
-          dq_rem((FAR dq_entry_t *)rtrtcb, &g_readytorun);
-          dq_addfirst((FAR dq_entry_t *)rtrtcb, tasklist);
+          nxsched_remove_prioritized(rtrtcb, &g_readytorun);
+          nxsched_addfirst_prioritized(rtrtcb, tasklist);
 
           rtrtcb->cpu = cpu;
           nxttcb = rtrtcb;
@@ -279,7 +279,7 @@ bool nxsched_remove_readytorun(FAR struct tcb_s *rtcb, bool merge)
        * g_assignedtasks[cpu] list.
        */
 
-      dq_rem((FAR dq_entry_t *)rtcb, tasklist);
+      nxsched_remove_prioritized(rtcb, tasklist);
     }
 
   /* Since the TCB is no longer in any list, it is now invalid */
@@ -0,0 +1,309 @@
+/****************************************************************************
+ * sched/sched/sched_rtrindex.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+#include <nuttx/queue.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The index of the g_readytorun list */
+
+static struct rtrindex_s g_readytorun_index;
+
+#ifdef CONFIG_SMP
+/* The indices of the g_assignedtasks[] lists */
+
+static struct rtrindex_s g_assignedtasks_index[CONFIG_SMP_NCPUS];
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxsched_rtrindex
+ *
+ * Description:
+ *   Return the priority index associated with a task list.  Only the
+ *   ready-to-run lists are indexed.
+ *
+ * Input Parameters:
+ *   list - Points to the task list
+ *
+ * Returned Value:
+ *   The index of the list or NULL if the list is not indexed.
+ *
+ ****************************************************************************/
+
+FAR struct rtrindex_s *nxsched_rtrindex(FAR dq_queue_t *list)
+{
+  if (list == &g_readytorun)
+    {
+      return &g_readytorun_index;
+    }
+
+#ifdef CONFIG_SMP
+  if (list >= g_assignedtasks && list < &g_assignedtasks[CONFIG_SMP_NCPUS])
+    {
+      return &g_assignedtasks_index[list - g_assignedtasks];
+    }
+#endif
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxsched_rtrindex_prev
+ *
+ * Description:
+ *   Return the TCB that a new TCB of the given priority must follow in the
+ *   indexed list, i.e. the last TCB with the lowest priority that is still
+ *   greater than or equal to 'priority'.  The bitmap is searched one word
+ *   at a time so the cost is bounded by the number of priorities, not by
+ *   the number of tasks in the list.
+ *
+ * Input Parameters:
+ *   index - The index of the list
+ *   priority - The priority of the TCB to be inserted
+ *
+ * Returned Value:
+ *   The TCB to insert after or NULL if the new TCB goes at the head of the
+ *   list.
+ *
+ ****************************************************************************/
+
+FAR struct tcb_s *nxsched_rtrindex_prev(FAR struct rtrindex_s *index,
+                                        uint8_t priority)
+{
+  unsigned int word = priority >> RTRINDEX_SHIFT;
+  uint32_t bits;
+
+  bits = index->bitmap[word] & (UINT32_MAX << (priority & RTRINDEX_MASK));
+  while (bits == 0)
+    {
+      if (++word >= RTRINDEX_NWORDS)
+        {
+          return NULL;
+        }
+
+      bits = index->bitmap[word];
+    }
+
+  return index->tail[(word << RTRINDEX_SHIFT) + ffs((int)bits) - 1];
+}
+
+/****************************************************************************
+ * Name: nxsched_rtrindex_insert
+ *
+ * Description:
+ *   Account for a TCB that has just been linked into an indexed list.  The
+ *   TCB becomes the tail of its priority run if it was appended behind the
+ *   current tail or if it is the first TCB with that priority.
+ *
+ ****************************************************************************/
+
+void nxsched_rtrindex_insert(FAR struct rtrindex_s *index,
+                             FAR struct tcb_s *tcb)
+{
+  uint8_t priority = tcb->sched_priority;
+
+  if (index->tail[priority] == NULL || index->tail[priority] == tcb->blink)
+    {
+      index->tail[priority] = tcb;
+    }
+
+  index->bitmap[priority >> RTRINDEX_SHIFT] |=
+    UINT32_C(1) << (priority & RTRINDEX_MASK);
+}
+
+/****************************************************************************
+ * Name: nxsched_rtrindex_remove
+ *
+ * Description:
+ *   Account for a TCB that is about to be unlinked from an indexed list.
+ *   This must be called before the TCB is unlinked and before its priority
+ *   is changed.
+ *
+ ****************************************************************************/
+
+void nxsched_rtrindex_remove(FAR struct rtrindex_s *index,
+                             FAR struct tcb_s *tcb)
+{
+  uint8_t priority = tcb->sched_priority;
+  FAR struct tcb_s *prev;
+
+  if (index->tail[priority] == tcb)
+    {
+      prev = tcb->blink;
+      if (prev != NULL && prev->sched_priority == priority)
+        {
+          index->tail[priority] = prev;
+        }
+      else
+        {
+          index->tail[priority] = NULL;
+          index->bitmap[priority >> RTRINDEX_SHIFT] &=
+            ~(UINT32_C(1) << (priority & RTRINDEX_MASK));
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxsched_rtrindex_reset
+ *
+ * Description:
+ *   Forget every TCB in an index.  Used when the whole list is moved
+ *   elsewhere.
+ *
+ ****************************************************************************/
+
+void nxsched_rtrindex_reset(FAR struct rtrindex_s *index)
+{
+  memset(index, 0, sizeof(*index));
+}
+
+/****************************************************************************
+ * Name: nxsched_remove_prioritized
+ *
+ * Description:
+ *   Remove a TCB from a prioritized TCB list, keeping the priority index of
+ *   the list up to date.
+ *
+ * Input Parameters:
+ *   tcb - Points to the TCB to remove
+ *   list - Points to the prioritized list holding the TCB
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before calling this
+ *   function.
+ *
+ ****************************************************************************/
+
+void nxsched_remove_prioritized(FAR struct tcb_s *tcb, FAR dq_queue_t *list)
+{
+  FAR struct rtrindex_s *index = nxsched_rtrindex(list);
+
+  if (index != NULL)
+    {
+      nxsched_rtrindex_remove(index, tcb);
+    }
+
+  dq_rem((FAR dq_entry_t *)tcb, list);
+}
+
+/****************************************************************************
+ * Name: nxsched_addfirst_prioritized
+ *
+ * Description:
+ *   Add a TCB to the head of a prioritized TCB list.  The TCB must have a
+ *   priority greater than or equal to that of the current head of the list.
+ *
+ * Input Parameters:
+ *   tcb - Points to the TCB to add
+ *   list - Points to the prioritized list
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before calling this
+ *   function.
+ *
+ ****************************************************************************/
+
+void nxsched_addfirst_prioritized(FAR struct tcb_s *tcb,
+                                  FAR dq_queue_t *list)
+{
+  FAR struct rtrindex_s *index = nxsched_rtrindex(list);
+
+  DEBUGASSERT(list->head == NULL ||
+              tcb->sched_priority >=
+              ((FAR struct tcb_s *)list->head)->sched_priority);
+
+  dq_addfirst((FAR dq_entry_t *)tcb, list);
+  if (index != NULL)
+    {
+      nxsched_rtrindex_insert(index, tcb);
+    }
+}
+
+/****************************************************************************
+ * Name: nxsched_sethead_priority
+ *
+ * Description:
+ *   Change the priority of the TCB at the head of a prioritized TCB list
+ *   without unlinking it.  The new priority must keep the TCB at the head
+ *   of the list.
+ *
+ * Input Parameters:
+ *   tcb - Points to the TCB at the head of the list
+ *   list - Points to the prioritized list
+ *   priority - The new priority of the TCB
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before calling this
+ *   function.
+ *
+ ****************************************************************************/
+
+void nxsched_sethead_priority(FAR struct tcb_s *tcb, FAR dq_queue_t *list,
+                              uint8_t priority)
+{
+  FAR struct rtrindex_s *index = nxsched_rtrindex(list);
+
+  DEBUGASSERT(tcb->blink == NULL);
+
+  if (index != NULL)
+    {
+      nxsched_rtrindex_remove(index, tcb);
+    }
+
+  tcb->sched_priority = priority;
+
+  if (index != NULL)
+    {
+      nxsched_rtrindex_insert(index, tcb);
+    }
+}
+
+#endif /* CONFIG_SCHED_READYTORUN_BITMAP */
@@ -122,13 +122,16 @@ static inline void nxsched_running_setpriority(FAR struct tcb_s *tcb,
                                                int sched_priority)
 {
   FAR struct tcb_s *nxttcb;
+  FAR dq_queue_t *tasklist;
 
   /* Get the TCB of the next highest priority, ready to run task */
 
 #ifdef CONFIG_SMP
-  nxttcb = nxsched_nexttcb(tcb);
+  nxttcb   = nxsched_nexttcb(tcb);
+  tasklist = TLIST_HEAD(tcb, tcb->cpu);
 #else
-  nxttcb = tcb->flink;
+  nxttcb   = tcb->flink;
+  tasklist = TLIST_HEAD(tcb);
 #endif
 
   DEBUGASSERT(nxttcb != NULL);
@@ -165,9 +168,11 @@ static inline void nxsched_running_setpriority(FAR struct tcb_s *tcb,
             }
           while (sched_priority < nxttcb->sched_priority);
 
-          /* Change the task priority */
+          /* Change the task priority.  The task stays at the head of its
+           * ready-to-run list.
+           */
 
-          tcb->sched_priority = (uint8_t)sched_priority;
+          nxsched_sethead_priority(tcb, tasklist, (uint8_t)sched_priority);
         }
       else
         {
@@ -186,7 +191,7 @@ static inline void nxsched_running_setpriority(FAR struct tcb_s *tcb,
     {
       /* Change the task priority */
 
-      tcb->sched_priority = (uint8_t)sched_priority;
+      nxsched_sethead_priority(tcb, tasklist, (uint8_t)sched_priority);
     }
 }
 
@@ -223,7 +228,7 @@ static void nxsched_readytorun_setpriority(FAR struct tcb_s *tcb,
 
   if (tcb->task_state == TSTATE_TASK_READYTORUN)
     {
-      cpu = nxsched_select_cpu(tcb->affinity);
+      cpu = nxsched_select_tcbcpu(tcb);
     }
 
   /* CASE 2b.  The task is ready to run, and assigned to a CPU.  An increase
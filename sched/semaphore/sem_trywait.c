@@ -106,6 +106,60 @@ int nxsem_trywait(FAR sem_t *sem)
   return ret;
 }
 
+/****************************************************************************
+ * Name: nxsem_trywait_holder
+ *
+ * Description:
+ *   This function takes a count of the specified semaphore on behalf of
+ *   another task, if the semaphore is currently available.  The task is
+ *   recorded as the holder of that count, so that it is subject to
+ *   priority inheritance just as if it had taken the count itself.
+ *
+ * Input Parameters:
+ *   sem    - Semaphore descriptor.
+ *   holder - The pid of the task that will hold the count.
+ *
+ * Returned Value:
+ *   This is an internal OS interface and should not be used by
+ *   applications.  It follows the NuttX internal error return policy:
+ *   Zero (OK) is returned on success.  A negated errno value is returned on
+ *   failure.  Possible returned errors:
+ *
+ *     - EAGAIN - The semaphore is not available.
+ *
+ ****************************************************************************/
+
+int nxsem_trywait_holder(FAR sem_t *sem, pid_t holder)
+{
+  FAR struct tcb_s *htcb;
+  irqstate_t flags;
+  int ret = -EAGAIN;
+
+  DEBUGASSERT(sem != NULL);
+
+  flags = enter_critical_section();
+
+  if (sem->semcount > 0)
+    {
+      sem->semcount--;
+
+      /* The holder may have exited in the meantime, there is nobody to
+       * boost then.
+       */
+
+      htcb = nxsched_get_tcb(holder);
+      if (htcb != NULL)
+        {
+          nxsem_add_holder_tcb(htcb, sem);
+        }
+
+      ret = OK;
+    }
+
+  leave_critical_section(flags);
+  return ret;
+}
+
 /****************************************************************************
  * Name: sem_trywait
  *
@@ -139,7 +139,7 @@ static int nxtask_restart(pid_t pid)
   tasklist = TLIST_HEAD(&tcb->cmn);
 #endif
 
-  dq_rem((FAR dq_entry_t *)tcb, tasklist);
+  nxsched_remove_prioritized(&tcb->cmn, tasklist);
   tcb->cmn.task_state = TSTATE_TASK_INVALID;
 
   /* Deallocate anything left in the TCB's signal queues */
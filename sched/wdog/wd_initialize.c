@@ -32,6 +32,17 @@
  * Public Data
  ****************************************************************************/
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* The timing wheel holding all active watchdogs.  No event is pending
+ * initially, so the cached next event is placed as far away as possible.
+ */
+
+struct wdog_wheel_s g_wdwheel =
+{
+  .next    = (clock_t)-1,
+  .expired = LIST_INITIAL_VALUE(g_wdwheel.expired),
+};
+#else
 /* The g_wdactivelist data structure is a singly linked list ordered by
  * watchdog expiration time. When watchdog timers expire,the functions on
  * this linked list are removed and the function is called.
@@ -46,6 +57,7 @@ sq_queue_t g_wdactivelist;
 #ifdef CONFIG_SCHED_TICKLESS
 clock_t g_wdtickbase;
 #endif
+#endif /* CONFIG_WDOG_TIMERWHEEL */
 
 /****************************************************************************
  * Public Functions
@@ -0,0 +1,682 @@
+/****************************************************************************
+ * sched/wdog/wd_wheel.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <strings.h>
+#include <limits.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/list.h>
+#include <nuttx/wdog.h>
+
+#include "sched/sched.h"
+#include "wdog/wdog.h"
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SCHED_CRITMONITOR_MAXTIME_WDOG
+#  define CONFIG_SCHED_CRITMONITOR_MAXTIME_WDOG 0
+#endif
+
+#if CONFIG_SCHED_CRITMONITOR_MAXTIME_WDOG > 0
+#  define CALL_FUNC(func, arg) \
+     do \
+       { \
+         clock_t start; \
+         clock_t elapsed; \
+         start = perf_gettime(); \
+         func(arg); \
+         elapsed = perf_gettime() - start; \
+         if (elapsed > CONFIG_SCHED_CRITMONITOR_MAXTIME_WDOG) \
+           { \
+             CRITMONITOR_PANIC("WDOG %p, %s IRQ, execute too long %ju\n", \
+                               func, up_interrupt_context() ? \
+                               "IN" : "NOT", (uintmax_t)elapsed); \
+           } \
+       } \
+     while (0)
+#else
+#  define CALL_FUNC(func, arg) func(arg)
+#endif
+
+/* Number of ticks covered by one slot of the given level */
+
+#define WHEEL_SHIFT(l)       ((l) * WDOG_WHEEL_BITS)
+
+/* Bitmap of all slots of one level */
+
+#if WDOG_WHEEL_SLOTS >= 64
+#  define WHEEL_ALLSLOTS     UINT64_MAX
+#else
+#  define WHEEL_ALLSLOTS     ((UINT64_C(1) << WDOG_WHEEL_SLOTS) - 1)
+#endif
+
+/* Compare two times relative to the current wheel base */
+
+#define WHEEL_BEFORE(a, b)   ((clock_t)((a) - g_wdwheel.base) < \
+                              (clock_t)((b) - g_wdwheel.base))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_event
+ *
+ * Description:
+ *   Return the absolute time at which the given slot will be processed
+ *   next, i.e. the first start of that slot after the wheel base.
+ *
+ ****************************************************************************/
+
+static inline clock_t wd_wheel_event(int level, unsigned int slot)
+{
+  clock_t cur = g_wdwheel.base >> WHEEL_SHIFT(level);
+  unsigned int diff = (slot - (unsigned int)cur) & WDOG_WHEEL_MASK;
+
+  if (diff == 0)
+    {
+      diff = WDOG_WHEEL_SLOTS;
+    }
+
+  return (cur + diff) << WHEEL_SHIFT(level);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_nextevent
+ *
+ * Description:
+ *   Find the earliest time at which any slot of the wheel must be
+ *   processed, either because its watchdogs expire (level 0) or because
+ *   they must be cascaded down to a lower level.  The cost is bounded by
+ *   the number of levels.
+ *
+ * Returned Value:
+ *   True if the wheel holds any watchdog; the event time is returned in
+ *   'event'.
+ *
+ ****************************************************************************/
+
+static bool wd_wheel_nextevent(FAR clock_t *event)
+{
+  bool found = false;
+  uint64_t bits;
+  uint64_t rot;
+  clock_t tmp;
+  unsigned int start;
+  unsigned int off;
+  int level;
+
+  for (level = 0; level < WDOG_WHEEL_LEVELS; level++)
+    {
+      bits = g_wdwheel.bitmap[level];
+      if (bits == 0)
+        {
+          continue;
+        }
+
+      /* Rotate the bitmap so that bit 0 corresponds to the slot following
+       * the current one; the first set bit is then the next slot due.
+       */
+
+      start = ((unsigned int)(g_wdwheel.base >> WHEEL_SHIFT(level)) + 1) &
+              WDOG_WHEEL_MASK;
+      rot   = start == 0 ? bits :
+              ((bits >> start) | (bits << (WDOG_WHEEL_SLOTS - start))) &
+              WHEEL_ALLSLOTS;
+      off   = ffsll((long long)rot) - 1;
+      tmp   = wd_wheel_event(level, (start + off) & WDOG_WHEEL_MASK);
+
+      if (!found || WHEEL_BEFORE(tmp, *event))
+        {
+          *event = tmp;
+          found  = true;
+        }
+    }
+
+  return found;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_insert
+ *
+ * Description:
+ *   Hash the watchdog into the lowest wheel level that can hold its
+ *   expiration time relative to the current wheel base.  Watchdogs beyond
+ *   the span of the wheel are parked in the farthest slot of the top level
+ *   and re-hashed when that slot comes due.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_insert(FAR struct wdog_s *wdog)
+{
+  FAR struct list_node *head;
+  clock_t delta = wdog->expired - g_wdwheel.base;
+  clock_t event;
+  unsigned int slot;
+  int level;
+
+  if ((sclock_t)delta <= 0)
+    {
+      /* Already expired */
+
+      list_add_tail(&g_wdwheel.expired, &wdog->node);
+      return;
+    }
+
+  for (level = 0; level < WDOG_WHEEL_LEVELS - 1; level++)
+    {
+      if (delta < ((clock_t)1 << WHEEL_SHIFT(level + 1)))
+        {
+          break;
+        }
+    }
+
+  if (level == WDOG_WHEEL_LEVELS - 1 &&
+      (delta >> WHEEL_SHIFT(level)) >= WDOG_WHEEL_SLOTS)
+    {
+      slot = (unsigned int)(g_wdwheel.base >> WHEEL_SHIFT(level)) &
+             WDOG_WHEEL_MASK;
+    }
+  else
+    {
+      slot = (unsigned int)(wdog->expired >> WHEEL_SHIFT(level)) &
+             WDOG_WHEEL_MASK;
+    }
+
+  head = &g_wdwheel.slots[level][slot];
+  if ((g_wdwheel.bitmap[level] & (UINT64_C(1) << slot)) == 0)
+    {
+      list_initialize(head);
+      g_wdwheel.bitmap[level] |= UINT64_C(1) << slot;
+    }
+
+  list_add_tail(head, &wdog->node);
+
+  /* Keep the cached next event up to date */
+
+  event = wd_wheel_event(level, slot);
+  if (WHEEL_BEFORE(event, g_wdwheel.next))
+    {
+      g_wdwheel.next = event;
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_process
+ *
+ * Description:
+ *   Process all slots that come due at the current wheel base: cascade the
+ *   watchdogs of the higher levels and move the watchdogs of the level 0
+ *   slot onto the expired list.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_process(void)
+{
+  FAR struct list_node *head;
+  struct list_node work;
+  clock_t now = g_wdwheel.base;
+  unsigned int slot;
+  int level;
+
+  for (level = WDOG_WHEEL_LEVELS - 1; level >= 0; level--)
+    {
+      if ((now & (((clock_t)1 << WHEEL_SHIFT(level)) - 1)) != 0)
+        {
+          continue;
+        }
+
+      slot = (unsigned int)(now >> WHEEL_SHIFT(level)) & WDOG_WHEEL_MASK;
+      if ((g_wdwheel.bitmap[level] & (UINT64_C(1) << slot)) == 0)
+        {
+          continue;
+        }
+
+      /* Detach the whole slot first, an overflowed watchdog may be hashed
+       * back into the very same slot.
+       */
+
+      head = &g_wdwheel.slots[level][slot];
+      g_wdwheel.bitmap[level] &= ~(UINT64_C(1) << slot);
+
+      work.next       = head->next;
+      work.prev       = head->prev;
+      work.next->prev = &work;
+      work.prev->next = &work;
+
+      while (!list_is_empty(&work))
+        {
+          FAR struct wdog_s *wdog =
+            container_of(work.next, struct wdog_s, node);
+
+          list_delete(&wdog->node);
+          wd_wheel_insert(wdog);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_advance
+ *
+ * Description:
+ *   Advance the wheel base to 'now', processing every wheel event on the
+ *   way.  Empty stretches of the wheel are skipped in one step, so the
+ *   cost does not depend on the number of elapsed ticks.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_advance(clock_t now)
+{
+  clock_t event;
+
+  /* The cached next event is never later than the real one, nothing can
+   * be due before it.
+   */
+
+  while (!WHEEL_BEFORE(now, g_wdwheel.next))
+    {
+      if (!wd_wheel_nextevent(&event))
+        {
+          g_wdwheel.next = now - 1;
+          break;
+        }
+
+      if (WHEEL_BEFORE(now, event))
+        {
+          g_wdwheel.next = event;
+          break;
+        }
+
+      /* Move to the event and force the next event to be looked up again
+       * once the due slots have been processed.
+       */
+
+      g_wdwheel.base = event;
+      g_wdwheel.next = event;
+      wd_wheel_process();
+    }
+
+  g_wdwheel.base = now;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_empty
+ ****************************************************************************/
+
+static inline bool wd_wheel_empty(void)
+{
+  int level;
+
+  for (level = 0; level < WDOG_WHEEL_LEVELS; level++)
+    {
+      if (g_wdwheel.bitmap[level] != 0)
+        {
+          return false;
+        }
+    }
+
+  return list_is_empty(&g_wdwheel.expired);
+}
+
+/****************************************************************************
+ * Name: wd_expiration
+ *
+ * Description:
+ *   Run all watchdogs that have been moved onto the expired list.
+ *
+ ****************************************************************************/
+
+static inline void wd_expiration(void)
+{
+  FAR struct wdog_s *wdog;
+  wdentry_t func;
+
+  while (!list_is_empty(&g_wdwheel.expired))
+    {
+      wdog = container_of(g_wdwheel.expired.next, struct wdog_s, node);
+      list_delete(&wdog->node);
+
+      /* Indicate that the watchdog is no longer active. */
+
+      func = wdog->func;
+      wdog->func = NULL;
+
+      /* Execute the watchdog function */
+
+      up_setpicbase(wdog->picbase);
+      CALL_FUNC(func, wdog->arg);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_start
+ *
+ * Description:
+ *   This function adds a watchdog timer to the timing wheel.  The
+ *   specified watchdog function at 'wdentry' will be called from the
+ *   interrupt level after the specified number of ticks has elapsed.
+ *   Watchdog timers may be started from the interrupt level.
+ *
+ *   Watchdog timers execute in the address environment that was in effect
+ *   when wd_start() is called.
+ *
+ *   Watchdog timers execute only once.
+ *
+ *   To replace either the timeout delay or the function to be executed,
+ *   call wd_start again with the same wdog; only the most recent wdStart()
+ *   on a given watchdog ID has any effect.
+ *
+ * Input Parameters:
+ *   wdog     - Watchdog ID
+ *   delay    - Delay count in clock ticks
+ *   wdentry  - Function to call on timeout
+ *   arg      - Parameter to pass to wdentry
+ *
+ *   NOTE:  The parameter must be of type wdparm_t.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is return to
+ *   indicate the nature of any failure.
+ *
+ * Assumptions:
+ *   The watchdog routine runs in the context of the timer interrupt handler
+ *   and is subject to all ISR restrictions.
+ *
+ ****************************************************************************/
+
+int wd_start(FAR struct wdog_s *wdog, sclock_t delay,
+             wdentry_t wdentry, wdparm_t arg)
+{
+  irqstate_t flags;
+
+  /* Verify the wdog and setup parameters */
+
+  if (wdog == NULL || wdentry == NULL || delay < 0)
+    {
+      return -EINVAL;
+    }
+
+  /* Check if the watchdog has been started. If so, stop it. */
+
+  flags = enter_critical_section();
+  if (WDOG_ISACTIVE(wdog))
+    {
+      wd_cancel(wdog);
+    }
+
+  /* Save the data in the watchdog structure */
+
+  wdog->func = wdentry;         /* Function to execute when delay expires */
+  up_getpicbase(&wdog->picbase);
+  wdog->arg = arg;
+
+  /* Calculate delay+1, forcing the delay into a range that we can handle.
+   * See wd_start.c for why one must be added to the delay.
+   */
+
+  if (delay <= 0)
+    {
+      delay = 1;
+    }
+  else if (++delay <= 0)
+    {
+      delay--;
+    }
+
+#ifdef CONFIG_SCHED_TICKLESS
+  /* Cancel the interval timer that drives the timing events.  This will
+   * cause wd_timer to be called which brings the wheel base up to date.
+   */
+
+  nxsched_cancel_timer();
+
+  /* The wheel base is not advanced while there is nothing to time, it is
+   * safe to resynchronize it with the system time when the wheel is empty.
+   */
+
+  if (wd_wheel_empty())
+    {
+      g_wdwheel.base = clock_systime_ticks();
+      g_wdwheel.next = g_wdwheel.base - 1;
+    }
+#endif
+
+  /* Hash the watchdog into the wheel, O(1) */
+
+  wdog->expired = g_wdwheel.base + delay;
+  wd_wheel_insert(wdog);
+
+#ifdef CONFIG_SCHED_TICKLESS
+  /* Resume the interval timer that will generate the next interval event.
+   * If the next wheel event changed, then this will pick that new delay.
+   */
+
+  nxsched_resume_timer();
+#endif
+
+  leave_critical_section(flags);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: wd_cancel
+ *
+ * Description:
+ *   This function cancels a currently running watchdog timer. Watchdog
+ *   timers may be canceled from the interrupt level.
+ *
+ * Input Parameters:
+ *   wdog - ID of the watchdog to cancel.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success;  A negated errno value is returned to
+ *   indicate the nature of any failure.
+ *
+ ****************************************************************************/
+
+int wd_cancel(FAR struct wdog_s *wdog)
+{
+  FAR struct list_node *prev;
+  FAR struct list_node *next;
+  irqstate_t flags;
+  int ret = -EINVAL;
+
+  flags = enter_critical_section();
+
+  /* Make sure that the watchdog is initialized (non-NULL) and is still
+   * active.
+   */
+
+  if (wdog != NULL && WDOG_ISACTIVE(wdog))
+    {
+      /* Unlink the watchdog, O(1).  If its neighbours are the same node
+       * afterwards, that node is the list head and the slot became empty.
+       */
+
+      prev = wdog->node.prev;
+      next = wdog->node.next;
+      DEBUGASSERT(prev != NULL && next != NULL);
+
+      list_delete(&wdog->node);
+
+      if (prev == next && prev != &g_wdwheel.expired)
+        {
+          uintptr_t index = prev - &g_wdwheel.slots[0][0];
+          int level = index >> WDOG_WHEEL_BITS;
+          unsigned int slot = index & WDOG_WHEEL_MASK;
+
+          DEBUGASSERT(level < WDOG_WHEEL_LEVELS);
+          g_wdwheel.bitmap[level] &= ~(UINT64_C(1) << slot);
+
+          /* Reassess the interval timer if the next event went away */
+
+          if (wd_wheel_event(level, slot) == g_wdwheel.next)
+            {
+              nxsched_reassess_timer();
+            }
+        }
+
+      /* Mark the watchdog inactive */
+
+      wdog->func = NULL;
+
+      /* Return success */
+
+      ret = OK;
+    }
+
+  leave_critical_section(flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: wd_gettime
+ *
+ * Description:
+ *   This function returns the time remaining before the specified watchdog
+ *   timer expires.
+ *
+ * Input Parameters:
+ *   wdog - watchdog ID
+ *
+ * Returned Value:
+ *   The time in system ticks remaining until the watchdog time expires.
+ *   Zero means either that wdog is not valid or that the wdog has already
+ *   expired.
+ *
+ ****************************************************************************/
+
+sclock_t wd_gettime(FAR struct wdog_s *wdog)
+{
+  irqstate_t flags;
+  sclock_t delay = 0;
+
+  flags = enter_critical_section();
+  if (wdog != NULL && WDOG_ISACTIVE(wdog))
+    {
+      delay = (sclock_t)(wdog->expired - g_wdwheel.base) - wd_elapse();
+      if (delay < 0)
+        {
+          delay = 0;
+        }
+    }
+
+  leave_critical_section(flags);
+  return delay;
+}
+
+/****************************************************************************
+ * Name: wd_timer
+ *
+ * Description:
+ *   This function is called from the timer interrupt handler to determine
+ *   if it is time to execute a watchdog function.  If so, the watchdog
+ *   function will be executed in the context of the timer interrupt
+ *   handler.
+ *
+ * Input Parameters:
+ *   ticks - If CONFIG_SCHED_TICKLESS is defined then the number of ticks
+ *     in the interval that just expired is provided.  Otherwise,
+ *     this function is called on each timer interrupt and a value of one
+ *     is implicit.
+ *   noswitches - True: Can't do context switches now.
+ *
+ * Returned Value:
+ *   If CONFIG_SCHED_TICKLESS is defined then the number of ticks for the
+ *   next delay is provided (zero if no delay).  Otherwise, this function
+ *   has no returned value.
+ *
+ * Assumptions:
+ *   Called from interrupt handler logic with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+unsigned int wd_timer(int ticks, bool noswitches)
+{
+  clock_t event;
+
+  /* Advance the wheel, this also updates the clock tickbase */
+
+  wd_wheel_advance(g_wdwheel.base + ticks);
+
+  /* Run the expired watchdogs unless context switches are not allowed */
+
+  if (!noswitches)
+    {
+      wd_expiration();
+    }
+
+  /* Return the delay for the next wheel event.  Cascading events are
+   * reported too, so the interval timer may fire before the next watchdog
+   * actually expires.
+   */
+
+  if (!list_is_empty(&g_wdwheel.expired))
+    {
+      return 1;
+    }
+
+  if (!wd_wheel_nextevent(&event))
+    {
+      return 0;
+    }
+
+  g_wdwheel.next = event;
+  event -= g_wdwheel.base;
+  return event < UINT_MAX ? (unsigned int)event : UINT_MAX;
+}
+
+#else
+void wd_timer(void)
+{
+  /* Advance the wheel by one tick, this is O(1) unless some slot comes due
+   * at this tick.
+   */
+
+  wd_wheel_advance(g_wdwheel.base + 1);
+
+  /* Run the expired watchdogs */
+
+  wd_expiration();
+}
+#endif /* CONFIG_SCHED_TICKLESS */
+#endif /* CONFIG_WDOG_TIMERWHEEL */
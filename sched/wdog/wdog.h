@@ -39,6 +39,25 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+#  define WDOG_WHEEL_LEVELS  CONFIG_WDOG_TIMERWHEEL_LEVELS
+#  define WDOG_WHEEL_BITS    CONFIG_WDOG_TIMERWHEEL_BITS
+#  define WDOG_WHEEL_SLOTS   (1 << WDOG_WHEEL_BITS)
+#  define WDOG_WHEEL_MASK    (WDOG_WHEEL_SLOTS - 1)
+
+/* The span covered by all levels must be representable in clock_t */
+
+#  ifdef CONFIG_SYSTEM_TIME64
+#    if WDOG_WHEEL_LEVELS * WDOG_WHEEL_BITS >= 64
+#      error "Timing wheel span does not fit in clock_t"
+#    endif
+#  else
+#    if WDOG_WHEEL_LEVELS * WDOG_WHEEL_BITS >= 32
+#      error "Timing wheel span does not fit in clock_t"
+#    endif
+#  endif
+#endif
+
 /****************************************************************************
  * Name: wd_elapse
  *
@@ -50,12 +69,37 @@
  *
  ****************************************************************************/
 
-#ifdef CONFIG_SCHED_TICKLESS
+#if defined(CONFIG_SCHED_TICKLESS) && defined(CONFIG_WDOG_TIMERWHEEL)
+#  define wd_elapse() (clock_systime_ticks() - g_wdwheel.base)
+#elif defined(CONFIG_SCHED_TICKLESS)
 #  define wd_elapse() (clock_systime_ticks() - g_wdtickbase)
 #else
 #  define wd_elapse() (0)
 #endif
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* This is the hierarchical timing wheel.  Level 0 has one slot per tick,
+ * each slot of level N spans WDOG_WHEEL_SLOTS slots of level N - 1.  A
+ * watchdog is hashed into the lowest level that can hold its expiration
+ * time and is moved ("cascaded") down one or more levels when the wheel
+ * reaches the start of its slot.  Slot list heads are only valid while
+ * the corresponding bit is set in bitmap[].
+ */
+
+struct wdog_wheel_s
+{
+  clock_t          base;       /* All events up to this tick are processed */
+  clock_t          next;       /* Cached time of the earliest wheel event */
+  uint64_t         bitmap[WDOG_WHEEL_LEVELS];
+  struct list_node slots[WDOG_WHEEL_LEVELS][WDOG_WHEEL_SLOTS];
+  struct list_node expired;    /* Expired watchdogs waiting to be run */
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -68,6 +112,13 @@ extern "C"
 #define EXTERN extern
 #endif
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* The timing wheel holding all active watchdogs.  In the tick-less mode,
+ * g_wdwheel.base also serves as the wdog tickbase.
+ */
+
+extern struct wdog_wheel_s g_wdwheel;
+#else
 /* The g_wdactivelist data structure is a singly linked list ordered by
  * watchdog expiration time. When watchdog timers expire,the functions on
  * this linked list are removed and the function is called.
@@ -82,6 +133,7 @@ extern sq_queue_t g_wdactivelist;
 #ifdef CONFIG_SCHED_TICKLESS
 extern clock_t g_wdtickbase;
 #endif
+#endif /* CONFIG_WDOG_TIMERWHEEL */
 
 /****************************************************************************
  * Public Function Prototypes
@@ -49,7 +49,7 @@
  *   work_queue() again.
  *
  * Input Parameters:
- *   wqueue  - The work queue to use.  Must be HPWORK or LPWORK
+ *   wqueue  - The work queue to use
  *   nthread - The number of threads in the work queue
  *             > 0 unsynchronous cancel
  *             < 0 synchronous cancel
@@ -84,13 +84,22 @@ static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, int nthread,
        * marked as available (i.e., the worker field is nullified).
        */
 
-      if (WDOG_ISACTIVE(&work->u.timer))
+      /* dq_rem() only uses the list to update its head or tail, so the
+       * work is in the delayed list if it is the head or the tail of it.
+       * Otherwise it is either in the middle of the delayed list or in the
+       * work queue, and removing it from the work queue is correct in both
+       * cases.  The timer is left running:  if the first delayed work was
+       * cancelled, it just expires early with nothing to do.
+       */
+
+      if (wqueue->delayed.head == &work->u.s.dq ||
+          wqueue->delayed.tail == &work->u.s.dq)
         {
-          wd_cancel(&work->u.timer);
+          dq_rem(&work->u.s.dq, &wqueue->delayed);
         }
       else
         {
-          dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+          dq_rem(&work->u.s.dq, &wqueue->q);
         }
 
       work->worker = NULL;
@@ -120,6 +129,37 @@ static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, int nthread,
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_cancel_wq/work_cancel_sync_wq
+ *
+ * Description:
+ *   Cancel previously queued work on a work queue.  See work_cancel() and
+ *   work_cancel_sync().
+ *
+ ****************************************************************************/
+
+int work_cancel_wq(FAR struct kwork_wqueue_s *wqueue,
+                   FAR struct work_s *work)
+{
+  if (wqueue == NULL)
+    {
+      return -EINVAL;
+    }
+
+  return work_qcancel(wqueue, -1, work);
+}
+
+int work_cancel_sync_wq(FAR struct kwork_wqueue_s *wqueue,
+                        FAR struct work_s *work)
+{
+  if (wqueue == NULL)
+    {
+      return -EINVAL;
+    }
+
+  return work_qcancel(wqueue, wqueue->nthreads, work);
+}
+
 /****************************************************************************
  * Name: work_cancel
  *
@@ -143,29 +183,7 @@ static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, int nthread,
 
 int work_cancel(int qid, FAR struct work_s *work)
 {
-#ifdef CONFIG_SCHED_HPWORK
-  if (qid == HPWORK)
-    {
-      /* Cancel high priority work */
-
-      return work_qcancel((FAR struct kwork_wqueue_s *)&g_hpwork,
-                          -1, work);
-    }
-  else
-#endif
-#ifdef CONFIG_SCHED_LPWORK
-  if (qid == LPWORK)
-    {
-      /* Cancel low priority work */
-
-      return work_qcancel((FAR struct kwork_wqueue_s *)&g_lpwork,
-                          -1, work);
-    }
-  else
-#endif
-    {
-      return -EINVAL;
-    }
+  return work_cancel_wq(work_qid2wq(qid), work);
 }
 
 /****************************************************************************
@@ -191,29 +209,27 @@ int work_cancel(int qid, FAR struct work_s *work)
 
 int work_cancel_sync(int qid, FAR struct work_s *work)
 {
-#ifdef CONFIG_SCHED_HPWORK
-  if (qid == HPWORK)
-    {
-      /* Cancel high priority work */
+  return work_cancel_sync_wq(work_qid2wq(qid), work);
+}
 
-      return work_qcancel((FAR struct kwork_wqueue_s *)&g_hpwork,
-                          CONFIG_SCHED_HPNTHREADS, work);
-    }
-  else
-#endif
-#ifdef CONFIG_SCHED_LPWORK
-  if (qid == LPWORK)
-    {
-      /* Cancel low priority work */
+/****************************************************************************
+ * Name: work_cancel_on
+ *
+ * Description:
+ *   Cancel previously queued work on the work queue of one CPU.
+ *
+ ****************************************************************************/
 
-      return work_qcancel((FAR struct kwork_wqueue_s *)&g_lpwork,
-                          CONFIG_SCHED_LPNTHREADS, work);
-    }
-  else
-#endif
+#ifdef CONFIG_SCHED_PERCPUWORK
+int work_cancel_on(int cpu, FAR struct work_s *work)
+{
+  if (cpu < 0 || cpu >= CONFIG_SMP_NCPUS)
     {
       return -EINVAL;
     }
+
+  return work_cancel_wq(g_percpu_wqueue[cpu], work);
 }
+#endif
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
@@ -0,0 +1,320 @@
+/****************************************************************************
+ * sched/wqueue/kwork_procfs.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
+#include <nuttx/fs/procfs.h>
+
+#include "wqueue/wqueue.h"
+
+#if defined(CONFIG_WQUEUE_LATENCY) && defined(CONFIG_FS_PROCFS) && \
+    !defined(CONFIG_FS_PROCFS_EXCLUDE_WQUEUE)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Determines the size of an intermediate buffer that must be large enough
+ * to handle the longest line generated by this logic.
+ */
+
+#define WQUEUEINFO_LINELEN (24 + 9 * (WQUEUE_LATENCY_NBUCKETS + 1))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure describes one open "file" */
+
+struct wqueue_file_s
+{
+  struct procfs_file_s base;     /* Base open file structure */
+  unsigned int linesize;         /* Number of valid characters in line[] */
+  char line[WQUEUEINFO_LINELEN]; /* Pre-allocated buffer for formatted lines */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     wqueue_open(FAR struct file *filep, FAR const char *relpath,
+                           int oflags, mode_t mode);
+static int     wqueue_close(FAR struct file *filep);
+static int     wqueue_dup(FAR const struct file *oldp,
+                          FAR struct file *newp);
+static int     wqueue_stat(FAR const char *relpath, FAR struct stat *buf);
+static ssize_t wqueue_read(FAR struct file *filep, FAR char *buffer,
+                           size_t buflen);
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct procfs_operations g_wqueue_operations =
+{
+  wqueue_open,   /* open */
+  wqueue_close,  /* close */
+  wqueue_read,   /* read */
+  NULL,          /* write */
+  wqueue_dup,    /* dup */
+  NULL,          /* opendir */
+  NULL,          /* closedir */
+  NULL,          /* readdir */
+  NULL,          /* rewinddir */
+  wqueue_stat    /* stat */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The list of the work queues shown in procfs, and its lock */
+
+static FAR struct kwork_wqueue_s *g_wqueue_procfs;
+static mutex_t g_wqueue_procfs_lock = NXMUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wqueue_open
+ ****************************************************************************/
+
+static int wqueue_open(FAR struct file *filep, FAR const char *relpath,
+                       int oflags, mode_t mode)
+{
+  FAR struct wqueue_file_s *procfile;
+
+  /* PROCFS is read-only.  Any attempt to open with any kind of write
+   * access is not permitted.
+   */
+
+  if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0)
+    {
+      return -EACCES;
+    }
+
+  procfile = kmm_zalloc(sizeof(struct wqueue_file_s));
+  if (procfile == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  filep->f_priv = procfile;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: wqueue_close
+ ****************************************************************************/
+
+static int wqueue_close(FAR struct file *filep)
+{
+  kmm_free(filep->f_priv);
+  filep->f_priv = NULL;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: wqueue_read
+ *
+ * Description:
+ *   Print one line per work queue:  its name, number of worker threads,
+ *   the worst latency and the latency histogram.  The header of each
+ *   histogram column is the lower bound of the bucket in system ticks.
+ *
+ ****************************************************************************/
+
+static ssize_t wqueue_read(FAR struct file *filep, FAR char *buffer,
+                           size_t buflen)
+{
+  FAR struct kwork_wqueue_s *wqueue;
+  FAR struct wqueue_file_s *procfile;
+  struct kwork_latency_s latency;
+  irqstate_t flags;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  off_t offset;
+  int i;
+
+  offset    = filep->f_pos;
+  procfile  = filep->f_priv;
+
+  linesize  = procfs_snprintf(procfile->line, WQUEUEINFO_LINELEN,
+                              "%12s%4s%9s%9u", "", "thr", "max", 0);
+  for (i = 1; i < WQUEUE_LATENCY_NBUCKETS; i++)
+    {
+      linesize += procfs_snprintf(procfile->line + linesize,
+                                  WQUEUEINFO_LINELEN - linesize,
+                                  "%9lu", 1ul << (i - 1));
+    }
+
+  linesize += procfs_snprintf(procfile->line + linesize,
+                              WQUEUEINFO_LINELEN - linesize, "\n");
+
+  copysize  = procfs_memcpy(procfile->line, linesize, buffer, buflen,
+                            &offset);
+  totalsize = copysize;
+
+  nxmutex_lock(&g_wqueue_procfs_lock);
+
+  for (wqueue = g_wqueue_procfs; wqueue != NULL; wqueue = wqueue->flink)
+    {
+      if (totalsize < buflen)
+        {
+          buffer    += copysize;
+          buflen    -= copysize;
+
+          /* Take a consistent snapshot, the worker threads update the
+           * histogram from within a critical section.
+           */
+
+          flags = enter_critical_section();
+          latency = wqueue->latency;
+          leave_critical_section(flags);
+
+          linesize   = procfs_snprintf(procfile->line, WQUEUEINFO_LINELEN,
+                                       "%11s:%4u%9lu", wqueue->name,
+                                       wqueue->nthreads,
+                                       (unsigned long)latency.max);
+          for (i = 0; i < WQUEUE_LATENCY_NBUCKETS; i++)
+            {
+              linesize += procfs_snprintf(procfile->line + linesize,
+                                          WQUEUEINFO_LINELEN - linesize,
+                                          "%9" PRIu32, latency.count[i]);
+            }
+
+          linesize  += procfs_snprintf(procfile->line + linesize,
+                                       WQUEUEINFO_LINELEN - linesize, "\n");
+
+          copysize   = procfs_memcpy(procfile->line, linesize, buffer,
+                                     buflen, &offset);
+          totalsize += copysize;
+        }
+    }
+
+  nxmutex_unlock(&g_wqueue_procfs_lock);
+
+  filep->f_pos += totalsize;
+  return totalsize;
+}
+
+/****************************************************************************
+ * Name: wqueue_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int wqueue_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+  FAR struct wqueue_file_s *oldattr;
+  FAR struct wqueue_file_s *newattr;
+
+  oldattr = oldp->f_priv;
+  newattr = kmm_malloc(sizeof(struct wqueue_file_s));
+  if (newattr == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memcpy(newattr, oldattr, sizeof(struct wqueue_file_s));
+  newp->f_priv = newattr;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: wqueue_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int wqueue_stat(FAR const char *relpath, FAR struct stat *buf)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_procfs_register
+ *
+ * Description:
+ *   Add a work queue to /proc/wqueue.
+ *
+ ****************************************************************************/
+
+void work_procfs_register(FAR struct kwork_wqueue_s *wqueue)
+{
+  nxmutex_lock(&g_wqueue_procfs_lock);
+  wqueue->flink   = g_wqueue_procfs;
+  g_wqueue_procfs = wqueue;
+  nxmutex_unlock(&g_wqueue_procfs_lock);
+}
+
+/****************************************************************************
+ * Name: work_procfs_unregister
+ *
+ * Description:
+ *   Remove a work queue from /proc/wqueue.
+ *
+ ****************************************************************************/
+
+void work_procfs_unregister(FAR struct kwork_wqueue_s *wqueue)
+{
+  FAR struct kwork_wqueue_s **cur;
+
+  nxmutex_lock(&g_wqueue_procfs_lock);
+
+  for (cur = &g_wqueue_procfs; *cur != NULL; cur = &(*cur)->flink)
+    {
+      if (*cur == wqueue)
+        {
+          *cur = wqueue->flink;
+          break;
+        }
+    }
+
+  nxmutex_unlock(&g_wqueue_procfs_lock);
+}
+
+#endif /* CONFIG_WQUEUE_LATENCY && !CONFIG_FS_PROCFS_EXCLUDE_WQUEUE */
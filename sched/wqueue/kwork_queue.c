@@ -46,11 +46,11 @@
   do \
     { \
       int sem_count; \
-      dq_addlast((FAR dq_entry_t *)(work), &(wqueue).q); \
-      nxsem_get_value(&(wqueue).sem, &sem_count); \
+      dq_addlast((FAR dq_entry_t *)(work), &(wqueue)->q); \
+      nxsem_get_value(&(wqueue)->sem, &sem_count); \
       if (sem_count < 0) /* There are threads waiting for sem. */ \
         { \
-          nxsem_post(&(wqueue).sem); \
+          nxsem_post(&(wqueue)->sem); \
         } \
     } \
   while (0)
@@ -60,34 +60,125 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: hp_work_timer_expiry
+ * Name: work_timer_expiry
+ *
+ * Description:
+ *   The timer of a work queue has expired.  Move all delayed work that is
+ *   now due to the work queue and restart the timer for the first work
+ *   that is not.
+ *
  ****************************************************************************/
 
-#ifdef CONFIG_SCHED_HPWORK
-static void hp_work_timer_expiry(wdparm_t arg)
+static void work_timer_expiry(wdparm_t arg)
 {
-  irqstate_t flags = enter_critical_section();
-  queue_work(g_hpwork, arg);
+  FAR struct kwork_wqueue_s *wqueue = (FAR struct kwork_wqueue_s *)arg;
+  FAR struct work_s *work;
+  irqstate_t flags;
+  clock_t now;
+
+  flags = enter_critical_section();
+  now   = clock_systime_ticks();
+
+  while ((work = (FAR struct work_s *)wqueue->delayed.head) != NULL &&
+         (sclock_t)(work->u.s.qtime - now) <= 0)
+    {
+      dq_remfirst(&wqueue->delayed);
+      queue_work(wqueue, work);
+    }
+
+  if (work != NULL)
+    {
+      wd_start(&wqueue->timer, work->u.s.qtime - now,
+               work_timer_expiry, arg);
+    }
+
   leave_critical_section(flags);
 }
-#endif
 
 /****************************************************************************
- * Name: lp_work_timer_expiry
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_queue_wq
+ *
+ * Description:
+ *   Queue kernel-mode work on a work queue.  See work_queue().
+ *
+ *   Delayed work does not use a timer of its own.  It is kept in a list
+ *   sorted by expiry time and the work queue restarts its single timer
+ *   only when the first work in that list changes, so any number of
+ *   delayed work items costs one timer.
+ *
  ****************************************************************************/
 
-#ifdef CONFIG_SCHED_LPWORK
-static void lp_work_timer_expiry(wdparm_t arg)
+int work_queue_wq(FAR struct kwork_wqueue_s *wqueue,
+                  FAR struct work_s *work, worker_t worker,
+                  FAR void *arg, clock_t delay)
 {
-  irqstate_t flags = enter_critical_section();
-  queue_work(g_lpwork, arg);
+  FAR dq_entry_t *prev;
+  irqstate_t flags;
+
+  if (wqueue == NULL || work == NULL)
+    {
+      return -EINVAL;
+    }
+
+  /* Interrupts are disabled so that this logic can be called from with
+   * task logic or from interrupt handling logic.
+   */
+
+  flags = enter_critical_section();
+
+  /* Remove the entry from the timer and work queue. */
+
+  if (work->worker != NULL)
+    {
+      work_cancel_wq(wqueue, work);
+    }
+
+  /* Initialize the work structure. */
+
+  work->worker    = worker;        /* Work callback. non-NULL means queued */
+  work->arg       = arg;           /* Callback argument */
+  work->u.s.qtime = clock_systime_ticks() + delay;
+
+  /* Queue the new work */
+
+  if (!delay)
+    {
+      queue_work(wqueue, work);
+    }
+  else
+    {
+      /* Search from the tail:  work is usually queued with similar delays,
+       * and work with the same expiry time is then performed in the order
+       * in which it was queued.
+       */
+
+      for (prev = wqueue->delayed.tail;
+           prev != NULL &&
+           (sclock_t)(work->u.s.qtime -
+                      ((FAR struct work_s *)prev)->u.s.qtime) < 0;
+           prev = prev->blink);
+
+      if (prev == NULL)
+        {
+          /* The new work expires first, restart the timer */
+
+          dq_addfirst(&work->u.s.dq, &wqueue->delayed);
+          wd_start(&wqueue->timer, delay, work_timer_expiry,
+                   (wdparm_t)wqueue);
+        }
+      else
+        {
+          dq_addafter(prev, &work->u.s.dq, &wqueue->delayed);
+        }
+    }
+
   leave_critical_section(flags);
+  return OK;
 }
-#endif
-
-/****************************************************************************
- * Public Functions
- ****************************************************************************/
 
 /****************************************************************************
  * Name: work_queue
@@ -122,70 +213,52 @@ static void lp_work_timer_expiry(wdparm_t arg)
 int work_queue(int qid, FAR struct work_s *work, worker_t worker,
                FAR void *arg, clock_t delay)
 {
-  irqstate_t flags;
-  int ret = OK;
-
-  /* Interrupts are disabled so that this logic can be called from with
-   * task logic or from interrupt handling logic.
-   */
-
-  flags = enter_critical_section();
+  return work_queue_wq(work_qid2wq(qid), work, worker, arg, delay);
+}
 
-  /* Remove the entry from the timer and work queue. */
+/****************************************************************************
+ * Name: work_queue_on
+ *
+ * Description:
+ *   Queue kernel-mode work on the work queue of one CPU.
+ *
+ ****************************************************************************/
 
-  if (work->worker != NULL)
+#ifdef CONFIG_SCHED_PERCPUWORK
+int work_queue_on(int cpu, FAR struct work_s *work, worker_t worker,
+                  FAR void *arg, clock_t delay)
+{
+  if (cpu < 0 || cpu >= CONFIG_SMP_NCPUS)
     {
-      work_cancel(qid, work);
+      return -EINVAL;
     }
 
-  /* Initialize the work structure. */
-
-  work->worker = worker;           /* Work callback. non-NULL means queued */
-  work->arg = arg;                 /* Callback argument */
+  return work_queue_wq(g_percpu_wqueue[cpu], work, worker, arg, delay);
+}
+#endif
 
-  /* Queue the new work */
+/****************************************************************************
+ * Name: work_timeleft
+ *
+ * Description:
+ *   Return the time remaining before the specified work starts.
+ *
+ ****************************************************************************/
 
-#ifdef CONFIG_SCHED_HPWORK
-  if (qid == HPWORK)
-    {
-      /* Queue high priority work */
+sclock_t work_timeleft(FAR const struct work_s *work)
+{
+  sclock_t left = 0;
 
-      if (!delay)
-        {
-          queue_work(g_hpwork, work);
-        }
-      else
-        {
-          wd_start(&work->u.timer, delay, hp_work_timer_expiry,
-                   (wdparm_t)work);
-        }
-    }
-  else
-#endif
-#ifdef CONFIG_SCHED_LPWORK
-  if (qid == LPWORK)
+  if (work->worker != NULL)
     {
-      /* Queue low priority work */
-
-      if (!delay)
-        {
-          queue_work(g_lpwork, work);
-        }
-      else
+      left = (sclock_t)(work->u.s.qtime - clock_systime_ticks());
+      if (left < 0)
         {
-          wd_start(&work->u.timer, delay, lp_work_timer_expiry,
-                   (wdparm_t)work);
+          left = 0;
         }
     }
-  else
-#endif
-    {
-      ret = -EINVAL;
-    }
-
-  leave_critical_section(flags);
 
-  return ret;
+  return left;
 }
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
@@ -28,6 +28,7 @@
 #include <sched.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <assert.h>
@@ -35,6 +36,7 @@
 
 #include <nuttx/queue.h>
 #include <nuttx/wqueue.h>
+#include <nuttx/kmalloc.h>
 #include <nuttx/kthread.h>
 #include <nuttx/semaphore.h>
 
@@ -80,8 +82,13 @@
 
 struct hp_wqueue_s g_hpwork =
 {
-  {NULL, NULL},
-  SEM_INITIALIZER(0),
+  {
+    {NULL, NULL},
+    SEM_INITIALIZER(0),
+    HPWORKNAME,
+    CONFIG_SCHED_HPNTHREADS,
+    g_hpwork.worker,
+  },
 };
 
 #endif /* CONFIG_SCHED_HPWORK */
@@ -91,35 +98,82 @@ struct hp_wqueue_s g_hpwork =
 
 struct lp_wqueue_s g_lpwork =
 {
-  {NULL, NULL},
-  SEM_INITIALIZER(0),
+  {
+    {NULL, NULL},
+    SEM_INITIALIZER(0),
+    LPWORKNAME,
+    CONFIG_SCHED_LPNTHREADS,
+    g_lpwork.worker,
+  },
 };
 
 #endif /* CONFIG_SCHED_LPWORK */
 
+#ifdef CONFIG_SCHED_PERCPUWORK
+/* The per-CPU work queues */
+
+FAR struct kwork_wqueue_s *g_percpu_wqueue[CONFIG_SMP_NCPUS];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_latency
+ *
+ * Description:
+ *   Account for the time a work waited for a worker thread after it became
+ *   due.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WQUEUE_LATENCY
+static void work_latency(FAR struct kwork_wqueue_s *wqueue,
+                         FAR struct work_s *work)
+{
+  clock_t elapsed = clock_systime_ticks() - work->u.s.qtime;
+  int bucket;
+
+  if ((sclock_t)elapsed < 0)
+    {
+      elapsed = 0;
+    }
+
+  bucket = elapsed != 0 ? flsll(elapsed) : 0;
+  if (bucket >= WQUEUE_LATENCY_NBUCKETS)
+    {
+      bucket = WQUEUE_LATENCY_NBUCKETS - 1;
+    }
+
+  wqueue->latency.count[bucket]++;
+  if (elapsed > wqueue->latency.max)
+    {
+      wqueue->latency.max = elapsed;
+    }
+}
+#else
+#  define work_latency(wqueue, work)
+#endif
+
 /****************************************************************************
  * Name: work_thread
  *
  * Description:
  *   These are the worker threads that perform the actions placed on the
- *   high priority work queue.
+ *   work queues.
  *
- *   These, along with the lower priority worker thread(s) are the kernel
- *   mode work queues (also built in the flat build).
- *
- *   All kernel mode worker threads are started by the OS during normal
- *   bring up.  This entry point is referenced by OS internally and should
- *   not be accessed by application logic.
+ *   The threads of the high and the lower priority work queues are the
+ *   kernel mode work queues (also built in the flat build).  They are
+ *   started by the OS during normal bring up.  Other work queues are
+ *   started by work_queue_create().  This entry point is referenced by OS
+ *   internally and should not be accessed by application logic.
  *
  * Input Parameters:
  *   argc, argv
  *
  * Returned Value:
- *   Does not return
+ *   Does not return until the work queue is freed
  *
  ****************************************************************************/
 
@@ -142,9 +196,9 @@ static int work_thread(int argc, FAR char *argv[])
 
   flags = enter_critical_section();
 
-  /* Loop forever */
+  /* Loop until the work queue is freed */
 
-  for (; ; )
+  while (!wqueue->exit)
     {
       /* And check each entry in the work queue.  Since we have disabled
        * interrupts we know:  (1) we will not be suspended unless we do
@@ -160,6 +214,8 @@ static int work_thread(int argc, FAR char *argv[])
               continue;
             }
 
+          work_latency(wqueue, work);
+
           /* Extract the work description from the entry (in case the work
            * instance will be re-used after it has been de-queued).
            */
@@ -209,30 +265,31 @@ static int work_thread(int argc, FAR char *argv[])
 
   leave_critical_section(flags);
 
-  return OK; /* To keep some compilers happy */
+  nxsem_post(&wqueue->exsem);
+  return OK;
 }
 
 /****************************************************************************
  * Name: work_thread_create
  *
  * Description:
- *   This function creates and activates a work thread task with kernel-
- *   mode privileges.
+ *   This function creates and activates the work threads of a work queue
+ *   with kernel-mode privileges.
  *
  * Input Parameters:
  *   name       - Name of the new task
  *   priority   - Priority of the new task
  *   stack_size - size (in bytes) of the stack needed
- *   nthread    - Number of work thread should be created
  *   wqueue     - Work queue instance
  *
  * Returned Value:
- *   A negated errno value is returned on failure.
+ *   A negated errno value is returned on failure.  The threads that were
+ *   created before the failure are left running.
  *
  ****************************************************************************/
 
 static int work_thread_create(FAR const char *name, int priority,
-                              int stack_size, int nthread,
+                              int stack_size,
                               FAR struct kwork_wqueue_s *wqueue)
 {
   FAR char *argv[3];
@@ -242,12 +299,12 @@ static int work_thread_create(FAR const char *name, int priority,
   int pid;
 
   /* Don't permit any of the threads to run until we have fully initialized
-   * g_hpwork and g_lpwork.
+   * the work queue.
    */
 
   sched_lock();
 
-  for (wndx = 0; wndx < nthread; wndx++)
+  for (wndx = 0; wndx < wqueue->nthreads; wndx++)
     {
       nxsem_init(&wqueue->worker[wndx].wait, 0, 0);
 
@@ -272,13 +329,212 @@ static int work_thread_create(FAR const char *name, int priority,
     }
 
   sched_unlock();
+
+  /* Registering takes a mutex, so it must not be done with the scheduler
+   * locked.
+   */
+
+  work_procfs_register(wqueue);
   return OK;
 }
 
+/****************************************************************************
+ * Name: work_thread_stop
+ *
+ * Description:
+ *   Discard all pending work of a work queue and wait for its running
+ *   worker threads to exit.
+ *
+ ****************************************************************************/
+
+static void work_thread_stop(FAR struct kwork_wqueue_s *wqueue)
+{
+  FAR struct work_s *work;
+  irqstate_t flags;
+  int nthreads = 0;
+  int wndx;
+
+  flags = enter_critical_section();
+
+  wqueue->exit = true;
+  wd_cancel(&wqueue->timer);
+
+  while ((work = (FAR struct work_s *)dq_remfirst(&wqueue->q)) != NULL)
+    {
+      work->worker = NULL;
+    }
+
+  while ((work = (FAR struct work_s *)dq_remfirst(&wqueue->delayed)) !=
+         NULL)
+    {
+      work->worker = NULL;
+    }
+
+  /* Wake up every worker thread so that it notices the exit request */
+
+  for (wndx = 0; wndx < wqueue->nthreads; wndx++)
+    {
+      if (wqueue->worker[wndx].pid > 0)
+        {
+          nxsem_post(&wqueue->sem);
+          nthreads++;
+        }
+    }
+
+  leave_critical_section(flags);
+
+  while (nthreads-- > 0)
+    {
+      nxsem_wait_uninterruptible(&wqueue->exsem);
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_qid2wq
+ *
+ * Description:
+ *   Return the work queue associated with a work queue ID.
+ *
+ ****************************************************************************/
+
+FAR struct kwork_wqueue_s *work_qid2wq(int qid)
+{
+#ifdef CONFIG_SCHED_HPWORK
+  if (qid == HPWORK)
+    {
+      return &g_hpwork.wq;
+    }
+#endif
+
+#ifdef CONFIG_SCHED_LPWORK
+  if (qid == LPWORK)
+    {
+      return &g_lpwork.wq;
+    }
+#endif
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: work_queue_create
+ *
+ * Description:
+ *   Create a new kernel-mode work queue with its own worker thread(s).
+ *
+ * Input Parameters:
+ *   name       - Name of the worker thread(s)
+ *   priority   - Priority of the worker thread(s)
+ *   stack_size - Stack size of each worker thread
+ *   nthreads   - Number of worker threads
+ *
+ * Returned Value:
+ *   The new work queue on success; NULL on failure.
+ *
+ ****************************************************************************/
+
+FAR struct kwork_wqueue_s *work_queue_create(FAR const char *name,
+                                             int priority, int stack_size,
+                                             int nthreads)
+{
+  FAR struct kwork_wqueue_s *wqueue;
+  FAR char *wname;
+  size_t namelen;
+  int ret;
+
+  if (name == NULL || nthreads <= 0 || nthreads > UINT8_MAX)
+    {
+      return NULL;
+    }
+
+  /* The workers and then the name are kept after the work queue, in the
+   * same allocation.
+   */
+
+  namelen = strlen(name) + 1;
+  wqueue  = kmm_zalloc(sizeof(struct kwork_wqueue_s) +
+                       nthreads * sizeof(struct kworker_s) + namelen);
+  if (wqueue == NULL)
+    {
+      return NULL;
+    }
+
+  wqueue->worker = (FAR struct kworker_s *)(wqueue + 1);
+  wname = (FAR char *)&wqueue->worker[nthreads];
+  memcpy(wname, name, namelen);
+
+  dq_init(&wqueue->q);
+  dq_init(&wqueue->delayed);
+  nxsem_init(&wqueue->sem, 0, 0);
+  nxsem_init(&wqueue->exsem, 0, 0);
+  wqueue->name     = wname;
+  wqueue->nthreads = nthreads;
+
+  ret = work_thread_create(wname, priority, stack_size, wqueue);
+  if (ret < 0)
+    {
+      work_thread_stop(wqueue);
+      nxsem_destroy(&wqueue->sem);
+      nxsem_destroy(&wqueue->exsem);
+      kmm_free(wqueue);
+      return NULL;
+    }
+
+  return wqueue;
+}
+
+/****************************************************************************
+ * Name: work_queue_free
+ *
+ * Description:
+ *   Stop the worker thread(s) of a work queue created by
+ *   work_queue_create() and free it.
+ *
+ * Input Parameters:
+ *   wqueue - The work queue to free
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ ****************************************************************************/
+
+int work_queue_free(FAR struct kwork_wqueue_s *wqueue)
+{
+  int wndx;
+
+  if (wqueue == NULL)
+    {
+      return -EINVAL;
+    }
+
+  /* A worker thread cannot wait for itself to exit */
+
+  for (wndx = 0; wndx < wqueue->nthreads; wndx++)
+    {
+      if (wqueue->worker[wndx].pid == nxsched_gettid())
+        {
+          return -EDEADLK;
+        }
+    }
+
+  work_procfs_unregister(wqueue);
+  work_thread_stop(wqueue);
+
+  for (wndx = 0; wndx < wqueue->nthreads; wndx++)
+    {
+      nxsem_destroy(&wqueue->worker[wndx].wait);
+    }
+
+  nxsem_destroy(&wqueue->sem);
+  nxsem_destroy(&wqueue->exsem);
+  kmm_free(wqueue);
+  return OK;
+}
+
 /****************************************************************************
  * Name: work_foreach
  *
@@ -298,31 +554,15 @@ static int work_thread_create(FAR const char *name, int priority,
 
 void work_foreach(int qid, work_foreach_t handler, FAR void *arg)
 {
-  FAR struct kwork_wqueue_s *wqueue;
-  int nthread;
+  FAR struct kwork_wqueue_s *wqueue = work_qid2wq(qid);
   int wndx;
 
-#ifdef CONFIG_SCHED_HPWORK
-  if (qid == HPWORK)
-    {
-      wqueue  = (FAR struct kwork_wqueue_s *)&g_hpwork;
-      nthread = CONFIG_SCHED_HPNTHREADS;
-    }
-  else
-#endif
-#ifdef CONFIG_SCHED_LPWORK
-  if (qid == LPWORK)
-    {
-      wqueue  = (FAR struct kwork_wqueue_s *)&g_lpwork;
-      nthread = CONFIG_SCHED_LPNTHREADS;
-    }
-  else
-#endif
+  if (wqueue == NULL)
     {
       return;
     }
 
-  for (wndx = 0; wndx < nthread; wndx++)
+  for (wndx = 0; wndx < wqueue->nthreads; wndx++)
     {
       handler(wqueue->worker[wndx].pid, arg);
     }
@@ -350,9 +590,7 @@ int work_start_highpri(void)
   sinfo("Starting high-priority kernel worker thread(s)\n");
 
   return work_thread_create(HPWORKNAME, CONFIG_SCHED_HPWORKPRIORITY,
-                            CONFIG_SCHED_HPWORKSTACKSIZE,
-                            CONFIG_SCHED_HPNTHREADS,
-                            (FAR struct kwork_wqueue_s *)&g_hpwork);
+                            CONFIG_SCHED_HPWORKSTACKSIZE, &g_hpwork.wq);
 }
 #endif /* CONFIG_SCHED_HPWORK */
 
@@ -378,10 +616,67 @@ int work_start_lowpri(void)
   sinfo("Starting low-priority kernel worker thread(s)\n");
 
   return work_thread_create(LPWORKNAME, CONFIG_SCHED_LPWORKPRIORITY,
-                            CONFIG_SCHED_LPWORKSTACKSIZE,
-                            CONFIG_SCHED_LPNTHREADS,
-                            (FAR struct kwork_wqueue_s *)&g_lpwork);
+                            CONFIG_SCHED_LPWORKSTACKSIZE, &g_lpwork.wq);
 }
 #endif /* CONFIG_SCHED_LPWORK */
 
+/****************************************************************************
+ * Name: work_start_percpu
+ *
+ * Description:
+ *   Start one kernel-mode work queue per CPU, each with a single worker
+ *   thread that may only run on that CPU.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_PERCPUWORK
+int work_start_percpu(void)
+{
+  FAR struct kwork_wqueue_s *wqueue;
+  char name[CONFIG_TASK_NAME_SIZE + 1];
+  cpu_set_t cpuset;
+  int ret;
+  int cpu;
+
+  sinfo("Starting per-CPU kernel worker threads\n");
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      snprintf(name, sizeof(name), PERCPUWORKNAME "%d", cpu);
+      wqueue = work_queue_create(name, CONFIG_SCHED_PERCPUWORKPRIORITY,
+                                 CONFIG_SCHED_PERCPUWORKSTACKSIZE, 1);
+      if (wqueue == NULL)
+        {
+          serr("ERROR: Failed to create the work queue of CPU%d\n", cpu);
+          return -ENOMEM;
+        }
+
+      /* The worker thread only waits on its semaphore until work is
+       * queued, so it can safely be moved to its CPU after it was started.
+       */
+
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpu, &cpuset);
+      ret = nxsched_set_affinity(wqueue->worker[0].pid, sizeof(cpuset),
+                                 &cpuset);
+      if (ret < 0)
+        {
+          serr("ERROR: Failed to bind the worker of CPU%d: %d\n", cpu, ret);
+          work_queue_free(wqueue);
+          return ret;
+        }
+
+      g_percpu_wqueue[cpu] = wqueue;
+    }
+
+  return OK;
+}
+#endif /* CONFIG_SCHED_PERCPUWORK */
+
 #endif /* CONFIG_SCHED_WORKQUEUE */
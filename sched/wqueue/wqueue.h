@@ -32,6 +32,8 @@
 
 #include <nuttx/clock.h>
 #include <nuttx/queue.h>
+#include <nuttx/wdog.h>
+#include <nuttx/wqueue.h>
 
 #ifdef CONFIG_SCHED_WORKQUEUE
 
@@ -43,6 +45,14 @@
 
 #define HPWORKNAME "hpwork"
 #define LPWORKNAME "lpwork"
+#define PERCPUWORKNAME "cpuwork"
+
+/* Number of buckets in a work queue latency histogram.  Bucket 0 counts
+ * work started in the tick it became due, bucket n > 0 counts latencies of
+ * [2^(n-1), 2^n) ticks and the last bucket everything above.
+ */
+
+#define WQUEUE_LATENCY_NBUCKETS 12
 
 /****************************************************************************
  * Public Type Definitions
@@ -57,42 +67,71 @@ struct kworker_s
   sem_t             wait;      /* Sync waiting for worker done */
 };
 
-/* This structure defines the state of one kernel-mode work queue */
+/* Latency statistics of one work queue, in system ticks from the time the
+ * work became due until a worker thread started it.
+ */
+
+#ifdef CONFIG_WQUEUE_LATENCY
+struct kwork_latency_s
+{
+  uint32_t          count[WQUEUE_LATENCY_NBUCKETS];
+  clock_t           max;       /* Worst latency seen */
+};
+#endif
+
+/* This structure defines the state of one kernel-mode work queue.
+ *
+ * Delayed work is kept in 'delayed', sorted by expiry time, and a single
+ * timer per queue moves it to 'q' when it becomes due.  The u.s.qtime
+ * field of each work holds the tick at which it is (or was) due.
+ */
 
 struct kwork_wqueue_s
 {
   struct dq_queue_s q;         /* The queue of pending work */
   sem_t             sem;       /* The counting semaphore of the wqueue */
-  struct kworker_s  worker[1]; /* Describes a worker thread */
+  FAR const char   *name;      /* Name of the worker thread(s) */
+  uint8_t           nthreads;  /* Number of worker threads */
+
+  /* Describes each worker thread */
+
+  FAR struct kworker_s *worker;
+
+  bool              exit;      /* Request the worker threads to exit */
+  struct dq_queue_s delayed;   /* Delayed work, sorted by expiry time */
+  struct wdog_s     timer;     /* Expires with the first delayed work */
+  sem_t             exsem;     /* Posted by each exiting worker thread */
+#ifdef CONFIG_WQUEUE_LATENCY
+  FAR struct kwork_wqueue_s *flink; /* Next queue shown in procfs */
+  struct kwork_latency_s latency;   /* Latency histogram */
+#endif
 };
 
-/* This structure defines the state of one high-priority work queue.  This
- * structure must be cast-compatible with kwork_wqueue_s.
- */
+/* This structure defines the state of one high-priority work queue */
 
 #ifdef CONFIG_SCHED_HPWORK
 struct hp_wqueue_s
 {
-  struct dq_queue_s q;         /* The queue of pending work */
-  sem_t             sem;       /* The counting semaphore of the wqueue */
+  struct kwork_wqueue_s wq;
 
-  /* Describes each thread in the high priority queue's thread pool */
+  /* Describes each thread in the high priority queue's thread pool.  This
+   * is the storage wq.worker points to.
+   */
 
   struct kworker_s  worker[CONFIG_SCHED_HPNTHREADS];
 };
 #endif
 
-/* This structure defines the state of one low-priority work queue.  This
- * structure must be cast compatible with kwork_wqueue_s
- */
+/* This structure defines the state of one low-priority work queue */
 
 #ifdef CONFIG_SCHED_LPWORK
 struct lp_wqueue_s
 {
-  struct dq_queue_s q;         /* The queue of pending work */
-  sem_t             sem;       /* The counting semaphore of the wqueue */
+  struct kwork_wqueue_s wq;
 
-  /* Describes each thread in the low priority queue's thread pool */
+  /* Describes each thread in the low priority queue's thread pool.  This
+   * is the storage wq.worker points to.
+   */
 
   struct kworker_s  worker[CONFIG_SCHED_LPNTHREADS];
 };
@@ -114,6 +153,12 @@ extern struct hp_wqueue_s g_hpwork;
 extern struct lp_wqueue_s g_lpwork;
 #endif
 
+#ifdef CONFIG_SCHED_PERCPUWORK
+/* The per-CPU work queues */
+
+extern FAR struct kwork_wqueue_s *g_percpu_wqueue[CONFIG_SMP_NCPUS];
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -168,5 +213,57 @@ int work_start_lowpri(void);
 void work_initialize_notifier(void);
 #endif
 
+/****************************************************************************
+ * Name: work_start_percpu
+ *
+ * Description:
+ *   Start one kernel-mode work queue per CPU, each with a single worker
+ *   thread that may only run on that CPU.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_PERCPUWORK
+int work_start_percpu(void);
+#endif
+
+/****************************************************************************
+ * Name: work_qid2wq
+ *
+ * Description:
+ *   Return the work queue associated with a work queue ID.
+ *
+ * Input Parameters:
+ *   qid - The work queue ID (HPWORK or LPWORK)
+ *
+ * Returned Value:
+ *   The work queue or NULL if the ID is not valid.
+ *
+ ****************************************************************************/
+
+FAR struct kwork_wqueue_s *work_qid2wq(int qid);
+
+/****************************************************************************
+ * Name: work_procfs_register/work_procfs_unregister
+ *
+ * Description:
+ *   Add or remove a work queue from /proc/wqueue.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_WQUEUE_LATENCY) && defined(CONFIG_FS_PROCFS) && \
+    !defined(CONFIG_FS_PROCFS_EXCLUDE_WQUEUE)
+void work_procfs_register(FAR struct kwork_wqueue_s *wqueue);
+void work_procfs_unregister(FAR struct kwork_wqueue_s *wqueue);
+#else
+#  define work_procfs_register(wqueue)
+#  define work_procfs_unregister(wqueue)
+#endif
+
 #endif /* CONFIG_SCHED_WORKQUEUE */
 #endif /* __SCHED_WQUEUE_WQUEUE_H */